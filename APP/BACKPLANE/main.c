@@ -39,6 +39,7 @@
 #include <msp430.h>
 #include <rtc_b.h>
 #include "timer.h"
+#include "scheduler.h"
 
 
 int main(void)
@@ -49,9 +50,7 @@ int main(void)
 
     init_App();                 // Set variables for app
 
-    while(1){
-        run();
-    }
+    schedulerRun();             // Runs the events the ISRs post, sleeps in between
 
     return 0;
 }
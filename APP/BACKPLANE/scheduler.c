@@ -0,0 +1,96 @@
+/*
+ * scheduler.c
+ *
+ * The queue is a bit mask with one bit per event, the bit number being the
+ * priority. Posting is a single BIS on the mask, which an interrupt cannot
+ * split, and picking the next event is a scan for the lowest set bit. An
+ * event cannot be queued twice, so the queue never overflows: ISRs keep
+ * their own data (the I2C ring, ADC results) and the event only says there
+ * is something to do.
+ */
+
+#include <stddef.h>
+
+#include "scheduler.h"
+
+static const SchedulerHandler *handlers = NULL;
+static uint8_t handlerCount = 0;
+static volatile uint16_t pending = 0;
+static volatile uint16_t args[SCHEDULER_MAX_EVENTS];
+static volatile uint16_t merged = 0;
+
+void schedulerInit(const SchedulerHandler *eventHandlers, uint8_t count)
+{
+    __disable_interrupt();
+    handlers = eventHandlers;
+    handlerCount = (count > SCHEDULER_MAX_EVENTS) ? SCHEDULER_MAX_EVENTS : count;
+    pending = 0;
+    merged = 0;
+    __enable_interrupt();
+}
+
+void schedulerPost(uint8_t event, uint16_t arg)
+{
+    uint16_t bit = 1u << event;
+
+    if (event >= handlerCount)
+        return;
+
+    args[event] = arg;
+    if (pending & bit)
+        merged++;
+    pending |= bit;
+}
+
+uint16_t schedulerPending(void)
+{
+    return pending;
+}
+
+uint8_t schedulerDispatch(void)
+{
+    uint16_t waiting;
+    uint16_t arg;
+    uint8_t event = 0;
+
+    __disable_interrupt();
+    waiting = pending;
+    if (waiting == 0) {
+        __enable_interrupt();
+        return SCHEDULER_NO_EVENT;
+    }
+    while (!(waiting & 1)) {
+        waiting >>= 1;
+        event++;
+    }
+    pending &= ~(1u << event);
+    arg = args[event];
+    __enable_interrupt();
+
+    handlers[event](arg);
+    return event;
+}
+
+void schedulerIdle(void)
+{
+    // Interrupts stay off between the check and entering LPM, so an event
+    // posted in between still wakes the loop
+    __disable_interrupt();
+    if (pending == 0)
+        __bis_SR_register(SCHEDULER_LPM_BITS + GIE);
+    __enable_interrupt();
+}
+
+uint16_t schedulerMerged(void)
+{
+    return merged;
+}
+
+void schedulerRun(void)
+{
+    while (1) {
+        while (schedulerDispatch() != SCHEDULER_NO_EVENT)
+            ;
+        schedulerIdle();
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * scheduler.h
+ *
+ * Run-to-completion event scheduler of the Backplane.
+ *
+ * ISRs post events and wake the CPU, the main loop runs one handler per
+ * pending event, highest priority first, and sleeps in SCHEDULER_LPM_BITS as
+ * soon as nothing is pending. Handlers never block: a slow job is split into
+ * events that follow each other.
+ */
+
+#ifndef APP_SCHEDULER_H_
+#define APP_SCHEDULER_H_
+
+#include <msp430.h>
+#include <stdint.h>
+
+#define SCHEDULER_MAX_EVENTS        16          /**< One bit each in the pending mask */
+#define SCHEDULER_NO_EVENT          0xFF
+#define SCHEDULER_LPM_BITS          LPM3_bits   /**< ACLK keeps the RTC running, the I2C slave runs from SCL */
+
+/**
+ * @brief Runs one event. arg is the value given to the last schedulerPost()
+ * of the event before it ran.
+ */
+typedef void (*SchedulerHandler)(uint16_t arg);
+
+/**
+ * @brief Sets up the handlers and drops any pending event.
+ *
+ * @param handlers
+ *        One per event, in priority order: event 0 runs first. Must stay in
+ *        memory, and must not hold more than SCHEDULER_MAX_EVENTS.
+ */
+void schedulerInit(const SchedulerHandler *handlers, uint8_t count);
+
+/**
+ * @brief Marks an event pending. Safe from ISRs and handlers.
+ *
+ * An event that is already pending runs once, with the newest arg; the merge
+ * is counted in schedulerMerged(). From an ISR, follow with
+ * __bic_SR_register_on_exit(SCHEDULER_LPM_BITS) to wake the main loop.
+ */
+void schedulerPost(uint8_t event, uint16_t arg);
+
+/**
+ * @brief Pending events, bit n for event n.
+ */
+uint16_t schedulerPending(void);
+
+/**
+ * @brief Runs the handler of the highest priority pending event.
+ *
+ * @return The event that ran, SCHEDULER_NO_EVENT if none was pending.
+ */
+uint8_t schedulerDispatch(void);
+
+/**
+ * @brief Sleeps in SCHEDULER_LPM_BITS until an ISR wakes the CPU, unless an
+ * event is already pending.
+ */
+void schedulerIdle(void);
+
+/**
+ * @brief Posts that found their event still pending, since schedulerInit().
+ */
+uint16_t schedulerMerged(void);
+
+/**
+ * @brief Dispatches events and sleeps in between, forever.
+ */
+void schedulerRun(void);
+
+#endif /* APP_SCHEDULER_H_ */
@@ -6,29 +6,68 @@
  */
 
 
-// TODO: The commented code is mostly I2C communications, this file should be Timer only
+// TODO: The I2C command handling should move out of this file, it should be Timer only
+
+#include <string.h>
 
 #include <timer.h>
 #include <rtc_b.h>
 #include <gpio.h>
+#include <i2c.h>
+#include "scheduler.h"
 
-#define SLAVE_ADDRESS 0x08
-//uint8_t stopCondition = 0x13;
+static volatile appStatus app;  // Current state of the Backplane
 
+static uint8_t commandBuffer[MAX_BUFFER_SIZE] = {0};    // Command from OBC, up to its stop condition
+static uint8_t bytesReceived = 0;                       // Bytes of the command received so far
+static uint8_t responseBuffer[MAX_BUFFER_SIZE] = {0};   // Response to the last command
 
-// 255 is used instead of a defined literal because the use of one led to a definition error
+// Every command in BACKPLANE_COMMANDS gets Name##Command, written by hand
+// below to fill its response payload. It returns -1 if it has nothing to
+// answer, and the OBC gets CommandUnavailable instead.
+typedef struct
+{
+    int16_t (*handler)(uint8_t *response);
+    uint8_t commandSize;
+    uint8_t responseSize;
+} sBackplaneCommand_t;
 
-static volatile appStatus app;  // Current state of the Backplane
+#define BACKPLANE_HANDLER_PROTOTYPE(Name, id, cmd_size, resp_size) \
+    static int16_t Name##Command(uint8_t *response);
+#define BACKPLANE_COMMAND_ENTRY(Name, id, cmd_size, resp_size) \
+    [id] = {Name##Command, (cmd_size), (resp_size)},
+// Build fails here if a command or its response does not fit the I2C buffers
+#define BACKPLANE_COMMAND_CHECK(Name, id, cmd_size, resp_size) \
+    typedef char Name##_fits_buffer[((cmd_size) <= MAX_BUFFER_SIZE && (resp_size) <= MAX_BUFFER_SIZE) ? 1 : -1];
+
+BACKPLANE_COMMANDS(BACKPLANE_HANDLER_PROTOTYPE)
+BACKPLANE_COMMANDS(BACKPLANE_COMMAND_CHECK)
+
+// Command table, indexed by ID, an ID without a handler is unknown. Being
+// const it stays in FRAM.
+static const sBackplaneCommand_t commandTable[] = {
+    BACKPLANE_COMMANDS(BACKPLANE_COMMAND_ENTRY)
+};
+
+#define COMMAND_TABLE_SIZE  (sizeof(commandTable) / sizeof(commandTable[0]))
 
-//static uint8_t commandBuffer[255] = {0};    // Buffer for receiving commands from OBC
-//static volatile uint8_t bytesReceived = 0;      // Number of bytes received from OBC for one command
-//static volatile uint8_t receivingData = 0;      // Acts like a boolean
-//
-//static uint8_t responseBuffer[255] = {0};   // Buffer for response to be sent to OBC
-//static volatile uint8_t *responsePointer = 0;
+#define BACKPLANE_EVENT_PROTOTYPE(Name, handler)    static void handler(uint16_t arg);
+#define BACKPLANE_EVENT_HANDLER(Name, handler)      handler,
+
+BACKPLANE_EVENTS(BACKPLANE_EVENT_PROTOTYPE)
+
+static const SchedulerHandler eventHandlers[BACKPLANE_EVENT_COUNT] = {
+    BACKPLANE_EVENTS(BACKPLANE_EVENT_HANDLER)
+};
+
+static void commandByte(uint8_t data);
+static void i2cReceived(void);
 
 void init_App(){
     app = timer_mode;       // Start in timer mode
+    schedulerInit(eventHandlers, BACKPLANE_EVENT_COUNT);
+
+    startCountdownAlarm(); // Starts countdown using 30 minute alarm
 }
 
 
@@ -48,10 +87,14 @@ void startCountdownAlarm() {
         GPIO_PRIMARY_MODULE_FUNCTION
     );
 
-    //Initialize LFXT1
-    CS_turnOnLFXT(
-//        CS_LFXT_DRIVE_3
-        );
+    //Initialize LFXT1, waiting until it runs without a fault
+    CSCTL0_H = CSKEY >> 8;
+    CSCTL4 &= ~LFXTOFF;
+    do {
+        CSCTL5 &= ~LFXTOFFG;
+        SFRIFG1 &= ~OFIFG;
+    } while (SFRIFG1 & OFIFG);
+    CSCTL0_H = 0;
 
     //Setup for Calendar
     currentTime.Seconds    = 0x00;
@@ -73,31 +116,22 @@ void startCountdownAlarm() {
     param.dayOfMonthAlarm   = 0x20;
     RTC_B_configureCalendarAlarm(RTC_B_BASE, &param);
 
+    //Only the alarm interrupt is enabled. The read ready interrupt would wake
+    //the CPU every second, and nothing uses the calendar event yet.
     RTC_B_clearInterrupt(RTC_B_BASE,
         RTC_B_CLOCK_READ_READY_INTERRUPT +
         RTC_B_TIME_EVENT_INTERRUPT +
         RTC_B_CLOCK_ALARM_INTERRUPT
         );
-    //Enable interrupt for RTC Ready Status, which asserts when the RTC
-    //Calendar registers are ready to read.
-    //Also, enable interrupts for the Calendar alarm and Calendar event.
     RTC_B_enableInterrupt(RTC_B_BASE,
-        RTC_B_CLOCK_READ_READY_INTERRUPT +
-        RTC_B_TIME_EVENT_INTERRUPT +
         RTC_B_CLOCK_ALARM_INTERRUPT
         );
 
-    //Start RTC Clock
+    //Start RTC Clock, the scheduler sleeps until the alarm
     RTC_B_startClock(RTC_B_BASE);
-
-    //Enter low power mode with interrupts enabled
-    __bis_SR_register(LPM0_bits + GIE);
-
-    __no_operation();
-
 }
 
-/*ISR that maintains LPM until 30 minutes has passed*/
+/*ISR that posts the countdown alarm*/
 #if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
 #pragma vector=RTC_VECTOR
 __interrupt
@@ -109,247 +143,124 @@ void RTC_B_ISR (void)
     switch (__even_in_range(RTCIV,16)){
         case 2:     //RTCRDYIFG, triggered every second
             break;
-        case 4:     //RTCEVIFG, triggered every minute
+        case 4:     //RTCEVIFG, not enabled
             break;
         case 6:     //RTCAIFG, triggers at set alarm
-            // Disable and clear interrupts
-            RTC_B_disableInterrupt(RTC_B_BASE,
-                RTC_B_CLOCK_READ_READY_INTERRUPT +
-                RTC_B_TIME_EVENT_INTERRUPT +
-                RTC_B_CLOCK_ALARM_INTERRUPT
-                );
-            RTC_B_clearInterrupt(RTC_B_BASE,
-                RTC_B_CLOCK_READ_READY_INTERRUPT +
-                RTC_B_TIME_EVENT_INTERRUPT +
-                RTC_B_CLOCK_ALARM_INTERRUPT
-                );
-            // Exit low power mode to resume run()
-            __bic_SR_register_on_exit(LPM0_bits);
-            // Switch to idle mode
-            app = idle;
-            // Initialize I2C for idle mode
-            void initializeI2C();
+            // The alarm is only used once
+            RTC_B_disableInterrupt(RTC_B_BASE, RTC_B_CLOCK_ALARM_INTERRUPT);
+            RTC_B_clearInterrupt(RTC_B_BASE, RTC_B_CLOCK_ALARM_INTERRUPT);
+            schedulerPost(EVENT_DEPLOY, 0);
+            __bic_SR_register_on_exit(SCHEDULER_LPM_BITS);
             break;
         default: break;
     }
 }
 
+/* Countdown over: start answering the OBC. The CDH supply switch has no pin
+ * on the Backplane schematic yet, so the alarm does not drive it. */
+static void onDeployAlarm(uint16_t arg){
+    (void)arg;
+    initializeI2C();
+    app = idle;
+}
+
 
 
 /* Data reading functionality */
 
 void initializeI2C()
 {
+    sI2cConfigCb_t i2cConfig = {
+        .Rx_Proc_Data = commandByte,
+        .Tx_Next_Data = NULL,
+        .Rx_Notify = i2cReceived,
+        .slave_addr = I2C_ADDR_BACKPLANE
+    };
+
+    // Configure Pins for I2C
+    /*
+    * Select Port 1
+    * Set Pin 6, 7 to input Secondary Module Function, (UCB0SIMO/UCB0SDA, UCB0SOMI/UCB0SCL).
+    */
+    GPIO_setAsPeripheralModuleFunctionInputPin(
+        GPIO_PORT_P1,
+        GPIO_PIN6 + GPIO_PIN7,
+        GPIO_SECONDARY_MODULE_FUNCTION
+    );
 
-//    // Configure Pins for I2C
-//    //Set P1.6 and P1.7 as Secondary Module Function Input.
-//    /*
-//
-//    * Select Port 1
-//    * Set Pin 6, 7 to input Secondary Module Function, (UCB0SIMO/UCB0SDA, UCB0SOMI/UCB0SCL).
-//    */
-//    GPIO_setAsPeripheralModuleFunctionInputPin(
-//        GPIO_PORT_P1,
-//        GPIO_PIN6 + GPIO_PIN7,
-//        GPIO_SECONDARY_MODULE_FUNCTION
-//    );
-//
-//    // eUSCI configuration
-//    EUSCI_B_I2C_initSlaveParam param = {0};
-//    param.slaveAddress = SLAVE_ADDRESS;
-//    param.slaveAddressOffset = EUSCI_B_I2C_OWN_ADDRESS_OFFSET0;
-//    param.slaveOwnAddressEnable = EUSCI_B_I2C_OWN_ADDRESS_ENABLE;
-//    EUSCI_B_I2C_initSlave(EUSCI_B0_BASE, &param);
-//
-//    EUSCI_B_I2C_enable(EUSCI_B0_BASE);
-//
-//    EUSCI_B_I2C_clearInterrupt(EUSCI_B0_BASE,
-//                EUSCI_B_I2C_RECEIVE_INTERRUPT0
-//                );
-//
-//    EUSCI_B_I2C_enableInterrupt(EUSCI_B0_BASE,
-//                EUSCI_B_I2C_RECEIVE_INTERRUPT0
-//                );
-//
-//    //Enter low power mode with interrupts enabled
-//    __bis_SR_register(CPUOFF + GIE);
-//    __no_operation();
-//}
-//
-//void suspendI2CInterrupts() {
-//    EUSCI_B_I2C_disableInterrupt(EUSCI_B0_BASE,
-//         EUSCI_B_I2C_RECEIVE_INTERRUPT0
-//         );
-//}
-//
-//void resumeI2CInterrupts() {
-//    EUSCI_B_I2C_enableInterrupt(EUSCI_B0_BASE,
-//        EUSCI_B_I2C_RECEIVE_INTERRUPT0
-//        );
-//    __bis_SR_register(CPUOFF + GIE); // Enter LPM with interrupts
-//}
-//
-//
-//
-//void commandHandler() {
-//
-//    switch(commandBuffer[0]){  // Command ID will always be the first byte transmitted
-//
-//        case SystemStatus:
-//            if (bytesReceived != SystemStatusSize) {
-//                // return error
-//            } else if (commandBuffer[bytesReceived] != stopCondition) {
-//                // return error
-//            } else {
-//                app = system_status;
-//            }
-//            break;
-//        case HealthCheck:
-//            if (bytesReceived != HealthCheckSize) {
-//                // return error
-//            } else if (commandBuffer[bytesReceived] != stopCondition) {
-//                // return error
-//            } else {
-//                app = health_check;
-//            }
-//            break;
-//        case Temperature:
-//            if (bytesReceived != TemperatureSize) {
-//                // return error
-//            } else if (commandBuffer[bytesReceived] != stopCondition) {
-//                // return error
-//            } else {
-//                app = temp_reading;
-//            }
-//            break;
-//        case TelecomAcknowledge:
-//            if (bytesReceived != TelecomAcknowledgeSize) {
-//                // return error
-//            } else if (commandBuffer[bytesReceived] != stopCondition) {
-//                // return error
-//            } else {
-//                app = telecom_acknowledge;
-//            }
-//            break;
-//        default: // Unrecognized command
-//            // return error
-//            break;
-//    }
+    bytesReceived = 0;
+    initI2C(&i2cConfig);
 }
 
+// Called from USCI_B0_ISR, which wakes the CPU on its way out
+static void i2cReceived(void){
+    schedulerPost(EVENT_I2C_RX, 0);
+}
 
-//#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
-//#pragma vector=USCI_B0_VECTOR
-//__interrupt
-//#elif defined(__GNUC__)
-//__attribute__((interrupt(USCI_B0_VECTOR)))
-//#endif
-//void USCIB0_ISR(void)
-//{
-//    switch(__even_in_range(UCB0IV, USCI_I2C_UCBIT9IFG))
-//    {
-//        case USCI_NONE:             // No interrupts break;
-//            break;
-//        case USCI_I2C_UCALIFG:      // Arbitration lost
-//            break;
-//        case USCI_I2C_UCNACKIFG:    // NAK received (master only)
-//            break;
-//        case USCI_I2C_UCSTTIFG:     // START condition detected with own address (slave mode only)
-//            break;
-//        case USCI_I2C_UCSTPIFG:     // STOP condition detected (master & slave mode)
-//
-//            // Receive the final byte and process the command
-//            commandBuffer[bytesReceived++] = EUSCI_B_I2C_slaveGetData(EUSCI_B0_BASE);
-//            receivingData = 0;      // End transmission of data
-//            suspendI2CInterrupts(); // Suspend interrupts and exit LPM during command handling
-//            commandHandler();
-//            __bic_SR_register_on_exit(CPUOFF); // Exit LPM to resume in correct mode
-//
-//            break;
-//        case USCI_I2C_UCRXIFG3:     // RXIFG3
-//            break;
-//        case USCI_I2C_UCTXIFG3:     // TXIFG3
-//            break;
-//        case USCI_I2C_UCRXIFG2:     // RXIFG2
-//            break;
-//        case USCI_I2C_UCTXIFG2:     // TXIFG2
-//            break;
-//        case USCI_I2C_UCRXIFG1:     // RXIFG1
-//            break;
-//        case USCI_I2C_UCTXIFG1:     // TXIFG1
-//            break;
-//        case USCI_I2C_UCRXIFG0:     // RXIFG0 -> slave mode receive data
-//            break;
-//        case USCI_I2C_UCTXIFG0:     // TXIFG0 -> slave mode transmit data
-//            break;
-//        case USCI_I2C_UCBCNTIFG:    // Byte count limit reached (UCBxTBCNT)
-//            break;
-//        case USCI_I2C_UCCLTOIFG:    // Clock low timeout - clock held low too long
-//            break;
-//        case USCI_I2C_UCBIT9IFG:    // Generated on 9th bit of a transmit (for debugging)
-//            break;
-//        default:
-//            break;
-//    }
-//}
-
-
-
-// LEDs used below to verify state of board
-
-
-void run(){
-
-    switch(app){
-        /* Count-down mode after power-on before switching to idle state */
-        case timer_mode:
-            startCountdownAlarm(); // Starts countdown using 30 minute alarm
-            break;
-        /* Idle state */
-        case idle:
-//            responsePointer = responseBuffer;  // Reset the response buffer pointer
-            resumeI2CInterrupts(); // Resume interrupts and enter LPM after executing command
-            break;
-        /* Single-use function to power on main board before changing to idle mode */
-        case power_cdh:
-            break;
-        /* Modes used for each command */
-        case system_status:
-            GPIO_setAsOutputPin(GPIO_PORT_P1, GPIO_PIN0);  // Green LED on
-            GPIO_setOutputHighOnPin(GPIO_PORT_P1, GPIO_PIN0);
-            // Do action
-            // Fill responseBuffer
-            app = idle;
-            break;
-        case health_check:
-            GPIO_setAsOutputPin(GPIO_PORT_P4, GPIO_PIN6);  // Red LED on
-            GPIO_setOutputHighOnPin(GPIO_PORT_P4, GPIO_PIN6);
-            // Do action
-            // Fill responseBuffer
-            app = idle;
-            break;
-        case temp_reading:
-            // Should enter MASTER mode to get data from Temp sensors
-            // EUSCI_B_I2C_setMode()
-            GPIO_setAsOutputPin(GPIO_PORT_P4, GPIO_PIN6);  // Red and Green LEDs on
-            GPIO_setOutputHighOnPin(GPIO_PORT_P4, GPIO_PIN6);
-            GPIO_setAsOutputPin(GPIO_PORT_P1, GPIO_PIN0);
-            GPIO_setOutputHighOnPin(GPIO_PORT_P1, GPIO_PIN0);
-            // Do action
-            // Fill responseBuffer
-            app = idle;
-            break;
-        case telecom_acknowledge:
-            GPIO_setAsOutputPin(GPIO_PORT_P4, GPIO_PIN6);  // Flash both LEDs
-            GPIO_toggleOutputOnPin(GPIO_PORT_P4, GPIO_PIN6);
-            GPIO_toggleOutputOnPin(GPIO_PORT_P4, GPIO_PIN6);
-            GPIO_setAsOutputPin(GPIO_PORT_P1, GPIO_PIN0);
-            GPIO_toggleOutputOnPin(GPIO_PORT_P1, GPIO_PIN0);
-            GPIO_toggleOutputOnPin(GPIO_PORT_P1, GPIO_PIN0);
-            // Do action
-            // Fill responseBuffer
-            app = idle;
-            break;
+static void onI2cReceive(uint16_t arg){
+    (void)arg;
+    processI2C();
+}
+
+static void commandByte(uint8_t data){
+    if (bytesReceived < MAX_BUFFER_SIZE)
+        commandBuffer[bytesReceived++] = data;
+
+    if (data == STOP_CONDITION) {
+        commandHandler();
+        bytesReceived = 0;
+    }
+}
+
+static void respond(uint8_t size){
+    responseBuffer[size - 1] = STOP_CONDITION;
+    transmitI2C(responseBuffer, size);
+}
+
+static void respondError(uint8_t error){
+    responseBuffer[0] = error;
+    respond(BACKPLANE_ERROR_RESP_SIZE);
+}
+
+void commandHandler() {
+    uint8_t id = commandBuffer[0];  // Command ID will always be the first byte transmitted
+    const sBackplaneCommand_t *command = (id < COMMAND_TABLE_SIZE) ? &commandTable[id] : NULL;
+
+    memset(responseBuffer, 0, sizeof(responseBuffer));
+
+    if (command == NULL || command->handler == NULL) {
+        respondError(CommandUnknown);
+    } else if (bytesReceived != command->commandSize) {
+        respondError(CommandBadSize);
+    } else if (command->handler(responseBuffer) != 0) {
+        respondError(CommandUnavailable);
+    } else {
+        respond(command->responseSize);
     }
 
+    app = idle;
+}
+
+// The command document does not define any response payload yet, so every
+// command answers CommandUnavailable until its format is written down
+
+static int16_t SystemStatusCommand(uint8_t *response){
+    (void)response;
+    return -1; // TODO switch to project defined error flags
+}
+
+static int16_t HealthCheckCommand(uint8_t *response){
+    (void)response;
+    return -1; // TODO switch to project defined error flags
+}
+
+static int16_t TemperatureCommand(uint8_t *response){
+    (void)response;
+    // No thermistor either until its pin is confirmed against the Backplane schematic
+    return -1; // TODO switch to project defined error flags
+}
+
+static int16_t TelecomAcknowledgeCommand(uint8_t *response){
+    (void)response;
+    return -1; // TODO switch to project defined error flags
 }
@@ -8,11 +8,12 @@
 #ifndef APP_APP_H_
 #define APP_APP_H_
 
+#include <stdint.h>
+
 
 typedef enum
 {
     timer_mode,
-    power_cdh,
     idle,
     system_status,
     health_check,
@@ -20,41 +21,75 @@ typedef enum
     telecom_acknowledge,
 } appStatus;
 
+#define STOP_CONDITION 0x13                 // Ends every command and response
+
+// Backplane command set, IDs and lengths are written down only here.
+// Sizes count the stop condition: command ID + stop, payload + stop.
+//
+//  X(Name,              ID,   command size, response size)
+#define BACKPLANE_COMMANDS(X) \
+    X(SystemStatus,       0x01, 0x02, 0x06) \
+    X(HealthCheck,        0x02, 0x02, 0x11) \
+    X(Temperature,        0x03, 0x02, 0x02) /* Response not defined in doc */ \
+    X(TelecomAcknowledge, 0x06, 0x02, 0x03)
+
+#define BACKPLANE_COMMAND_ID(Name, id, cmd_size, resp_size)        Name = (id),
+#define BACKPLANE_COMMAND_SIZE(Name, id, cmd_size, resp_size)      Name##Size = (cmd_size),
+#define BACKPLANE_RESPONSE_SIZE(Name, id, cmd_size, resp_size)     Name##RespSize = (resp_size),
+
 enum Command
 {
-    SystemStatus = 0x01,
-    HealthCheck = 0x02,
-    Temperature = 0x03,
-    TelecomAcknowledge = 0x06,
+    BACKPLANE_COMMANDS(BACKPLANE_COMMAND_ID)
 };
 
 enum CommandSize  // ID + stop condition
 {
-    SystemStatusSize = 0x02,
-    HealthCheckSize = 0x02,
-    TemperatureSize = 0x02,
-    TelecomAcknowledgeSize = 0x02,
+    BACKPLANE_COMMANDS(BACKPLANE_COMMAND_SIZE)
 };
 
 enum ResponseSize  // payload size + stop condition
 {
-    SystemStatusRespSize = 0x06,        // 0x05 + 1
-    HealthCheckRespSize = 0x11,         // 0x10 + 1
-    TemperatureRespSize = 0x02,         // Not defined in doc
-    TelecomAcknowledgeRespSize = 0x03,  // 0x02 + 1
+    BACKPLANE_COMMANDS(BACKPLANE_RESPONSE_SIZE)
+};
+
+// A command that cannot be answered gets an error code and the stop condition
+// instead of its response. The codes are not in the doc, they are kept clear
+// of the command IDs.
+#define BACKPLANE_ERROR_RESP_SIZE   0x02
+
+enum CommandError
+{
+    CommandUnknown      = 0xE1,     // No command with this ID
+    CommandBadSize      = 0xE2,     // Stop condition not at the command size
+    CommandUnavailable  = 0xE3,     // Response format not defined in doc yet
 };
 
+// Scheduler events (scheduler.h), highest priority first. The handlers are
+// in timer.c, posted by the ISR named in each comment.
+//
+//  X(Name,               handler)
+#define BACKPLANE_EVENTS(X) \
+    X(EVENT_DEPLOY,       onDeployAlarm)  /* RTC_B_ISR: the countdown alarm */ \
+    X(EVENT_I2C_RX,       onI2cReceive)   /* USCI_B0_ISR: command bytes queued */
+
+#define BACKPLANE_EVENT_ID(Name, handler)       Name,
+
+enum BackplaneEvent
+{
+    BACKPLANE_EVENTS(BACKPLANE_EVENT_ID)
+    BACKPLANE_EVENT_COUNT
+};
+
+/**
+ * @brief Sets up the scheduler and the countdown. Leaves
+ * every wake-up to the ISRs, so main() only has to call schedulerRun().
+ */
 void init_App();
 
-void startCountdownCounter();
 void startCountdownAlarm();
 
 void initializeI2C();
-void suspendI2CInterrupts();
-void resumeI2CInterrupts();
 void commandHandler();
 
-void run();
-
 
 #endif /* APP_APP_H_ */
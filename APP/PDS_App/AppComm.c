@@ -1,20 +1,63 @@
 
+#include <string.h>
+
 #include "AppComm.h"
 #include "bsp.h"
 
+//*******************************************************************************
+// Buffers **********************************************************************
+//*******************************************************************************
+
+// Buffers for holding command arguments received from the master, and the
+// response data sent back, one pair per command in PDS_COMMANDS
+#define PDS_COMMAND_BUFFERS(ID, Name, cmd_len, resp_len) \
+    static uint8_t Name##Buf[cmd_len] = {0}; \
+    static uint8_t Name##RespBuf[resp_len] = {0};
+
+PDS_COMMANDS(PDS_COMMAND_BUFFERS)
+
 //***************************Private functions definitions***************************************************
 
-static int16_t SendTelemetryResponse();
-static int16_t ProcessTelemetryRequest(uint8_t command);
-static int16_t ProcessTelecommand(uint8_t command, const uint8_t* buffer, uint8_t size);
+// Every command in PDS_COMMANDS gets Name##Command, generated below to store
+// its arguments, and Refresh##Name, written by hand to fill its response
+#define PDS_HANDLER_PROTOTYPES(ID, Name, cmd_len, resp_len) \
+    static int16_t Name##Command(const uint8_t* buffer, uint16_t size); \
+    static int16_t Refresh##Name(void);
+
+PDS_COMMANDS(PDS_HANDLER_PROTOTYPES)
+
+// Command tables, indexed by ID. Being const they stay in FRAM and the parser
+// dispatches with a single lookup, no switch and no registration at boot.
+#define PDS_TELECOMMAND_ENTRY(ID, Name, cmd_len, resp_len) \
+    [ID##_ID] = {Name##Command, (cmd_len), NULL},
+#define PDS_TELEMETRY_ENTRY(ID, Name, cmd_len, resp_len) \
+    [ID##_ID] = {Name##RespBuf, (resp_len), PDS_IS_LARGE(resp_len), Refresh##Name},
+
+static const struct TINYPROTOCOL_TelecommandEntry telecommandTable[PDS_COMMAND_TABLE_SIZE] = {
+    PDS_COMMANDS(PDS_TELECOMMAND_ENTRY)
+};
+
+static const struct TINYPROTOCOL_TelemetryEntry telemetryTable[PDS_COMMAND_TABLE_SIZE] = {
+    PDS_COMMANDS(PDS_TELEMETRY_ENTRY)
+};
+
+static const struct TINYPROTOCOL_Registry protocolRegistry = {
+    .telecommands = telecommandTable,
+    .telecommand_count = PDS_COMMAND_TABLE_SIZE,
+    .telemetry = telemetryTable,
+    .telemetry_count = PDS_COMMAND_TABLE_SIZE
+};
 
 static const struct TINYPROTOCOL_Config protocolConfig = 
 {
-    .TINYPROTOCOL_ProcessTelecommand = ProcessTelecommand,
-    .TINYPROTOCOL_ProcessTelemetryRequest = ProcessTelemetryRequest, 
-    .TINYPROTOCOL_WriteBuffer = transmitI2C
+    .TINYPROTOCOL_WriteBuffer = transmitI2C,
+    .TINYPROTOCOL_TelemetryReady = transmitI2CStream   // The TX ISR reads the response straight out of the table's buffers
 };
 
+// Build fails here if the rail fault table does not fit its response. Bytes
+// past the last rail stay zero, no fault.
+typedef char RAIL_FAULTS_RESP_LEN_fits_rails[(RAIL_FAULTS_RESP_LEN >= PDS_RAIL_COUNT * PDS_RAIL_FAULT_SIZE) ? 1 : -1];
+
 static void I2C_Proc_RX_Data(uint8_t data);
 
 /**
@@ -52,19 +95,18 @@ static void setup_telecom_acknowledge_test(uint8_t *TelecommandAckRespBuf);
 void InitAppComm(void) {
     sI2cConfigCb_t i2cConfig = {
         .Rx_Proc_Data = I2C_Proc_RX_Data,
+        .Tx_Next_Data = TINYPROTOCOL_ReadNextTelemetryByte,
         .slave_addr = SLAVE_ADDR
     };
 
     initI2C(&i2cConfig);
     
     TINYPROTOCOL_Initialize();
+    TINYPROTOCOL_SetRegistry(&protocolRegistry);
+}
 
-    TINYPROTOCOL_RegisterTelemetryChannel(SYSTEM_STATUS_ID, SystemStatusRespBuf, sizeof(SystemStatusRespBuf));
-    TINYPROTOCOL_RegisterTelemetryChannel(HEALTH_CHECK_ID, HealthCheckRespBuf, sizeof(HealthCheckRespBuf));
-    TINYPROTOCOL_RegisterTelemetryChannel(REBOOT_ID, RebootRespBuf, sizeof(RebootRespBuf));
-    TINYPROTOCOL_RegisterTelemetryChannel(CONVERTER_MONITOR_ID, ConverterMonitorRespBuf, sizeof(ConverterMonitorRespBuf));
-    TINYPROTOCOL_RegisterTelemetryChannel(TELECOMMAND_ACK_ID, TelecommandAckRespBuf, sizeof(TelecommandAckRespBuf));
-    TINYPROTOCOL_RegisterTelemetryChannel(BINGO_BONGO_ID, NULL, 0); // TODO
+void ProcessAppComm(void) {
+    processI2C();
 }
 
 //***************************Private Functions Implementations***************************************************
@@ -72,53 +114,45 @@ void I2C_Proc_RX_Data(uint8_t data) {
     TINYPROTOCOL_ParseByte(&protocolConfig, data);
 }
 
-int16_t ProcessTelecommand(uint8_t command, const uint8_t* buffer, uint8_t size) {
-  switch (command) {
-    // TODO
-    default:
-        break;
-  }
-  return ETINYPROTOCOL_SUCCESS;
+// Telecommands keep their arguments for the next response
+#define PDS_STORE_ARGUMENTS(ID, Name, cmd_len, resp_len) \
+    int16_t Name##Command(const uint8_t* buffer, uint16_t size) { \
+        memcpy(Name##Buf, buffer, size); \
+        return ETINYPROTOCOL_SUCCESS; \
+    }
+
+PDS_COMMANDS(PDS_STORE_ARGUMENTS)
+
+int16_t RefreshSystemStatus(void) {
+    setup_system_status_test(SystemStatusRespBuf, SystemStatusBuf);
+    return ETINYPROTOCOL_SUCCESS;
 }
 
-int16_t ProcessTelemetryRequest(uint8_t command) {
-    switch(command) {
-        case SYSTEM_STATUS_ID:
-            setup_system_status_test(SystemStatusRespBuf,SystemStatusBuf);
-            break;
-        case HEALTH_CHECK_ID:
-            setup_health_check_test(HealthCheckRespBuf, HealthCheckBuf);
-            break;
-        case REBOOT_ID:
-            // TODO move to command
-            break;
-        case CONVERTER_MONITOR_ID:
-            setup_converter_monitor_test(ConverterMonitorRespBuf);
-            break;
-        case TELECOMMAND_ACK_ID:
-            setup_telecom_acknowledge_test(TelecommandAckRespBuf);
-            break;
-    }
-    // todo move this function inside tiny embededded
-    return SendTelemetryResponse();
+int16_t RefreshHealthCheck(void) {
+    setup_health_check_test(HealthCheckRespBuf, HealthCheckBuf);
+    return ETINYPROTOCOL_SUCCESS;
 }
 
-int16_t SendTelemetryResponse() { 
-    uint8_t bytes[TINYPROTOCOL_MAX_PACKET_SIZE];
-    uint8_t count = 0;
-    uint8_t* pbyte = bytes;
-
-    while(TINYPROTOCOL_TelemetryBytesLeft() > 0) {
-        int16_t result = TINYPROTOCOL_ReadNextTelemetryByte(pbyte);
-        if (result == ETINYPROTOCOL_SUCCESS) {
-            pbyte++;
-            count++;
-        } else {
-            return result;
-        }
-    }
-    
-    transmitI2C(bytes, count);
+int16_t RefreshReboot(void) {
+    // TODO move to command
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+int16_t RefreshConverterMonitor(void) {
+    setup_converter_monitor_test(ConverterMonitorRespBuf);
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+int16_t RefreshTelecommandAck(void) {
+    setup_telecom_acknowledge_test(TelecommandAckRespBuf);
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+int16_t RefreshRailFaults(void) {
+    // A RAIL_FAULTS telecommand with a non-zero first byte acknowledges the
+    // faults: they are cleared once this report has been taken
+    railFaultReport(RailFaultsRespBuf, RailFaultsBuf[0]);
+    RailFaultsBuf[0] = 0;
     return ETINYPROTOCOL_SUCCESS;
 }
 
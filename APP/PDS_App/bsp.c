@@ -2,6 +2,7 @@
 #include "bsp.h"
 #include "gpio.h"
 #include "i2c.h"
+#include "ADC_Read.h"
 #include <msp430.h> 
 
 //******************************************************************************
@@ -12,6 +13,7 @@ void initBsp()
 {
     initClockTo16MHz();
     initGPIO();
+    initAdc();
 }
 
 void initClockTo16MHz()
@@ -39,4 +41,97 @@ void initGPIO()
     // Disable the GPIO power-on default high-impedance mode to activate
     // previously configured port settings
     PM5CTL0 &= ~LOCKLPM5;
-}
\ No newline at end of file
+}
+
+#ifdef PDS_RAILS_H
+
+#define PDS_RAIL_PIN(Name, adc_pin, port, pin, low, high)      adc_pin,
+#define PDS_RAIL_WINDOW(Name, adc_pin, port, pin, low, high)   {adc_pin, low, high},
+#define PDS_RAIL_GPIO(Name, adc_pin, port, pin, low, high) \
+    GPIO_setAsPeripheralModuleFunctionInputPin(port, pin, GPIO_TERNARY_MODULE_FUNCTION);
+
+#define RAIL_MONITOR_RATE           (100 * PDS_RAIL_COUNT)   /**< Conversions per second, 100 per rail */
+#define RAIL_MONITOR_MEMORY         ADC12_B_MEMORY_16
+
+// Build fails here if the telemetry layout and the driver's disagree
+typedef char PDS_RAIL_FAULT_SIZE_matches_driver[(PDS_RAIL_FAULT_SIZE == ADC_MONITOR_REPORT_SIZE) ? 1 : -1];
+
+static const ADC_Pin railPins[PDS_RAIL_COUNT] = {
+    PDS_RAILS(PDS_RAIL_PIN)
+};
+
+static const sAdcMonitorRail_t railWindows[PDS_RAIL_COUNT] = {
+    PDS_RAILS(PDS_RAIL_WINDOW)
+};
+
+void initAdc()
+{
+    sAdcSequenceConfig_t railSequence = {
+        .pins = railPins,
+        .count = PDS_RAIL_COUNT,
+        .firstMemory = ADC12_B_MEMORY_0,
+        .Sequence_Done = NULL
+    };
+
+    PDS_RAILS(PDS_RAIL_GPIO)                  // Analog function on every rail pin
+
+    ADC_init_Standard();
+    ADC_SequenceInit(&railSequence);
+}
+
+void initRailMonitor()
+{
+    sAdcMonitorConfig_t railMonitor = {
+        .rails = railWindows,
+        .count = PDS_RAIL_COUNT,
+        .firstMemory = RAIL_MONITOR_MEMORY,
+        .conversionRate = RAIL_MONITOR_RATE,
+        .Rail_Alarm = NULL
+    };
+
+    ADC_MonitorInit(&railMonitor);
+    ADC_MonitorStart();
+}
+
+void samplePdsRails(uint16_t *results)
+{
+    if (ADC_MonitorRunning())
+        ADC_MonitorRead(results);
+    else
+        ADC_SampleSequence(results);
+}
+
+uint8_t takeRailAlarms()
+{
+    return ADC_MonitorEvents();
+}
+
+void railFaultReport(uint8_t *buffer, uint8_t clear)
+{
+    ADC_MonitorReport(buffer, clear);
+}
+
+#else // No rail table, see PDS_RAILS in bsp.h
+
+void initAdc()
+{
+}
+
+void initRailMonitor()
+{
+}
+
+void samplePdsRails(uint16_t *results)
+{
+}
+
+uint8_t takeRailAlarms()
+{
+    return 0;
+}
+
+void railFaultReport(uint8_t *buffer, uint8_t clear)
+{
+}
+
+#endif // PDS_RAILS_H
@@ -6,7 +6,35 @@
 #ifndef _BSP_
 #define _BSP_
 
-#define SLAVE_ADDR                  0x08  /**< I2C Slave Address for the MSP430 device */
+#include <stdint.h>
+#include "i2c.h"
+
+#define SLAVE_ADDR                  I2C_ADDR_PDS  /**< I2C Slave Address for the MSP430 device */
+
+// Converter rails sampled together by one ADC sequence, in conversion order,
+// and their alarm windows in 12-bit codes at the ADC pin (see initRailMonitor()):
+//
+//  X(Rail name,  ADC pin, GPIO port,    GPIO pin,  alarm low, alarm high)
+//
+// The PDS schematic does not fix the rail pins and dividers yet, so the table
+// is not defined here. A build that has one names its header in PDS_RAILS_H.
+// Without it no pin is taken from its GPIO function and the rails are neither
+// sampled nor monitored.
+#ifdef PDS_RAILS_H
+#include PDS_RAILS_H
+#else
+#define PDS_RAILS(X)
+#endif
+
+#define PDS_RAIL_ID(Name, adc_pin, port, pin, low, high)  Name,
+
+#define PDS_RAIL_FAULT_SIZE         6     /**< Bytes per rail in railFaultReport() */
+
+/** Position of each rail in the results of samplePdsRails() and in railFaultReport() */
+enum PdsRail {
+    PDS_RAILS(PDS_RAIL_ID)
+    PDS_RAIL_COUNT
+};
 
 void initBsp();
 
@@ -20,4 +48,44 @@ void initClockTo16MHz();
  */
 void initGPIO();
 
+/**
+ * @brief Routes the rail pins to the ADC and sets up the sequence that samples
+ * every rail of PDS_RAILS with one trigger.
+ */
+void initAdc();
+
+/**
+ * @brief Starts watching every rail against its PDS_RAILS alarm window with the
+ * ADC window comparator. The CPU is only woken when a rail leaves its window.
+ */
+void initRailMonitor();
+
+/**
+ * @brief Samples every converter rail once, sleeping in LPM0 during the conversions.
+ *
+ * While the rail monitor runs, the rails are not sampled again: its last
+ * results, at most one scan old, are returned instead.
+ *
+ * @param results Receives PDS_RAIL_COUNT 12-bit values, indexed by enum PdsRail
+ */
+void samplePdsRails(uint16_t *results);
+
+/**
+ * @brief Rails whose alarm window was left since the last call, bit per enum PdsRail.
+ */
+uint8_t takeRailAlarms();
+
+/**
+ * @brief Packs the latched rail fault table for telemetry.
+ *
+ * PDS_RAIL_FAULT_SIZE bytes per rail, indexed by enum PdsRail: status bits
+ * (0x01 went above, 0x02 went below, 0x04 / 0x08 still above / below), the
+ * number of excursions, then the highest and lowest result seen outside the
+ * window, 16-bit little endian.
+ *
+ * @param buffer Receives PDS_RAIL_COUNT * PDS_RAIL_FAULT_SIZE bytes
+ * @param clear Non-zero to clear the latches once packed
+ */
+void railFaultReport(uint8_t *buffer, uint8_t clear);
+
 #endif // _BSP_
@@ -2,32 +2,56 @@
 #ifndef _COMM_
 #define _COMM_
 
+#include "tinyprotocol.h"
+
 //*******************************************************************************
 // Device Communication Defines *************************************************
 //*******************************************************************************
 
-// Command IDs for various I2C commands
-// #define SYSTEM_STATUS_ID            0x01  /**< Command ID for requesting system status */
-// #define HEALTH_CHECK_ID             0x02  /**< Command ID for health check */
-// #define REBOOT_ID                   0x03  /**< Command ID to initiate reboot */
-// #define CONVERTER_MONITOR_ID        0x04  /**< Command ID for converter monitoring */
-// #define TELECOMMAND_ACK_ID          0x05  /**< Command ID for telecommand acknowledgement */
-// #define BINGO_BONGO                 0x09  /**< Example command ID for testing */
-
-// Command argument lengths (number of bytes expected per command)
-#define SYSTEM_STATUS_CMD_LEN       2     /**< Length of arguments for system status command */
-#define HEALTH_CHECK_CMD_LEN        2     /**< Length of arguments for health check command */
-#define REBOOT_CMD_LEN              2     /**< Length of arguments for reboot command */
-#define CONVERTER_MONITOR_CMD_LEN   2     /**< Length of arguments for converter monitor command */
-#define TELECOMMAND_ACK_CMD_LEN     2     /**< Length of arguments for telecommand acknowledgement */
-#define TYPE_3_LENGTH               10    /**< Example length for an additional command */
-
-// Response lengths for each command (number of bytes to be sent back to the master)
-#define SYSTEM_STATUS_RESP_LEN      5     /**< Response length for system status */
-#define HEALTH_CHECK_RESP_LEN       16    /**< Response length for health check */
-#define REBOOT_RESP_LEN             1     /**< Response length for reboot */
-#define CONVERTER_MONITOR_RESP_LEN  3     /**< Response length for converter monitor */
-#define TELECOMMAND_ACK_RESP_LEN    2     /**< Response length for telecommand acknowledgement */
+// The PDS command set, the one place command IDs and lengths are written down.
+// Everything else is expanded from this list at compile time: the IDs and
+// lengths below, the argument / response buffers (AppComm.h), the slave's const
+// command tables and handler prototypes (AppComm.c) and the master's encoders
+// (comm_master.h).
+//
+// IDs are handed out in order from TINYPROTOCOL_TC_RESERVED, so append new
+// commands at the end. Responses above TINYPROTOCOL_MAX_PAYLOAD_SIZE are sent as
+// large frames; arguments must fit a small frame.
+//
+//  X(ID name,          Handler name,     argument bytes, response bytes)
+#define PDS_COMMANDS(X) \
+    X(SYSTEM_STATUS,     SystemStatus,     2,  5)  \
+    X(HEALTH_CHECK,      HealthCheck,      2,  16) \
+    X(REBOOT,            Reboot,           2,  1)  \
+    X(CONVERTER_MONITOR, ConverterMonitor, 2,  3)  \
+    X(TELECOMMAND_ACK,   TelecommandAck,   2,  2)  \
+    X(RAIL_FAULTS,       RailFaults,       2,  36)
 
-#endif // _COMM_
+#define PDS_IS_LARGE(len)   ((len) > TINYPROTOCOL_MAX_PAYLOAD_SIZE)
+
+// Command IDs, also the telemetry channel carrying each command's response
+#define PDS_COMMAND_ID(ID, Name, cmd_len, resp_len)     ID##_ID,
+
+enum CustomProtocolTelecommand {
+    PDS_COMMAND_ID_BASE = TINYPROTOCOL_TC_RESERVED - 1,
+    PDS_COMMANDS(PDS_COMMAND_ID)
+    PDS_COMMAND_TABLE_SIZE      /**< One past the last ID, size of the command tables */
+};
+
+// Command argument lengths and response lengths (bytes sent back to the master)
+#define PDS_COMMAND_LENGTHS(ID, Name, cmd_len, resp_len) \
+    ID##_CMD_LEN = (cmd_len), \
+    ID##_RESP_LEN = (resp_len),
 
+enum CustomProtocolLengths {
+    PDS_COMMANDS(PDS_COMMAND_LENGTHS)
+};
+
+// Build fails here if a command does not fit its frame
+#define PDS_COMMAND_CHECK(ID, Name, cmd_len, resp_len) \
+    typedef char ID##_CMD_LEN_fits_small_frame[((cmd_len) > 0 && (cmd_len) <= TINYPROTOCOL_MAX_PAYLOAD_SIZE) ? 1 : -1]; \
+    typedef char ID##_RESP_LEN_fits_large_frame[((resp_len) > 0 && (resp_len) <= TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE) ? 1 : -1];
+
+PDS_COMMANDS(PDS_COMMAND_CHECK)
+
+#endif // _COMM_
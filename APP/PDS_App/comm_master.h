@@ -0,0 +1,39 @@
+
+#ifndef _COMM_MASTER_
+#define _COMM_MASTER_
+
+#include <stdint.h>
+
+#include "comm.h"
+#include "tinyprotocol.h"
+
+//*******************************************************************************
+// Master side encoders *********************************************************
+//*******************************************************************************
+
+// Generated from PDS_COMMANDS for the master (SAMV71), so the master always
+// sends the argument count and expects the response length the PDS was built
+// with. Frames go out through the WriteBuffer callback of cfg.
+//
+//  PDS_Send<Name>(cfg, args)     telecommand carrying <ID>_CMD_LEN argument bytes
+//  PDS_Request<Name>(cfg)        telemetry request for the command's response
+//  <ID>_RESP_FRAME_LEN           bytes to read back: payload, length prefix of
+//                                large frames, CRC
+#define PDS_MASTER_ENCODERS(ID, Name, cmd_len, resp_len) \
+    static inline int16_t PDS_Send##Name(const struct TINYPROTOCOL_Config *cfg, const uint8_t args[cmd_len]) { \
+        return TINYPROTOCOL_SendTelecommand(cfg, ID##_ID, args, (cmd_len)); \
+    } \
+    static inline int16_t PDS_Request##Name(const struct TINYPROTOCOL_Config *cfg) { \
+        return TINYPROTOCOL_SendTelemetryRequest(cfg, ID##_ID); \
+    }
+
+PDS_COMMANDS(PDS_MASTER_ENCODERS)
+
+#define PDS_RESPONSE_FRAME_LEN(ID, Name, cmd_len, resp_len) \
+    ID##_RESP_FRAME_LEN = (resp_len) + (PDS_IS_LARGE(resp_len) ? 2 : 0) + 1,
+
+enum CustomProtocolFrameLengths {
+    PDS_COMMANDS(PDS_RESPONSE_FRAME_LEN)
+};
+
+#endif // _COMM_MASTER_
@@ -30,7 +30,17 @@ int main(void)
     //PMM_unlockLPM5();           // Disable the GPIO power-on default high-impedance mode
 
     initBsp();
+    initRailMonitor();
     InitAppComm();
 
-    __bis_SR_register(LPM0_bits + GIE);
+    while (1) {
+        ProcessAppComm();
+
+        // Interrupts stay off between the check and entering LPM0, so a byte
+        // queued in between still wakes the loop
+        __disable_interrupt();
+        if (i2cRxPending() == 0)
+            __bis_SR_register(LPM0_bits + GIE);
+        __enable_interrupt();
+    }
 }
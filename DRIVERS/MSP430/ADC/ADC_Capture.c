@@ -0,0 +1,187 @@
+/*
+ * Continuous capture of one ADC pin at ADC_CAPTURE_MIN_RATE to ADC_CAPTURE_MAX_RATE samples per second.
+ *
+ * Timer_A0 CCR1 (reset/set output) is the ADC sample-and-hold source in repeated single channel mode,
+ * so the ADC converts on every timer period with no software involved. Each end of conversion triggers
+ * DMA channel 0, which copies ADC12MEM31 into the buffer in repeated single transfer mode.
+ *
+ * The buffer is used as two halves. When a half is full the DMA reloads its destination from DMA0DA and
+ * carries on; DMA0DA has already been pointed at the other half, and the ISR points it back at the half
+ * just filled for the reload after that. The CPU only runs once per half.
+ *
+ */
+
+#include <stddef.h>
+
+#include <msp430.h>
+
+#include "include/adc12_b.h"
+#include "ADC_Capture.h"
+
+typedef struct sAdcCaptureCtx {
+    void (*Half_Full)(const uint16_t *samples, uint16_t count);
+    uint16_t *buffer;
+    uint16_t halfLength;
+    uint8_t filling;                /**< Half the DMA writes into */
+    uint8_t next;                   /**< Half ADC_CaptureProcess() hands out next */
+    volatile uint8_t filled;        /**< Bit per half, set by DMA_ISR, cleared once processed */
+    uint16_t overruns;
+    uint8_t running;                /**< Between ADC_CaptureStart() and ADC_CaptureStop() */
+} sAdcCaptureCtx_t;
+
+static sAdcCaptureCtx_t adcCapture = {
+    .Half_Full = NULL,
+    .buffer = NULL
+};
+
+static uint16_t *CaptureHalf(uint8_t half){
+    return adcCapture.buffer + (half ? adcCapture.halfLength : 0);
+}
+
+int16_t ADC_CaptureInit(const sAdcCaptureConfig_t *config){
+    uint16_t period;
+
+    if (config->sampleRate < ADC_CAPTURE_MIN_RATE || config->sampleRate > ADC_CAPTURE_MAX_RATE ||
+        config->buffer == NULL || config->halfLength == 0)
+        return -1; // TODO switch to project defined error flags
+
+    // DMA channel 0 running for someone else: the rail monitor owns the peripherals
+    if (!adcCapture.running && (DMA0CTL & DMAEN))
+        return -1; // TODO switch to project defined error flags
+
+    ADC_CaptureStop();
+
+    // ADC: one conversion per rising edge of TA0.1, on MODOSC. 4 cycles of sampling
+    // and 14 of conversion at 4.8 MHz take 3.75 us, under the 5 us of the maximum rate.
+    ADC12_B_initParam adcParams = {
+        .sampleHoldSignalSourceSelect = ADC12_B_SAMPLEHOLDSOURCE_1,
+        .clockSourceSelect = ADC12_B_CLOCKSOURCE_ADC12OSC,
+        .clockSourceDivider = ADC12_B_CLOCKDIVIDER_1,
+        .clockSourcePredivider = ADC12_B_CLOCKPREDIVIDER__1,
+        .internalChannelMap = ADC12_B_NOINTCH
+    };
+    ADC12_B_init(ADC12_B_BASE, &adcParams);
+    ADC12_B_enable(ADC12_B_BASE);
+    ADC12_B_setupSamplingTimer(ADC12_B_BASE,
+        ADC12_B_CYCLEHOLD_4_CYCLES,
+        ADC12_B_CYCLEHOLD_4_CYCLES,
+        ADC12_B_MULTIPLESAMPLESDISABLE);
+
+    ADC12_B_configureMemoryParam memoryParams = {
+        .memoryBufferControlIndex = ADC_CAPTURE_MEMORY,
+        .inputSourceSelect = config->pin,
+        .refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS,
+        .endOfSequence = ADC12_B_ENDOFSEQUENCE,
+        .windowComparatorSelect = ADC12_B_WINDOW_COMPARATOR_DISABLE,
+        .differentialModeSelect = ADC12_B_DIFFERENTIAL_MODE_DISABLE
+    };
+    ADC12_B_configureMemory(ADC12_B_BASE, &memoryParams);
+
+    // Timer_A0: rising edge of TA0.1 at the start of every period, which the minimum rate keeps under 65536 cycles
+    period = (uint16_t)(ADC_CAPTURE_SMCLK_HZ / config->sampleRate);
+    TA0CTL = MC__STOP | TACLR;
+    TA0CCR0 = period - 1;
+    TA0CCR1 = period / 2;
+    TA0CCTL1 = OUTMOD_7;
+
+    // DMA channel 0: word from ADC12MEM31 to the next buffer slot on each end of conversion
+    DMACTL0 = (DMACTL0 & ~DMA0TSEL_31) | DMA0TSEL__ADC12IFG;
+    DMA0CTL = DMADT_4 | DMASRCINCR_0 | DMADSTINCR_3 | DMAIE;
+    __data16_write_addr((unsigned short)(DMA_BASE + OFS_DMA0SA),
+        ADC12_B_getMemoryAddressForDMA(ADC12_B_BASE, ADC_CAPTURE_MEMORY));
+    DMA0SZ = config->halfLength;
+
+    adcCapture.Half_Full = config->Half_Full;
+    adcCapture.buffer = config->buffer;
+    adcCapture.halfLength = config->halfLength;
+    adcCapture.overruns = 0;
+
+    return 0;
+}
+
+void ADC_CaptureStart(void){
+    adcCapture.filling = 0;
+    adcCapture.next = 0;
+    adcCapture.filled = 0;
+
+    // DMAEN latches the first half, DMA0DA then already holds the second for the first reload
+    __data16_write_addr((unsigned short)(DMA_BASE + OFS_DMA0DA), (unsigned long)CaptureHalf(0));
+    DMA0CTL &= ~DMAIFG;
+    DMA0CTL |= DMAEN;
+    __data16_write_addr((unsigned short)(DMA_BASE + OFS_DMA0DA), (unsigned long)CaptureHalf(1));
+
+    adcCapture.running = 1;
+    ADC12_B_startConversion(ADC12_B_BASE, ADC_CAPTURE_MEMORY >> 1, ADC12_B_REPEATED_SINGLECHANNEL);
+    TA0CTL = TASSEL__SMCLK | MC__UP | TACLR;
+}
+
+void ADC_CaptureStop(void){
+    if (!adcCapture.running)
+        return;
+
+    TA0CTL = MC__STOP;
+    ADC12_B_disableConversions(ADC12_B_BASE, ADC12_B_PREEMPTCONVERSION);
+    DMA0CTL &= ~DMAEN;
+    adcCapture.running = 0;
+}
+
+uint8_t ADC_CapturePending(void){
+    uint8_t filled = adcCapture.filled;
+    return (filled & 1) + ((filled >> 1) & 1);
+}
+
+void ADC_CaptureProcess(void){
+    while (adcCapture.filled & (1 << adcCapture.next)) {
+        if (adcCapture.Half_Full != NULL)
+            adcCapture.Half_Full(CaptureHalf(adcCapture.next), adcCapture.halfLength);
+
+        // The half goes back to the DMA only now that it has been read
+        __disable_interrupt();
+        adcCapture.filled &= ~(1 << adcCapture.next);
+        __enable_interrupt();
+        adcCapture.next ^= 1;
+    }
+}
+
+uint16_t ADC_CaptureOverruns(void){
+    return adcCapture.overruns;
+}
+
+//******************************************************************************
+// DMA Interrupt ***************************************************************
+//******************************************************************************
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = DMA_VECTOR
+__interrupt void DMA_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__ ((interrupt(DMA_VECTOR))) DMA_ISR (void)
+#else
+#error Compiler not supported!
+#endif
+{
+    uint8_t half;
+
+    switch (__even_in_range(DMAIV, DMAIV_DMA2IFG))
+    {
+        case DMAIV_NONE:    break;              // Vector 0: No interrupt
+        case DMAIV_DMA0IFG:                     // Vector 2: DMA0, a half of the capture buffer is full
+            half = adcCapture.filling;
+            adcCapture.filling ^= 1;
+
+            // The DMA already reloaded into the other half; the reload after
+            // that comes back to this one
+            __data16_write_addr((unsigned short)(DMA_BASE + OFS_DMA0DA), (unsigned long)CaptureHalf(half));
+
+            // The other half is being overwritten before it was processed
+            if (adcCapture.filled & (1 << adcCapture.filling))
+                adcCapture.overruns++;
+            adcCapture.filled |= 1 << half;
+
+            __bic_SR_register_on_exit(LPM0_bits);   // -> Wake the main loop
+            break;
+        case DMAIV_DMA1IFG: break;              // Vector 4: DMA1
+        case DMAIV_DMA2IFG: break;              // Vector 6: DMA2
+        default: break;
+    }
+}
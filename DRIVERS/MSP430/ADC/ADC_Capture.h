@@ -0,0 +1,92 @@
+#ifndef ADC_CAPTURE_H_
+#define ADC_CAPTURE_H_
+
+#include "ADC_Read.h"
+
+#ifndef ADC_CAPTURE_SMCLK_HZ
+#define ADC_CAPTURE_SMCLK_HZ        16000000UL  /**< SMCLK set by initClockTo16MHz(), clocks the sample timer */
+#endif
+
+#define ADC_CAPTURE_MIN_RATE        (ADC_CAPTURE_SMCLK_HZ / 65535UL + 1)    /**< Samples per second, the 16-bit timer period limit: 245 at 16 MHz */
+#define ADC_CAPTURE_MAX_RATE        200000UL    /**< Samples per second, the ADC12_B conversion rate limit */
+#define ADC_CAPTURE_MEMORY          ADC12_B_MEMORY_31   /**< Memory register used by the capture, clear of the sequences */
+
+/******************************************************************************
+ * @brief A continuous capture of one ADC pin.
+ ******************************************************************************/
+typedef struct sAdcCaptureConfig {
+    ADC_Pin pin;
+    uint32_t sampleRate;            /**< Samples per second, ADC_CAPTURE_MIN_RATE to ADC_CAPTURE_MAX_RATE */
+    uint16_t *buffer;               /**< 2 * halfLength samples */
+    uint16_t halfLength;            /**< Samples per half of the buffer */
+    void (*Half_Full)(const uint16_t *samples, uint16_t count);   /**< Called from ADC_CaptureProcess() */
+} sAdcCaptureConfig_t;
+
+
+/******************************************************************************
+ * @brief Sets up a continuous capture of one pin into a ping-pong buffer.
+ *
+ * Timer_A0 triggers a conversion every 1 / sampleRate seconds, and DMA
+ * channel 0 moves each result from ADC12MEM31 into the buffer without the
+ * CPU. When one half of the buffer is full the DMA carries on in the other
+ * half, and the filled half is handed to Half_Full from the main loop, so
+ * processing overlaps acquisition.
+ *
+ * Call after initClockTo16MHz(). It takes over the ADC, Timer_A0 and DMA
+ * channel 0 until ADC_CaptureStop(); ADC_SequenceInit(...) has to be called
+ * again to use the sequence functions of ADC_Read.h afterwards. The rail
+ * monitor of ADC_Read.h needs the same peripherals: while it runs this
+ * fails, ADC_MonitorStop() first.
+ *
+ * @param config
+ *        The capture to run. It is copied, the buffer has to stay in memory.
+ *
+ * @return 0 on success, -1 if the rate is under ADC_CAPTURE_MIN_RATE or
+ *         above ADC_CAPTURE_MAX_RATE, the buffer is missing, halfLength is 0
+ *         or another driver has DMA channel 0 running.
+ ******************************************************************************/
+extern int16_t ADC_CaptureInit(const sAdcCaptureConfig_t *config);
+
+
+/******************************************************************************
+ * @brief Starts sampling, into the first half of the buffer.
+ *
+ * @return None.
+ ******************************************************************************/
+extern void ADC_CaptureStart(void);
+
+
+/******************************************************************************
+ * @brief Stops sampling. A partly filled half is dropped.
+ *
+ * @return None.
+ ******************************************************************************/
+extern void ADC_CaptureStop(void);
+
+
+/******************************************************************************
+ * @brief Number of filled halves waiting for ADC_CaptureProcess(), 0 to 2.
+ ******************************************************************************/
+extern uint8_t ADC_CapturePending(void);
+
+
+/******************************************************************************
+ * @brief Hands every filled half to Half_Full, oldest first.
+ *
+ * A half is given back to the DMA once Half_Full returns. Call it from the
+ * main loop whenever the CPU wakes up: it has one half's time to process a
+ * half before the DMA needs it again.
+ *
+ * @return None.
+ ******************************************************************************/
+extern void ADC_CaptureProcess(void);
+
+
+/******************************************************************************
+ * @brief Number of times the DMA went on into a half that was not processed
+ * yet, since ADC_CaptureInit(...). Each one lost up to halfLength samples.
+ ******************************************************************************/
+extern uint16_t ADC_CaptureOverruns(void);
+
+
+#endif /* ADC_CAPTURE_H_ */
@@ -9,11 +9,63 @@
  * Finally, a Read_ADC() function, where the memory register you have set before is passed as a parameter,
  * is used to return the results. For example, Read_ADC(ADC12_B_MEMORY_0) will return the ADC at P1_3 (as arbitrarily set above)
  *
+ * To sample several pins, ADC_SequenceInit() assigns them consecutive memory registers ending with the
+ * end-of-sequence marker, and ADC_SequenceStart() converts all of them with one trigger. ADC12_ISR below
+ * collects the results at the end of the sequence, so the CPU can sleep in LPM0 while the ADC works.
+ *
+ * The rail monitor (ADC_MonitorInit()) has Timer_A0 convert one rail per period and the window comparator
+ * check every result against that rail's thresholds. The ADC has a single window, so at the end of each
+ * period TA0CCR0 triggers DMA channels 0 and 1, which load the next rail's thresholds into ADC12LO / ADC12HI
+ * from a table. The CPU only runs when a result is outside its window and once per scan, at the end of the
+ * sequence, to collect the results and notice the rails that came back inside.
+ *
  */
 
+#include <stddef.h>
+
+#include <msp430.h>
+
 #include "include/adc12_b.h"
 #include "ADC_Read.h"
 
+#define ADC_MEMORY_COUNT            32
+
+typedef struct sAdcSequenceCtx {
+    void (*Sequence_Done)(void);
+    uint8_t first;                  /**< Index of the first ADC12MEMx of the sequence */
+    uint8_t count;
+    volatile uint8_t ready;         /**< Set by ADC12_ISR, cleared by ADC_SequenceRead() */
+    uint16_t results[ADC_SEQUENCE_MAX_CHANNELS];
+} sAdcSequenceCtx_t;
+
+/** The sequence set up by ADC_SequenceInit(), results written by ADC12_ISR only */
+static sAdcSequenceCtx_t adcSequence = {
+    .Sequence_Done = NULL,
+    .first = 0,
+    .count = 0,
+    .ready = 0
+};
+
+typedef struct sAdcMonitorCtx {
+    void (*Rail_Alarm)(uint8_t rail, uint8_t status);
+    uint8_t first;                  /**< Index of the ADC12MEMx of rails[0] */
+    uint8_t count;
+    uint8_t running;
+    uint8_t seen;                   /**< Bit per rail outside its window during this scan */
+    volatile uint8_t events;        /**< Bit per rail, set by ADC12_ISR, cleared by ADC_MonitorEvents() */
+    uint16_t low[ADC_MONITOR_MAX_RAILS];    /**< DMA0 table, thresholds of the rail after each one */
+    uint16_t high[ADC_MONITOR_MAX_RAILS];   /**< DMA1 table, likewise */
+    uint16_t results[ADC_MONITOR_MAX_RAILS];
+    sAdcMonitorFault_t faults[ADC_MONITOR_MAX_RAILS];
+} sAdcMonitorCtx_t;
+
+/** The monitor set up by ADC_MonitorInit(), results and faults written by ADC12_ISR only */
+static sAdcMonitorCtx_t adcMonitor = {
+    .Rail_Alarm = NULL,
+    .count = 0,
+    .running = 0
+};
+
 void ADC_init_Standard()
 {
     ADC12_B_initParam adcParams = {
@@ -47,8 +99,9 @@ void ADC_PinSelect(ADC_Pin pin, uint8_t memoryBufferIndex){
 }
 
 uint16_t Read_ADC(uint8_t memoryBufferIndex){
+    // ADC12_B_MEMORY_x is the byte offset of ADC12MEMx, the start address is x
     ADC12_B_startConversion(ADC12_B_BASE,
-        ADC12_B_START_AT_ADC12MEM0,
+        memoryBufferIndex >> 1,
         ADC12_B_SINGLECHANNEL);
 
     while (ADC12_B_isBusy(ADC12_B_BASE));
@@ -57,3 +110,405 @@ uint16_t Read_ADC(uint8_t memoryBufferIndex){
 
     return result;
 }
+
+int16_t ADC_SequenceInit(const sAdcSequenceConfig_t *config){
+    uint8_t first = config->firstMemory >> 1;
+    uint8_t i;
+
+    if (config->count == 0 || config->count > ADC_SEQUENCE_MAX_CHANNELS ||
+        first + config->count > ADC_MEMORY_COUNT)
+        return -1; // TODO switch to project defined error flags
+
+    // Memory registers can only be changed with ENC cleared
+    ADC12_B_disableConversions(ADC12_B_BASE, ADC12_B_PREEMPTCONVERSION);
+    ADC12_B_disableInterrupt(ADC12_B_BASE, 0xFFFF, 0xFFFF, 0);
+
+    for (i = 0; i < config->count; i++) {
+        ADC12_B_configureMemoryParam memoryParams = {
+            .memoryBufferControlIndex = (first + i) << 1,
+            .inputSourceSelect = config->pins[i],
+            .refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS,
+            .endOfSequence = (i == config->count - 1) ? ADC12_B_ENDOFSEQUENCE : ADC12_B_NOTENDOFSEQUENCE,
+            .windowComparatorSelect = ADC12_B_WINDOW_COMPARATOR_DISABLE,
+            .differentialModeSelect = ADC12_B_DIFFERENTIAL_MODE_DISABLE
+        };
+
+        ADC12_B_configureMemory(ADC12_B_BASE, &memoryParams);
+    }
+
+    // Each conversion starts as soon as the previous one is done, one trigger runs the sequence
+    ADC12_B_setupSamplingTimer(ADC12_B_BASE,
+        ADC12_B_CYCLEHOLD_16_CYCLES,
+        ADC12_B_CYCLEHOLD_16_CYCLES,
+        ADC12_B_MULTIPLESAMPLESENABLE);
+
+    adcSequence.Sequence_Done = config->Sequence_Done;
+    adcSequence.first = first;
+    adcSequence.count = config->count;
+    adcSequence.ready = 0;
+
+    // Only the end of the sequence interrupts, ADC12IFGx bits are 1 << x
+    i = first + config->count - 1;
+    ADC12_B_clearInterrupt(ADC12_B_BASE, i / 16, (uint16_t)1 << (i % 16));
+    if (i < 16)
+        ADC12_B_enableInterrupt(ADC12_B_BASE, (uint16_t)1 << i, 0, 0);
+    else
+        ADC12_B_enableInterrupt(ADC12_B_BASE, 0, (uint16_t)1 << (i - 16), 0);
+
+    return 0;
+}
+
+void ADC_SequenceStart(uint8_t conversionSequenceModeSelect){
+    adcSequence.ready = 0;
+    ADC12_B_startConversion(ADC12_B_BASE, adcSequence.first, conversionSequenceModeSelect);
+}
+
+void ADC_SequenceStop(void){
+    ADC12_B_disableConversions(ADC12_B_BASE, ADC12_B_PREEMPTCONVERSION);
+}
+
+uint8_t ADC_SequenceReady(void){
+    return adcSequence.ready;
+}
+
+uint8_t ADC_SequenceRead(uint16_t *results){
+    uint8_t count = 0;
+    uint8_t i;
+
+    // A repeated sequence may complete while the results are copied
+    __disable_interrupt();
+    if (adcSequence.ready) {
+        for (i = 0; i < adcSequence.count; i++)
+            results[i] = adcSequence.results[i];
+        count = adcSequence.count;
+        adcSequence.ready = 0;
+    }
+    __enable_interrupt();
+
+    return count;
+}
+
+uint8_t ADC_SampleSequence(uint16_t *results){
+    ADC_SequenceStart(ADC12_B_SEQOFCHANNELS);
+
+    // Interrupts stay off between the check and entering LPM0, so the end of
+    // the sequence cannot slip in between and leave the CPU asleep
+    __disable_interrupt();
+    while (!adcSequence.ready) {
+        __bis_SR_register(LPM0_bits + GIE);
+        __disable_interrupt();
+    }
+    __enable_interrupt();
+
+    return ADC_SequenceRead(results);
+}
+
+int16_t ADC_MonitorInit(const sAdcMonitorConfig_t *config){
+    uint8_t first = config->firstMemory >> 1;
+    uint16_t period;
+    uint8_t i;
+
+    if (config->count == 0 || config->count > ADC_MONITOR_MAX_RAILS || first + config->count > ADC_MEMORY_COUNT ||
+        config->conversionRate < ADC_MONITOR_MIN_RATE || config->conversionRate > ADC_MONITOR_MAX_RATE)
+        return -1; // TODO switch to project defined error flags
+
+    for (i = 0; i < config->count; i++) {
+        if (config->rails[i].low > config->rails[i].high)
+            return -1; // TODO switch to project defined error flags
+    }
+
+    // DMA channel 0 running for someone else: a capture owns the peripherals
+    if (!adcMonitor.running && (DMA0CTL & DMAEN))
+        return -1; // TODO switch to project defined error flags
+
+    ADC_MonitorStop();
+
+    // ADC: one conversion of the next rail per rising edge of TA0.1
+    ADC12_B_initParam adcParams = {
+        .sampleHoldSignalSourceSelect = ADC12_B_SAMPLEHOLDSOURCE_1,
+        .clockSourceSelect = ADC12_B_CLOCKSOURCE_SMCLK,
+        .clockSourceDivider = ADC12_B_CLOCKDIVIDER_1,
+        .clockSourcePredivider = ADC12_B_CLOCKPREDIVIDER__1,
+        .internalChannelMap = ADC12_B_NOINTCH
+    };
+    ADC12_B_init(ADC12_B_BASE, &adcParams);
+    ADC12_B_enable(ADC12_B_BASE);
+    ADC12_B_setupSamplingTimer(ADC12_B_BASE,
+        ADC12_B_CYCLEHOLD_16_CYCLES,
+        ADC12_B_CYCLEHOLD_16_CYCLES,
+        ADC12_B_MULTIPLESAMPLESDISABLE);
+
+    for (i = 0; i < config->count; i++) {
+        const sAdcMonitorRail_t *next = &config->rails[(i + 1 == config->count) ? 0 : i + 1];
+        ADC12_B_configureMemoryParam memoryParams = {
+            .memoryBufferControlIndex = (first + i) << 1,
+            .inputSourceSelect = config->rails[i].pin,
+            .refVoltageSourceSelect = ADC12_B_VREFPOS_AVCC_VREFNEG_VSS,
+            .endOfSequence = (i == config->count - 1) ? ADC12_B_ENDOFSEQUENCE : ADC12_B_NOTENDOFSEQUENCE,
+            .windowComparatorSelect = ADC12_B_WINDOW_COMPARATOR_ENABLE,
+            .differentialModeSelect = ADC12_B_DIFFERENTIAL_MODE_DISABLE
+        };
+
+        ADC12_B_configureMemory(ADC12_B_BASE, &memoryParams);
+
+        // Loaded at the end of rail i's period, for the conversion after it
+        adcMonitor.low[i] = next->low;
+        adcMonitor.high[i] = next->high;
+
+        adcMonitor.results[i] = 0;
+        adcMonitor.faults[i].status = 0;
+        adcMonitor.faults[i].count = 0;
+        adcMonitor.faults[i].peak = 0;
+        adcMonitor.faults[i].trough = 0xFFFF;
+    }
+
+    adcMonitor.Rail_Alarm = config->Rail_Alarm;
+    adcMonitor.first = first;
+    adcMonitor.count = config->count;
+    adcMonitor.seen = 0;
+    adcMonitor.events = 0;
+
+    // Timer_A0 on SMCLK / 64: rising edge of TA0.1 in the middle of every
+    // period, TA0CCR0 at its end
+    period = (uint16_t)(ADC_MONITOR_TIMER_HZ / config->conversionRate);
+    TA0CTL = MC__STOP | TACLR;
+    TA0EX0 = TAIDEX_7;
+    TA0CCR0 = period - 1;
+    TA0CCR1 = period / 2;
+    TA0CCTL1 = OUTMOD_7;
+
+    // DMA channels 0 and 1: one word of each table into ADC12LO / ADC12HI per
+    // TA0CCR0, in repeated single transfer mode so they go round the tables
+    DMACTL0 = (DMACTL0 & ~(DMA0TSEL_31 | DMA1TSEL_31)) | DMA0TSEL__TA0CCR0 | DMA1TSEL__TA0CCR0;
+    DMA0CTL = DMADT_4 | DMASRCINCR_3 | DMADSTINCR_0;
+    DMA1CTL = DMADT_4 | DMASRCINCR_3 | DMADSTINCR_0;
+    __data16_write_addr((unsigned short)(DMA_BASE + OFS_DMA0SA), (unsigned long)adcMonitor.low);
+    __data16_write_addr((unsigned short)(DMA_BASE + OFS_DMA0DA), (unsigned long)(ADC12_B_BASE + OFS_ADC12LO));
+    __data16_write_addr((unsigned short)(DMA_BASE + OFS_DMA1SA), (unsigned long)adcMonitor.high);
+    __data16_write_addr((unsigned short)(DMA_BASE + OFS_DMA1DA), (unsigned long)(ADC12_B_BASE + OFS_ADC12HI));
+    DMA0SZ = config->count;
+    DMA1SZ = config->count;
+
+    return 0;
+}
+
+void ADC_MonitorStart(void){
+    uint8_t last;
+
+    if (adcMonitor.count == 0)
+        return;
+
+    // The first rail's window by hand, the DMA takes over from the second
+    ADC12_B_setWindowCompAdvanced(ADC12_B_BASE, adcMonitor.high[adcMonitor.count - 1], adcMonitor.low[adcMonitor.count - 1]);
+    DMA0CTL |= DMAEN;
+    DMA1CTL |= DMAEN;
+
+    // Excursions raise ADC12HIIFG / ADC12LOIFG, the end of the sequence
+    // interrupts once per scan. ADC12IFGx bits are 1 << x.
+    last = adcMonitor.first + adcMonitor.count - 1;
+    ADC12_B_clearInterrupt(ADC12_B_BASE, 2, ADC12_B_HIIFG | ADC12_B_LOIFG | ADC12_B_INIFG);
+    if (last < 16)
+        ADC12_B_enableInterrupt(ADC12_B_BASE, (uint16_t)1 << last, 0, ADC12_B_HIIE | ADC12_B_LOIE);
+    else
+        ADC12_B_enableInterrupt(ADC12_B_BASE, 0, (uint16_t)1 << (last - 16), ADC12_B_HIIE | ADC12_B_LOIE);
+
+    adcMonitor.seen = 0;
+    adcMonitor.running = 1;
+    ADC12_B_startConversion(ADC12_B_BASE, adcMonitor.first, ADC12_B_REPEATED_SEQOFCHANNELS);
+    TA0CTL = TASSEL__SMCLK | ID__8 | MC__UP | TACLR;
+}
+
+void ADC_MonitorStop(void){
+    uint8_t last = adcMonitor.first + adcMonitor.count - 1;
+
+    if (!adcMonitor.running)
+        return;
+
+    TA0CTL = MC__STOP;
+    ADC12_B_disableConversions(ADC12_B_BASE, ADC12_B_PREEMPTCONVERSION);
+    DMA0CTL &= ~DMAEN;
+    DMA1CTL &= ~DMAEN;
+    if (last < 16)
+        ADC12_B_disableInterrupt(ADC12_B_BASE, (uint16_t)1 << last, 0, ADC12_B_HIIE | ADC12_B_LOIE);
+    else
+        ADC12_B_disableInterrupt(ADC12_B_BASE, 0, (uint16_t)1 << (last - 16), ADC12_B_HIIE | ADC12_B_LOIE);
+    adcMonitor.running = 0;
+}
+
+uint8_t ADC_MonitorRunning(void){
+    return adcMonitor.running;
+}
+
+uint8_t ADC_MonitorEvents(void){
+    uint8_t events;
+
+    __disable_interrupt();
+    events = adcMonitor.events;
+    adcMonitor.events = 0;
+    __enable_interrupt();
+
+    return events;
+}
+
+uint8_t ADC_MonitorRead(uint16_t *results){
+    uint8_t i;
+
+    __disable_interrupt();
+    for (i = 0; i < adcMonitor.count; i++)
+        results[i] = adcMonitor.results[i];
+    __enable_interrupt();
+
+    return adcMonitor.count;
+}
+
+uint8_t ADC_MonitorReadFaults(sAdcMonitorFault_t *faults, uint8_t clear){
+    uint8_t i;
+
+    __disable_interrupt();
+    for (i = 0; i < adcMonitor.count; i++) {
+        sAdcMonitorFault_t *fault = &adcMonitor.faults[i];
+
+        faults[i] = *fault;
+        if (!clear)
+            continue;
+
+        // A rail still outside stays latched, from its last result
+        fault->status &= ADC_MONITOR_ABOVE | ADC_MONITOR_BELOW;
+        fault->count = 0;
+        fault->peak = 0;
+        fault->trough = 0xFFFF;
+        if (fault->status & ADC_MONITOR_ABOVE) {
+            fault->status |= ADC_MONITOR_HIGH;
+            fault->peak = adcMonitor.results[i];
+        }
+        if (fault->status & ADC_MONITOR_BELOW) {
+            fault->status |= ADC_MONITOR_LOW;
+            fault->trough = adcMonitor.results[i];
+        }
+    }
+    __enable_interrupt();
+
+    return adcMonitor.count;
+}
+
+uint8_t ADC_MonitorReport(uint8_t *buffer, uint8_t clear){
+    sAdcMonitorFault_t faults[ADC_MONITOR_MAX_RAILS];
+    uint8_t count = ADC_MonitorReadFaults(faults, clear);
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+        buffer[0] = faults[i].status;
+        buffer[1] = faults[i].count;
+        buffer[2] = (uint8_t)faults[i].peak;
+        buffer[3] = (uint8_t)(faults[i].peak >> 8);
+        buffer[4] = (uint8_t)faults[i].trough;
+        buffer[5] = (uint8_t)(faults[i].trough >> 8);
+        buffer += ADC_MONITOR_REPORT_SIZE;
+    }
+
+    return count * ADC_MONITOR_REPORT_SIZE;
+}
+
+// A result crossed the window, ADC12HIIFG or ADC12LOIFG. The end of scan
+// reads every result, so the rail just converted is the highest one whose
+// ADC12IFGx is still set.
+static void MonitorExcursion(uint8_t side){
+    uint32_t flags = (((uint32_t)ADC12IFGR1 << 16) | ADC12IFGR0) >> adcMonitor.first;
+    uint8_t rail = adcMonitor.count - 1;
+    sAdcMonitorFault_t *fault;
+
+    while (rail > 0 && !(flags & ((uint32_t)1 << rail)))
+        rail--;
+    fault = &adcMonitor.faults[rail];
+    adcMonitor.seen |= 1 << rail;
+
+    // Still outside on the same side, the excursion goes on
+    if (fault->status & side)
+        return;
+
+    fault->status &= ~(ADC_MONITOR_ABOVE | ADC_MONITOR_BELOW);
+    fault->status |= side | ((side == ADC_MONITOR_ABOVE) ? ADC_MONITOR_HIGH : ADC_MONITOR_LOW);
+    if (fault->count < 0xFF)
+        fault->count++;
+    adcMonitor.events |= 1 << rail;
+
+    if (adcMonitor.Rail_Alarm != NULL)
+        adcMonitor.Rail_Alarm(rail, fault->status);
+}
+
+// End of a scan: keep the results, track the peaks of the rails outside and
+// close the excursions of the ones that were not seen outside this time
+static void MonitorScan(void){
+    uint8_t rail;
+
+    for (rail = 0; rail < adcMonitor.count; rail++) {
+        sAdcMonitorFault_t *fault = &adcMonitor.faults[rail];
+        uint16_t result = ADC12_B_getResults(ADC12_B_BASE, (adcMonitor.first + rail) << 1);
+
+        adcMonitor.results[rail] = result;
+        if (!(adcMonitor.seen & (1 << rail)))
+            fault->status &= ~(ADC_MONITOR_ABOVE | ADC_MONITOR_BELOW);
+        else if ((fault->status & ADC_MONITOR_ABOVE) && result > fault->peak)
+            fault->peak = result;
+        else if ((fault->status & ADC_MONITOR_BELOW) && result < fault->trough)
+            fault->trough = result;
+    }
+    adcMonitor.seen = 0;
+}
+
+//******************************************************************************
+// ADC12 Interrupt *************************************************************
+//******************************************************************************
+
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = ADC12_VECTOR
+__interrupt void ADC12_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__ ((interrupt(ADC12_VECTOR))) ADC12_ISR (void)
+#else
+#error Compiler not supported!
+#endif
+{
+    uint16_t vector = __even_in_range(ADC12IV, ADC12IV_ADC12RDYIFG);
+    uint8_t mem;
+    uint8_t i;
+
+    switch (vector)
+    {
+        case ADC12IV_NONE:        break;        // Vector  0: No interrupt
+        case ADC12IV_ADC12OVIFG:  break;        // Vector  2: ADC12MEMx overwritten before it was read
+        case ADC12IV_ADC12TOVIFG: break;        // Vector  4: Conversion time overflow
+        case ADC12IV_ADC12HIIFG:                // Vector  6: ADC12BHI, a rail is above its window
+            ADC12_B_clearInterrupt(ADC12_B_BASE, 2, ADC12_B_HIIFG);
+            MonitorExcursion(ADC_MONITOR_ABOVE);
+            if (adcMonitor.events)
+                __bic_SR_register_on_exit(LPM3_bits);   // -> Wake the main loop, from LPM0 or LPM3
+            break;
+        case ADC12IV_ADC12LOIFG:                // Vector  8: ADC12BLO, a rail is below its window
+            ADC12_B_clearInterrupt(ADC12_B_BASE, 2, ADC12_B_LOIFG);
+            MonitorExcursion(ADC_MONITOR_BELOW);
+            if (adcMonitor.events)
+                __bic_SR_register_on_exit(LPM3_bits);   // -> Wake the main loop, from LPM0 or LPM3
+            break;
+        case ADC12IV_ADC12INIFG:  break;        // Vector 10: ADC12BIN
+        case ADC12IV_ADC12RDYIFG: break;        // Vector 76: ADC12RDY
+        default:                                // Vectors 12..74: ADC12MEMx
+            mem = (vector - ADC12IV_ADC12IFG0) >> 1;
+            if (adcMonitor.running && mem == adcMonitor.first + adcMonitor.count - 1) {
+                MonitorScan();
+                break;
+            }
+
+            // Only the end of the sequence is enabled. Reading the results
+            // clears their ADC12IFGx, a repeated sequence then does not overflow
+            for (i = 0; i < adcSequence.count; i++)
+                adcSequence.results[i] = ADC12_B_getResults(ADC12_B_BASE, (adcSequence.first + i) << 1);
+            adcSequence.ready = 1;
+
+            if (adcSequence.Sequence_Done != NULL)
+                adcSequence.Sequence_Done();
+
+            __bic_SR_register_on_exit(LPM3_bits);   // -> Wake the main loop, from LPM0 or LPM3
+            break;
+    }
+}
@@ -3,6 +3,22 @@
 
 #include "include/adc12_b.h"
 
+#ifndef ADC_SEQUENCE_MAX_CHANNELS
+#define ADC_SEQUENCE_MAX_CHANNELS   8   /**< Channels one ADC_SequenceInit() sequence can hold */
+#endif
+
+#define ADC_MONITOR_MAX_RAILS       8           /**< Rails one ADC_MonitorInit() monitor can watch */
+#define ADC_MONITOR_TIMER_HZ        250000UL    /**< Timer_A0 clock, 16 MHz SMCLK divided by 8 and 8 */
+#define ADC_MONITOR_MIN_RATE        4           /**< Conversions per second, the 16-bit timer period limit */
+#define ADC_MONITOR_MAX_RATE        10000       /**< Conversions per second */
+#define ADC_MONITOR_REPORT_SIZE     6           /**< Bytes per rail written by ADC_MonitorReport() */
+
+// sAdcMonitorFault_t status bits
+#define ADC_MONITOR_HIGH            0x01        /**< Latched: went above the window since the last clear */
+#define ADC_MONITOR_LOW             0x02        /**< Latched: went below the window since the last clear */
+#define ADC_MONITOR_ABOVE           0x04        /**< Last conversion was above the window */
+#define ADC_MONITOR_BELOW           0x08        /**< Last conversion was below the window */
+
 /******************************************************************************
  * @brief Used in the ADC_PinSelect() function as the pin parameter.
  ******************************************************************************/
@@ -71,9 +87,238 @@ extern void ADC_PinSelect(ADC_Pin pin, uint8_t memoryBufferIndex);
  *        "ADC12_B_MEMORY_x" (where 0 <= x <= 31), configured earlier
  *        via ADC_PinSelect(...).
  *
+ * The conversion starts at the given memory index, so every pin set up with
+ * ADC_PinSelect(...) can be read, not just ADC12_B_MEMORY_0. The CPU polls
+ * until it is done: use the sequence functions below to sample several pins.
+ *
  * @return A 16-bit unsigned integer representing the digital value.
  ******************************************************************************/
 extern uint16_t Read_ADC(uint8_t memoryBufferIndex);
 
 
+/******************************************************************************
+ * @brief Pins sampled together by one ADC sequence.
+ ******************************************************************************/
+typedef struct sAdcSequenceConfig {
+    const ADC_Pin *pins;            /**< Pins in conversion order */
+    uint8_t count;                  /**< Number of pins, 1..ADC_SEQUENCE_MAX_CHANNELS */
+    uint8_t firstMemory;            /**< ADC12_B_MEMORY_x of pins[0], the others follow it */
+    void (*Sequence_Done)(void);    /**< Called from ADC12_ISR once a sequence is read, may be NULL */
+} sAdcSequenceConfig_t;
+
+
+/******************************************************************************
+ * @brief Sets up a sequence of channels, converted with a single trigger.
+ *
+ * pins[i] is assigned to the memory register after firstMemory + i, and the
+ * last one is marked as the end of the sequence. Only that register raises an
+ * interrupt: ADC12_ISR copies the whole sequence out and wakes the CPU from
+ * LPM0, so nothing polls the ADC while it converts. The sampling timer is set
+ * to convert the next channel as soon as the previous one is done.
+ *
+ * Call after ADC_init_Standard(). It stops any conversion in progress.
+ *
+ * @param config
+ *        The pins to sample. It is copied, so it does not have to stay in
+ *        memory after the call.
+ *
+ * @return 0 on success, -1 if the sequence is empty, too long or does not fit
+ *         in the 32 memory registers.
+ ******************************************************************************/
+extern int16_t ADC_SequenceInit(const sAdcSequenceConfig_t *config);
+
+
+/******************************************************************************
+ * @brief Starts the sequence set up by ADC_SequenceInit(...).
+ *
+ * @param conversionSequenceModeSelect
+ *        ADC12_B_SEQOFCHANNELS to sample every pin once, or
+ *        ADC12_B_REPEATED_SEQOFCHANNELS to sample them again and again until
+ *        ADC_SequenceStop(). Each completed sequence replaces the results.
+ *
+ * @return None.
+ ******************************************************************************/
+extern void ADC_SequenceStart(uint8_t conversionSequenceModeSelect);
+
+
+/******************************************************************************
+ * @brief Stops a repeated sequence at once, discarding the one in progress.
+ *
+ * @return None.
+ ******************************************************************************/
+extern void ADC_SequenceStop(void);
+
+
+/******************************************************************************
+ * @brief Tells if a completed sequence has not been read yet.
+ *
+ * @return Non-zero once ADC12_ISR has stored a sequence, until
+ *         ADC_SequenceRead(...) takes it.
+ ******************************************************************************/
+extern uint8_t ADC_SequenceReady(void);
+
+
+/******************************************************************************
+ * @brief Copies the last completed sequence.
+ *
+ * @param results
+ *        Receives one 12-bit value per pin, in the order of the pins in the
+ *        sequence configuration.
+ *
+ * @return The number of values copied, 0 if no sequence completed since the
+ *         last call.
+ ******************************************************************************/
+extern uint8_t ADC_SequenceRead(uint16_t *results);
+
+
+/******************************************************************************
+ * @brief Samples every pin of the sequence once and waits for the results.
+ *
+ * The CPU stays in LPM0 until ADC12_ISR reports the end of the sequence. The
+ * ADC interrupt must not be masked by the caller.
+ *
+ * @param results
+ *        Receives one 12-bit value per pin, as for ADC_SequenceRead(...).
+ *
+ * @return The number of values copied.
+ ******************************************************************************/
+extern uint8_t ADC_SampleSequence(uint16_t *results);
+
+
+/******************************************************************************
+ * @brief One rail of the window comparator monitor and its alarm thresholds.
+ *
+ * Results above high or below low are excursions. Use 4095 or 0 to leave a
+ * side unchecked.
+ ******************************************************************************/
+typedef struct sAdcMonitorRail {
+    ADC_Pin pin;
+    uint16_t low;                   /**< Lowest 12-bit result still inside the window */
+    uint16_t high;                  /**< Highest 12-bit result still inside the window */
+} sAdcMonitorRail_t;
+
+typedef struct sAdcMonitorConfig {
+    const sAdcMonitorRail_t *rails;
+    uint8_t count;                  /**< Number of rails, 1..ADC_MONITOR_MAX_RAILS */
+    uint8_t firstMemory;            /**< ADC12_B_MEMORY_x of rails[0], the others follow it */
+    uint16_t conversionRate;        /**< Conversions per second, each rail gets conversionRate / count */
+    void (*Rail_Alarm)(uint8_t rail, uint8_t status);  /**< Called from ADC12_ISR when an excursion starts, may be NULL */
+} sAdcMonitorConfig_t;
+
+/******************************************************************************
+ * @brief Latched fault table entry of one rail.
+ ******************************************************************************/
+typedef struct sAdcMonitorFault {
+    uint8_t status;                 /**< ADC_MONITOR_* bits */
+    uint8_t count;                  /**< Excursions since the last clear, saturates at 255 */
+    uint16_t peak;                  /**< Highest result above the window, valid with ADC_MONITOR_HIGH */
+    uint16_t trough;                /**< Lowest result below the window, valid with ADC_MONITOR_LOW */
+} sAdcMonitorFault_t;
+
+
+/******************************************************************************
+ * @brief Sets up the rail monitor on the ADC12_B window comparator.
+ *
+ * Timer_A0 triggers one conversion every 1 / conversionRate seconds, walking
+ * through the rails in a repeated sequence. The ADC compares each result with
+ * the window in ADC12HI / ADC12LO in hardware, and DMA channels 0 and 1 load
+ * the next rail's thresholds between conversions, as the ADC12_B has a single
+ * window for every channel.
+ *
+ * ADC12_ISR runs once per scan of every rail, and for each result outside its
+ * window. Only the start of an excursion wakes the main loop.
+ *
+ * Takes over the ADC, Timer_A0 and DMA channels 0 and 1, like
+ * ADC_CaptureInit(...): only one of them runs at a time, so this fails while
+ * a capture runs, ADC_CaptureStop() first. Read_ADC(...) or a sequence need
+ * ADC_init_Standard() again once the monitor is stopped.
+ *
+ * @param config
+ *        The rails to watch. It is copied, so it does not have to stay in
+ *        memory after the call.
+ *
+ * @return 0 on success, -1 if the rails, their thresholds or the rate are out
+ *         of range, or another driver has DMA channel 0 running.
+ ******************************************************************************/
+extern int16_t ADC_MonitorInit(const sAdcMonitorConfig_t *config);
+
+
+/******************************************************************************
+ * @brief Starts the monitor set up by ADC_MonitorInit(...). The fault table
+ * is kept.
+ *
+ * @return None.
+ ******************************************************************************/
+extern void ADC_MonitorStart(void);
+
+
+/******************************************************************************
+ * @brief Stops the monitor timer and conversions.
+ *
+ * @return None.
+ ******************************************************************************/
+extern void ADC_MonitorStop(void);
+
+
+/******************************************************************************
+ * @brief Tells if the monitor is converting.
+ *
+ * @return Non-zero between ADC_MonitorStart() and ADC_MonitorStop().
+ ******************************************************************************/
+extern uint8_t ADC_MonitorRunning(void);
+
+
+/******************************************************************************
+ * @brief Takes the rails whose excursion started since the last call.
+ *
+ * Each excursion is reported once, when the rail leaves its window. It has to
+ * come back inside before it can raise another one.
+ *
+ * @return Bit per rail, bit i for rails[i].
+ ******************************************************************************/
+extern uint8_t ADC_MonitorEvents(void);
+
+
+/******************************************************************************
+ * @brief Copies the last result of every rail, at most one scan old.
+ *
+ * @param results
+ *        Receives one 12-bit value per rail, in the order of the rails in the
+ *        monitor configuration.
+ *
+ * @return The number of values copied.
+ ******************************************************************************/
+extern uint8_t ADC_MonitorRead(uint16_t *results);
+
+
+/******************************************************************************
+ * @brief Copies the latched fault table.
+ *
+ * @param faults
+ *        Receives one entry per rail.
+ *
+ * @param clear
+ *        Non-zero to clear the latches once copied, in the same critical
+ *        section so no excursion is lost. A rail that is still outside its
+ *        window stays latched.
+ *
+ * @return The number of entries copied.
+ ******************************************************************************/
+extern uint8_t ADC_MonitorReadFaults(sAdcMonitorFault_t *faults, uint8_t clear);
+
+
+/******************************************************************************
+ * @brief Packs the fault table for telemetry.
+ *
+ * ADC_MONITOR_REPORT_SIZE bytes per rail, in rail order: status, excursion
+ * count, peak and trough as 16-bit little endian values.
+ *
+ * @param clear
+ *        As for ADC_MonitorReadFaults(...).
+ *
+ * @return The number of bytes written.
+ ******************************************************************************/
+extern uint8_t ADC_MonitorReport(uint8_t *buffer, uint8_t clear);
+
+
 #endif /* ADC_READ_H_ */
@@ -0,0 +1,195 @@
+/*
+ * Streaming statistics and decimation of 12-bit ADC samples, so telemetry can carry a summary of a
+ * channel at any sampling rate instead of the raw samples.
+ *
+ * Per sample only integer additions and one 16 x 16 bit multiply (the square for the RMS) are done.
+ * ADC_StatsAddBlock() keeps its partial sums in 32 bits: 256 squares of 4095 still fit, and the 64-bit
+ * total is only touched once per 256 samples. Divisions and the square root are left to the moment the
+ * mean and RMS are read.
+ *
+ * The decimator is a boxcar (order 1) or CIC filter with 2^rateShift decimation. Its integrators and combs
+ * work modulo 2^32, which gives the exact result as long as the output fits in 32 bits.
+ *
+ */
+
+#include "ADC_Stats.h"
+
+#define ADC_STATS_BLOCK             256     /**< Samples whose sum of squares fits in 32 bits */
+#define ADC_STATS_FRACTION_BITS     4       /**< Mean, RMS and decimator outputs are 12.4 fixed point */
+
+void ADC_StatsReset(sAdcStats_t *stats){
+    stats->min = 0xFFFF;
+    stats->max = 0;
+    stats->count = 0;
+    stats->sum = 0;
+    stats->sumSquares = 0;
+}
+
+void ADC_StatsAdd(sAdcStats_t *stats, uint16_t sample){
+    if (stats->count == ADC_STATS_MAX_COUNT)
+        return;
+
+    if (sample < stats->min)
+        stats->min = sample;
+    if (sample > stats->max)
+        stats->max = sample;
+    stats->sum += sample;
+    stats->sumSquares += (uint32_t)sample * sample;
+    stats->count++;
+}
+
+void ADC_StatsAddBlock(sAdcStats_t *stats, const uint16_t *samples, uint16_t count){
+    uint16_t min = stats->min;
+    uint16_t max = stats->max;
+
+    while (count > 0 && stats->count < ADC_STATS_MAX_COUNT) {
+        uint16_t n = ADC_STATS_MAX_COUNT - stats->count;
+        uint32_t sum = 0;
+        uint32_t squares = 0;
+        uint16_t i;
+
+        if (n > count)
+            n = count;
+        if (n > ADC_STATS_BLOCK)
+            n = ADC_STATS_BLOCK;
+
+        for (i = 0; i < n; i++) {
+            uint16_t sample = samples[i];
+
+            if (sample < min)
+                min = sample;
+            if (sample > max)
+                max = sample;
+            sum += sample;
+            squares += (uint32_t)sample * sample;
+        }
+
+        stats->sum += sum;
+        stats->sumSquares += squares;
+        stats->count += n;
+        samples += n;
+        count -= n;
+    }
+
+    stats->min = min;
+    stats->max = max;
+}
+
+uint16_t ADC_StatsMean(const sAdcStats_t *stats){
+    if (stats->count == 0)
+        return 0;
+
+    // 0xFFFF samples of 4095, times 16, still fit in 32 bits
+    return (uint16_t)(((stats->sum << ADC_STATS_FRACTION_BITS) + stats->count / 2) / stats->count);
+}
+
+// Square root rounded to the nearest integer, one result bit per iteration
+static uint16_t SquareRoot(uint32_t value){
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value)
+        bit >>= 2;
+
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    // value now holds value - root^2, round up past root + 1/2
+    if (value > root)
+        root++;
+    return (uint16_t)root;
+}
+
+uint16_t ADC_StatsRms(const sAdcStats_t *stats){
+    uint32_t meanSquare;
+
+    if (stats->count == 0)
+        return 0;
+
+    // Mean square in 1/256 of a code squared: below 4096^2 * 256, 32 bits
+    meanSquare = (uint32_t)(((stats->sumSquares << (2 * ADC_STATS_FRACTION_BITS)) + stats->count / 2) /
+                            stats->count);
+    return SquareRoot(meanSquare);
+}
+
+static uint8_t *PutValue(uint8_t *buffer, uint16_t value){
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+    return buffer + 2;
+}
+
+uint8_t ADC_StatsSummary(const sAdcStats_t *stats, uint8_t *buffer){
+    uint8_t *p = buffer;
+
+    p = PutValue(p, stats->count ? stats->min : 0);
+    p = PutValue(p, stats->max);
+    p = PutValue(p, ADC_StatsMean(stats));
+    p = PutValue(p, ADC_StatsRms(stats));
+    p = PutValue(p, stats->count);
+
+    return (uint8_t)(p - buffer);
+}
+
+int16_t ADC_DecimatorInit(sAdcDecimator_t *decimator, uint8_t order, uint8_t rateShift){
+    uint8_t k;
+
+    if (order == 0 || order > ADC_DECIMATOR_MAX_ORDER || rateShift == 0 || rateShift > ADC_DECIMATOR_MAX_SHIFT ||
+        12 + order * rateShift > 32)
+        return -1; // TODO switch to project defined error flags
+
+    for (k = 0; k < ADC_DECIMATOR_MAX_ORDER; k++) {
+        decimator->integrator[k] = 0;
+        decimator->comb[k] = 0;
+    }
+    decimator->order = order;
+    decimator->rateShift = rateShift;
+    decimator->phase = 0;
+
+    return 0;
+}
+
+uint16_t ADC_DecimatorRun(sAdcDecimator_t *decimator, const uint16_t *samples, uint16_t count,
+                          uint16_t *output){
+    uint8_t gainBits = decimator->order * decimator->rateShift;
+    uint16_t ratio = 1U << decimator->rateShift;
+    uint16_t written = 0;
+    uint16_t i;
+    uint8_t k;
+
+    for (i = 0; i < count; i++) {
+        uint32_t value = samples[i];
+
+        // Integrators at the input rate
+        for (k = 0; k < decimator->order; k++) {
+            decimator->integrator[k] += value;
+            value = decimator->integrator[k];
+        }
+
+        if (++decimator->phase < ratio)
+            continue;
+        decimator->phase = 0;
+
+        // Combs at the output rate
+        for (k = 0; k < decimator->order; k++) {
+            uint32_t previous = decimator->comb[k];
+            decimator->comb[k] = value;
+            value -= previous;
+        }
+
+        // Remove the 2^(order * rateShift) gain, keep 4 fraction bits
+        if (gainBits > ADC_STATS_FRACTION_BITS)
+            value = (value + (1UL << (gainBits - ADC_STATS_FRACTION_BITS - 1))) >> (gainBits - ADC_STATS_FRACTION_BITS);
+        else
+            value <<= ADC_STATS_FRACTION_BITS - gainBits;
+        output[written++] = (uint16_t)value;
+    }
+
+    return written;
+}
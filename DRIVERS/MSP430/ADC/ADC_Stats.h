@@ -0,0 +1,123 @@
+#ifndef ADC_STATS_H_
+#define ADC_STATS_H_
+
+#include <stdint.h>
+
+#define ADC_STATS_MAX_COUNT         0xFFFF  /**< Samples one window can hold, later ones are not counted */
+#define ADC_STATS_SUMMARY_SIZE      10      /**< Bytes written by ADC_StatsSummary() */
+#define ADC_DECIMATOR_MAX_ORDER     3
+#define ADC_DECIMATOR_MAX_SHIFT     15      /**< Largest ratio the 16-bit phase counts, 32768:1 */
+
+/******************************************************************************
+ * @brief Running statistics of one channel's 12-bit samples.
+ *
+ * Only integer additions and 16 x 16 bit multiplies are done per sample, which
+ * the MPY32 takes in hardware. Mean and RMS are worked out when they are read,
+ * normally once per telemetry period.
+ ******************************************************************************/
+typedef struct sAdcStats {
+    uint16_t min;
+    uint16_t max;
+    uint16_t count;
+    uint32_t sum;                   /**< Fits 0xFFFF samples of 4095 */
+    uint64_t sumSquares;
+} sAdcStats_t;
+
+/******************************************************************************
+ * @brief Boxcar (order 1) or CIC (order 2..3) decimator.
+ *
+ * Keeps one output every 2^rateShift input samples. The integrators and
+ * combs wrap around in 32 bits, which is exact for 12-bit samples as long as
+ * 12 + order * rateShift <= 32.
+ ******************************************************************************/
+typedef struct sAdcDecimator {
+    uint32_t integrator[ADC_DECIMATOR_MAX_ORDER];
+    uint32_t comb[ADC_DECIMATOR_MAX_ORDER];     /**< Previous input of each comb stage */
+    uint8_t order;
+    uint8_t rateShift;
+    uint16_t phase;                 /**< Input samples since the last output */
+} sAdcDecimator_t;
+
+
+/******************************************************************************
+ * @brief Empties a statistics window.
+ ******************************************************************************/
+extern void ADC_StatsReset(sAdcStats_t *stats);
+
+
+/******************************************************************************
+ * @brief Adds one 12-bit sample, ADC_SequenceRead(...) results for example.
+ ******************************************************************************/
+extern void ADC_StatsAdd(sAdcStats_t *stats, uint16_t sample);
+
+
+/******************************************************************************
+ * @brief Adds a block of 12-bit samples of one channel, such as a half of the
+ * ADC_Capture.h buffer.
+ *
+ * Cheaper per sample than ADC_StatsAdd(...): the sums stay in 32-bit
+ * registers for up to 256 samples at a time.
+ ******************************************************************************/
+extern void ADC_StatsAddBlock(sAdcStats_t *stats, const uint16_t *samples, uint16_t count);
+
+
+/******************************************************************************
+ * @brief Mean of the window, in 1/16 of an ADC code (12.4 fixed point).
+ *
+ * @return 0 for an empty window.
+ ******************************************************************************/
+extern uint16_t ADC_StatsMean(const sAdcStats_t *stats);
+
+
+/******************************************************************************
+ * @brief Root mean square of the window, in 1/16 of an ADC code (12.4 fixed point).
+ *
+ * @return 0 for an empty window.
+ ******************************************************************************/
+extern uint16_t ADC_StatsRms(const sAdcStats_t *stats);
+
+
+/******************************************************************************
+ * @brief Writes the compact summary sent in telemetry instead of the samples.
+ *
+ * ADC_STATS_SUMMARY_SIZE bytes, 16-bit little endian values: minimum,
+ * maximum, mean (12.4), RMS (12.4), sample count.
+ *
+ * @return The number of bytes written.
+ ******************************************************************************/
+extern uint8_t ADC_StatsSummary(const sAdcStats_t *stats, uint8_t *buffer);
+
+
+/******************************************************************************
+ * @brief Sets up a decimator and clears its state.
+ *
+ * @param order
+ *        1 for a boxcar average, 2 or 3 for a CIC filter.
+ *
+ * @param rateShift
+ *        Decimation ratio as a power of two, 1..(32 - 12) / order and at
+ *        most ADC_DECIMATOR_MAX_SHIFT.
+ *
+ * @return 0 on success, -1 if the order or ratio is out of range.
+ ******************************************************************************/
+extern int16_t ADC_DecimatorInit(sAdcDecimator_t *decimator, uint8_t order, uint8_t rateShift);
+
+
+/******************************************************************************
+ * @brief Runs a block of 12-bit samples through the decimator.
+ *
+ * The filter state carries over from one block to the next, blocks do not
+ * have to be a multiple of the ratio.
+ *
+ * @param output
+ *        Receives one value per 2^rateShift inputs, scaled back to the input
+ *        range in 1/16 of an ADC code (12.4 fixed point). It needs room for
+ *        count / 2^rateShift + 1 values.
+ *
+ * @return The number of values written to output.
+ ******************************************************************************/
+extern uint16_t ADC_DecimatorRun(sAdcDecimator_t *decimator, const uint16_t *samples, uint16_t count,
+                                 uint16_t *output);
+
+
+#endif /* ADC_STATS_H_ */
@@ -0,0 +1,145 @@
+/*
+ * Calibrated conversion of 12-bit ADC codes to engineering units (mV, mA) without floating point.
+ *
+ * A code goes through the ADC gain and offset from the TLV table, the reference factor, the reference
+ * voltage and the board's divider or amplifier. All of it but the offset is one multiplication, so
+ * ADC_UnitsInit() folds the chain into a Q15 mantissa and a shift, and the offset into a bias, with 64-bit
+ * arithmetic once. Converting is then one 16 x 16 bit multiply per code.
+ *
+ * The scale is rounded to 15 significant bits, a relative error of at most 2^-15. At full scale that is
+ * under a quarter of a unit as long as the channel's full scale is under 8192 units, so results are the
+ * exactly rounded value or one away from it.
+ *
+ */
+
+#include <msp430.h>
+
+#include "include/adc12_b.h"
+#include "ADC_Units.h"
+
+#define ADC_UNITS_Q15_ONE           0x8000u
+#define ADC_UNITS_CODE_BITS         12
+#define ADC_UNITS_CHAIN_BITS        (2 * 15 + ADC_UNITS_CODE_BITS)  /**< gain and refFactor Q15, code / 4096 */
+
+static const uint16_t refMillivolts[] = {0, 1200, 2000, 2500};
+
+// Rounds n / d to the nearest integer, halves away from zero
+static int64_t DivideRounded(int64_t n, uint64_t d){
+    if (n < 0)
+        return -(int64_t)(((uint64_t)-n + d / 2) / d);
+    return (int64_t)(((uint64_t)n + d / 2) / d);
+}
+
+int16_t ADC_CalibrationRead(sAdcCalibration_t *calibration, uint8_t reference, uint16_t avccMillivolts){
+    uint8_t found = (reference == ADC_UNITS_REF_AVCC) ? TLV_REFCAL : 0;
+    uint16_t address = TLV_START;
+
+    calibration->gain = ADC_UNITS_Q15_ONE;
+    calibration->offset = 0;
+    calibration->refFactor = ADC_UNITS_Q15_ONE;
+    if (reference > ADC_UNITS_REF_2V5) {
+        calibration->refMillivolts = 0;
+        return -1; // TODO switch to project defined error flags
+    }
+    calibration->refMillivolts = (reference == ADC_UNITS_REF_AVCC) ? avccMillivolts : refMillivolts[reference];
+
+    // Tag and length bytes, then the record. Erased or unprogrammed memory ends the walk.
+    while (address + 2 <= TLV_END) {
+        uint8_t tag = HWREG8(address);
+        uint8_t length = HWREG8(address + 1);
+
+        if (tag == 0xFF || length == 0 || address + 2 + length > TLV_END + 1)
+            break;
+
+        if (tag == TLV_ADC12CAL && length >= 4) {
+            calibration->gain = HWREG16(address + 2);
+            calibration->offset = (int16_t)HWREG16(address + 4);
+            found |= TLV_ADC12CAL;
+        }
+        else if (tag == TLV_REFCAL && reference != ADC_UNITS_REF_AVCC && length >= 2 * reference) {
+            calibration->refFactor = HWREG16(address + 2 * reference);
+            found |= TLV_REFCAL;
+        }
+        address += 2 + length;
+    }
+
+    if (found != (TLV_ADC12CAL | TLV_REFCAL))
+        return -1; // TODO switch to project defined error flags
+
+    return 0;
+}
+
+int16_t ADC_UnitsInit(sAdcUnits_t *units, const sAdcCalibration_t *calibration,
+                      const sAdcUnitsChannel_t *channel){
+    uint64_t chain;
+    uint32_t scale = 0;
+    int64_t bias;
+    int8_t shift;
+
+    if (channel->divider == 0 || calibration->refMillivolts > ADC_UNITS_MAX_REF_MV)
+        return -1; // TODO switch to project defined error flags
+
+    // Units per code = chain / (divider * 2^ADC_UNITS_CHAIN_BITS), below 2^60 with every factor in range
+    chain = (uint64_t)calibration->refMillivolts * calibration->gain * calibration->refFactor *
+            channel->multiplier;
+
+    // Largest shift that keeps the mantissa in 15 bits
+    for (shift = ADC_UNITS_MAX_SHIFT; shift >= 0; shift--) {
+        uint64_t d = (uint64_t)channel->divider << (ADC_UNITS_CHAIN_BITS - shift);
+
+        scale = (uint32_t)((chain + d / 2) / d);
+        if (scale <= 0x7FFF)
+            break;
+    }
+    if (shift < 0 || scale == 0)
+        return -1; // TODO switch to project defined error flags
+
+    // The ADC offset is in codes after the gain, it only goes through the reference and the channel
+    bias = (int64_t)calibration->offset * calibration->refMillivolts * calibration->refFactor * channel->multiplier;
+    if (shift <= 15 + ADC_UNITS_CODE_BITS)
+        bias = DivideRounded(bias, (uint64_t)channel->divider << (15 + ADC_UNITS_CODE_BITS - shift));
+    else
+        bias = DivideRounded(bias * ((int64_t)1 << (shift - 15 - ADC_UNITS_CODE_BITS)), channel->divider);
+    if (shift > 0)
+        bias += (int64_t)1 << (shift - 1);
+    if (bias > 0x3FFFFFFF || bias < -0x40000000)
+        return -1; // TODO switch to project defined error flags
+
+    units->scale = (uint16_t)scale;
+    units->shift = (uint8_t)shift;
+    units->bias = (int32_t)bias;
+    units->offset = channel->offset;
+    return 0;
+}
+
+static inline int16_t Saturate(int32_t value){
+    if (value > 32767)
+        return 32767;
+    if (value < -32768)
+        return -32768;
+    return (int16_t)value;
+}
+
+int16_t ADC_UnitsConvert(const sAdcUnits_t *units, uint16_t code){
+    return Saturate((((int32_t)((uint32_t)code * units->scale) + units->bias) >> units->shift) + units->offset);
+}
+
+void ADC_UnitsConvertBlock(const sAdcUnits_t *units, const uint16_t *codes, int16_t *values,
+                           uint16_t count){
+    const uint16_t scale = units->scale;
+    const int32_t bias = units->bias;
+    const uint8_t shift = units->shift;
+    const int16_t offset = units->offset;
+    uint16_t i;
+
+    for (i = 0; i < count; i++)
+        values[i] = Saturate((((int32_t)((uint32_t)codes[i] * scale) + bias) >> shift) + offset);
+}
+
+void ADC_UnitsConvertSequence(const sAdcUnits_t *units, const uint16_t *codes, int16_t *values,
+                              uint8_t count){
+    uint8_t i;
+
+    for (i = 0; i < count; i++)
+        values[i] = ADC_UnitsConvert(&units[i], codes[i]);
+}
@@ -0,0 +1,108 @@
+#ifndef ADC_UNITS_H_
+#define ADC_UNITS_H_
+
+#include <stdint.h>
+
+#define ADC_UNITS_REF_AVCC          0       /**< AVCC, as initAdc() and the rail monitor use */
+#define ADC_UNITS_REF_1V2           1
+#define ADC_UNITS_REF_2V0           2
+#define ADC_UNITS_REF_2V5           3
+
+#define ADC_UNITS_MAX_REF_MV        4095    /**< Largest reference voltage the scale factors are worked out for */
+#define ADC_UNITS_MAX_SHIFT         30
+
+/******************************************************************************
+ * @brief ADC and reference calibration of one device, from its TLV table.
+ *
+ * Factors are Q15, 0x8000 is 1.0. A code is corrected as
+ * (code * gain / 0x8000 + offset) * refFactor / 0x8000.
+ ******************************************************************************/
+typedef struct sAdcCalibration {
+    uint16_t gain;                  /**< ADC gain factor */
+    int16_t offset;                 /**< ADC offset, in codes */
+    uint16_t refFactor;             /**< Reference factor, 0x8000 for AVCC */
+    uint16_t refMillivolts;         /**< Nominal reference voltage */
+} sAdcCalibration_t;
+
+/******************************************************************************
+ * @brief What a channel measures, from the voltage at its pin.
+ *
+ * value = pin millivolts * multiplier / divider + offset. A 2:1 divider in
+ * front of the pin is {2, 1, 0}; a current sense amplifier of 0.5 V/A is
+ * {2, 1, 0} in mA, with offset taking out the amplifier's zero-current output.
+ ******************************************************************************/
+typedef struct sAdcUnitsChannel {
+    uint16_t multiplier;
+    uint16_t divider;
+    int16_t offset;                 /**< In the channel's units */
+} sAdcUnitsChannel_t;
+
+/******************************************************************************
+ * @brief Conversion of one channel, worked out by ADC_UnitsInit(...).
+ *
+ * value = ((code * scale + bias) >> shift) + offset. scale is the whole
+ * calibration chain as a Q15 mantissa (0x4000..0x7FFF unless the chain is
+ * tiny), so each code costs one 16 x 16 bit multiply, which the MPY32 does in
+ * hardware, an addition and a shift.
+ ******************************************************************************/
+typedef struct sAdcUnits {
+    int32_t bias;                   /**< ADC offset through the chain, plus rounding */
+    uint16_t scale;
+    uint8_t shift;
+    int16_t offset;
+} sAdcUnits_t;
+
+
+/******************************************************************************
+ * @brief Reads the device's calibration for a reference from its TLV table.
+ *
+ * @param reference
+ *        ADC_UNITS_REF_xxx the ADC converts against.
+ *
+ * @param avccMillivolts
+ *        AVCC, only used with ADC_UNITS_REF_AVCC, which has no calibration
+ *        factor.
+ *
+ * @return 0 on success, -1 if a record is missing from the TLV table or the
+ *         reference is unknown. The missing factors are then left at 1.0.
+ ******************************************************************************/
+extern int16_t ADC_CalibrationRead(sAdcCalibration_t *calibration, uint8_t reference, uint16_t avccMillivolts);
+
+
+/******************************************************************************
+ * @brief Works out the fixed-point conversion of one channel. Done once at
+ * initialization, any 64-bit arithmetic stays here.
+ *
+ * @return 0 on success, -1 if the divider is 0, the reference is above
+ *         ADC_UNITS_MAX_REF_MV, or the chain does not fit the fixed-point
+ *         format (more than 0x7FFF units per code, or less than 2^-30).
+ ******************************************************************************/
+extern int16_t ADC_UnitsInit(sAdcUnits_t *units, const sAdcCalibration_t *calibration,
+                             const sAdcUnitsChannel_t *channel);
+
+
+/******************************************************************************
+ * @brief Converts one 12-bit code. Values outside -32768..32767 saturate.
+ ******************************************************************************/
+extern int16_t ADC_UnitsConvert(const sAdcUnits_t *units, uint16_t code);
+
+
+/******************************************************************************
+ * @brief Converts a block of 12-bit codes of one channel, such as a half of
+ * the ADC_Capture.h buffer, in one pass.
+ *
+ * codes and values may be the same buffer.
+ ******************************************************************************/
+extern void ADC_UnitsConvertBlock(const sAdcUnits_t *units, const uint16_t *codes, int16_t *values,
+                                  uint16_t count);
+
+
+/******************************************************************************
+ * @brief Converts one code per channel, such as the results of
+ * ADC_SampleSequence(...), each with its own units[i].
+ ******************************************************************************/
+extern void ADC_UnitsConvertSequence(const sAdcUnits_t *units, const uint16_t *codes, int16_t *values,
+                                     uint8_t count);
+
+
+#endif /* ADC_UNITS_H_ */
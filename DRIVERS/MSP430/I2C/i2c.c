@@ -1,5 +1,6 @@
 
 #include "i2c.h"
+#include "i2c_ring.h"
 #include "utils.h"
 
 typedef enum eI2C_Mode {
@@ -9,20 +10,31 @@ typedef enum eI2C_Mode {
     I2C_MODE_MAX
 } eI2C_Mode_t;
 
+typedef enum eI2C_TxSource {
+    I2C_TX_FROM_BUFFER,     /**< Bytes come from TransmitBuffer (transmitI2C) */
+    I2C_TX_FROM_STREAM,     /**< Bytes come from Tx_Next_Data (transmitI2CStream) */
+} eI2C_TxSource_t;
+
 typedef struct sI2cCtxPriv
 {
     void (*Rx_Proc_Data)(uint8_t data);
+    int16_t (*Tx_Next_Data)(uint8_t *data);
+    void (*Rx_Notify)(void);
     eI2C_Mode_t i2c_mode;
+    eI2C_TxSource_t tx_source;
 } sI2cCtxPriv;
 
 /** I2C SlaveMode - Tracks the current mode of the I2C software state machine */
 static sI2cCtxPriv i2cSlaveCtx = {
     .Rx_Proc_Data = NULL,
-    .i2c_mode = I2C_IDLE_MODE
+    .Tx_Next_Data = NULL,
+    .Rx_Notify = NULL,
+    .i2c_mode = I2C_IDLE_MODE,
+    .tx_source = I2C_TX_FROM_BUFFER
 };
 
-uint8_t ReceiveBuffer[MAX_BUFFER_SIZE] = {0};
-uint8_t ReceiveIndex = 0;
+/** Received bytes waiting for processI2C(), filled by the ISR only */
+static sI2cRing_t i2cRxRing;
 
 uint8_t TransmitBuffer[MAX_BUFFER_SIZE] = {0};
 uint8_t TransmitIndex = 0;
@@ -39,7 +51,36 @@ void initI2C(sI2cConfigCb_t* cb_config)
     UCB0IE |= UCTXIE;                          // Enable TX interrupt
     
     i2cSlaveCtx.Rx_Proc_Data = cb_config->Rx_Proc_Data;
+    i2cSlaveCtx.Tx_Next_Data = cb_config->Tx_Next_Data;
+    i2cSlaveCtx.Rx_Notify = cb_config->Rx_Notify;
     i2cSlaveCtx.i2c_mode = I2C_IDLE_MODE;
+    i2cSlaveCtx.tx_source = I2C_TX_FROM_BUFFER;
+    i2cRingInit(&i2cRxRing);
+}
+
+void processI2C(void)
+{
+    uint8_t data;
+
+    // A byte stays in the ring until it is fully processed, so the TX ISR
+    // knows a response may still be on its way
+    while (i2cRingPeek(&i2cRxRing, &data)) {
+        i2cSlaveCtx.Rx_Proc_Data(data);
+        i2cRingDrop(&i2cRxRing);
+    }
+
+    // Release a master read the ISR held off while bytes were queued. Reading
+    // UCB0IV cleared UCTXIFG0 on the way in, so raise it again, or the ISR
+    // never comes back to load the byte and SCL stays low.
+    if (!(UCB0IE & UCTXIE)) {
+        UCB0IFG |= UCTXIFG0;
+        UCB0IE |= UCTXIE;
+    }
+}
+
+uint8_t i2cRxPending(void)
+{
+    return i2cRingCount(&i2cRxRing);
 }
 
 int16_t transmitI2C(const uint8_t* data, uint8_t size)
@@ -47,11 +88,23 @@ int16_t transmitI2C(const uint8_t* data, uint8_t size)
     // Copy response to TransmitBuffer
     CopyArray((uint8_t*)data, TransmitBuffer, MIN(size, MAX_BUFFER_SIZE));
 
-    i2cSlaveCtx.i2c_mode = I2C_TX_MODE;
+    // Only arms the next master read. i2c_mode follows the bus: the STOP of
+    // the request write can still be pending, and must not reset the source.
+    i2cSlaveCtx.tx_source = I2C_TX_FROM_BUFFER;
 
     return 0; // TODO switch to project defined error flags
 }
 
+int16_t transmitI2CStream(void)
+{
+    if (i2cSlaveCtx.Tx_Next_Data == NULL)
+        return -1; // TODO switch to project defined error flags
+
+    i2cSlaveCtx.tx_source = I2C_TX_FROM_STREAM;     // Armed like transmitI2C()
+
+    return 0;
+}
+
 //******************************************************************************
 // I2C Interrupt ***************************************************************
 //******************************************************************************
@@ -74,9 +127,10 @@ void __attribute__ ((interrupt(USCI_B0_VECTOR))) USCI_B0_ISR (void)
     case USCI_I2C_UCSTTIFG:  break;         // Vector 6: STTIFG
     case USCI_I2C_UCSTPIFG:                 // Vector 8: STPIFG
         if (i2cSlaveCtx.i2c_mode == I2C_RX_MODE) {          // Recieve
-            ReceiveIndex = 0;
+            // Bytes are already queued for processI2C()
         } else if (i2cSlaveCtx.i2c_mode == I2C_TX_MODE) {   // Transmit
             TransmitIndex = 0;
+            i2cSlaveCtx.tx_source = I2C_TX_FROM_BUFFER;
         } 
         // else {
             // TODO: throw an error. 
@@ -92,16 +146,30 @@ void __attribute__ ((interrupt(USCI_B0_VECTOR))) USCI_B0_ISR (void)
     case USCI_I2C_UCRXIFG1:  break;         // Vector 18: RXIFG1
     case USCI_I2C_UCTXIFG1:  break;         // Vector 20: TXIFG1
     case USCI_I2C_UCRXIFG0:                 // Vector 22: RXIFG0  -> Receive one byte from MASTER (SAMV71)
-        ReceiveBuffer[ReceiveIndex] = UCB0RXBUF;         // -> Get the single byte
-        i2cSlaveCtx.Rx_Proc_Data(ReceiveBuffer[ReceiveIndex]);
+        i2cRingPush(&i2cRxRing, UCB0RXBUF);               // -> Queue the single byte, parsed by processI2C()
 
-        ReceiveIndex = (ReceiveIndex + 1) % MAX_BUFFER_SIZE;
         i2cSlaveCtx.i2c_mode = I2C_RX_MODE;
+        if (i2cSlaveCtx.Rx_Notify != NULL)
+            i2cSlaveCtx.Rx_Notify();                     // -> Tell an event driven main loop
+        __bic_SR_register_on_exit(LPM3_bits);            // -> Wake the main loop, from LPM0 or LPM3
         break;
     case USCI_I2C_UCTXIFG0:                 // Vector 24: TXIFG0  -> Send one byte to MASTER (SAMV71)
-        UCB0TXBUF = TransmitBuffer[TransmitIndex];
+        if (i2cRingCount(&i2cRxRing) != 0) {
+            // The request is not parsed yet: leave TXBUF empty so SCL is held
+            // low, and let processI2C() re-enable this interrupt when done
+            UCB0IE &= ~UCTXIE;
+            break;
+        }
+
+        if (i2cSlaveCtx.tx_source == I2C_TX_FROM_STREAM) {
+            uint8_t data = 0xFF;                        // -> Pulled straight from the source, no copy
+            i2cSlaveCtx.Tx_Next_Data(&data);
+            UCB0TXBUF = data;
+        } else {
+            UCB0TXBUF = TransmitBuffer[TransmitIndex];
+            TransmitIndex = (TransmitIndex + 1) % MAX_BUFFER_SIZE;
+        }
 
-        TransmitIndex = (TransmitIndex + 1) % MAX_BUFFER_SIZE;
         i2cSlaveCtx.i2c_mode = I2C_TX_MODE;
         break;                      // Interrupt Vector: I2C Mode: UCTXIFG
     default: 
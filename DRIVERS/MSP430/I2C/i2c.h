@@ -22,9 +22,18 @@
 
 #define MAX_BUFFER_SIZE             20    /**< Maximum buffer size for I2C data transmission */
 
+//*******************************************************************************
+// Slave addresses on the OBC bus ***********************************************
+//*******************************************************************************
+
+#define I2C_ADDR_PDS                0x08  /**< APP/PDS_App */
+#define I2C_ADDR_BACKPLANE          0x09  /**< APP/BACKPLANE */
+
 typedef struct sI2cConfigCb
 {
     void (*Rx_Proc_Data)(uint8_t data);
+    int16_t (*Tx_Next_Data)(uint8_t *data);  /**< Source pulled by the TX ISR after transmitI2CStream(), may be NULL */
+    void (*Rx_Notify)(void);                 /**< Called by the RX ISR once a byte is queued, may be NULL */
     uint8_t slave_addr;
 } sI2cConfigCb_t;
 
@@ -33,9 +42,33 @@ typedef struct sI2cConfigCb
  */
 void initI2C(sI2cConfigCb_t* cb_config);
 
+/**
+ * @brief Hands every byte queued by the RX ISR to Rx_Proc_Data.
+ *
+ * The ISR only enqueues received bytes, so protocol parsing and command
+ * handling run here, from the main loop, instead of in interrupt context.
+ */
+void processI2C(void);
+
+/**
+ * @brief Number of received bytes waiting for processI2C().
+ */
+uint8_t i2cRxPending(void);
+
 /** 
 * @brief Write 
 */
 int16_t transmitI2C(const uint8_t* data, uint8_t size) ;
 
+/**
+ * @brief Arms the next master read to be served straight from Tx_Next_Data.
+ *
+ * Each TX interrupt pulls one byte from the callback instead of from the
+ * TransmitBuffer copy, so the response is never staged in RAM. Once the
+ * callback reports an error the master is sent 0xFF until it stops reading.
+ *
+ * @return 0 on success, -1 if no Tx_Next_Data callback was configured
+ */
+int16_t transmitI2CStream(void);
+
 #endif /* I2C */
@@ -0,0 +1,92 @@
+/**
+ * @file i2c_ring.h
+ * @brief Lock-free single-producer / single-consumer byte ring.
+ *
+ * Used to hand received I2C bytes from USCI_B0_ISR (the only producer) to the
+ * main loop (the only consumer) without disabling interrupts. The producer
+ * only writes head and the consumer only writes tail; both indices run freely
+ * and are masked on access, so head - tail is always the fill level.
+ */
+
+#ifndef _I2C_RING_
+#define _I2C_RING_
+
+#include <stdint.h>
+
+#define I2C_RING_SIZE               32    /**< Must be a power of two, at most 128 */
+#define I2C_RING_MASK               (I2C_RING_SIZE - 1)
+
+#if (I2C_RING_SIZE & I2C_RING_MASK) != 0 || I2C_RING_SIZE > 128
+#error I2C_RING_SIZE must be a power of two no larger than 128
+#endif
+
+typedef struct sI2cRing
+{
+    volatile uint8_t data[I2C_RING_SIZE];
+    volatile uint8_t head;          /**< Next slot to write, owned by the producer */
+    volatile uint8_t tail;          /**< Next slot to read, owned by the consumer */
+    volatile uint8_t overflows;     /**< Bytes dropped because the ring was full */
+} sI2cRing_t;
+
+/**
+ * @brief Empties the ring. Only call while neither side is running.
+ */
+static inline void i2cRingInit(sI2cRing_t *ring)
+{
+    ring->head = 0;
+    ring->tail = 0;
+    ring->overflows = 0;
+}
+
+/**
+ * @brief Producer side: appends one byte.
+ *
+ * @return 1 on success, 0 if the ring was full and the byte was dropped
+ */
+static inline uint8_t i2cRingPush(sI2cRing_t *ring, uint8_t data)
+{
+    uint8_t head = ring->head;
+
+    if ((uint8_t)(head - ring->tail) == I2C_RING_SIZE) {
+        ring->overflows++;
+        return 0;
+    }
+
+    ring->data[head & I2C_RING_MASK] = data;
+    ring->head = head + 1;  // Publish only after the data is written
+    return 1;
+}
+
+/**
+ * @brief Consumer side: reads the oldest byte without removing it.
+ *
+ * @return 1 if a byte was available, 0 if the ring is empty
+ */
+static inline uint8_t i2cRingPeek(const sI2cRing_t *ring, uint8_t *data)
+{
+    uint8_t tail = ring->tail;
+
+    if (tail == ring->head)
+        return 0;
+
+    *data = ring->data[tail & I2C_RING_MASK];
+    return 1;
+}
+
+/**
+ * @brief Consumer side: removes the byte returned by the last i2cRingPeek().
+ */
+static inline void i2cRingDrop(sI2cRing_t *ring)
+{
+    ring->tail = ring->tail + 1;
+}
+
+/**
+ * @brief Number of bytes waiting in the ring.
+ */
+static inline uint8_t i2cRingCount(const sI2cRing_t *ring)
+{
+    return (uint8_t)(ring->head - ring->tail);
+}
+
+#endif // _I2C_RING_
@@ -0,0 +1,376 @@
+/*
+ * Tickless software timers on Timer_A1 CCR0.
+ *
+ * Running timers are filed in a hierarchical timing wheel: SOFT_TIMER_LEVELS levels of 16 slots, level n
+ * slot s holding the timers due in the 16^n ticks long window whose number ends in s. Starting or stopping
+ * a timer is a push or an unlink on one slot list, whatever the number of timers. When the clock enters a
+ * window, the timers of its level n slot are filed again, a level lower; level 0 slots hold the timers due
+ * on one tick, which expire.
+ *
+ * A bit mask per level marks the slots in use, so the next tick with anything to do (an expiry or a window
+ * to file again) is found without walking the wheel, and the clock jumps straight to it: empty ticks cost
+ * nothing. TA1CCR0 is only set to the next expiry, at most SOFT_TIMER_HORIZON ahead; the ISR of an expiry
+ * catches up with the windows before it.
+ *
+ */
+
+#include <stddef.h>
+
+#include <msp430.h>
+
+#include "SoftTimer.h"
+
+#define SLOTS                       (1u << SOFT_TIMER_LEVEL_BITS)
+#define SLOT_MASK                   (SLOTS - 1)
+#define MAX_DELAY                   ((1UL << (SOFT_TIMER_LEVEL_BITS * SOFT_TIMER_LEVELS)) - 1)
+#define SLOT_EXPIRING               0xFF    /**< Taken off the wheel by Take(), not filed anywhere */
+
+typedef char SoftTimerSlotsFit[(SLOTS <= 16 && SOFT_TIMER_LEVELS * SLOTS < SLOT_EXPIRING) ? 1 : -1];
+
+typedef struct sSoftTimerCtx {
+    sSoftTimer_t *slots[SOFT_TIMER_LEVELS][SLOTS];
+    uint16_t used[SOFT_TIMER_LEVELS];   /**< Bit per slot holding a timer */
+    uint32_t clock;                     /**< Next tick to process */
+    uint32_t now;                       /**< Last counter reading, extended to 32 bits */
+    uint32_t compare;                   /**< Tick TA1CCR0 is set to */
+    uint8_t armed;                      /**< CCIE set */
+    uint16_t count;
+    uint8_t inIsr;                      /**< TIMER1_A0_ISR sets the compare once it is done */
+} sSoftTimerCtx_t;
+
+static sSoftTimerCtx_t softTimer;
+
+// TA1R counts ACLK, asynchronous to MCLK: two equal reads are a stable value
+static uint32_t ReadCounter(void){
+    uint16_t count, again;
+
+    do {
+        count = HWREG16(SOFT_TIMER_BASE + OFS_TAxR);
+        again = HWREG16(SOFT_TIMER_BASE + OFS_TAxR);
+    } while (count != again);
+
+    softTimer.now += (uint16_t)(count - (uint16_t)softTimer.now);
+    return softTimer.now;
+}
+
+static void File(sSoftTimer_t *timer){
+    uint32_t delay = timer->expires - softTimer.clock;
+    uint32_t at = timer->expires;
+    uint8_t level = 0;
+    uint8_t slot;
+
+    if ((int32_t)delay < 0) {
+        at = softTimer.clock;
+        delay = 0;
+    } else if (delay > MAX_DELAY) {
+        // Filed at the end of the wheel, and again from there until it is in range
+        at = softTimer.clock + MAX_DELAY;
+        delay = MAX_DELAY;
+    }
+    while (level < SOFT_TIMER_LEVELS - 1 && delay >= (1UL << ((level + 1) * SOFT_TIMER_LEVEL_BITS)))
+        level++;
+    slot = (at >> (level * SOFT_TIMER_LEVEL_BITS)) & SLOT_MASK;
+
+    timer->next = softTimer.slots[level][slot];
+    if (timer->next != NULL)
+        timer->next->link = &timer->next;
+    timer->link = &softTimer.slots[level][slot];
+    timer->slot = level * SLOTS + slot;
+    softTimer.slots[level][slot] = timer;
+    softTimer.used[level] |= 1u << slot;
+}
+
+static void Unlink(sSoftTimer_t *timer){
+    uint8_t level = timer->slot / SLOTS;
+    uint8_t slot = timer->slot % SLOTS;
+
+    *timer->link = timer->next;
+    if (timer->next != NULL)
+        timer->next->link = timer->link;
+    timer->link = NULL;
+
+    if (timer->slot != SLOT_EXPIRING && softTimer.slots[level][slot] == NULL)
+        softTimer.used[level] &= ~(1u << slot);
+}
+
+// Takes a whole slot off the wheel, as a list headed by *list
+static void Take(uint8_t level, uint8_t slot, sSoftTimer_t **list){
+    sSoftTimer_t *timer;
+
+    *list = softTimer.slots[level][slot];
+    softTimer.slots[level][slot] = NULL;
+    softTimer.used[level] &= ~(1u << slot);
+
+    if (*list != NULL)
+        (*list)->link = list;
+    for (timer = *list; timer != NULL; timer = timer->next)
+        timer->slot = SLOT_EXPIRING;
+}
+
+// Slots in use, rotated so bit 0 is the next window of the level to start (level 0: the current tick)
+static uint16_t Ahead(uint8_t level, uint32_t *window){
+    uint8_t shift = level * SOFT_TIMER_LEVEL_BITS;
+    uint32_t used = softTimer.used[level];
+    uint8_t index;
+
+    *window = (softTimer.clock + (1UL << shift) - 1) >> shift;
+    index = *window & SLOT_MASK;
+    return ((used >> index) | (used << (SLOTS - index))) & ((1UL << SLOTS) - 1);
+}
+
+static uint8_t FirstSlot(uint16_t *ahead){
+    uint8_t slots = 0;
+
+    while (!(*ahead & 1)) {
+        *ahead >>= 1;
+        slots++;
+    }
+    return slots;
+}
+
+static void Earliest(uint8_t *found, uint32_t *tick, uint32_t at){
+    if (!*found || (int32_t)(at - *tick) < 0)
+        *tick = at;
+    *found = 1;
+}
+
+// Next tick with a slot to expire or to file again, 0 if the wheel is empty
+static uint8_t NextEvent(uint32_t *tick){
+    uint8_t found = 0;
+    uint8_t level;
+
+    for (level = 0; level < SOFT_TIMER_LEVELS; level++) {
+        uint32_t window;
+        uint16_t ahead = Ahead(level, &window);
+
+        if (ahead != 0)
+            Earliest(&found, tick, (window + FirstSlot(&ahead)) << (level * SOFT_TIMER_LEVEL_BITS));
+    }
+    return found;
+}
+
+// Next expiry, 0 if the wheel is empty. Windows are filed again by the ISR of the first expiry after
+// them, so they cost no wake-up of their own. The first slot in use of a level holds its earliest
+// timers, unless they were filed at the end of the wheel: the next slot in use bounds those. A slot is
+// only walked when its window starts before every deadline found below it, and once the clock is in
+// that window its timers go down a level, so each timer is walked about once per level.
+static uint8_t NextDeadline(uint32_t *tick){
+    uint8_t found = 0;
+    uint8_t level;
+
+    for (level = 0; level < SOFT_TIMER_LEVELS; level++) {
+        uint8_t shift = level * SOFT_TIMER_LEVEL_BITS;
+        uint32_t window;
+        uint16_t ahead = Ahead(level, &window);
+        uint8_t first;
+        sSoftTimer_t *timer;
+
+        if (ahead == 0)
+            continue;
+
+        first = FirstSlot(&ahead);
+        if (level == 0) {
+            Earliest(&found, tick, window + first);
+            continue;
+        }
+        // Nothing in a window expires before it starts: most of the time the levels below win
+        if (found && (int32_t)(((window + first) << shift) - *tick) >= 0)
+            continue;
+
+        for (timer = softTimer.slots[level][(window + first) & SLOT_MASK]; timer != NULL; timer = timer->next)
+            Earliest(&found, tick, timer->expires);
+        ahead >>= 1;
+        if (ahead != 0)
+            Earliest(&found, tick, (window + first + 1 + FirstSlot(&ahead)) << shift);
+    }
+    return found;
+}
+
+// Processes every tick with something to do up to now, returns the timers expired
+static uint16_t Run(uint32_t now){
+    uint16_t expired = 0;
+    uint32_t tick = 0;
+
+    while (NextEvent(&tick) && (int32_t)(tick - now) <= 0) {
+        sSoftTimer_t *list;
+        uint8_t level;
+
+        softTimer.clock = tick;
+
+        // Windows starting on this tick, the timers go one level down or more
+        for (level = 1; level < SOFT_TIMER_LEVELS; level++) {
+            if (tick & ((1UL << (level * SOFT_TIMER_LEVEL_BITS)) - 1))
+                break;
+            Take(level, (tick >> (level * SOFT_TIMER_LEVEL_BITS)) & SLOT_MASK, &list);
+            while (list != NULL) {
+                sSoftTimer_t *timer = list;
+
+                Unlink(timer);
+                File(timer);
+            }
+        }
+
+        // The clock moves on first, so a timer started from Timer_Expired is filed for a later tick
+        Take(0, tick & SLOT_MASK, &list);
+        softTimer.clock = tick + 1;
+        while (list != NULL) {
+            sSoftTimer_t *timer = list;
+
+            Unlink(timer);
+            if (timer->period != 0) {
+                timer->expires += timer->period;
+                File(timer);
+            } else {
+                softTimer.count--;
+            }
+            expired++;
+            timer->Timer_Expired(timer);
+        }
+    }
+
+    // Nothing left up to now: the clock can skip the empty ticks
+    if ((int32_t)(now + 1 - softTimer.clock) > 0)
+        softTimer.clock = now + 1;
+    return expired;
+}
+
+// Sets TA1CCR0 to a deadline, or raises CCIFG if it is already due
+static void SetCompare(uint32_t tick){
+    uint32_t now = ReadCounter();
+
+    if ((int32_t)(tick - now) > (int32_t)SOFT_TIMER_HORIZON)
+        tick = now + SOFT_TIMER_HORIZON;
+
+    softTimer.compare = tick;
+    softTimer.armed = 1;
+    HWREG16(SOFT_TIMER_BASE + OFS_TAxCCR0) = (uint16_t)tick;
+    HWREG16(SOFT_TIMER_BASE + OFS_TAxCCTL0) = CCIE;
+
+    // The compare only fires when the counter steps onto TA1CCR0: a tick already reached is raised here
+    if ((int32_t)(tick - ReadCounter()) <= 0)
+        HWREG16(SOFT_TIMER_BASE + OFS_TAxCCTL0) |= CCIFG;
+}
+
+static void Disarm(void){
+    softTimer.armed = 0;
+    HWREG16(SOFT_TIMER_BASE + OFS_TAxCCTL0) &= ~CCIE;
+}
+
+void SoftTimer_Init(void){
+    uint8_t level, slot;
+
+    Timer_A_initContinuousModeParam param = {
+        .clockSource = TIMER_A_CLOCKSOURCE_ACLK,
+        .clockSourceDivider = SOFT_TIMER_ACLK_DIVIDER,
+        .timerInterruptEnable_TAIE = TIMER_A_TAIE_INTERRUPT_DISABLE,
+        .timerClear = TIMER_A_DO_CLEAR,
+        .startTimer = true
+    };
+
+    HWREG16(SOFT_TIMER_BASE + OFS_TAxCCTL0) = 0;
+    softTimer.armed = 0;
+
+    for (level = 0; level < SOFT_TIMER_LEVELS; level++) {
+        for (slot = 0; slot < SLOTS; slot++) {
+            sSoftTimer_t *timer = softTimer.slots[level][slot];
+
+            for (; timer != NULL; timer = timer->next)
+                timer->link = NULL;
+            softTimer.slots[level][slot] = NULL;
+        }
+        softTimer.used[level] = 0;
+    }
+    softTimer.count = 0;
+    softTimer.inIsr = 0;
+
+    Timer_A_initContinuousMode(SOFT_TIMER_BASE, &param);
+    softTimer.now = 0;
+    softTimer.clock = ReadCounter() + 1;
+}
+
+void SoftTimer_Start(sSoftTimer_t *timer, uint32_t delay, uint32_t period){
+    uint16_t interrupts = __get_SR_register() & GIE;
+    uint32_t now;
+
+    __disable_interrupt();
+
+    if (timer->link != NULL)
+        SoftTimer_Stop(timer);
+
+    now = ReadCounter();
+    if (softTimer.count == 0)
+        softTimer.clock = now + 1;
+
+    timer->period = period;
+    timer->expires = now + (delay ? delay : 1);
+    File(timer);
+    softTimer.count++;
+
+    // Only an earlier deadline moves the compare, the ISR finds the next one after it
+    if (!softTimer.inIsr && (!softTimer.armed || (int32_t)(timer->expires - softTimer.compare) < 0))
+        SetCompare(timer->expires);
+
+    __bis_SR_register(interrupts);
+}
+
+void SoftTimer_Stop(sSoftTimer_t *timer){
+    uint16_t interrupts = __get_SR_register() & GIE;
+
+    __disable_interrupt();
+
+    if (timer->link != NULL) {
+        Unlink(timer);
+        softTimer.count--;
+        // A compare left behind for a stopped timer is a spare wake-up, the ISR finds the next deadline.
+        // With none left, no wake-up at all.
+        if (softTimer.count == 0 && !softTimer.inIsr)
+            Disarm();
+    }
+
+    __bis_SR_register(interrupts);
+}
+
+uint8_t SoftTimer_Running(const sSoftTimer_t *timer){
+    return timer->link != NULL;
+}
+
+uint16_t SoftTimer_Count(void){
+    return softTimer.count;
+}
+
+uint32_t SoftTimer_Now(void){
+    uint16_t interrupts = __get_SR_register() & GIE;
+    uint32_t now;
+
+    __disable_interrupt();
+    now = ReadCounter();
+    __bis_SR_register(interrupts);
+    return now;
+}
+
+/*ISR that expires the timers due, then sets the compare to the next deadline*/
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void TIMER1_A0_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__ ((interrupt(TIMER1_A0_VECTOR))) TIMER1_A0_ISR (void)
+#else
+#error Compiler not supported!
+#endif
+{
+    uint32_t deadline = 0;
+    uint16_t expired;
+
+    // CCIFG of CCR0 is cleared by the interrupt being taken
+    softTimer.inIsr = 1;
+    expired = Run(ReadCounter());
+    softTimer.inIsr = 0;
+    if (NextDeadline(&deadline))
+        SetCompare(deadline);
+    else
+        Disarm();
+
+    // Only a deadline wakes the main loop, not a horizon compare
+    if (expired != 0)
+        __bic_SR_register_on_exit(LPM3_bits);
+}
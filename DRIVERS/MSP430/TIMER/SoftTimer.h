@@ -0,0 +1,113 @@
+#ifndef SOFT_TIMER_H_
+#define SOFT_TIMER_H_
+
+#include <stdint.h>
+
+#include "timer_a.h"     // DRIVERS/MSP430/PWM/include
+
+#define SOFT_TIMER_BASE             TIMER_A1_BASE   /**< Timer_A0 triggers the ADC, Timer_B0 is the PWM */
+
+#ifndef SOFT_TIMER_ACLK_HZ
+#define SOFT_TIMER_ACLK_HZ          32768UL     /**< LFXT, keeps counting in LPM3 */
+#endif
+
+#define SOFT_TIMER_ACLK_DIVIDER     TIMER_A_CLOCKSOURCE_DIVIDER_8
+#define SOFT_TIMER_HZ               (SOFT_TIMER_ACLK_HZ / 8)    /**< Ticks per second, 244 us each */
+
+#define SOFT_TIMER_LEVEL_BITS       4           /**< 16 slots per wheel level */
+#define SOFT_TIMER_LEVELS           6           /**< 2^24 ticks ahead (68 minutes) before a timer is re-filed */
+#define SOFT_TIMER_HORIZON          0x4000UL    /**< Longest compare, so the 16-bit counter never wraps unseen */
+
+#define SOFT_TIMER_MS(ms)           ((uint32_t)(((uint32_t)(ms) * (SOFT_TIMER_HZ / 8) + 124) / 125))   /**< Up to 2 hours */
+#define SOFT_TIMER_SECONDS(s)       ((uint32_t)(s) * SOFT_TIMER_HZ)
+
+/******************************************************************************
+ * @brief A software timer. The caller owns the memory, the service only links
+ * it into its wheel while it runs, so there is no limit on the count.
+ *
+ * A timer has to start out stopped, with link NULL: SoftTimer_Start() takes a
+ * non-NULL link for a running timer and unlinks it. Static timers are zeroed
+ * already; set up any other one with SOFT_TIMER_INIT() before its first start.
+ ******************************************************************************/
+typedef struct sSoftTimer {
+    void (*Timer_Expired)(struct sSoftTimer *timer);    /**< Called from TIMER1_A0_ISR, set before SoftTimer_Start() */
+    uint32_t period;                /**< Ticks between expiries, 0 for a one-shot */
+    uint32_t expires;               /**< Tick of the next expiry, owned by the service */
+    struct sSoftTimer *next;        /**< Owned by the service */
+    struct sSoftTimer **link;       /**< Owned by the service, NULL while stopped */
+    uint8_t slot;                   /**< Owned by the service */
+} sSoftTimer_t;
+
+/** Initializer of a stopped timer: sSoftTimer_t t = SOFT_TIMER_INIT(OnExpiry); */
+#define SOFT_TIMER_INIT(expired)    { .Timer_Expired = (expired), .link = NULL }
+
+
+/******************************************************************************
+ * @brief Starts Timer_A1 counting ACLK / 8 in continuous mode and stops every
+ * software timer.
+ *
+ * Nothing is periodic: TA1CCR0 is only ever set to the next deadline, and its
+ * interrupt is off while no timer runs, so the CPU can sleep in LPM3 from one
+ * deadline to the next. Needs LFXT running (startCountdownAlarm() on the
+ * Backplane).
+ *
+ * @return None.
+ ******************************************************************************/
+extern void SoftTimer_Init(void);
+
+
+/******************************************************************************
+ * @brief Starts, or restarts, a software timer.
+ *
+ * Safe from the main loop, from Timer_Expired and from other ISRs. A timer
+ * that is already running is moved to the new deadline.
+ *
+ * @param timer
+ *        The timer, with Timer_Expired set. Must stay in memory while it runs,
+ *        and be zeroed or SOFT_TIMER_INIT() before its first start.
+ *
+ * @param delay
+ *        Ticks to the first expiry (SOFT_TIMER_MS()). 0 is taken as 1, the
+ *        next tick.
+ *
+ * @param period
+ *        Ticks between the following expiries, 0 for a one-shot. A periodic
+ *        timer keeps its phase: a late expiry does not push the next one.
+ *
+ * @return None.
+ ******************************************************************************/
+extern void SoftTimer_Start(sSoftTimer_t *timer, uint32_t delay, uint32_t period);
+
+
+/******************************************************************************
+ * @brief Stops a timer. Does nothing if it is not running.
+ *
+ * @return None.
+ ******************************************************************************/
+extern void SoftTimer_Stop(sSoftTimer_t *timer);
+
+
+/******************************************************************************
+ * @brief Non-zero while the timer is waiting for an expiry.
+ ******************************************************************************/
+extern uint8_t SoftTimer_Running(const sSoftTimer_t *timer);
+
+
+/******************************************************************************
+ * @brief Timers running.
+ ******************************************************************************/
+extern uint16_t SoftTimer_Count(void);
+
+
+/******************************************************************************
+ * @brief Current tick.
+ *
+ * The 16-bit counter is extended in software each time it is read, which the
+ * service does at least every SOFT_TIMER_HORIZON ticks while a timer runs.
+ * With no timer running it may miss wraps, so only use differences taken
+ * while a timer runs.
+ ******************************************************************************/
+extern uint32_t SoftTimer_Now(void);
+
+
+#endif /* SOFT_TIMER_H_ */
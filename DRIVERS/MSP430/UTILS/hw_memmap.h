@@ -36,11 +36,14 @@
 // Macros for hardware access
 //
 //*****************************************************************************
+// Unless the device header already maps them (host build, Tools/HostBench/hal)
+#ifndef HWREG16
 #define HWREG32(x)                                                              \
         (*((volatile uint32_t *)((uint16_t)x)))
 #define HWREG16(x)                                                             \
         (*((volatile uint16_t *)((uint16_t)x)))
 #define HWREG8(x)                                                             \
         (*((volatile uint8_t *)((uint16_t)x)))
+#endif
 
 #endif // #ifndef __HW_MEMMAP__
@@ -5,33 +5,240 @@
 #include "tinyprotocol.h"
 
 static const uint8_t *tlm_pointer[TINYPROTOCOL_MAX_CMD_NUM] = {0};
-static uint8_t tlm_pointer_size[TINYPROTOCOL_MAX_CMD_NUM] = {0};
+static uint16_t tlm_pointer_size[TINYPROTOCOL_MAX_CMD_NUM] = {0};
+static uint8_t tlm_large[(TINYPROTOCOL_MAX_CMD_NUM + 7) / 8] = {0};    // One bit per large frame channel
 static uint8_t tlm_current_channel = 0;
-static uint8_t tlm_buffer_idx = 0;
+static const uint8_t *tlm_current_ptr = 0;
+static uint16_t tlm_current_size = 0;
+static uint16_t tlm_buffer_idx = 0;
+static uint8_t tlm_prefix[4] = {0};    // Sent ahead of the current payload, already in tlm_crc
+static uint8_t tlm_prefix_size = 0;
+static uint8_t tlm_prefix_idx = 0;
+static uint8_t tlm_crc = 0;     // Running CRC of the telemetry bytes sent so far
+
+// Channels of the response being sent: one for a plain request, several for a burst
+static const uint8_t *tlm_response_ptr[TINYPROTOCOL_MAX_BURST_CHANNELS] = {0};
+static uint16_t tlm_response_size[TINYPROTOCOL_MAX_BURST_CHANNELS] = {0};
+static uint8_t tlm_response_large[TINYPROTOCOL_MAX_BURST_CHANNELS] = {0};
+static uint8_t tlm_response_count = 0;
+static uint8_t tlm_response_pos = 0;
+static uint16_t tlm_bytes_left = 0;
 
 static uint8_t tc_size[TINYPROTOCOL_MAX_CMD_NUM] = {0};
 static uint8_t tlcmd_buffer_idx = 0;
 static uint8_t tlcmd_current = 0;
+static uint8_t tlcmd_size = 0;          // Size of the telecommand being received, ID included
+static TINYPROTOCOL_TelecommandHandler tlcmd_handler = 0;  // Its registry handler, if it has one
+
+static const struct TINYPROTOCOL_Registry *registry = 0;
 
 static uint8_t rx_buffer[TINYPROTOCOL_RX_BUFF_SIZE] = {0};
+
+// Large frame telecommands receive straight into a buffer provided by the app
+typedef struct {
+    uint8_t command;
+    uint8_t* buffer;
+    uint16_t max_size;
+} TINYPROTOCOL_LargeTelecommand;
+
+static TINYPROTOCOL_LargeTelecommand large_tc[TINYPROTOCOL_MAX_LARGE_TELECOMMANDS] = {0};
+static uint8_t large_tc_count = 0;
+static uint8_t* large_tc_buffer = 0;
+static uint16_t large_tc_max = 0;
+static uint16_t large_tc_size = 0;
+static uint16_t large_tc_idx = 0;
+static uint8_t large_tc_crc = 0;
 TINYPROTOCOL_ReceiveFSM current_state = TINYPROTOCOL_FSM_IDLE;
 
 static uint8_t tc_send_buffer_tmp[TINYPROTOCOL_MAX_PACKET_SIZE] = {0};
 
 static volatile TINYPROTOCOL_TlmAckPacket TlmAckPacket = {0};
 
-uint8_t TINYPROTOCOL_CalculateCRC(const uint8_t* buffer, uint8_t buffer_size) {
-    uint8_t crc = crc_init_value;
-
-    uint8_t i;
-    for (i = 0; i < buffer_size; i++) {
+#if TINYPROTOCOL_CRC_SLICES > 1
+// crc_slice_table[k - 1][x] is the CRC register after feeding x followed by k zero bytes,
+// which lets several input bytes be folded into the register with independent lookups.
+static const uint8_t crc_slice_table[7][256] = {
+        {   // 1 zero byte
+            0x00, 0xE9, 0xFD, 0x14, 0xD5, 0x3C, 0x28, 0xC1, 0x85, 0x6C, 0x78, 0x91, 0x50, 0xB9, 0xAD, 0x44,
+            0x25, 0xCC, 0xD8, 0x31, 0xF0, 0x19, 0x0D, 0xE4, 0xA0, 0x49, 0x5D, 0xB4, 0x75, 0x9C, 0x88, 0x61,
+            0x4A, 0xA3, 0xB7, 0x5E, 0x9F, 0x76, 0x62, 0x8B, 0xCF, 0x26, 0x32, 0xDB, 0x1A, 0xF3, 0xE7, 0x0E,
+            0x6F, 0x86, 0x92, 0x7B, 0xBA, 0x53, 0x47, 0xAE, 0xEA, 0x03, 0x17, 0xFE, 0x3F, 0xD6, 0xC2, 0x2B,
+            0x94, 0x7D, 0x69, 0x80, 0x41, 0xA8, 0xBC, 0x55, 0x11, 0xF8, 0xEC, 0x05, 0xC4, 0x2D, 0x39, 0xD0,
+            0xB1, 0x58, 0x4C, 0xA5, 0x64, 0x8D, 0x99, 0x70, 0x34, 0xDD, 0xC9, 0x20, 0xE1, 0x08, 0x1C, 0xF5,
+            0xDE, 0x37, 0x23, 0xCA, 0x0B, 0xE2, 0xF6, 0x1F, 0x5B, 0xB2, 0xA6, 0x4F, 0x8E, 0x67, 0x73, 0x9A,
+            0xFB, 0x12, 0x06, 0xEF, 0x2E, 0xC7, 0xD3, 0x3A, 0x7E, 0x97, 0x83, 0x6A, 0xAB, 0x42, 0x56, 0xBF,
+            0x07, 0xEE, 0xFA, 0x13, 0xD2, 0x3B, 0x2F, 0xC6, 0x82, 0x6B, 0x7F, 0x96, 0x57, 0xBE, 0xAA, 0x43,
+            0x22, 0xCB, 0xDF, 0x36, 0xF7, 0x1E, 0x0A, 0xE3, 0xA7, 0x4E, 0x5A, 0xB3, 0x72, 0x9B, 0x8F, 0x66,
+            0x4D, 0xA4, 0xB0, 0x59, 0x98, 0x71, 0x65, 0x8C, 0xC8, 0x21, 0x35, 0xDC, 0x1D, 0xF4, 0xE0, 0x09,
+            0x68, 0x81, 0x95, 0x7C, 0xBD, 0x54, 0x40, 0xA9, 0xED, 0x04, 0x10, 0xF9, 0x38, 0xD1, 0xC5, 0x2C,
+            0x93, 0x7A, 0x6E, 0x87, 0x46, 0xAF, 0xBB, 0x52, 0x16, 0xFF, 0xEB, 0x02, 0xC3, 0x2A, 0x3E, 0xD7,
+            0xB6, 0x5F, 0x4B, 0xA2, 0x63, 0x8A, 0x9E, 0x77, 0x33, 0xDA, 0xCE, 0x27, 0xE6, 0x0F, 0x1B, 0xF2,
+            0xD9, 0x30, 0x24, 0xCD, 0x0C, 0xE5, 0xF1, 0x18, 0x5C, 0xB5, 0xA1, 0x48, 0x89, 0x60, 0x74, 0x9D,
+            0xFC, 0x15, 0x01, 0xE8, 0x29, 0xC0, 0xD4, 0x3D, 0x79, 0x90, 0x84, 0x6D, 0xAC, 0x45, 0x51, 0xB8
+        },
+        {   // 2 zero bytes
+            0x00, 0x0E, 0x1C, 0x12, 0x38, 0x36, 0x24, 0x2A, 0x70, 0x7E, 0x6C, 0x62, 0x48, 0x46, 0x54, 0x5A,
+            0xE0, 0xEE, 0xFC, 0xF2, 0xD8, 0xD6, 0xC4, 0xCA, 0x90, 0x9E, 0x8C, 0x82, 0xA8, 0xA6, 0xB4, 0xBA,
+            0xEF, 0xE1, 0xF3, 0xFD, 0xD7, 0xD9, 0xCB, 0xC5, 0x9F, 0x91, 0x83, 0x8D, 0xA7, 0xA9, 0xBB, 0xB5,
+            0x0F, 0x01, 0x13, 0x1D, 0x37, 0x39, 0x2B, 0x25, 0x7F, 0x71, 0x63, 0x6D, 0x47, 0x49, 0x5B, 0x55,
+            0xF1, 0xFF, 0xED, 0xE3, 0xC9, 0xC7, 0xD5, 0xDB, 0x81, 0x8F, 0x9D, 0x93, 0xB9, 0xB7, 0xA5, 0xAB,
+            0x11, 0x1F, 0x0D, 0x03, 0x29, 0x27, 0x35, 0x3B, 0x61, 0x6F, 0x7D, 0x73, 0x59, 0x57, 0x45, 0x4B,
+            0x1E, 0x10, 0x02, 0x0C, 0x26, 0x28, 0x3A, 0x34, 0x6E, 0x60, 0x72, 0x7C, 0x56, 0x58, 0x4A, 0x44,
+            0xFE, 0xF0, 0xE2, 0xEC, 0xC6, 0xC8, 0xDA, 0xD4, 0x8E, 0x80, 0x92, 0x9C, 0xB6, 0xB8, 0xAA, 0xA4,
+            0xCD, 0xC3, 0xD1, 0xDF, 0xF5, 0xFB, 0xE9, 0xE7, 0xBD, 0xB3, 0xA1, 0xAF, 0x85, 0x8B, 0x99, 0x97,
+            0x2D, 0x23, 0x31, 0x3F, 0x15, 0x1B, 0x09, 0x07, 0x5D, 0x53, 0x41, 0x4F, 0x65, 0x6B, 0x79, 0x77,
+            0x22, 0x2C, 0x3E, 0x30, 0x1A, 0x14, 0x06, 0x08, 0x52, 0x5C, 0x4E, 0x40, 0x6A, 0x64, 0x76, 0x78,
+            0xC2, 0xCC, 0xDE, 0xD0, 0xFA, 0xF4, 0xE6, 0xE8, 0xB2, 0xBC, 0xAE, 0xA0, 0x8A, 0x84, 0x96, 0x98,
+            0x3C, 0x32, 0x20, 0x2E, 0x04, 0x0A, 0x18, 0x16, 0x4C, 0x42, 0x50, 0x5E, 0x74, 0x7A, 0x68, 0x66,
+            0xDC, 0xD2, 0xC0, 0xCE, 0xE4, 0xEA, 0xF8, 0xF6, 0xAC, 0xA2, 0xB0, 0xBE, 0x94, 0x9A, 0x88, 0x86,
+            0xD3, 0xDD, 0xCF, 0xC1, 0xEB, 0xE5, 0xF7, 0xF9, 0xA3, 0xAD, 0xBF, 0xB1, 0x9B, 0x95, 0x87, 0x89,
+            0x33, 0x3D, 0x2F, 0x21, 0x0B, 0x05, 0x17, 0x19, 0x43, 0x4D, 0x5F, 0x51, 0x7B, 0x75, 0x67, 0x69
+        },
+        {   // 3 zero bytes
+            0x00, 0xB5, 0x45, 0xF0, 0x8A, 0x3F, 0xCF, 0x7A, 0x3B, 0x8E, 0x7E, 0xCB, 0xB1, 0x04, 0xF4, 0x41,
+            0x76, 0xC3, 0x33, 0x86, 0xFC, 0x49, 0xB9, 0x0C, 0x4D, 0xF8, 0x08, 0xBD, 0xC7, 0x72, 0x82, 0x37,
+            0xEC, 0x59, 0xA9, 0x1C, 0x66, 0xD3, 0x23, 0x96, 0xD7, 0x62, 0x92, 0x27, 0x5D, 0xE8, 0x18, 0xAD,
+            0x9A, 0x2F, 0xDF, 0x6A, 0x10, 0xA5, 0x55, 0xE0, 0xA1, 0x14, 0xE4, 0x51, 0x2B, 0x9E, 0x6E, 0xDB,
+            0xF7, 0x42, 0xB2, 0x07, 0x7D, 0xC8, 0x38, 0x8D, 0xCC, 0x79, 0x89, 0x3C, 0x46, 0xF3, 0x03, 0xB6,
+            0x81, 0x34, 0xC4, 0x71, 0x0B, 0xBE, 0x4E, 0xFB, 0xBA, 0x0F, 0xFF, 0x4A, 0x30, 0x85, 0x75, 0xC0,
+            0x1B, 0xAE, 0x5E, 0xEB, 0x91, 0x24, 0xD4, 0x61, 0x20, 0x95, 0x65, 0xD0, 0xAA, 0x1F, 0xEF, 0x5A,
+            0x6D, 0xD8, 0x28, 0x9D, 0xE7, 0x52, 0xA2, 0x17, 0x56, 0xE3, 0x13, 0xA6, 0xDC, 0x69, 0x99, 0x2C,
+            0xC1, 0x74, 0x84, 0x31, 0x4B, 0xFE, 0x0E, 0xBB, 0xFA, 0x4F, 0xBF, 0x0A, 0x70, 0xC5, 0x35, 0x80,
+            0xB7, 0x02, 0xF2, 0x47, 0x3D, 0x88, 0x78, 0xCD, 0x8C, 0x39, 0xC9, 0x7C, 0x06, 0xB3, 0x43, 0xF6,
+            0x2D, 0x98, 0x68, 0xDD, 0xA7, 0x12, 0xE2, 0x57, 0x16, 0xA3, 0x53, 0xE6, 0x9C, 0x29, 0xD9, 0x6C,
+            0x5B, 0xEE, 0x1E, 0xAB, 0xD1, 0x64, 0x94, 0x21, 0x60, 0xD5, 0x25, 0x90, 0xEA, 0x5F, 0xAF, 0x1A,
+            0x36, 0x83, 0x73, 0xC6, 0xBC, 0x09, 0xF9, 0x4C, 0x0D, 0xB8, 0x48, 0xFD, 0x87, 0x32, 0xC2, 0x77,
+            0x40, 0xF5, 0x05, 0xB0, 0xCA, 0x7F, 0x8F, 0x3A, 0x7B, 0xCE, 0x3E, 0x8B, 0xF1, 0x44, 0xB4, 0x01,
+            0xDA, 0x6F, 0x9F, 0x2A, 0x50, 0xE5, 0x15, 0xA0, 0xE1, 0x54, 0xA4, 0x11, 0x6B, 0xDE, 0x2E, 0x9B,
+            0xAC, 0x19, 0xE9, 0x5C, 0x26, 0x93, 0x63, 0xD6, 0x97, 0x22, 0xD2, 0x67, 0x1D, 0xA8, 0x58, 0xED
+        },
+        {   // 4 zero bytes
+            0x00, 0xAD, 0x75, 0xD8, 0xEA, 0x47, 0x9F, 0x32, 0xFB, 0x56, 0x8E, 0x23, 0x11, 0xBC, 0x64, 0xC9,
+            0xD9, 0x74, 0xAC, 0x01, 0x33, 0x9E, 0x46, 0xEB, 0x22, 0x8F, 0x57, 0xFA, 0xC8, 0x65, 0xBD, 0x10,
+            0x9D, 0x30, 0xE8, 0x45, 0x77, 0xDA, 0x02, 0xAF, 0x66, 0xCB, 0x13, 0xBE, 0x8C, 0x21, 0xF9, 0x54,
+            0x44, 0xE9, 0x31, 0x9C, 0xAE, 0x03, 0xDB, 0x76, 0xBF, 0x12, 0xCA, 0x67, 0x55, 0xF8, 0x20, 0x8D,
+            0x15, 0xB8, 0x60, 0xCD, 0xFF, 0x52, 0x8A, 0x27, 0xEE, 0x43, 0x9B, 0x36, 0x04, 0xA9, 0x71, 0xDC,
+            0xCC, 0x61, 0xB9, 0x14, 0x26, 0x8B, 0x53, 0xFE, 0x37, 0x9A, 0x42, 0xEF, 0xDD, 0x70, 0xA8, 0x05,
+            0x88, 0x25, 0xFD, 0x50, 0x62, 0xCF, 0x17, 0xBA, 0x73, 0xDE, 0x06, 0xAB, 0x99, 0x34, 0xEC, 0x41,
+            0x51, 0xFC, 0x24, 0x89, 0xBB, 0x16, 0xCE, 0x63, 0xAA, 0x07, 0xDF, 0x72, 0x40, 0xED, 0x35, 0x98,
+            0x2A, 0x87, 0x5F, 0xF2, 0xC0, 0x6D, 0xB5, 0x18, 0xD1, 0x7C, 0xA4, 0x09, 0x3B, 0x96, 0x4E, 0xE3,
+            0xF3, 0x5E, 0x86, 0x2B, 0x19, 0xB4, 0x6C, 0xC1, 0x08, 0xA5, 0x7D, 0xD0, 0xE2, 0x4F, 0x97, 0x3A,
+            0xB7, 0x1A, 0xC2, 0x6F, 0x5D, 0xF0, 0x28, 0x85, 0x4C, 0xE1, 0x39, 0x94, 0xA6, 0x0B, 0xD3, 0x7E,
+            0x6E, 0xC3, 0x1B, 0xB6, 0x84, 0x29, 0xF1, 0x5C, 0x95, 0x38, 0xE0, 0x4D, 0x7F, 0xD2, 0x0A, 0xA7,
+            0x3F, 0x92, 0x4A, 0xE7, 0xD5, 0x78, 0xA0, 0x0D, 0xC4, 0x69, 0xB1, 0x1C, 0x2E, 0x83, 0x5B, 0xF6,
+            0xE6, 0x4B, 0x93, 0x3E, 0x0C, 0xA1, 0x79, 0xD4, 0x1D, 0xB0, 0x68, 0xC5, 0xF7, 0x5A, 0x82, 0x2F,
+            0xA2, 0x0F, 0xD7, 0x7A, 0x48, 0xE5, 0x3D, 0x90, 0x59, 0xF4, 0x2C, 0x81, 0xB3, 0x1E, 0xC6, 0x6B,
+            0x7B, 0xD6, 0x0E, 0xA3, 0x91, 0x3C, 0xE4, 0x49, 0x80, 0x2D, 0xF5, 0x58, 0x6A, 0xC7, 0x1F, 0xB2
+        },
+        {   // 5 zero bytes
+            0x00, 0x54, 0xA8, 0xFC, 0x7F, 0x2B, 0xD7, 0x83, 0xFE, 0xAA, 0x56, 0x02, 0x81, 0xD5, 0x29, 0x7D,
+            0xD3, 0x87, 0x7B, 0x2F, 0xAC, 0xF8, 0x04, 0x50, 0x2D, 0x79, 0x85, 0xD1, 0x52, 0x06, 0xFA, 0xAE,
+            0x89, 0xDD, 0x21, 0x75, 0xF6, 0xA2, 0x5E, 0x0A, 0x77, 0x23, 0xDF, 0x8B, 0x08, 0x5C, 0xA0, 0xF4,
+            0x5A, 0x0E, 0xF2, 0xA6, 0x25, 0x71, 0x8D, 0xD9, 0xA4, 0xF0, 0x0C, 0x58, 0xDB, 0x8F, 0x73, 0x27,
+            0x3D, 0x69, 0x95, 0xC1, 0x42, 0x16, 0xEA, 0xBE, 0xC3, 0x97, 0x6B, 0x3F, 0xBC, 0xE8, 0x14, 0x40,
+            0xEE, 0xBA, 0x46, 0x12, 0x91, 0xC5, 0x39, 0x6D, 0x10, 0x44, 0xB8, 0xEC, 0x6F, 0x3B, 0xC7, 0x93,
+            0xB4, 0xE0, 0x1C, 0x48, 0xCB, 0x9F, 0x63, 0x37, 0x4A, 0x1E, 0xE2, 0xB6, 0x35, 0x61, 0x9D, 0xC9,
+            0x67, 0x33, 0xCF, 0x9B, 0x18, 0x4C, 0xB0, 0xE4, 0x99, 0xCD, 0x31, 0x65, 0xE6, 0xB2, 0x4E, 0x1A,
+            0x7A, 0x2E, 0xD2, 0x86, 0x05, 0x51, 0xAD, 0xF9, 0x84, 0xD0, 0x2C, 0x78, 0xFB, 0xAF, 0x53, 0x07,
+            0xA9, 0xFD, 0x01, 0x55, 0xD6, 0x82, 0x7E, 0x2A, 0x57, 0x03, 0xFF, 0xAB, 0x28, 0x7C, 0x80, 0xD4,
+            0xF3, 0xA7, 0x5B, 0x0F, 0x8C, 0xD8, 0x24, 0x70, 0x0D, 0x59, 0xA5, 0xF1, 0x72, 0x26, 0xDA, 0x8E,
+            0x20, 0x74, 0x88, 0xDC, 0x5F, 0x0B, 0xF7, 0xA3, 0xDE, 0x8A, 0x76, 0x22, 0xA1, 0xF5, 0x09, 0x5D,
+            0x47, 0x13, 0xEF, 0xBB, 0x38, 0x6C, 0x90, 0xC4, 0xB9, 0xED, 0x11, 0x45, 0xC6, 0x92, 0x6E, 0x3A,
+            0x94, 0xC0, 0x3C, 0x68, 0xEB, 0xBF, 0x43, 0x17, 0x6A, 0x3E, 0xC2, 0x96, 0x15, 0x41, 0xBD, 0xE9,
+            0xCE, 0x9A, 0x66, 0x32, 0xB1, 0xE5, 0x19, 0x4D, 0x30, 0x64, 0x98, 0xCC, 0x4F, 0x1B, 0xE7, 0xB3,
+            0x1D, 0x49, 0xB5, 0xE1, 0x62, 0x36, 0xCA, 0x9E, 0xE3, 0xB7, 0x4B, 0x1F, 0x9C, 0xC8, 0x34, 0x60
+        },
+        {   // 6 zero bytes
+            0x00, 0xF4, 0xC7, 0x33, 0xA1, 0x55, 0x66, 0x92, 0x6D, 0x99, 0xAA, 0x5E, 0xCC, 0x38, 0x0B, 0xFF,
+            0xDA, 0x2E, 0x1D, 0xE9, 0x7B, 0x8F, 0xBC, 0x48, 0xB7, 0x43, 0x70, 0x84, 0x16, 0xE2, 0xD1, 0x25,
+            0x9B, 0x6F, 0x5C, 0xA8, 0x3A, 0xCE, 0xFD, 0x09, 0xF6, 0x02, 0x31, 0xC5, 0x57, 0xA3, 0x90, 0x64,
+            0x41, 0xB5, 0x86, 0x72, 0xE0, 0x14, 0x27, 0xD3, 0x2C, 0xD8, 0xEB, 0x1F, 0x8D, 0x79, 0x4A, 0xBE,
+            0x19, 0xED, 0xDE, 0x2A, 0xB8, 0x4C, 0x7F, 0x8B, 0x74, 0x80, 0xB3, 0x47, 0xD5, 0x21, 0x12, 0xE6,
+            0xC3, 0x37, 0x04, 0xF0, 0x62, 0x96, 0xA5, 0x51, 0xAE, 0x5A, 0x69, 0x9D, 0x0F, 0xFB, 0xC8, 0x3C,
+            0x82, 0x76, 0x45, 0xB1, 0x23, 0xD7, 0xE4, 0x10, 0xEF, 0x1B, 0x28, 0xDC, 0x4E, 0xBA, 0x89, 0x7D,
+            0x58, 0xAC, 0x9F, 0x6B, 0xF9, 0x0D, 0x3E, 0xCA, 0x35, 0xC1, 0xF2, 0x06, 0x94, 0x60, 0x53, 0xA7,
+            0x32, 0xC6, 0xF5, 0x01, 0x93, 0x67, 0x54, 0xA0, 0x5F, 0xAB, 0x98, 0x6C, 0xFE, 0x0A, 0x39, 0xCD,
+            0xE8, 0x1C, 0x2F, 0xDB, 0x49, 0xBD, 0x8E, 0x7A, 0x85, 0x71, 0x42, 0xB6, 0x24, 0xD0, 0xE3, 0x17,
+            0xA9, 0x5D, 0x6E, 0x9A, 0x08, 0xFC, 0xCF, 0x3B, 0xC4, 0x30, 0x03, 0xF7, 0x65, 0x91, 0xA2, 0x56,
+            0x73, 0x87, 0xB4, 0x40, 0xD2, 0x26, 0x15, 0xE1, 0x1E, 0xEA, 0xD9, 0x2D, 0xBF, 0x4B, 0x78, 0x8C,
+            0x2B, 0xDF, 0xEC, 0x18, 0x8A, 0x7E, 0x4D, 0xB9, 0x46, 0xB2, 0x81, 0x75, 0xE7, 0x13, 0x20, 0xD4,
+            0xF1, 0x05, 0x36, 0xC2, 0x50, 0xA4, 0x97, 0x63, 0x9C, 0x68, 0x5B, 0xAF, 0x3D, 0xC9, 0xFA, 0x0E,
+            0xB0, 0x44, 0x77, 0x83, 0x11, 0xE5, 0xD6, 0x22, 0xDD, 0x29, 0x1A, 0xEE, 0x7C, 0x88, 0xBB, 0x4F,
+            0x6A, 0x9E, 0xAD, 0x59, 0xCB, 0x3F, 0x0C, 0xF8, 0x07, 0xF3, 0xC0, 0x34, 0xA6, 0x52, 0x61, 0x95
+        },
+        {   // 7 zero bytes
+            0x00, 0x64, 0xC8, 0xAC, 0xBF, 0xDB, 0x77, 0x13, 0x51, 0x35, 0x99, 0xFD, 0xEE, 0x8A, 0x26, 0x42,
+            0xA2, 0xC6, 0x6A, 0x0E, 0x1D, 0x79, 0xD5, 0xB1, 0xF3, 0x97, 0x3B, 0x5F, 0x4C, 0x28, 0x84, 0xE0,
+            0x6B, 0x0F, 0xA3, 0xC7, 0xD4, 0xB0, 0x1C, 0x78, 0x3A, 0x5E, 0xF2, 0x96, 0x85, 0xE1, 0x4D, 0x29,
+            0xC9, 0xAD, 0x01, 0x65, 0x76, 0x12, 0xBE, 0xDA, 0x98, 0xFC, 0x50, 0x34, 0x27, 0x43, 0xEF, 0x8B,
+            0xD6, 0xB2, 0x1E, 0x7A, 0x69, 0x0D, 0xA1, 0xC5, 0x87, 0xE3, 0x4F, 0x2B, 0x38, 0x5C, 0xF0, 0x94,
+            0x74, 0x10, 0xBC, 0xD8, 0xCB, 0xAF, 0x03, 0x67, 0x25, 0x41, 0xED, 0x89, 0x9A, 0xFE, 0x52, 0x36,
+            0xBD, 0xD9, 0x75, 0x11, 0x02, 0x66, 0xCA, 0xAE, 0xEC, 0x88, 0x24, 0x40, 0x53, 0x37, 0x9B, 0xFF,
+            0x1F, 0x7B, 0xD7, 0xB3, 0xA0, 0xC4, 0x68, 0x0C, 0x4E, 0x2A, 0x86, 0xE2, 0xF1, 0x95, 0x39, 0x5D,
+            0x83, 0xE7, 0x4B, 0x2F, 0x3C, 0x58, 0xF4, 0x90, 0xD2, 0xB6, 0x1A, 0x7E, 0x6D, 0x09, 0xA5, 0xC1,
+            0x21, 0x45, 0xE9, 0x8D, 0x9E, 0xFA, 0x56, 0x32, 0x70, 0x14, 0xB8, 0xDC, 0xCF, 0xAB, 0x07, 0x63,
+            0xE8, 0x8C, 0x20, 0x44, 0x57, 0x33, 0x9F, 0xFB, 0xB9, 0xDD, 0x71, 0x15, 0x06, 0x62, 0xCE, 0xAA,
+            0x4A, 0x2E, 0x82, 0xE6, 0xF5, 0x91, 0x3D, 0x59, 0x1B, 0x7F, 0xD3, 0xB7, 0xA4, 0xC0, 0x6C, 0x08,
+            0x55, 0x31, 0x9D, 0xF9, 0xEA, 0x8E, 0x22, 0x46, 0x04, 0x60, 0xCC, 0xA8, 0xBB, 0xDF, 0x73, 0x17,
+            0xF7, 0x93, 0x3F, 0x5B, 0x48, 0x2C, 0x80, 0xE4, 0xA6, 0xC2, 0x6E, 0x0A, 0x19, 0x7D, 0xD1, 0xB5,
+            0x3E, 0x5A, 0xF6, 0x92, 0x81, 0xE5, 0x49, 0x2D, 0x6F, 0x0B, 0xA7, 0xC3, 0xD0, 0xB4, 0x18, 0x7C,
+            0x9C, 0xF8, 0x54, 0x30, 0x23, 0x47, 0xEB, 0x8F, 0xCD, 0xA9, 0x05, 0x61, 0x72, 0x16, 0xBA, 0xDE
+        }
+};
+
+#define CRC_SLICE(k, x) crc_slice_table[(k) - 1][(x)]
+#endif
+
+// Feeds buffer into a running CRC register, without the final XOR
+static uint8_t UpdateCRC(uint8_t crc, const uint8_t* buffer, uint16_t buffer_size) {
+    uint16_t i = 0;
+#if TINYPROTOCOL_CRC_SLICES == 8
+    for (; buffer_size - i >= 8; i += 8) {
+        crc = CRC_SLICE(7, buffer[i] ^ crc) ^ CRC_SLICE(6, buffer[i + 1]) ^
+              CRC_SLICE(5, buffer[i + 2]) ^ CRC_SLICE(4, buffer[i + 3]) ^
+              CRC_SLICE(3, buffer[i + 4]) ^ CRC_SLICE(2, buffer[i + 5]) ^
+              CRC_SLICE(1, buffer[i + 6]) ^ crc_lookup_table[buffer[i + 7]];
+    }
+#elif TINYPROTOCOL_CRC_SLICES == 4
+    for (; buffer_size - i >= 4; i += 4) {
+        crc = CRC_SLICE(3, buffer[i] ^ crc) ^ CRC_SLICE(2, buffer[i + 1]) ^
+              CRC_SLICE(1, buffer[i + 2]) ^ crc_lookup_table[buffer[i + 3]];
+    }
+#elif TINYPROTOCOL_CRC_SLICES == 2
+    for (; buffer_size - i >= 2; i += 2) {
+        crc = CRC_SLICE(1, buffer[i] ^ crc) ^ crc_lookup_table[buffer[i + 1]];
+    }
+#elif TINYPROTOCOL_CRC_SLICES != 1
+#error TINYPROTOCOL_CRC_SLICES must be 1, 2, 4 or 8
+#endif
+    for (; i < buffer_size; i++) {
         crc = crc_lookup_table[buffer[i] ^ crc];
     }
 
-    return crc ^ crc_xor_value;
+    return crc;
+}
+
+uint8_t TINYPROTOCOL_CalculateCRC(const uint8_t* buffer, uint8_t buffer_size) {
+    return UpdateCRC(crc_init_value, buffer, buffer_size) ^ crc_xor_value;
 }
 
 int16_t TINYPROTOCOL_Initialize() {
+    uint8_t i;
+
+    // Drop every registration and any frame or response in progress
+    for (i = 0; i < TINYPROTOCOL_MAX_CMD_NUM; i++) {
+        tc_size[i] = 0;
+        tlm_pointer_size[i] = 0;
+    }
+    for (i = 0; i < sizeof(tlm_large); i++) {
+        tlm_large[i] = 0;
+    }
+    large_tc_count = 0;
+    registry = 0;
+    tlm_response_count = 0;
+    tlm_bytes_left = 0;
+    current_state = TINYPROTOCOL_FSM_IDLE;
+
     // Register reserved Telecommands
     // Telecommand IDs are included in the size
     tc_size[TINYPROTOCOL_TC_PING] = 1;
@@ -43,6 +250,152 @@ int16_t TINYPROTOCOL_Initialize() {
     return ETINYPROTOCOL_SUCCESS;
 }
 
+#define TLM_IS_LARGE(channel)   ((tlm_large[(channel) >> 3] >> ((channel) & 7)) & 1)
+
+static const struct TINYPROTOCOL_TelecommandEntry* RegistryTelecommand(uint8_t command) {
+    if (registry == 0 || command < TINYPROTOCOL_TC_RESERVED || command >= registry->telecommand_count)
+        return 0;
+    if (registry->telecommands[command].handler == 0)
+        return 0;
+    return &registry->telecommands[command];
+}
+
+static const struct TINYPROTOCOL_TelemetryEntry* RegistryChannel(uint8_t channel) {
+    if (registry == 0 || channel < TINYPROTOCOL_TLM_RESERVED || channel >= registry->telemetry_count)
+        return 0;
+    if (registry->telemetry[channel].ptr == 0 && registry->telemetry[channel].refresh == 0)
+        return 0;
+    return &registry->telemetry[channel];
+}
+
+// Finds a channel in the registry first, then in the channels registered at runtime
+static uint8_t LookupChannel(uint8_t channel, const uint8_t** ptr, uint16_t* size, uint8_t* large) {
+    const struct TINYPROTOCOL_TelemetryEntry* entry = RegistryChannel(channel);
+
+    if (entry) {
+        *ptr = entry->ptr;
+        *size = entry->size;
+        *large = entry->large;
+        return 1;
+    }
+
+    if (channel >= TINYPROTOCOL_MAX_CMD_NUM || tlm_pointer_size[channel] <= 0)
+        return 0;
+
+    *ptr = tlm_pointer[channel];
+    *size = tlm_pointer_size[channel] - 1;
+    *large = TLM_IS_LARGE(channel);
+    return 1;
+}
+
+static uint8_t IsValidChannel(uint8_t channel) {
+    const uint8_t* ptr;
+    uint16_t size;
+    uint8_t large;
+    return LookupChannel(channel, &ptr, &size, &large);
+}
+
+static void SelectResponseChannel(uint8_t pos) {
+    tlm_response_pos = pos;
+    tlm_current_ptr = tlm_response_ptr[pos];
+    tlm_current_size = tlm_response_size[pos];
+    tlm_buffer_idx = 0;
+    tlm_prefix_idx = 0;
+    tlm_prefix_size = 0;
+
+    // Large channels lead with their payload length, little endian
+    if (tlm_response_large[pos]) {
+        tlm_prefix[0] = (uint8_t)tlm_current_size;
+        tlm_prefix[1] = (uint8_t)(tlm_current_size >> 8);
+        tlm_prefix_size = 2;
+        tlm_crc = UpdateCRC(tlm_crc, tlm_prefix, 2);
+    }
+}
+
+static void StartTelemetryResponse(const uint8_t* channels, uint8_t count) {
+    uint8_t i;
+
+    tlm_bytes_left = 1; // CRC
+    for (i = 0; i < count; i++) {
+        LookupChannel(channels[i], &tlm_response_ptr[i], &tlm_response_size[i], &tlm_response_large[i]);
+        tlm_bytes_left += tlm_response_size[i];
+        if (tlm_response_large[i])
+            tlm_bytes_left += 2;
+    }
+
+    tlm_response_count = count;
+    tlm_crc = crc_init_value;
+    SelectResponseChannel(0);
+}
+
+// Makes a large frame the response the master reads next, for a transport
+// without WriteBuffer. The payload is read in place as it goes out.
+static int16_t StageLargeFrame(const struct TINYPROTOCOL_Config *cfg, uint8_t command, const uint8_t* buffer, uint16_t size) {
+    tlm_response_ptr[0] = buffer;
+    tlm_response_size[0] = size;
+    tlm_response_large[0] = 0;
+    tlm_response_count = 1;
+    tlm_bytes_left = 4 + size + 1;
+
+    tlm_crc = crc_init_value;
+    SelectResponseChannel(0);
+    tlm_prefix[0] = TINYPROTOCOL_MAGIC;
+    tlm_prefix[1] = command;
+    tlm_prefix[2] = (uint8_t)size;
+    tlm_prefix[3] = (uint8_t)(size >> 8);
+    tlm_prefix_size = 4;
+    tlm_crc = UpdateCRC(tlm_crc, &tlm_prefix[1], 3);
+
+    if (cfg->TINYPROTOCOL_TelemetryReady)
+        return cfg->TINYPROTOCOL_TelemetryReady();
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+// Lets the app refresh each requested channel, then tells it the response can be read
+static void NotifyTelemetryRequest(const struct TINYPROTOCOL_Config *cfg, const uint8_t* channels, uint8_t count) {
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+        const struct TINYPROTOCOL_TelemetryEntry* entry = RegistryChannel(channels[i]);
+        if (entry) {
+            if (entry->refresh)
+                entry->refresh();
+        } else if (cfg->TINYPROTOCOL_ProcessTelemetryRequest) {
+            cfg->TINYPROTOCOL_ProcessTelemetryRequest(channels[i]);
+        }
+    }
+
+    if (cfg->TINYPROTOCOL_TelemetryReady)
+        cfg->TINYPROTOCOL_TelemetryReady();
+}
+
+static TINYPROTOCOL_LargeTelecommand* FindLargeTelecommand(uint8_t command) {
+    uint8_t i;
+    for (i = 0; i < large_tc_count; i++) {
+        if (large_tc[i].command == command)
+            return &large_tc[i];
+    }
+    return 0;
+}
+
+static void StartLargeTelecommand(uint8_t* buffer, uint16_t max_size) {
+    large_tc_buffer = buffer;
+    large_tc_max = max_size;
+    large_tc_size = 0;
+    large_tc_idx = 0;
+    large_tc_crc = crc_lookup_table[tlcmd_current ^ crc_init_value];
+    current_state = TINYPROTOCOL_FSM_EXPECT_LARGE_LEN;
+}
+
+static uint8_t IsValidBurst(const uint8_t* channels, uint8_t count) {
+    uint8_t i;
+    for (i = 0; i < count; i++) {
+        if (channels[i] == TINYPROTOCOL_TLM_BURST || !IsValidChannel(channels[i]))
+            return 0;
+    }
+    return 1;
+}
+
 int16_t TINYPROTOCOL_ParseByte(const struct TINYPROTOCOL_Config *cfg, uint8_t byte) {
     switch(current_state) {
         case TINYPROTOCOL_FSM_IDLE:
@@ -56,24 +409,51 @@ int16_t TINYPROTOCOL_ParseByte(const struct TINYPROTOCOL_Config *cfg, uint8_t by
             if ((byte & 0x80) != 0) {
                 // get the channel crosponding for the tele request cmd received. 
                 tlm_current_channel = (byte & 0x7F);
-                tlm_buffer_idx = 0;
                 current_state = TINYPROTOCOL_FSM_EXPECT_TLM_REQ;
 
-                // check if tele request cmd is a valid cmd
-                if(tlm_pointer_size[tlm_current_channel] <= 0) {
+                // Any response still being read is dropped
+                tlm_response_count = 0;
+                tlm_bytes_left = 0;
+
+                if (tlm_current_channel == TINYPROTOCOL_TLM_BURST) {
+                    // rx_buffer collects the burst ID, channel count and channel list for the CRC
+                    rx_buffer[0] = tlm_current_channel;
+                    tlcmd_buffer_idx = 1;
+                    current_state = TINYPROTOCOL_FSM_EXPECT_BURST;
+                } else if(!IsValidChannel(tlm_current_channel)) { // check if tele request cmd is a valid cmd
                     TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EINVALID_TLM_REQ;
                     current_state = TINYPROTOCOL_FSM_IDLE;
                     // TODO add a return here
                 }
             } else {
+                const struct TINYPROTOCOL_TelecommandEntry* entry = RegistryTelecommand(byte);
+
                 tlcmd_current = byte;
                 tlcmd_buffer_idx = 0;
                 current_state = TINYPROTOCOL_FSM_EXPECT_TC;
 
-                if(tc_size[tlcmd_current] <= 0) {
-                    TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EINVALID_TC;
-                    current_state = TINYPROTOCOL_FSM_IDLE;
-                    return -ETINYPROTOCOL_INVALID_CMD_ID;
+                if (entry) {
+                    // One table lookup, no registration needed
+                    tlcmd_handler = entry->handler;
+                    if (entry->large_buffer) {
+                        StartLargeTelecommand(entry->large_buffer, entry->size);
+                        break;
+                    }
+                    tlcmd_size = (uint8_t)entry->size + 1;
+                } else {
+                    tlcmd_handler = 0;
+                    if(tlcmd_current >= TINYPROTOCOL_MAX_CMD_NUM || tc_size[tlcmd_current] <= 0) {
+                        TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EINVALID_TC;
+                        current_state = TINYPROTOCOL_FSM_IDLE;
+                        return -ETINYPROTOCOL_INVALID_CMD_ID;
+                    }
+
+                    if (tc_size[tlcmd_current] == TINYPROTOCOL_LARGE_FRAME) {
+                        TINYPROTOCOL_LargeTelecommand* large = FindLargeTelecommand(tlcmd_current);
+                        StartLargeTelecommand(large->buffer, large->max_size);
+                        break;
+                    }
+                    tlcmd_size = tc_size[tlcmd_current];
                 }
 
                 rx_buffer[tlcmd_buffer_idx ++] = tlcmd_current;
@@ -83,22 +463,88 @@ int16_t TINYPROTOCOL_ParseByte(const struct TINYPROTOCOL_Config *cfg, uint8_t by
             if (TINYPROTOCOL_CalculateCRC(&tlm_current_channel, 1) != byte) {
                 TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EINVALID_CRC;
             } else {
-                cfg->TINYPROTOCOL_ProcessTelemetryRequest(TlmAckPacket.last_command & 0x7F);
+                StartTelemetryResponse(&tlm_current_channel, 1);
+                NotifyTelemetryRequest(cfg, &tlm_current_channel, 1);
+                TlmAckPacket.result = TLM_ACK_PACKET_RESULT_COMPLETED;
+            }
+
+            current_state = TINYPROTOCOL_FSM_IDLE;
+            break;
+        case TINYPROTOCOL_FSM_EXPECT_BURST:
+            if (tlcmd_buffer_idx == 1) {
+                // Channel count
+                if (byte == 0 || byte > TINYPROTOCOL_MAX_BURST_CHANNELS) {
+                    TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EINVALID_TLM_REQ;
+                    current_state = TINYPROTOCOL_FSM_IDLE;
+                    break;
+                }
+                rx_buffer[tlcmd_buffer_idx ++] = byte;
+            } else if (tlcmd_buffer_idx < rx_buffer[1] + 2) {
+                // Channel list
+                rx_buffer[tlcmd_buffer_idx ++] = byte;
+            } else {
+                if (TINYPROTOCOL_CalculateCRC(rx_buffer, tlcmd_buffer_idx) != byte) {
+                    TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EINVALID_CRC;
+                } else if (!IsValidBurst(&rx_buffer[2], rx_buffer[1])) {
+                    TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EINVALID_TLM_REQ;
+                } else {
+                    // One response for every channel, the app refreshes each of them in turn
+                    StartTelemetryResponse(&rx_buffer[2], rx_buffer[1]);
+                    NotifyTelemetryRequest(cfg, &rx_buffer[2], rx_buffer[1]);
+                    TlmAckPacket.result = TLM_ACK_PACKET_RESULT_COMPLETED;
+                }
+
+                current_state = TINYPROTOCOL_FSM_IDLE;
+            }
+            break;
+        case TINYPROTOCOL_FSM_EXPECT_LARGE_LEN:
+            // Payload length, little endian
+            large_tc_crc = crc_lookup_table[byte ^ large_tc_crc];
+            large_tc_size |= (uint16_t)byte << (8 * large_tc_idx);
+
+            if (++large_tc_idx == 2) {
+                if (large_tc_size > large_tc_max) {
+                    TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EOVERFLOW;
+                    current_state = TINYPROTOCOL_FSM_IDLE;
+                    return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+                }
+                large_tc_idx = 0;
+                current_state = TINYPROTOCOL_FSM_EXPECT_LARGE_TC;
+            }
+            break;
+        case TINYPROTOCOL_FSM_EXPECT_LARGE_TC:
+            if (large_tc_idx < large_tc_size) {
+                large_tc_buffer[large_tc_idx ++] = byte;
+                large_tc_crc = crc_lookup_table[byte ^ large_tc_crc];
+                break;
+            }
+
+            large_tc_crc ^= crc_xor_value;
+            if (large_tc_crc == byte) {
+                TlmAckPacket.result = TLM_ACK_PACKET_RESULT_PROCESSING;
+                if (tlcmd_handler)
+                    tlcmd_handler(large_tc_buffer, large_tc_size);
+                else
+                    cfg->TINYPROTOCOL_ProcessTelecommand(tlcmd_current, large_tc_buffer, large_tc_size);
                 TlmAckPacket.result = TLM_ACK_PACKET_RESULT_COMPLETED;
+            } else {
+                TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EINVALID_CRC;
             }
 
             current_state = TINYPROTOCOL_FSM_IDLE;
             break;
         case TINYPROTOCOL_FSM_EXPECT_TC:
-            if (tlcmd_buffer_idx == tc_size[tlcmd_current]) {
-                if (TINYPROTOCOL_CalculateCRC(rx_buffer, tc_size[tlcmd_current]) == byte) {
+            if (tlcmd_buffer_idx == tlcmd_size) {
+                if (TINYPROTOCOL_CalculateCRC(rx_buffer, tlcmd_size) == byte) {
                     TlmAckPacket.result = TLM_ACK_PACKET_RESULT_PROCESSING;
 
-                    if (tc_size[tlcmd_current] == 1) {
+                    if (tlcmd_handler) {
+                        tlcmd_handler(&rx_buffer[1], tlcmd_size - 1);
+                    } else if (tlcmd_size == 1) {
                         uint8_t dummy = 0;
                         cfg->TINYPROTOCOL_ProcessTelecommand(rx_buffer[0], &dummy, 1);
                     } else {
-                        cfg->TINYPROTOCOL_ProcessTelecommand(rx_buffer[0], &rx_buffer[1], tc_size[tlcmd_current] - 1);
+                        cfg->TINYPROTOCOL_ProcessTelecommand(rx_buffer[0], &rx_buffer[1], tlcmd_size - 1);
                     }
 
                     TlmAckPacket.result = TLM_ACK_PACKET_RESULT_COMPLETED;
@@ -120,7 +566,10 @@ int16_t TINYPROTOCOL_ParseByte(const struct TINYPROTOCOL_Config *cfg, uint8_t by
 }
 
 int16_t TINYPROTOCOL_RegisterTelecommand(uint8_t cmd, uint8_t size) {
-    if (cmd > TINYPROTOCOL_MAX_CMD_NUM)
+    if (size > TINYPROTOCOL_MAX_PAYLOAD_SIZE)
+        return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+
+    if (cmd >= TINYPROTOCOL_MAX_CMD_NUM)
         return -ETINYPROTOCOL_INVALID_CMD_ID;
 
     if (cmd < TINYPROTOCOL_TC_RESERVED || tc_size[cmd] > 0)
@@ -130,6 +579,25 @@ int16_t TINYPROTOCOL_RegisterTelecommand(uint8_t cmd, uint8_t size) {
     return ETINYPROTOCOL_SUCCESS;
 }
 
+int16_t TINYPROTOCOL_RegisterLargeTelecommand(uint8_t cmd, uint8_t* buffer, uint16_t max_size) {
+    if (max_size > TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE)
+        return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+
+    if (cmd >= TINYPROTOCOL_MAX_CMD_NUM)
+        return -ETINYPROTOCOL_INVALID_CMD_ID;
+
+    if (cmd < TINYPROTOCOL_TC_RESERVED || tc_size[cmd] > 0 || large_tc_count >= TINYPROTOCOL_MAX_LARGE_TELECOMMANDS)
+        return -ETINYPROTOCOL_CMD_USED;
+
+    large_tc[large_tc_count].command = cmd;
+    large_tc[large_tc_count].buffer = buffer;
+    large_tc[large_tc_count].max_size = max_size;
+    large_tc_count++;
+
+    tc_size[cmd] = TINYPROTOCOL_LARGE_FRAME;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
 int16_t TINYPROTOCOL_SendTelecommand(const struct TINYPROTOCOL_Config *cfg, uint8_t command, const uint8_t* buffer, uint8_t size) {
     if (size > TINYPROTOCOL_MAX_PAYLOAD_SIZE)
         return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
@@ -146,6 +614,40 @@ int16_t TINYPROTOCOL_SendTelecommand(const struct TINYPROTOCOL_Config *cfg, uint
     return cfg->TINYPROTOCOL_WriteBuffer(tc_send_buffer_tmp, size + 3);
 }
 
+int16_t TINYPROTOCOL_SendLargeTelecommand(const struct TINYPROTOCOL_Config *cfg, uint8_t command, const uint8_t* buffer, uint16_t size) {
+    uint8_t crc;
+    int16_t result;
+
+    if (size > TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE)
+        return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+
+    if (cfg->TINYPROTOCOL_WriteBuffer == 0)
+        return StageLargeFrame(cfg, command, buffer, size);
+
+    tc_send_buffer_tmp[0] = TINYPROTOCOL_MAGIC;
+    tc_send_buffer_tmp[1] = command;
+    tc_send_buffer_tmp[2] = (uint8_t)size;
+    tc_send_buffer_tmp[3] = (uint8_t)(size >> 8);
+    crc = UpdateCRC(crc_init_value, &tc_send_buffer_tmp[1], 3);
+
+    result = cfg->TINYPROTOCOL_WriteBuffer(tc_send_buffer_tmp, 4);
+
+    // The payload is written in place, in pieces WriteBuffer can take
+    while (size > 0 && result >= ETINYPROTOCOL_SUCCESS) {
+        uint8_t chunk = (size > 0xFF) ? 0xFF : (uint8_t)size;
+        crc = UpdateCRC(crc, buffer, chunk);
+        result = cfg->TINYPROTOCOL_WriteBuffer(buffer, chunk);
+        buffer += chunk;
+        size -= chunk;
+    }
+
+    if (result < ETINYPROTOCOL_SUCCESS)
+        return result;
+
+    tc_send_buffer_tmp[0] = crc ^ crc_xor_value;
+    return cfg->TINYPROTOCOL_WriteBuffer(tc_send_buffer_tmp, 1);
+}
+
 int16_t TINYPROTOCOL_SendEmptyTelecommand(const struct TINYPROTOCOL_Config *cfg, uint8_t command) {
     tc_send_buffer_tmp[0] = TINYPROTOCOL_MAGIC;
     tc_send_buffer_tmp[1] = command;
@@ -157,7 +659,23 @@ int16_t TINYPROTOCOL_RegisterTelemetryChannel(uint8_t tlm_channel, const uint8_t
     if (size > TINYPROTOCOL_MAX_PAYLOAD_SIZE)
         return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
 
-    if (tlm_channel > TINYPROTOCOL_MAX_CMD_NUM)
+    if (tlm_channel >= TINYPROTOCOL_MAX_CMD_NUM)
+        return -ETINYPROTOCOL_INVALID_CMD_ID;
+
+    if (tlm_channel < TINYPROTOCOL_TLM_RESERVED || tlm_pointer_size[tlm_channel] > 0)
+        return -ETINYPROTOCOL_CMD_USED;
+
+    tlm_pointer[tlm_channel] = ptr;
+    tlm_pointer_size[tlm_channel] = size + 1; // Include 1 extra byte for the CRC
+
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+int16_t TINYPROTOCOL_RegisterLargeTelemetryChannel(uint8_t tlm_channel, const uint8_t* ptr, uint16_t size) {
+    if (size > TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE)
+        return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+
+    if (tlm_channel >= TINYPROTOCOL_MAX_CMD_NUM)
         return -ETINYPROTOCOL_INVALID_CMD_ID;
 
     if (tlm_channel < TINYPROTOCOL_TLM_RESERVED || tlm_pointer_size[tlm_channel] > 0)
@@ -165,7 +683,38 @@ int16_t TINYPROTOCOL_RegisterTelemetryChannel(uint8_t tlm_channel, const uint8_t
 
     tlm_pointer[tlm_channel] = ptr;
     tlm_pointer_size[tlm_channel] = size + 1; // Include 1 extra byte for the CRC
+    tlm_large[tlm_channel >> 3] |= 1 << (tlm_channel & 7);
+
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+int16_t TINYPROTOCOL_SetRegistry(const struct TINYPROTOCOL_Registry* table) {
+    uint8_t i;
+
+    if (table) {
+        if (table->telecommand_count > TINYPROTOCOL_MAX_CMD_NUM || table->telemetry_count > TINYPROTOCOL_MAX_CMD_NUM)
+            return -ETINYPROTOCOL_INVALID_CMD_ID;
+
+        for (i = 0; i < table->telecommand_count; i++) {
+            const struct TINYPROTOCOL_TelecommandEntry* entry = &table->telecommands[i];
+            uint16_t limit = entry->large_buffer ? TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE : TINYPROTOCOL_MAX_PAYLOAD_SIZE;
+            if (entry->handler && entry->size > limit)
+                return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+        }
+
+        for (i = 0; i < table->telemetry_count; i++) {
+            const struct TINYPROTOCOL_TelemetryEntry* entry = &table->telemetry[i];
+            uint16_t limit = entry->large ? TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE : TINYPROTOCOL_MAX_PAYLOAD_SIZE;
+            if ((entry->ptr || entry->refresh) && entry->size > limit)
+                return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+            // A refresh handler alone has no buffer to send the payload from
+            if (entry->ptr == 0 && entry->size != 0)
+                return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+        }
+    }
 
+    registry = table;
+    current_state = TINYPROTOCOL_FSM_IDLE;
     return ETINYPROTOCOL_SUCCESS;
 }
 
@@ -180,37 +729,70 @@ int16_t TINYPROTOCOL_SendTelemetryRequest(const struct TINYPROTOCOL_Config *cfg,
     return cfg->TINYPROTOCOL_WriteBuffer(buf, 3);
 }
 
+int16_t TINYPROTOCOL_SendTelemetryBurstRequest(const struct TINYPROTOCOL_Config *cfg, const uint8_t* channels, uint8_t count) {
+    uint8_t buf[TINYPROTOCOL_MAX_BURST_CHANNELS + 4];
+    uint8_t i;
+
+    if (count == 0 || count > TINYPROTOCOL_MAX_BURST_CHANNELS)
+        return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+
+    buf[0] = TINYPROTOCOL_MAGIC;
+    buf[1] = TINYPROTOCOL_TLM_BURST;
+    buf[2] = count;
+    for (i = 0; i < count; i++) {
+        buf[i + 3] = channels[i];
+    }
+
+    // Like single requests, the CRC covers the ID without the telemetry bit
+    buf[count + 3] = TINYPROTOCOL_CalculateCRC(&buf[1], count + 2);
+    buf[1] |= 0x80;
+
+    return cfg->TINYPROTOCOL_WriteBuffer(buf, count + 4);
+}
+
 int16_t TINYPROTOCOL_ReadNextTelemetryByte(uint8_t *byte) {
     *byte = 0xFF;
 
-    if(tlm_current_channel > TINYPROTOCOL_MAX_CMD_NUM || tlm_pointer_size[tlm_current_channel] <= 0) {
+    if (tlm_response_count == 0) {
         TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EINVALID_TLM_REQ;
         return -ETINYPROTOCOL_INVALID_CMD_ID;
     }
 
-    if (tlm_buffer_idx >= tlm_pointer_size[tlm_current_channel]) {
+    if (tlm_bytes_left == 0) {
         TlmAckPacket.result = TLM_ACK_PACKET_RESULT_EOVERFLOW;
         return -ETINYPROTOCOL_OVERFLOW;
     }
 
-    if (tlm_buffer_idx == tlm_pointer_size[tlm_current_channel] - 1) {
-        *byte = TINYPROTOCOL_CalculateCRC(tlm_pointer[tlm_current_channel], tlm_pointer_size[tlm_current_channel] - 1);
-        tlm_buffer_idx ++;
+    // The CRC is accumulated as the payload goes out, so the last byte costs
+    // the same as every other one instead of a pass over the whole channel.
+    if (tlm_bytes_left == 1) {
+        *byte = tlm_crc ^ crc_xor_value;
     } else {
-        *byte = tlm_pointer[tlm_current_channel][tlm_buffer_idx++];
+        // Move on to the next channel of a burst once this one is sent
+        while (tlm_prefix_idx == tlm_prefix_size && tlm_buffer_idx >= tlm_current_size) {
+            SelectResponseChannel(tlm_response_pos + 1);
+        }
+
+        if (tlm_prefix_idx != tlm_prefix_size) {
+            *byte = tlm_prefix[tlm_prefix_idx++];
+        } else {
+            *byte = tlm_current_ptr[tlm_buffer_idx++];
+            tlm_crc = crc_lookup_table[*byte ^ tlm_crc];
+        }
     }
 
+    tlm_bytes_left --;
     return ETINYPROTOCOL_SUCCESS;
 }
 
 int16_t TINYPROTOCOL_TelemetryBytesLeft() {
-    if(tlm_current_channel > TINYPROTOCOL_MAX_CMD_NUM || tlm_pointer_size[tlm_current_channel] <= 0) {
+    if (tlm_response_count == 0) {
         return -ETINYPROTOCOL_INVALID_CMD_ID;
     }
 
-    if (tlm_buffer_idx >= tlm_pointer_size[tlm_current_channel]) {
+    if (tlm_bytes_left == 0) {
         return -ETINYPROTOCOL_OVERFLOW;
     }
 
-    return (int16_t)(tlm_pointer_size[tlm_current_channel] - tlm_buffer_idx);
+    return (int16_t)tlm_bytes_left;
 }
@@ -7,14 +7,21 @@
 
 #include <stdint.h>
 
+// Number of bytes folded into the CRC per loop iteration (1, 2, 4 or 8).
+// 1 only needs the 256 byte table below; every extra slice costs another
+// 256 byte table, so keep 1 on the MSP430 and raise it for host / ground tools.
+#ifndef TINYPROTOCOL_CRC_SLICES
+#define TINYPROTOCOL_CRC_SLICES             1
+#endif
+
 // Start condition for the CRC algorithm
-const static uint8_t crc_init_value = 0xFF;
+static const uint8_t crc_init_value = 0xFF;
 
 // Value XORed to the final register before the CRC is returned
-const static uint8_t crc_xor_value = 0xFF;
+static const uint8_t crc_xor_value = 0xFF;
 
 // Pre-computed AUTOSAR CRC8 table
-const static uint8_t crc_lookup_table[256] = {
+static const uint8_t crc_lookup_table[256] = {
         0x00, 0x2F, 0x5E, 0x71, 0xBC, 0x93, 0xE2, 0xCD, 0x57, 0x78, 0x09, 0x26, 0xEB, 0xC4, 0xB5, 0x9A,
         0xAE, 0x81, 0xF0, 0xDF, 0x12, 0x3D, 0x4C, 0x63, 0xF9, 0xD6, 0xA7, 0x88, 0x45, 0x6A, 0x1B, 0x34,
         0x73, 0x5C, 0x2D, 0x02, 0xCF, 0xE0, 0x91, 0xBE, 0x24, 0x0B, 0x7A, 0x55, 0x98, 0xB7, 0xC6, 0xE9,
@@ -32,10 +39,43 @@ const static uint8_t crc_lookup_table[256] = {
         0x76, 0x59, 0x28, 0x07, 0xCA, 0xE5, 0x94, 0xBB, 0x21, 0x0E, 0x7F, 0x50, 0x9D, 0xB2, 0xC3, 0xEC,
         0xD8, 0xF7, 0x86, 0xA9, 0x64, 0x4B, 0x3A, 0x15, 0x8F, 0xA0, 0xD1, 0xFE, 0x33, 0x1C, 0x6D, 0x42 };
 
+// A slave that cannot write on its own, like an I2C slave, leaves WriteBuffer
+// NULL. TINYPROTOCOL_SendLargeTelecommand then makes the frame the response
+// the master reads next with ReadNextTelemetryByte, straight from the payload
+// buffer, which has to stay unchanged until it is read or replaced.
 struct TINYPROTOCOL_Config{
-    int16_t (*TINYPROTOCOL_ProcessTelecommand)(uint8_t command, const uint8_t* buffer, uint8_t size);
+    int16_t (*TINYPROTOCOL_ProcessTelecommand)(uint8_t command, const uint8_t* buffer, uint16_t size);
     int16_t (*TINYPROTOCOL_ProcessTelemetryRequest)(uint8_t command);
     int16_t (*TINYPROTOCOL_WriteBuffer)(const uint8_t* buffer, uint8_t size);
+    int16_t (*TINYPROTOCOL_TelemetryReady)(void);   // Optional, called once a response can be read
+};
+
+// Registry: per-ID command tables the app keeps as const data (FRAM on the
+// MSP430). ParseByte finds a command with one index into the table and calls
+// its handler directly, so there is no registration at boot and no switch in
+// the app. IDs without an entry fall back to the Register* functions and the
+// Config callbacks.
+typedef int16_t (*TINYPROTOCOL_TelecommandHandler)(const uint8_t* buffer, uint16_t size);
+typedef int16_t (*TINYPROTOCOL_TelemetryHandler)(void);
+
+struct TINYPROTOCOL_TelecommandEntry {
+    TINYPROTOCOL_TelecommandHandler handler;    // NULL: no entry for this ID
+    uint16_t size;                              // Payload size, or largest payload of a large frame
+    uint8_t* large_buffer;                      // Set for large frame telecommands, receives the payload
+};
+
+struct TINYPROTOCOL_TelemetryEntry {
+    const uint8_t* ptr;
+    uint16_t size;
+    uint8_t large;                              // Sent as a large frame
+    TINYPROTOCOL_TelemetryHandler refresh;      // Optional, refreshes the contents of the channel buffer before sending
+};
+
+struct TINYPROTOCOL_Registry {
+    const struct TINYPROTOCOL_TelecommandEntry* telecommands;   // Indexed by command ID
+    uint8_t telecommand_count;
+    const struct TINYPROTOCOL_TelemetryEntry* telemetry;        // Indexed by channel ID
+    uint8_t telemetry_count;
 };
 
 int16_t TINYPROTOCOL_Initialize();
@@ -44,14 +84,27 @@ int16_t TINYPROTOCOL_ParseByte(const struct TINYPROTOCOL_Config *cfg, uint8_t by
 // Slave functions
 int16_t TINYPROTOCOL_RegisterTelecommand(uint8_t command, uint8_t size);
 int16_t TINYPROTOCOL_RegisterTelemetryChannel(uint8_t tlm_channel, const uint8_t* ptr, uint8_t size);
+
+// Large frame variants, for payloads above TINYPROTOCOL_MAX_PAYLOAD_SIZE. The
+// frame carries a 16 bit little endian payload length after the command ID
+// (telecommands) or ahead of the payload (telemetry responses), covered by the
+// frame CRC. The received payload of a large telecommand is written to buffer.
+int16_t TINYPROTOCOL_RegisterLargeTelecommand(uint8_t command, uint8_t* buffer, uint16_t max_size);
+int16_t TINYPROTOCOL_RegisterLargeTelemetryChannel(uint8_t tlm_channel, const uint8_t* ptr, uint16_t size);
+int16_t TINYPROTOCOL_SetRegistry(const struct TINYPROTOCOL_Registry* registry);
 int16_t TINYPROTOCOL_ReadNextTelemetryByte(uint8_t *byte);
 int16_t TINYPROTOCOL_TelemetryBytesLeft();
 
 // Master functions 
 int16_t TINYPROTOCOL_SendTelecommand(const struct TINYPROTOCOL_Config *cfg, uint8_t tlcmd, const uint8_t* buffer, uint8_t size);
+int16_t TINYPROTOCOL_SendLargeTelecommand(const struct TINYPROTOCOL_Config *cfg, uint8_t tlcmd, const uint8_t* buffer, uint16_t size);
 int16_t TINYPROTOCOL_SendEmptyTelecommand(const struct TINYPROTOCOL_Config *cfg, uint8_t tlcmd);
 int16_t TINYPROTOCOL_SendTelemetryRequest(const struct TINYPROTOCOL_Config *cfg, uint8_t tlm_req);
 
+// Requests several telemetry channels in one frame. The slave answers with the
+// payloads of all channels concatenated in the given order, followed by one CRC.
+int16_t TINYPROTOCOL_SendTelemetryBurstRequest(const struct TINYPROTOCOL_Config *cfg, const uint8_t* channels, uint8_t count);
+
 uint8_t TINYPROTOCOL_CalculateCRC(const uint8_t* buffer, uint8_t buffer_size);
 
 typedef enum {
@@ -59,6 +112,9 @@ typedef enum {
     TINYPROTOCOL_FSM_EXPECT_CMD,
     TINYPROTOCOL_FSM_EXPECT_TLM_REQ,
     TINYPROTOCOL_FSM_EXPECT_TC,
+    TINYPROTOCOL_FSM_EXPECT_BURST,
+    TINYPROTOCOL_FSM_EXPECT_LARGE_LEN,
+    TINYPROTOCOL_FSM_EXPECT_LARGE_TC,
 } TINYPROTOCOL_ReceiveFSM;
 
 typedef enum {
@@ -80,6 +136,16 @@ typedef struct {
 #define TINYPROTOCOL_MAX_CMD_NUM            127
 #define TINYPROTOCOL_MAX_PACKET_SIZE        14
 #define TINYPROTOCOL_MAX_PAYLOAD_SIZE       (TINYPROTOCOL_MAX_PACKET_SIZE - 3)
+#define TINYPROTOCOL_MAX_BURST_CHANNELS     8
+#define TINYPROTOCOL_LARGE_FRAME            0xFF    // Telecommand size marking a large frame command
+
+// Largest payload of a large frame, and how many large telecommands can be registered
+#ifndef TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE
+#define TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE 1024
+#endif
+#ifndef TINYPROTOCOL_MAX_LARGE_TELECOMMANDS
+#define TINYPROTOCOL_MAX_LARGE_TELECOMMANDS 4
+#endif
 
 // ERRORS
 #define ETINYPROTOCOL_SUCCESS               0
@@ -94,6 +160,7 @@ typedef struct {
 #define TINYPROTOCOL_TC_RESERVED            1
 #define TINYPROTOCOL_TLM_ACK                0
 #define TINYPROTOCOL_TLM_RESERVED           1
+#define TINYPROTOCOL_TLM_BURST              TINYPROTOCOL_MAX_CMD_NUM  // Never a channel, marks a burst request
 
 // BUFFER SIZES
 #define TINYPROTOCOL_RX_BUFF_SIZE           127
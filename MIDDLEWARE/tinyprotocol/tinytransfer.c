@@ -0,0 +1,521 @@
+//
+// Segmented bulk transfers on top of tinyprotocol, see tinytransfer.h
+//
+
+#include "tinytransfer.h"
+
+#define TINYTRANSFER_ACK_SIZE       6
+
+typedef enum {
+    SENDER_IDLE,
+    SENDER_STARTING,    // START sent, waiting for the first ACK
+    SENDER_SENDING,
+    SENDER_ENDING,      // END sent, waiting for DONE
+    SENDER_DONE,
+    SENDER_FAILED,
+} TINYTRANSFER_SenderState;
+
+static struct {
+    const struct TINYPROTOCOL_Config *cfg;
+    uint8_t data_cmd;
+    uint8_t window;
+    uint16_t timeout;
+
+    const uint8_t *object;
+    uint32_t size;
+    uint16_t segment_size;
+    uint16_t segment_count;
+    uint16_t object_crc;
+    uint8_t id;
+    uint8_t attempts;
+    uint8_t timeouts;       // In a row, since the last step forward
+    uint8_t result;
+    TINYTRANSFER_SenderState state;
+
+    uint16_t base;          // First segment not acknowledged
+    uint16_t next;          // First segment never sent
+    uint16_t acked;         // Bit i: segment base + i acknowledged
+    uint16_t fast_resent;   // Bit i: segment base + i already resent for a gap in the ACKs
+    uint16_t sent_tick[TINYTRANSFER_MAX_WINDOW];  // Indexed by sequence number modulo the window
+    uint16_t control_tick;  // When START / END was last sent
+    uint16_t tick;
+
+    TINYTRANSFER_SenderStats stats;
+} sender;
+
+// Frames are built in these buffers and stay there until the next one, where
+// a master reading them from a slave finds them
+static uint8_t sender_ack_buffer[TINYTRANSFER_ACK_SIZE];
+static uint8_t sender_tx_buffer[TINYTRANSFER_HEADER_SIZE + TINYTRANSFER_MAX_SEGMENT_SIZE];
+
+static struct {
+    const struct TINYPROTOCOL_Config *cfg;
+    uint8_t ack_cmd;
+    uint8_t *object;
+    uint32_t capacity;
+
+    uint32_t size;
+    uint16_t segment_size;
+    uint16_t segment_count;
+    uint8_t id;
+    TINYTRANSFER_Status status;
+
+    uint16_t base;          // Next segment expected in order
+    uint16_t received;      // Bit i: segment base + 1 + i already stored
+    uint8_t result;         // Reported in DONE once the END frame was checked
+} receiver;
+
+static uint8_t receiver_rx_buffer[TINYTRANSFER_HEADER_SIZE + TINYTRANSFER_MAX_SEGMENT_SIZE];
+static uint8_t receiver_tx_buffer[TINYTRANSFER_ACK_SIZE];
+
+// CRC-16/CCITT-FALSE, one nibble at a time to keep the table at 32 bytes
+static const uint16_t crc16_nibble_table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF };
+
+uint16_t TINYTRANSFER_CalculateCRC16(uint16_t crc, const uint8_t* buffer, uint32_t size) {
+    uint32_t i;
+    for (i = 0; i < size; i++) {
+        crc = (crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (buffer[i] >> 4)];
+        crc = (crc << 4) ^ crc16_nibble_table[(crc >> 12) ^ (buffer[i] & 0x0F)];
+    }
+    return crc;
+}
+
+static void PutU16(uint8_t *buffer, uint16_t value) {
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t GetU16(const uint8_t *buffer) {
+    return (uint16_t)buffer[0] | ((uint16_t)buffer[1] << 8);
+}
+
+//***************************Sender***************************************************
+
+static void SendStart(void) {
+    uint8_t *frame = sender_tx_buffer;
+
+    frame[0] = TINYTRANSFER_FRAME_START;
+    frame[1] = sender.id;
+    PutU16(&frame[2], (uint16_t)sender.size);
+    PutU16(&frame[4], (uint16_t)(sender.size >> 16));
+    PutU16(&frame[6], sender.segment_size);
+
+    sender.control_tick = sender.tick;
+    TINYPROTOCOL_SendLargeTelecommand(sender.cfg, sender.data_cmd, frame, 8);
+}
+
+static void SendEnd(void) {
+    uint8_t *frame = sender_tx_buffer;
+
+    frame[0] = TINYTRANSFER_FRAME_END;
+    frame[1] = sender.id;
+    PutU16(&frame[2], sender.object_crc);
+
+    sender.control_tick = sender.tick;
+    TINYPROTOCOL_SendLargeTelecommand(sender.cfg, sender.data_cmd, frame, 4);
+}
+
+static void SendSegment(uint16_t seq) {
+    uint32_t offset = (uint32_t)seq * sender.segment_size;
+    uint16_t length = sender.segment_size;
+    uint16_t i;
+
+    if (offset + length > sender.size)
+        length = (uint16_t)(sender.size - offset);
+
+    sender_tx_buffer[0] = TINYTRANSFER_FRAME_DATA;
+    sender_tx_buffer[1] = sender.id;
+    PutU16(&sender_tx_buffer[2], seq);
+    for (i = 0; i < length; i++) {
+        sender_tx_buffer[TINYTRANSFER_HEADER_SIZE + i] = sender.object[offset + i];
+    }
+
+    sender.sent_tick[seq % TINYTRANSFER_MAX_WINDOW] = sender.tick;
+    sender.stats.segments_sent++;
+    TINYPROTOCOL_SendLargeTelecommand(sender.cfg, sender.data_cmd, sender_tx_buffer, TINYTRANSFER_HEADER_SIZE + length);
+}
+
+static void FillWindow(void) {
+    while (sender.next < sender.segment_count && sender.next - sender.base < sender.window) {
+        SendSegment(sender.next++);
+    }
+}
+
+// (Re)starts the object under a new ID, so frames of an earlier attempt are ignored
+static void StartAttempt(void) {
+    sender.id++;
+    sender.base = 0;
+    sender.next = 0;
+    sender.acked = 0;
+    sender.fast_resent = 0;
+    sender.timeouts = 0;
+    sender.state = SENDER_STARTING;
+    SendStart();
+}
+
+// Counts a timeout, and gives up once the receiver looks gone
+static uint8_t TimedOut(void) {
+    if (++sender.timeouts < TINYTRANSFER_MAX_TIMEOUTS)
+        return 0;
+
+    sender.result = TINYTRANSFER_RESULT_ETIMEOUT;
+    sender.state = SENDER_FAILED;
+    return 1;
+}
+
+int16_t TINYTRANSFER_InitSender(const struct TINYPROTOCOL_Config *cfg, uint8_t data_cmd, uint8_t ack_cmd,
+                                uint8_t window, uint16_t timeout_ticks) {
+    int16_t result;
+
+    if (window == 0 || window > TINYTRANSFER_MAX_WINDOW || timeout_ticks == 0)
+        return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+
+    result = TINYPROTOCOL_RegisterLargeTelecommand(ack_cmd, sender_ack_buffer, sizeof(sender_ack_buffer));
+    if (result != ETINYPROTOCOL_SUCCESS)
+        return result;
+
+    sender.cfg = cfg;
+    sender.data_cmd = data_cmd;
+    sender.window = window;
+    sender.timeout = timeout_ticks;
+    sender.state = SENDER_IDLE;
+
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+int16_t TINYTRANSFER_Send(const uint8_t* object, uint32_t size, uint16_t segment_size) {
+    if (segment_size == 0 || segment_size > TINYTRANSFER_MAX_SEGMENT_SIZE)
+        return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+
+    if (size == 0 || (size + segment_size - 1) / segment_size > 0xFFFF)
+        return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+
+    if (sender.state == SENDER_STARTING || sender.state == SENDER_SENDING || sender.state == SENDER_ENDING)
+        return -ETINYPROTOCOL_CMD_USED;
+
+    sender.object = object;
+    sender.size = size;
+    sender.segment_size = segment_size;
+    sender.segment_count = (uint16_t)((size + segment_size - 1) / segment_size);
+    sender.object_crc = TINYTRANSFER_CalculateCRC16(TINYTRANSFER_CRC16_INIT, object, size);
+    sender.attempts = 1;
+    sender.stats.segments_sent = 0;
+    sender.stats.retransmits = 0;
+    sender.stats.acks_received = 0;
+    sender.stats.restarts = 0;
+
+    StartAttempt();
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+void TINYTRANSFER_SenderTick(void) {
+    uint16_t seq;
+    uint8_t timed_out = 0;
+
+    sender.tick++;
+
+    switch (sender.state) {
+        case SENDER_STARTING:
+            if ((uint16_t)(sender.tick - sender.control_tick) >= sender.timeout && !TimedOut())
+                SendStart();
+            break;
+        case SENDER_SENDING:
+            // Timed out segments first, then fill the window with new ones. A
+            // tick that resends several segments counts as one timeout.
+            for (seq = sender.base; seq != sender.next; seq++) {
+                uint16_t bit = 1u << (seq - sender.base);
+                if ((sender.acked & bit) == 0 &&
+                    (uint16_t)(sender.tick - sender.sent_tick[seq % TINYTRANSFER_MAX_WINDOW]) >= sender.timeout) {
+                    if (!timed_out && TimedOut())
+                        return;
+                    timed_out = 1;
+                    sender.fast_resent &= ~bit;
+                    sender.stats.retransmits++;
+                    SendSegment(seq);
+                }
+            }
+            FillWindow();
+            break;
+        case SENDER_ENDING:
+            if ((uint16_t)(sender.tick - sender.control_tick) >= sender.timeout && !TimedOut())
+                SendEnd();
+            break;
+        default:
+            break;
+    }
+}
+
+static void HandleAck(uint16_t next_expected, uint16_t bitmap) {
+    uint16_t seq, highest;
+
+    if (sender.state == SENDER_STARTING) {
+        sender.timeouts = 0;
+        sender.state = SENDER_SENDING;
+        FillWindow();
+        return;
+    }
+
+    if (sender.state != SENDER_SENDING || next_expected < sender.base || next_expected > sender.next)
+        return;
+
+    if (next_expected != sender.base)
+        sender.timeouts = 0;
+
+    // Slide the window up to the receiver's cumulative position
+    if (next_expected - sender.base >= 16) {
+        sender.acked = 0;
+        sender.fast_resent = 0;
+    } else {
+        sender.acked >>= (next_expected - sender.base);
+        sender.fast_resent >>= (next_expected - sender.base);
+    }
+    sender.base = next_expected;
+    sender.acked |= bitmap << 1;
+
+    if (sender.base == sender.segment_count) {
+        sender.timeouts = 0;
+        sender.state = SENDER_ENDING;
+        SendEnd();
+        return;
+    }
+
+    // Segments missing below one the receiver already has were lost, resend them once
+    // without waiting for the timeout
+    highest = 0;
+    for (seq = 1; seq < TINYTRANSFER_MAX_WINDOW; seq++) {
+        if (sender.acked & (1u << seq))
+            highest = seq;
+    }
+    for (seq = 0; seq < highest; seq++) {
+        uint16_t bit = 1u << seq;
+        if ((sender.acked & bit) == 0 && (sender.fast_resent & bit) == 0) {
+            sender.fast_resent |= bit;
+            sender.stats.retransmits++;
+            SendSegment(sender.base + seq);
+        }
+    }
+
+    FillWindow();
+}
+
+int16_t TINYTRANSFER_ProcessAck(const uint8_t* buffer, uint16_t size) {
+    if (size < 3 || buffer[1] != sender.id)
+        return -ETINYPROTOCOL_INVALID_CMD_ID;
+
+    switch (buffer[0]) {
+        case TINYTRANSFER_FRAME_ACK:
+            if (size < TINYTRANSFER_ACK_SIZE)
+                return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+            sender.stats.acks_received++;
+            HandleAck(GetU16(&buffer[2]), GetU16(&buffer[4]));
+            break;
+        case TINYTRANSFER_FRAME_DONE:
+            if (sender.state != SENDER_ENDING && sender.state != SENDER_STARTING)
+                break;
+
+            sender.result = buffer[2];
+            if (buffer[2] == TINYTRANSFER_RESULT_OK && sender.state == SENDER_ENDING) {
+                sender.state = SENDER_DONE;
+            } else if (buffer[2] == TINYTRANSFER_RESULT_EBAD_CRC && sender.attempts < TINYTRANSFER_MAX_ATTEMPTS) {
+                sender.attempts++;
+                sender.stats.restarts++;
+                StartAttempt();
+            } else {
+                sender.state = SENDER_FAILED;
+            }
+            break;
+        default:
+            return -ETINYPROTOCOL_INVALID_CMD_ID;
+    }
+
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+TINYTRANSFER_Status TINYTRANSFER_SenderStatus(void) {
+    switch (sender.state) {
+        case SENDER_IDLE:
+            return TINYTRANSFER_IDLE;
+        case SENDER_DONE:
+            return TINYTRANSFER_DONE;
+        case SENDER_FAILED:
+            return TINYTRANSFER_FAILED;
+        default:
+            return TINYTRANSFER_BUSY;
+    }
+}
+
+uint8_t TINYTRANSFER_SenderResult(void) {
+    return sender.result;
+}
+
+const TINYTRANSFER_SenderStats* TINYTRANSFER_GetSenderStats(void) {
+    return &sender.stats;
+}
+
+//***************************Receiver***************************************************
+
+static void SendAck(void) {
+    uint8_t *frame = receiver_tx_buffer;
+
+    frame[0] = TINYTRANSFER_FRAME_ACK;
+    frame[1] = receiver.id;
+    PutU16(&frame[2], receiver.base);
+    PutU16(&frame[4], receiver.received);
+
+    TINYPROTOCOL_SendLargeTelecommand(receiver.cfg, receiver.ack_cmd, frame, TINYTRANSFER_ACK_SIZE);
+}
+
+static void SendDone(uint8_t id, uint8_t result) {
+    uint8_t *frame = receiver_tx_buffer;
+
+    frame[0] = TINYTRANSFER_FRAME_DONE;
+    frame[1] = id;
+    frame[2] = result;
+    TINYPROTOCOL_SendLargeTelecommand(receiver.cfg, receiver.ack_cmd, frame, 3);
+}
+
+int16_t TINYTRANSFER_InitReceiver(const struct TINYPROTOCOL_Config *cfg, uint8_t data_cmd, uint8_t ack_cmd,
+                                  uint8_t* buffer, uint32_t capacity) {
+    int16_t result = TINYPROTOCOL_RegisterLargeTelecommand(data_cmd, receiver_rx_buffer, sizeof(receiver_rx_buffer));
+    if (result != ETINYPROTOCOL_SUCCESS)
+        return result;
+
+    receiver.cfg = cfg;
+    receiver.ack_cmd = ack_cmd;
+    receiver.object = buffer;
+    receiver.capacity = capacity;
+    receiver.status = TINYTRANSFER_IDLE;
+
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static void HandleStart(const uint8_t* buffer, uint16_t size) {
+    uint32_t object_size;
+    uint16_t segment_size;
+
+    if (size < 8)
+        return;
+
+    // A repeated START only lost its answer: the ACK, or the DONE of an
+    // object that was already rejected or received
+    if (receiver.status != TINYTRANSFER_IDLE && buffer[1] == receiver.id) {
+        if (receiver.status == TINYTRANSFER_BUSY)
+            SendAck();
+        else
+            SendDone(receiver.id, receiver.result);
+        return;
+    }
+
+    object_size = GetU16(&buffer[2]) | ((uint32_t)GetU16(&buffer[4]) << 16);
+    segment_size = GetU16(&buffer[6]);
+
+    receiver.id = buffer[1];
+    if (object_size == 0 || object_size > receiver.capacity ||
+        segment_size == 0 || segment_size > TINYTRANSFER_MAX_SEGMENT_SIZE) {
+        receiver.result = TINYTRANSFER_RESULT_ETOO_LARGE;
+        receiver.status = TINYTRANSFER_FAILED;
+        SendDone(receiver.id, receiver.result);
+        return;
+    }
+
+    receiver.size = object_size;
+    receiver.segment_size = segment_size;
+    receiver.segment_count = (uint16_t)((object_size + segment_size - 1) / segment_size);
+    receiver.base = 0;
+    receiver.received = 0;
+    receiver.status = TINYTRANSFER_BUSY;
+    SendAck();
+}
+
+static void HandleData(const uint8_t* buffer, uint16_t size) {
+    uint16_t seq = GetU16(&buffer[2]);
+    uint16_t offset = seq - receiver.base;
+    uint32_t position = (uint32_t)seq * receiver.segment_size;
+    uint16_t length = size - TINYTRANSFER_HEADER_SIZE;
+    uint16_t i;
+
+    if (receiver.status != TINYTRANSFER_BUSY || buffer[1] != receiver.id)
+        return;
+
+    // Outside the window, or already stored: only the ACK went missing
+    if (seq < receiver.base || seq >= receiver.segment_count || offset > TINYTRANSFER_MAX_WINDOW ||
+        (offset > 0 && (receiver.received & (1u << (offset - 1))))) {
+        SendAck();
+        return;
+    }
+
+    if (length != receiver.segment_size && position + length != receiver.size)
+        return;
+    if (position + length > receiver.size)
+        return;
+
+    for (i = 0; i < length; i++) {
+        receiver.object[position + i] = buffer[TINYTRANSFER_HEADER_SIZE + i];
+    }
+
+    if (offset == 0) {
+        // In order: move past every segment that was already waiting
+        receiver.base++;
+        while (receiver.received & 1) {
+            receiver.received >>= 1;
+            receiver.base++;
+        }
+        receiver.received >>= 1;
+    } else {
+        receiver.received |= 1u << (offset - 1);
+    }
+
+    SendAck();
+}
+
+static void HandleEnd(const uint8_t* buffer, uint16_t size) {
+    if (size < 4 || receiver.status == TINYTRANSFER_IDLE || buffer[1] != receiver.id)
+        return;
+
+    if (receiver.status == TINYTRANSFER_BUSY) {
+        if (receiver.base != receiver.segment_count)
+            return;
+
+        if (TINYTRANSFER_CalculateCRC16(TINYTRANSFER_CRC16_INIT, receiver.object, receiver.size) == GetU16(&buffer[2])) {
+            receiver.result = TINYTRANSFER_RESULT_OK;
+            receiver.status = TINYTRANSFER_DONE;
+        } else {
+            receiver.result = TINYTRANSFER_RESULT_EBAD_CRC;
+            receiver.status = TINYTRANSFER_FAILED;
+        }
+    }
+
+    // Answered again when the sender repeats END because DONE was lost
+    SendDone(receiver.id, receiver.result);
+}
+
+int16_t TINYTRANSFER_ProcessSegment(const uint8_t* buffer, uint16_t size) {
+    if (size < 2)
+        return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+
+    switch (buffer[0]) {
+        case TINYTRANSFER_FRAME_START:
+            HandleStart(buffer, size);
+            break;
+        case TINYTRANSFER_FRAME_DATA:
+            if (size < TINYTRANSFER_HEADER_SIZE)
+                return -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE;
+            HandleData(buffer, size);
+            break;
+        case TINYTRANSFER_FRAME_END:
+            HandleEnd(buffer, size);
+            break;
+        default:
+            return -ETINYPROTOCOL_INVALID_CMD_ID;
+    }
+
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+TINYTRANSFER_Status TINYTRANSFER_ReceiverStatus(uint32_t* size) {
+    if (size)
+        *size = receiver.size;
+    return receiver.status;
+}
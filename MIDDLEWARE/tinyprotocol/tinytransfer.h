@@ -0,0 +1,90 @@
+//
+// Segmented bulk transfers on top of tinyprotocol.
+//
+// An object (file, capture buffer, log) is cut into numbered segments sent as
+// large frame telecommands. The receiver answers every segment with its
+// cumulative position plus a bitmap of the segments it already holds past it,
+// so the sender keeps a window of segments in flight and only resends the
+// missing ones. A CRC16 over the whole object is checked once at the end.
+//
+// Frames go out through the TINYPROTOCOL_WriteBuffer callback of the config
+// passed at init, so the layer runs over any transport tinyprotocol runs on.
+// On an I2C slave the config has no WriteBuffer and the master reads each
+// frame (see TINYPROTOCOL_Config). Only the last frame can be read there, so
+// a sender on the slave uses a window of 1.
+// Both ends only react to TINYTRANSFER_Process*() and TINYTRANSFER_SenderTick(),
+// which the app calls from its ProcessTelecommand callback and its main loop.
+//
+
+#ifndef TINYEMBED_TINYTRANSFER_H
+#define TINYEMBED_TINYTRANSFER_H
+
+#include <stdint.h>
+
+#include "tinyprotocol.h"
+
+#ifndef TINYTRANSFER_MAX_SEGMENT_SIZE
+#define TINYTRANSFER_MAX_SEGMENT_SIZE       256
+#endif
+
+#define TINYTRANSFER_MAX_WINDOW             16      // Bounded by the 16 bit acknowledgement bitmap
+#define TINYTRANSFER_MAX_ATTEMPTS           3       // Whole object restarts after a CRC mismatch
+#define TINYTRANSFER_MAX_TIMEOUTS           8       // Timeouts in a row without progress before the sender gives up
+#define TINYTRANSFER_HEADER_SIZE            4       // type, transfer ID, sequence number
+
+#if TINYTRANSFER_MAX_SEGMENT_SIZE + TINYTRANSFER_HEADER_SIZE > TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE
+#error TINYTRANSFER_MAX_SEGMENT_SIZE does not fit in a large frame
+#endif
+
+typedef enum {
+    TINYTRANSFER_IDLE,
+    TINYTRANSFER_BUSY,
+    TINYTRANSFER_DONE,
+    TINYTRANSFER_FAILED,
+} TINYTRANSFER_Status;
+
+typedef struct {
+    uint32_t segments_sent;     // Including retransmissions
+    uint32_t retransmits;
+    uint32_t acks_received;
+    uint8_t restarts;
+} TINYTRANSFER_SenderStats;
+
+// Sender functions
+// window is the number of unacknowledged segments allowed in flight (1 is
+// stop-and-wait), timeout_ticks how many TINYTRANSFER_SenderTick() calls a
+// segment may stay unacknowledged before it is sent again. After
+// TINYTRANSFER_MAX_TIMEOUTS timeouts in a row with no segment acknowledged
+// and no step forward, the sender fails with TINYTRANSFER_RESULT_ETIMEOUT.
+int16_t TINYTRANSFER_InitSender(const struct TINYPROTOCOL_Config *cfg, uint8_t data_cmd, uint8_t ack_cmd,
+                                uint8_t window, uint16_t timeout_ticks);
+int16_t TINYTRANSFER_Send(const uint8_t* object, uint32_t size, uint16_t segment_size);
+void TINYTRANSFER_SenderTick(void);
+int16_t TINYTRANSFER_ProcessAck(const uint8_t* buffer, uint16_t size);
+TINYTRANSFER_Status TINYTRANSFER_SenderStatus(void);
+uint8_t TINYTRANSFER_SenderResult(void);   // TINYTRANSFER_RESULT_* once the sender is DONE or FAILED
+const TINYTRANSFER_SenderStats* TINYTRANSFER_GetSenderStats(void);
+
+// Receiver functions
+int16_t TINYTRANSFER_InitReceiver(const struct TINYPROTOCOL_Config *cfg, uint8_t data_cmd, uint8_t ack_cmd,
+                                  uint8_t* buffer, uint32_t capacity);
+int16_t TINYTRANSFER_ProcessSegment(const uint8_t* buffer, uint16_t size);
+TINYTRANSFER_Status TINYTRANSFER_ReceiverStatus(uint32_t* size);
+
+uint16_t TINYTRANSFER_CalculateCRC16(uint16_t crc, const uint8_t* buffer, uint32_t size);
+
+// Frame types, first byte of every payload
+#define TINYTRANSFER_FRAME_START            1   // ID, object size (32 bit), segment size (16 bit)
+#define TINYTRANSFER_FRAME_DATA             2   // ID, sequence number (16 bit), data
+#define TINYTRANSFER_FRAME_END              3   // ID, object CRC16
+#define TINYTRANSFER_FRAME_ACK              4   // ID, next expected segment (16 bit), bitmap of later ones (16 bit)
+#define TINYTRANSFER_FRAME_DONE             5   // ID, result
+
+#define TINYTRANSFER_RESULT_OK              0
+#define TINYTRANSFER_RESULT_EBAD_CRC        1
+#define TINYTRANSFER_RESULT_ETOO_LARGE      2
+#define TINYTRANSFER_RESULT_ETIMEOUT        3   // Sender only, never sent in DONE: the receiver stopped answering
+
+#define TINYTRANSFER_CRC16_INIT             0xFFFF  // CRC-16/CCITT-FALSE
+
+#endif //TINYEMBED_TINYTRANSFER_H
@@ -0,0 +1,348 @@
+/**
+ * @file adc_capture_sim.c
+ * @brief Cycle-approximate run of the DMA ping-pong ADC capture (ADC_Capture.c).
+ *
+ * The real ADC_Capture.c and adc12_b.c set up Timer_A0, the ADC and DMA
+ * channel 0 on the host register file. The simulation then plays the
+ * hardware from those registers, one MCLK cycle at a time:
+ *  - Timer_A0 raises TA0.1 every TA0CCR0 + 1 SMCLK cycles, which starts a
+ *    conversion (hal/adc12_model.c). A trigger that finds the ADC still
+ *    converting is lost (a conversion time overflow).
+ *  - at the end of the conversion the result lands in ADC12MEM31 and the DMA
+ *    (hal/dma_model.c) copies it into the buffer, taking the bus from the CPU
+ *    for DMA_MODEL_TRANSFER_CYCLES
+ *  - the CPU runs DMA_ISR when a half is full, then the main loop processes
+ *    the filled halves (ADC_CaptureProcess), then sleeps in LPM0
+ *
+ * The input is a ramp that steps on every conversion, so the processing
+ * callback can tell a lost or repeated sample from the values alone.
+ *
+ * The ISR cost is built like in i2c_slave_timing_sim: entry, frame and RETI
+ * plus 3 cycles per register access the real ISR made. Processing costs a
+ * fixed number of cycles per sample, to be set to what the application does
+ * with the data.
+ *
+ * Every rate up to ADC_CAPTURE_MAX_RATE must run without a lost sample. A run
+ * at the maximum rate with processing slower than the sample period must be
+ * reported as overruns by the capture itself. The capture and the rail
+ * monitor of ADC_Read.c must refuse to start while the other one runs.
+ *
+ * Usage: adc_capture_sim [half_length] [process_cycles_per_sample]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <msp430.h>
+
+#include "ADC_Capture.h"
+#include "adc12_model.h"
+#include "dma_model.h"
+#include "msp430_cycles.h"
+
+#define SIM_HALF_LENGTH             128
+#define SIM_MAX_HALF_LENGTH         1024
+#define SIM_PROCESS_CYCLES          40      /**< Per sample, the application's work on a filled half */
+#define SIM_HALVES                  64      /**< Halves processed per run */
+#define SIM_MODOSC_HZ               4.8e6   /**< ADC12OSC, typical */
+#define SIM_CAPTURE_CHANNEL         4       /**< P1.4 is A4, the captured pin */
+
+// CPU cost model, in MCLK cycles, on top of msp430_cycles.h
+#define ISR_HALF_CYCLES             20      /**< Half bookkeeping, LPM0 exit on return */
+#define LPM0_WAKE_CYCLES            10
+#define MAIN_CALL_CYCLES            30      /**< ADC_CaptureProcess entry, callback call, LPM0 entry */
+
+void DMA_ISR(void);
+
+static uint16_t buffer[2 * SIM_MAX_HALF_LENGTH];
+
+//***************************Processing callback*******************************************
+
+static uint32_t expected;           /**< Next ramp value the callback should see */
+static uint32_t received;
+static uint32_t gaps;               /**< Samples out of sequence */
+
+static void CheckHalf(const uint16_t *samples, uint16_t count) {
+    uint16_t i;
+
+    for (i = 0; i < count; i++) {
+        if (samples[i] != (expected & 0x0FFF)) {
+            gaps++;
+            expected = samples[i];  // Resynchronize, count each break once
+        }
+        expected++;
+    }
+    received += count;
+}
+
+//***************************Hardware from the registers************************************
+
+static const uint16_t sample_hold_cycles[16] = {4, 8, 16, 32, 64, 96, 128, 192, 256, 384, 512, 512, 512, 512, 512, 512};
+
+// Sample and conversion time of one ADC12MEM31 result, in MCLK cycles
+static uint32_t ConversionCycles(void) {
+    uint16_t ctl0 = HOST_REG16(ADC12_B_BASE + OFS_ADC12CTL0);
+    uint16_t ctl1 = HOST_REG16(ADC12_B_BASE + OFS_ADC12CTL1);
+    uint16_t ctl2 = HOST_REG16(ADC12_B_BASE + OFS_ADC12CTL2);
+    uint16_t mem = HOST_REG16(ADC12_B_BASE + OFS_ADC12CTL3) & ADC12CSTARTADD_31;
+    double adc_hz = ((ctl1 & ADC12SSEL_3) == ADC12SSEL_0) ? SIM_MODOSC_HZ : ADC_CAPTURE_SMCLK_HZ;
+    uint16_t sht = (mem >= 8 && mem <= 23) ? (ctl0 >> 12) & 0xF : (ctl0 >> 8) & 0xF;
+    uint16_t bits = 8 + 2 * ((ctl2 & ADC12RES_3) >> 4);
+    double divider = (double)(((ctl1 & ADC12DIV_7) >> 5) + 1);
+
+    switch (ctl1 & (ADC12PDIV__4 | ADC12PDIV__32)) {
+        case ADC12PDIV__4:  divider *= 4;  break;
+        case ADC12PDIV__32: divider *= 32; break;
+        case ADC12PDIV__64: divider *= 64; break;
+    }
+
+    // 12 bit takes 14 ADC12CLK cycles to convert, 10 bit 12, 8 bit 10
+    return (uint32_t)((sample_hold_cycles[sht] + bits + 2) * divider * ADC_CAPTURE_SMCLK_HZ / adc_hz + 0.999);
+}
+
+static int CheckSetup(uint32_t rate) {
+    uint16_t period = HOST_REG16(TIMER_A0_BASE + OFS_TAxCCR0) + 1;
+
+    if ((HOST_REG16(TIMER_A0_BASE + OFS_TAxCTL) & (TASSEL_3 | MC_3)) != (TASSEL__SMCLK | MC__UP) ||
+        (HOST_REG16(TIMER_A0_BASE + OFS_TAxCCTL1) & OUTMOD_7) != OUTMOD_7 ||
+        (HOST_REG16(ADC12_B_BASE + OFS_ADC12CTL1) & ADC12SHS_7) != ADC12SHS_1 ||
+        (HOST_REG16(ADC12_B_BASE + OFS_ADC12CTL1) & ADC12CONSEQ_3) != ADC12CONSEQ_2) {
+        fprintf(stderr, "FAIL: the capture does not run the ADC from TA0.1 in repeated single channel mode\n");
+        return 0;
+    }
+    if (period != (uint16_t)(ADC_CAPTURE_SMCLK_HZ / rate)) {
+        fprintf(stderr, "FAIL: %u SMCLK cycles per sample for %u samples/s\n", period, rate);
+        return 0;
+    }
+    return 1;
+}
+
+//***************************Run*************************************************************
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t dma_cycles;
+    uint32_t isr_cycles;
+    uint32_t isrs;
+    uint32_t process_cycles;
+    uint32_t lost_triggers;
+} sRunStats_t;
+
+static int RunCapture(uint32_t rate, uint16_t half_length, uint32_t process_cycles, int expect_overruns) {
+    sAdcCaptureConfig_t config = {
+        .pin = P1_4,
+        .sampleRate = rate,
+        .buffer = buffer,
+        .halfLength = half_length,
+        .Half_Full = CheckHalf
+    };
+    sRunStats_t run;
+    uint32_t period, conversion, next_trigger = 0, conversion_done = 0;
+    uint32_t ramp = 0, stall = 0, isr_left = 0, work_left = 0;
+    uint8_t converting = 0, asleep = 1, working = 0;
+    int ok;
+
+    hostRegReset();
+    adcModelInit();
+    dmaModelInit();
+    memset(&run, 0, sizeof(run));
+    expected = received = gaps = 0;
+
+    if (ADC_CaptureInit(&config) != 0) {
+        fprintf(stderr, "FAIL: ADC_CaptureInit refused %u samples/s\n", rate);
+        return 0;
+    }
+    ADC_CaptureStart();
+    hostRegSync();
+    if (!CheckSetup(rate))
+        return 0;
+
+    period = HOST_REG16(TIMER_A0_BASE + OFS_TAxCCR0) + 1;
+    conversion = ConversionCycles();
+
+    while (received < (uint32_t)SIM_HALVES * half_length) {
+        // Timer_A0 and the ADC
+        if (run.cycles == next_trigger) {
+            if (converting) {
+                run.lost_triggers++;
+            } else {
+                converting = 1;
+                conversion_done = run.cycles + conversion;
+            }
+            next_trigger += period;
+        }
+        if (converting && run.cycles == conversion_done) {
+            converting = 0;
+            adcModelSetInput(SIM_CAPTURE_CHANNEL, ramp++ & 0x0FFF);
+            adcModelTrigger();
+            stall += DMA_MODEL_TRANSFER_CYCLES * dmaModelTrigger(DMA0TSEL__ADC12IFG);
+        }
+
+        // CPU, one cycle: the DMA has the bus, else an ISR, else the main loop, else LPM0
+        if (stall > 0) {
+            stall--;
+            run.dma_cycles++;
+        } else if (isr_left > 0) {
+            isr_left--;
+            run.isr_cycles++;
+        } else if (dmaModelInterruptPending()) {
+            uint32_t accesses = host_reg_accesses;
+
+            DMA_ISR();
+            hostRegSync();
+            accesses = host_reg_accesses - accesses;
+            isr_left = ISR_ACCEPT_CYCLES + ISR_FRAME_CYCLES + ISR_HALF_CYCLES + ISR_RETURN_CYCLES +
+                       accesses * ISR_REG_ACCESS_CYCLES + (asleep ? LPM0_WAKE_CYCLES : 0) - 1;
+            asleep = 0;
+            run.isrs++;
+            run.isr_cycles++;
+        } else if (working) {
+            run.process_cycles++;
+            if (--work_left == 0) {
+                // The callback reads the half at the end of its time, when
+                // the DMA may already have overwritten it
+                ADC_CaptureProcess();
+                working = 0;
+            }
+        } else if (ADC_CapturePending() > 0) {
+            working = 1;
+            work_left = MAIN_CALL_CYCLES + ADC_CapturePending() * half_length * process_cycles;
+            run.process_cycles++;
+            work_left--;
+        } else {
+            asleep = 1;
+        }
+
+        run.cycles++;
+        if (run.cycles > (uint32_t)(SIM_HALVES + 4) * half_length * period) {
+            fprintf(stderr, "FAIL: %u samples/s delivered %u samples in the time of %u\n",
+                    rate, received, (uint32_t)SIM_HALVES * half_length);
+            return 0;
+        }
+    }
+    ADC_CaptureStop();
+
+    ok = gaps == 0 && ADC_CaptureOverruns() == 0 && run.lost_triggers == 0 &&
+         !(HOST_REG16(ADC12_B_BASE + OFS_ADC12IFGR2) & ADC12OVIFG);
+
+    printf("  %8u %7u %6u %8.1f%% %5.1f%% %9.1f%% %6.1f%% %9u %5u %5u\n",
+           rate, period, conversion,
+           100.0 * run.dma_cycles / run.cycles, 100.0 * run.isr_cycles / run.cycles,
+           100.0 * run.process_cycles / run.cycles,
+           100.0 * (run.cycles - run.dma_cycles - run.isr_cycles - run.process_cycles) / run.cycles,
+           ADC_CaptureOverruns(), gaps, run.lost_triggers);
+
+    if (expect_overruns) {
+        if (ADC_CaptureOverruns() == 0) {
+            fprintf(stderr, "FAIL: processing slower than the samples arrive was not reported as overruns\n");
+            return 0;
+        }
+        return 1;
+    }
+    if (!ok)
+        fprintf(stderr, "FAIL: samples lost at %u samples/s\n", rate);
+    return ok;
+}
+
+// The capture and the rail monitor share Timer_A0 and DMA channel 0, each
+// Init must refuse while the other runs and succeed once it is stopped
+static int CheckExclusive(void) {
+    static const sAdcMonitorRail_t rail = {P1_2, 0, 4095};
+    static const sAdcMonitorConfig_t monitor = {&rail, 1, ADC12_B_MEMORY_0, 1000, NULL};
+    const sAdcCaptureConfig_t capture = {
+        .pin = P1_4,
+        .sampleRate = 10000,
+        .buffer = buffer,
+        .halfLength = SIM_HALF_LENGTH
+    };
+    int ok = 1;
+
+    hostRegReset();
+    if (ADC_CaptureInit(&capture) != 0) {
+        fprintf(stderr, "FAIL: ADC_CaptureInit refused a valid capture\n");
+        return 0;
+    }
+    ADC_CaptureStart();
+    if (ADC_MonitorInit(&monitor) == 0) {
+        fprintf(stderr, "FAIL: ADC_MonitorInit took the peripherals of a running capture\n");
+        ok = 0;
+    }
+    ADC_CaptureStop();
+    if (ADC_MonitorInit(&monitor) != 0) {
+        fprintf(stderr, "FAIL: ADC_MonitorInit refused after ADC_CaptureStop\n");
+        return 0;
+    }
+
+    ADC_MonitorStart();
+    if (ADC_CaptureInit(&capture) == 0) {
+        fprintf(stderr, "FAIL: ADC_CaptureInit took the peripherals of the running rail monitor\n");
+        ok = 0;
+    }
+    ADC_MonitorStop();
+    if (ADC_CaptureInit(&capture) != 0) {
+        fprintf(stderr, "FAIL: ADC_CaptureInit refused after ADC_MonitorStop\n");
+        ok = 0;
+    }
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    static const uint32_t rates[] = {10000, 50000, 100000, 150000, ADC_CAPTURE_MAX_RATE};
+    uint16_t half_length = (argc > 1) ? (uint16_t)strtoul(argv[1], NULL, 0) : SIM_HALF_LENGTH;
+    uint32_t process_cycles = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : SIM_PROCESS_CYCLES;
+    uint32_t max_period = (uint32_t)(ADC_CAPTURE_SMCLK_HZ / ADC_CAPTURE_MAX_RATE);
+    sAdcCaptureConfig_t too_fast = {
+        .pin = P1_4,
+        .sampleRate = ADC_CAPTURE_MAX_RATE + 1,
+        .buffer = buffer,
+        .halfLength = SIM_HALF_LENGTH
+    };
+    sAdcCaptureConfig_t too_slow = too_fast, slowest = too_fast;
+    unsigned r;
+    int ok = 1;
+
+    if (half_length == 0 || half_length > SIM_MAX_HALF_LENGTH) {
+        fprintf(stderr, "half_length must be 1..%u\n", SIM_MAX_HALF_LENGTH);
+        return 1;
+    }
+
+    printf("ADC capture through DMA into 2 x %u samples, %u cycles of processing per sample\n",
+           half_length, process_cycles);
+    printf("  %8s %7s %6s %9s %6s %10s %7s %9s %5s %5s\n",
+           "samples/s", "period", "conv", "DMA", "ISR", "process", "idle", "overruns", "gaps", "lost");
+
+    for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+        ok &= RunCapture(rates[r], half_length, process_cycles, 0);
+
+    // Processing that cannot keep up has to show up as overruns
+    printf("  processing at %u cycles per sample, more than the %u cycle period:\n", max_period + 10, max_period);
+    ok &= RunCapture(ADC_CAPTURE_MAX_RATE, half_length, max_period + 10, 1);
+
+    hostRegReset();
+    if (ADC_CaptureInit(&too_fast) == 0) {
+        fprintf(stderr, "FAIL: ADC_CaptureInit accepted %lu samples/s\n", ADC_CAPTURE_MAX_RATE + 1);
+        ok = 0;
+    }
+
+    // The slowest rate still has its whole period in the 16-bit timer
+    hostRegReset();
+    too_slow.sampleRate = ADC_CAPTURE_MIN_RATE - 1;
+    if (ADC_CaptureInit(&too_slow) == 0) {
+        fprintf(stderr, "FAIL: ADC_CaptureInit accepted %lu samples/s\n", ADC_CAPTURE_MIN_RATE - 1);
+        ok = 0;
+    }
+    slowest.sampleRate = ADC_CAPTURE_MIN_RATE;
+    if (ADC_CaptureInit(&slowest) != 0 ||
+        HOST_REG16(TIMER_A0_BASE + OFS_TAxCCR0) + 1UL != ADC_CAPTURE_SMCLK_HZ / ADC_CAPTURE_MIN_RATE) {
+        fprintf(stderr, "FAIL: the period at %lu samples/s does not fit Timer_A0\n", ADC_CAPTURE_MIN_RATE);
+        ok = 0;
+    }
+
+    if (CheckExclusive())
+        printf("  capture and rail monitor: each refuses to start while the other runs\n");
+    else
+        ok = 0;
+
+    return ok ? 0 : 1;
+}
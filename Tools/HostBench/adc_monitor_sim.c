@@ -0,0 +1,410 @@
+/**
+ * @file adc_monitor_sim.c
+ * @brief Window comparator rail monitor (ADC_Read.c) against software polling.
+ *
+ * The real bsp.c starts the rail monitor as main.c does, on the host register
+ * file. Each period of Timer_A0 the simulation plays the hardware from the
+ * registers it left behind:
+ *  - TA0.1 triggers one conversion (hal/adc12_model.c, which also runs the
+ *    window comparator), then ADC12_ISR runs until no enabled interrupt is
+ *    pending and the main loop takes the rail alarms
+ *  - TA0CCR0 triggers DMA channels 0 and 1 (hal/dma_model.c), which load the
+ *    next rail's window, taking the bus from the CPU for
+ *    DMA_MODEL_TRANSFER_CYCLES each
+ *
+ * The rails follow a script of excursions: above, below, straight from above
+ * to below, a single conversion glitch and one still outside at the end. A
+ * software reference walks the same conversions with the same thresholds.
+ * The fault table, the alarms the main loop took, the last results and the
+ * RAIL_FAULTS telemetry packing must all match it exactly.
+ *
+ * Then the CPU cost is compared with polling at the same rate per rail: a
+ * timer wakes the main loop, samplePdsRails() converts the sequence and
+ * every rail is compared in software. ISR costs are built like in
+ * adc_capture_sim: entry, frame and RETI plus 3 cycles per register access.
+ *
+ * Usage: adc_monitor_sim [seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <msp430.h>
+
+#include "adc12_model.h"
+#include "dma_model.h"
+#include "msp430_cycles.h"
+#include "ADC_Read.h"
+#include "bsp.h"
+
+#define SIM_SECONDS                 10
+#define SIM_MCLK_HZ                 16000000.0
+
+// CPU cost model, in MCLK cycles, on top of msp430_cycles.h
+#define LPM0_WAKE_CYCLES            10
+#define MAIN_WAKE_CYCLES            30      /**< Main loop pass: alarm check, LPM0 entry */
+#define POLL_TIMER_CYCLES           (ISR_ACCEPT_CYCLES + ISR_FRAME_CYCLES + ISR_RETURN_CYCLES + 2 * ISR_REG_ACCESS_CYCLES)
+#define POLL_COMPARE_CYCLES         12      /**< Per rail: two compares, branch, table pointer */
+
+void ADC12_ISR(void);
+
+//***************************Rail script********************************************************
+
+#define RAIL_NOMINAL(Name, adc_pin, port, pin, low, high)   ((low) + (high)) / 2,
+#define RAIL_LOW(Name, adc_pin, port, pin, low, high)       low,
+#define RAIL_HIGH(Name, adc_pin, port, pin, low, high)      high,
+#define RAIL_CHANNEL(Name, adc_pin, port, pin, low, high)   adc_pin,
+
+static const uint16_t nominal[PDS_RAIL_COUNT] = { PDS_RAILS(RAIL_NOMINAL) };
+static const uint16_t windowLow[PDS_RAIL_COUNT] = { PDS_RAILS(RAIL_LOW) };
+static const uint16_t windowHigh[PDS_RAIL_COUNT] = { PDS_RAILS(RAIL_HIGH) };
+static const uint8_t channel[PDS_RAIL_COUNT] = { PDS_RAILS(RAIL_CHANNEL) };
+
+// A rail held at a code over [from, to) seconds, later entries win
+static const struct {
+    uint8_t rail;
+    double from, to;
+    uint16_t code;
+} script[] = {
+    {RAIL_3V3,  2.00, 2.50, 2300},      // Above
+    {RAIL_3V3,  2.20, 2.30, 2450},      // and its peak
+    {RAIL_VBAT, 4.00, 4.01, 2000},      // One conversion below
+    {RAIL_5V,   6.00, 6.30, 3500},      // Above, then straight below
+    {RAIL_5V,   6.30, 6.60, 2500},
+    {RAIL_3V3,  7.00, 7.20, 1800},      // Below
+    {RAIL_IBAT, 8.00, 1e9,  3700},      // Above until the end
+};
+
+static uint16_t RailCode(uint8_t rail, double t) {
+    uint16_t code = nominal[rail];
+    unsigned i;
+
+    for (i = 0; i < sizeof(script) / sizeof(script[0]); i++) {
+        if (script[i].rail == rail && t >= script[i].from && t < script[i].to)
+            code = script[i].code;
+    }
+    return code;
+}
+
+//***************************Software reference*************************************************
+
+static sAdcMonitorFault_t reference[PDS_RAIL_COUNT];
+static uint16_t referenceResults[PDS_RAIL_COUNT];
+static uint32_t referenceEvents[PDS_RAIL_COUNT];
+
+static void ReferenceReset(void) {
+    uint8_t rail;
+
+    memset(reference, 0, sizeof(reference));
+    memset(referenceEvents, 0, sizeof(referenceEvents));
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++)
+        reference[rail].trough = 0xFFFF;
+}
+
+static void ReferenceConvert(uint8_t rail, uint16_t code) {
+    sAdcMonitorFault_t *fault = &reference[rail];
+    uint8_t side = 0;
+
+    referenceResults[rail] = code;
+    if (code > windowHigh[rail])
+        side = ADC_MONITOR_ABOVE;
+    else if (code < windowLow[rail])
+        side = ADC_MONITOR_BELOW;
+
+    if (side != 0 && !(fault->status & side)) {
+        fault->status |= (side == ADC_MONITOR_ABOVE) ? ADC_MONITOR_HIGH : ADC_MONITOR_LOW;
+        if (fault->count < 0xFF)
+            fault->count++;
+        referenceEvents[rail]++;
+    }
+    fault->status = (fault->status & ~(ADC_MONITOR_ABOVE | ADC_MONITOR_BELOW)) | side;
+    if (side == ADC_MONITOR_ABOVE && code > fault->peak)
+        fault->peak = code;
+    if (side == ADC_MONITOR_BELOW && code < fault->trough)
+        fault->trough = code;
+}
+
+//***************************Checks*************************************************************
+
+static const char *railNames[PDS_RAIL_COUNT] = {
+#define RAIL_NAME(Name, adc_pin, port, pin, low, high)      #Name,
+    PDS_RAILS(RAIL_NAME)
+};
+
+static int CheckFaults(const char *when) {
+    sAdcMonitorFault_t faults[ADC_MONITOR_MAX_RAILS];
+    uint8_t rail;
+
+    if (ADC_MonitorReadFaults(faults, 0) != PDS_RAIL_COUNT) {
+        fprintf(stderr, "FAIL: %s: fault table does not hold every rail\n", when);
+        return 0;
+    }
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++) {
+        const sAdcMonitorFault_t *f = &faults[rail], *r = &reference[rail];
+
+        if (f->status != r->status || f->count != r->count ||
+            ((r->status & ADC_MONITOR_HIGH) && f->peak != r->peak) ||
+            ((r->status & ADC_MONITOR_LOW) && f->trough != r->trough)) {
+            fprintf(stderr, "FAIL: %s: %s status 0x%02X/0x%02X count %u/%u peak %u/%u trough %u/%u\n",
+                    when, railNames[rail], f->status, r->status, f->count, r->count,
+                    f->peak, r->peak, f->trough, r->trough);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int CheckReport(void) {
+    uint8_t report[PDS_RAIL_COUNT * PDS_RAIL_FAULT_SIZE];
+    uint8_t rail;
+
+    railFaultReport(report, 1);
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++) {
+        const uint8_t *p = &report[rail * PDS_RAIL_FAULT_SIZE];
+        const sAdcMonitorFault_t *r = &reference[rail];
+
+        if (p[0] != r->status || p[1] != r->count ||
+            ((r->status & ADC_MONITOR_HIGH) && (uint16_t)(p[2] | p[3] << 8) != r->peak) ||
+            ((r->status & ADC_MONITOR_LOW) && (uint16_t)(p[4] | p[5] << 8) != r->trough)) {
+            fprintf(stderr, "FAIL: RAIL_FAULTS report of %s does not match the fault table\n", railNames[rail]);
+            return 0;
+        }
+    }
+
+    // Cleared, except for a rail still outside, latched again from its last result
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++) {
+        sAdcMonitorFault_t *r = &reference[rail];
+        uint8_t side = r->status & (ADC_MONITOR_ABOVE | ADC_MONITOR_BELOW);
+
+        r->status = side;
+        r->count = 0;
+        r->peak = 0;
+        r->trough = 0xFFFF;
+        if (side & ADC_MONITOR_ABOVE) {
+            r->status |= ADC_MONITOR_HIGH;
+            r->peak = referenceResults[rail];
+        }
+        if (side & ADC_MONITOR_BELOW) {
+            r->status |= ADC_MONITOR_LOW;
+            r->trough = referenceResults[rail];
+        }
+    }
+    return CheckFaults("after clearing");
+}
+
+static int CheckInvalid(void) {
+    static const sAdcMonitorRail_t rails[2] = {{P1_2, 100, 200}, {P1_3, 300, 200}};
+    static const struct {
+        uint8_t count;
+        uint8_t firstMemory;
+        uint16_t rate;
+        const char *what;
+    } cases[] = {
+        {0, ADC12_B_MEMORY_0,  100,                      "no rail"},
+        {9, ADC12_B_MEMORY_0,  100,                      "9 rails"},
+        {1, ADC12_B_MEMORY_31, ADC_MONITOR_MIN_RATE - 1, "a rate under the minimum"},
+        {1, ADC12_B_MEMORY_0,  ADC_MONITOR_MAX_RATE + 1, "a rate over the maximum"},
+        {2, ADC12_B_MEMORY_0,  100,                      "a window with low above high"},
+        {2, ADC12_B_MEMORY_31, 100,                      "rails past ADC12MEM31"},
+    };
+    unsigned i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        sAdcMonitorConfig_t config = {
+            .rails = rails,
+            .count = cases[i].count,
+            .firstMemory = cases[i].firstMemory,
+            .conversionRate = cases[i].rate,
+            .Rail_Alarm = NULL
+        };
+        if (ADC_MonitorInit(&config) == 0) {
+            fprintf(stderr, "FAIL: ADC_MonitorInit accepted %s\n", cases[i].what);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//***************************Polling baseline***************************************************
+
+static uint32_t pollIsrs;
+static uint32_t pollAccesses;
+
+static void WakeOnAdc(void) {
+    uint32_t accesses = host_reg_accesses;
+
+    ADC12_ISR();
+    hostRegSync();
+    pollAccesses += host_reg_accesses - accesses;
+    pollIsrs++;
+}
+
+// Cycles one polling scan of every rail costs: timer wake, sequence, compares
+static uint32_t PollScanCycles(void) {
+    uint16_t results[PDS_RAIL_COUNT];
+    uint32_t accesses;
+    uint8_t rail;
+
+    hostRegReset();
+    adcModelInit();
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++)
+        adcModelSetInput(channel[rail], nominal[rail]);
+    hostLowPowerHook(WakeOnAdc);
+    initAdc();
+
+    pollIsrs = pollAccesses = 0;
+    accesses = host_reg_accesses;
+    samplePdsRails(results);
+    hostRegSync();
+    accesses = host_reg_accesses - accesses - pollAccesses;
+
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++) {
+        if (results[rail] != nominal[rail]) {
+            fprintf(stderr, "FAIL: polling read %s as %u, %u expected\n", railNames[rail], results[rail], nominal[rail]);
+            return 0;
+        }
+    }
+
+    return LPM0_WAKE_CYCLES + POLL_TIMER_CYCLES + MAIN_WAKE_CYCLES + accesses * ISR_REG_ACCESS_CYCLES +
+           pollIsrs * (ISR_ACCEPT_CYCLES + ISR_FRAME_CYCLES + ISR_RETURN_CYCLES + LPM0_WAKE_CYCLES) +
+           pollAccesses * ISR_REG_ACCESS_CYCLES + PDS_RAIL_COUNT * POLL_COMPARE_CYCLES;
+}
+
+//***************************Simulation*********************************************************
+
+int main(int argc, char **argv) {
+    double seconds = (argc > 1) ? strtod(argv[1], NULL) : SIM_SECONDS;
+    uint32_t events[PDS_RAIL_COUNT] = {0};
+    uint16_t results[PDS_RAIL_COUNT];
+    uint32_t conversions, k, isrs = 0, wakeups = 0, pollScan;
+    double rate, isrCycles = 0, dmaCycles = 0, monitorCycles, pollCycles;
+    uint8_t rail;
+
+    if (seconds < 9.0) {
+        fprintf(stderr, "usage: %s [seconds >= 9, the script runs to 8.0 s]\n", argv[0]);
+        return 1;
+    }
+
+    hostRegReset();
+    adcModelInit();
+    dmaModelInit();
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++)
+        adcModelSetInput(channel[rail], nominal[rail]);
+    initAdc();
+    initRailMonitor();
+    hostRegSync();
+
+    if (!ADC_MonitorRunning() || !(HOST_REG16(TIMER_A0_BASE + OFS_TAxCTL) & MC__UP)) {
+        fprintf(stderr, "FAIL: the rail monitor did not start\n");
+        return 1;
+    }
+    rate = (double)ADC_MONITOR_TIMER_HZ / (HOST_REG16(TIMER_A0_BASE + OFS_TAxCCR0) + 1);
+    conversions = (uint32_t)(seconds * rate) / PDS_RAIL_COUNT * PDS_RAIL_COUNT;   // Whole scans
+    ReferenceReset();
+
+    for (k = 0; k < conversions; k++) {
+        double t = k / rate;
+
+        rail = k % PDS_RAIL_COUNT;
+        adcModelSetInput(channel[rail], RailCode(rail, t));
+        adcModelTrigger();
+        ReferenceConvert(rail, RailCode(rail, t));
+
+        while (adcModelInterruptPending()) {
+            uint32_t accesses = host_reg_accesses;
+
+            ADC12_ISR();
+            hostRegSync();
+            isrCycles += ISR_ACCEPT_CYCLES + ISR_FRAME_CYCLES + ISR_RETURN_CYCLES +
+                         (host_reg_accesses - accesses) * ISR_REG_ACCESS_CYCLES;
+            isrs++;
+        }
+
+        // The main loop only runs when an alarm woke it
+        {
+            uint8_t alarms = takeRailAlarms();
+            if (alarms) {
+                wakeups++;
+                for (rail = 0; rail < PDS_RAIL_COUNT; rail++)
+                    events[rail] += (alarms >> rail) & 1;
+            }
+        }
+
+        // End of the period, the next rail's window
+        if (dmaModelTrigger(DMA0TSEL__TA0CCR0) != 2) {
+            fprintf(stderr, "FAIL: TA0CCR0 did not load both thresholds\n");
+            return 1;
+        }
+        dmaCycles += 2 * DMA_MODEL_TRANSFER_CYCLES;
+        hostRegSync();
+        if (HOST_REG16(ADC12_B_BASE + OFS_ADC12HI) != windowHigh[(k + 1) % PDS_RAIL_COUNT] ||
+            HOST_REG16(ADC12_B_BASE + OFS_ADC12LO) != windowLow[(k + 1) % PDS_RAIL_COUNT]) {
+            fprintf(stderr, "FAIL: the window after conversion %u is not the next rail's\n", k);
+            return 1;
+        }
+    }
+
+    if (HOST_REG16(ADC12_B_BASE + OFS_ADC12IFGR2) & ADC12OVIFG) {
+        fprintf(stderr, "FAIL: a rail result was overwritten before ADC12_ISR read it\n");
+        return 1;
+    }
+    if (!CheckFaults("end of script"))
+        return 1;
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++) {
+        if (events[rail] != referenceEvents[rail]) {
+            fprintf(stderr, "FAIL: %s raised %u alarms, %u excursions\n", railNames[rail], events[rail], referenceEvents[rail]);
+            return 1;
+        }
+    }
+    samplePdsRails(results);
+    if (memcmp(results, referenceResults, sizeof(results)) != 0) {
+        fprintf(stderr, "FAIL: samplePdsRails does not return the monitor's last results\n");
+        return 1;
+    }
+
+    printf("Rail monitor, %u rails at %.0f conversions/s (%.0f per rail), %.1f s\n",
+           PDS_RAIL_COUNT, rate, rate / PDS_RAIL_COUNT, seconds);
+    printf("  %-10s %6s %6s %8s %8s\n", "rail", "status", "count", "peak", "trough");
+    {
+        sAdcMonitorFault_t faults[ADC_MONITOR_MAX_RAILS];
+        ADC_MonitorReadFaults(faults, 0);
+        for (rail = 0; rail < PDS_RAIL_COUNT; rail++) {
+            printf("  %-10s   0x%02X %6u", railNames[rail] + 5, faults[rail].status, faults[rail].count);
+            if (faults[rail].status & ADC_MONITOR_HIGH)
+                printf(" %8u", faults[rail].peak);
+            else
+                printf(" %8s", "-");
+            if (faults[rail].status & ADC_MONITOR_LOW)
+                printf(" %8u\n", faults[rail].trough);
+            else
+                printf(" %8s\n", "-");
+        }
+    }
+
+    if (!CheckReport())
+        return 1;
+
+    ADC_MonitorStop();
+    if (!CheckInvalid())
+        return 1;
+
+    pollScan = PollScanCycles();
+    if (pollScan == 0)
+        return 1;
+
+    monitorCycles = (isrCycles + dmaCycles + wakeups * (LPM0_WAKE_CYCLES + MAIN_WAKE_CYCLES)) / seconds;
+    pollCycles = pollScan * rate / PDS_RAIL_COUNT;
+
+    printf("  %-22s %14s %10s %14s %8s\n", "CPU", "main wakes/s", "ISRs/s", "cycles/s", "CPU");
+    printf("  %-22s %14.1f %10.1f %14.0f %7.3f%%\n", "window comparator", wakeups / seconds, isrs / seconds,
+           monitorCycles, 100.0 * monitorCycles / SIM_MCLK_HZ);
+    printf("  %-22s %14.1f %10.1f %14.0f %7.3f%%\n", "polling, same rate", rate / PDS_RAIL_COUNT,
+           (pollIsrs + 1) * rate / PDS_RAIL_COUNT, pollCycles, 100.0 * pollCycles / SIM_MCLK_HZ);
+
+    if (monitorCycles >= pollCycles) {
+        fprintf(stderr, "FAIL: the window comparator costs more CPU than polling\n");
+        return 1;
+    }
+    return 0;
+}
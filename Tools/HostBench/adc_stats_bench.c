@@ -0,0 +1,276 @@
+/**
+ * @file adc_stats_bench.c
+ * @brief Accuracy check and cycles per sample of the ADC statistics and decimation stage.
+ *
+ * The statistics of random, constant and full-scale windows are compared with
+ * a double precision reference: min, max and count exactly, mean and RMS to
+ * within one 1/16 code step. The decimators are compared bit for bit with a
+ * direct cascade of moving sums, fed in blocks that are not a multiple of the
+ * ratio. Then the cycles per sample of every stage are printed.
+ *
+ * Usage: adc_stats_bench [block_samples] [iterations]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "ADC_Stats.h"
+
+#define ADC_STATS_BENCH_SAMPLES     4096u
+#define ADC_STATS_BENCH_BLOCK       256u    // An ADC_Capture.h half at the default length
+#define ADC_STATS_BENCH_ITERATIONS  2000u
+
+static uint16_t samples[ADC_STATS_BENCH_SAMPLES];
+static uint16_t output[ADC_STATS_BENCH_SAMPLES + 1];
+static uint64_t reference[ADC_STATS_BENCH_SAMPLES];
+static uint32_t seed = 0x5EED1234u;
+
+static void FillRandom(uint16_t *buffer, uint32_t count, uint16_t low, uint16_t high) {
+    uint32_t i;
+    for (i = 0; i < count; i++)
+        buffer[i] = (uint16_t)(low + bench_rand(&seed) % (uint32_t)(high - low + 1));
+}
+
+static int CheckWindow(const char *name, const uint16_t *buffer, uint32_t count, int block) {
+    sAdcStats_t stats;
+    uint16_t min = 0xFFFF, max = 0, used = count > ADC_STATS_MAX_COUNT ? ADC_STATS_MAX_COUNT : (uint16_t)count;
+    double sum = 0, squares = 0, mean, rms;
+    uint8_t summary[ADC_STATS_SUMMARY_SIZE];
+    uint32_t i;
+
+    ADC_StatsReset(&stats);
+    if (block) {
+        // Uneven blocks, so the 256 sample chunking is crossed at odd places
+        for (i = 0; i < count; ) {
+            uint32_t n = 1 + bench_rand(&seed) % 700u;
+            if (n > count - i)
+                n = count - i;
+            ADC_StatsAddBlock(&stats, &buffer[i], (uint16_t)n);
+            i += n;
+        }
+    } else {
+        for (i = 0; i < count; i++)
+            ADC_StatsAdd(&stats, buffer[i]);
+    }
+
+    for (i = 0; i < used; i++) {
+        if (buffer[i] < min)
+            min = buffer[i];
+        if (buffer[i] > max)
+            max = buffer[i];
+        sum += buffer[i];
+        squares += (double)buffer[i] * buffer[i];
+    }
+    mean = used ? sum / used * 16.0 : 0.0;
+    rms = used ? sqrt(squares / used) * 16.0 : 0.0;
+
+    if (stats.count != used || (used && (stats.min != min || stats.max != max)) ||
+        fabs(ADC_StatsMean(&stats) - mean) > 1.0 || fabs(ADC_StatsRms(&stats) - rms) > 1.0) {
+        fprintf(stderr, "FAIL: %s (%s): count %u/%u min %u/%u max %u/%u mean %u/%.2f rms %u/%.2f\n",
+                name, block ? "block" : "single", stats.count, used, stats.min, min, stats.max, max,
+                ADC_StatsMean(&stats), mean, ADC_StatsRms(&stats), rms);
+        return 0;
+    }
+
+    if (ADC_StatsSummary(&stats, summary) != ADC_STATS_SUMMARY_SIZE ||
+        (uint16_t)(summary[4] | summary[5] << 8) != ADC_StatsMean(&stats) ||
+        (uint16_t)(summary[6] | summary[7] << 8) != ADC_StatsRms(&stats) ||
+        (uint16_t)(summary[8] | summary[9] << 8) != used) {
+        fprintf(stderr, "FAIL: %s: summary does not match the statistics\n", name);
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckStatistics(void) {
+    static uint16_t window[ADC_STATS_MAX_COUNT + 100u];
+    uint32_t i;
+    int block;
+
+    for (block = 0; block <= 1; block++) {
+        FillRandom(samples, ADC_STATS_BENCH_SAMPLES, 0, 4095);
+        if (!CheckWindow("random", samples, ADC_STATS_BENCH_SAMPLES, block))
+            return 0;
+        FillRandom(samples, ADC_STATS_BENCH_SAMPLES, 2040, 2056);
+        if (!CheckWindow("narrow", samples, ADC_STATS_BENCH_SAMPLES, block))
+            return 0;
+        if (!CheckWindow("empty", samples, 0, block))
+            return 0;
+
+        // A full window of full scale codes, plus samples past the limit that must be dropped
+        for (i = 0; i < sizeof(window) / sizeof(window[0]); i++)
+            window[i] = 4095;
+        if (!CheckWindow("full scale", window, sizeof(window) / sizeof(window[0]), block))
+            return 0;
+        FillRandom(window, sizeof(window) / sizeof(window[0]), 0, 4095);
+        if (!CheckWindow("full window", window, sizeof(window) / sizeof(window[0]), block))
+            return 0;
+    }
+    return 1;
+}
+
+// Direct form: order moving sums of 2^rateShift samples, every 2^rateShift-th value kept
+static uint32_t ReferenceDecimate(const uint16_t *input, uint32_t count, uint8_t order, uint8_t rateShift) {
+    uint32_t ratio = 1u << rateShift, gainBits = order * rateShift, written = 0, i, j;
+    uint8_t k;
+
+    for (i = 0; i < count; i++)
+        reference[i] = input[i];
+    for (k = 0; k < order; k++) {
+        for (i = count; i-- > 0; ) {
+            uint64_t total = 0;
+            for (j = 0; j < ratio && j <= i; j++)
+                total += reference[i - j];
+            reference[i] = total;
+        }
+    }
+
+    for (i = ratio - 1; i < count; i += ratio) {
+        uint64_t value = reference[i];
+        if (gainBits > 4)
+            value = (value + (1ull << (gainBits - 5))) >> (gainBits - 4);
+        else
+            value <<= 4 - gainBits;
+        reference[written++] = value;
+    }
+    return written;
+}
+
+static int CheckDecimators(void) {
+    static const uint8_t invalid[][2] = {{0, 1}, {4, 1}, {1, 0}, {1, 16}, {2, 11}, {3, 7}};
+    sAdcDecimator_t decimator;
+    uint32_t count = 1024, i, j, written, expected;
+    uint8_t order, rateShift;
+
+    for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (ADC_DecimatorInit(&decimator, invalid[i][0], invalid[i][1]) == 0) {
+            fprintf(stderr, "FAIL: decimator order %u ratio 2^%u accepted\n", invalid[i][0], invalid[i][1]);
+            return 0;
+        }
+    }
+
+    for (order = 1; order <= ADC_DECIMATOR_MAX_ORDER; order++) {
+        for (rateShift = 1; 12 + order * rateShift <= 32 && rateShift <= 8; rateShift++) {
+            FillRandom(samples, count, 0, 4095);
+            if (ADC_DecimatorInit(&decimator, order, rateShift) != 0) {
+                fprintf(stderr, "FAIL: decimator order %u ratio 2^%u rejected\n", order, rateShift);
+                return 0;
+            }
+
+            for (i = 0, written = 0; i < count; ) {
+                uint32_t n = 1 + bench_rand(&seed) % 100u;
+                if (n > count - i)
+                    n = count - i;
+                written += ADC_DecimatorRun(&decimator, &samples[i], (uint16_t)n, &output[written]);
+                i += n;
+            }
+
+            expected = ReferenceDecimate(samples, count, order, rateShift);
+            if (written != expected) {
+                fprintf(stderr, "FAIL: order %u ratio 2^%u: %u outputs, expected %u\n", order, rateShift, written, expected);
+                return 0;
+            }
+            for (j = 0; j < written; j++) {
+                if (output[j] != reference[j]) {
+                    fprintf(stderr, "FAIL: order %u ratio 2^%u output %u: %u, expected %llu\n",
+                            order, rateShift, j, output[j], (unsigned long long)reference[j]);
+                    return 0;
+                }
+            }
+        }
+
+        // Full scale through the largest ratio must not wrap, once the filter has filled up
+        rateShift = (32 - 12) / order;
+        if (rateShift > ADC_DECIMATOR_MAX_SHIFT)
+            rateShift = ADC_DECIMATOR_MAX_SHIFT;
+        for (i = 0; i < count; i++)
+            samples[i] = 4095;
+        ADC_DecimatorInit(&decimator, order, rateShift);
+        for (i = 0, expected = 0; expected <= order; i++) {
+            written = ADC_DecimatorRun(&decimator, samples, (uint16_t)count, output);
+            for (j = 0; j < written; j++, expected++) {
+                if (expected >= order && output[j] != 4095 * 16) {
+                    fprintf(stderr, "FAIL: order %u ratio 2^%u full scale gave %u\n", order, rateShift, output[j]);
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+static void Report(const char *name, uint64_t best, uint32_t block) {
+    printf("  %-28s %8.2f cycles/sample\n", name, (double)best / block);
+}
+
+int main(int argc, char **argv) {
+    uint32_t block = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : ADC_STATS_BENCH_BLOCK;
+    uint32_t iterations = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : ADC_STATS_BENCH_ITERATIONS;
+    uint64_t overhead = bench_cycles_overhead();
+    volatile uint16_t sink = 0;
+    sAdcStats_t stats;
+    sAdcDecimator_t decimator;
+    uint64_t best;
+    uint32_t i, it;
+    uint8_t order;
+
+    if (block == 0 || block > ADC_STATS_BENCH_SAMPLES || iterations == 0) {
+        fprintf(stderr, "usage: %s [block_samples 1..%u] [iterations]\n", argv[0], ADC_STATS_BENCH_SAMPLES);
+        return 1;
+    }
+
+    if (!CheckStatistics() || !CheckDecimators())
+        return 1;
+    printf("adc_stats_bench: statistics and decimators match the reference\n");
+
+    FillRandom(samples, block, 0, 4095);
+    printf("%u sample blocks, best of %u runs:\n", block, iterations);
+
+    best = UINT64_MAX;
+    for (it = 0; it < iterations; it++) {
+        uint64_t t0, t1;
+        ADC_StatsReset(&stats);
+        t0 = bench_cycles();
+        for (i = 0; i < block; i++)
+            ADC_StatsAdd(&stats, samples[i]);
+        t1 = bench_cycles();
+        sink += stats.max;
+        if (t1 - t0 - overhead < best)
+            best = t1 - t0 - overhead;
+    }
+    Report("ADC_StatsAdd", best, block);
+
+    best = UINT64_MAX;
+    for (it = 0; it < iterations; it++) {
+        uint64_t t0, t1;
+        ADC_StatsReset(&stats);
+        t0 = bench_cycles();
+        ADC_StatsAddBlock(&stats, samples, (uint16_t)block);
+        t1 = bench_cycles();
+        sink += stats.max;
+        if (t1 - t0 - overhead < best)
+            best = t1 - t0 - overhead;
+    }
+    Report("ADC_StatsAddBlock", best, block);
+
+    for (order = 1; order <= ADC_DECIMATOR_MAX_ORDER; order++) {
+        char name[40];
+        best = UINT64_MAX;
+        ADC_DecimatorInit(&decimator, order, 4);
+        for (it = 0; it < iterations; it++) {
+            uint64_t t0, t1;
+            t0 = bench_cycles();
+            sink += ADC_DecimatorRun(&decimator, samples, (uint16_t)block, output);
+            t1 = bench_cycles();
+            if (t1 - t0 - overhead < best)
+                best = t1 - t0 - overhead;
+        }
+        snprintf(name, sizeof(name), "%s order %u, 16:1", order == 1 ? "boxcar" : "CIC", order);
+        Report(name, best, block);
+    }
+
+    (void)sink;
+    return 0;
+}
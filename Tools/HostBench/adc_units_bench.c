@@ -0,0 +1,322 @@
+/**
+ * @file adc_units_bench.c
+ * @brief Accuracy and cycles per sample of the fixed-point ADC unit conversion.
+ *
+ * The TLV table of a device is written into the host register file and read
+ * back with ADC_CalibrationRead() for every reference. Then every 12-bit code
+ * is converted through random calibrations and a set of channels, and checked
+ * against the same chain in double precision: within the error the Q15 scale
+ * allows, and the exactly rounded value or one away from it for channels
+ * under 8192 units full scale. Saturation, in-place blocks and invalid
+ * channels are checked too.
+ *
+ * The cycles per sample are printed next to a single precision float
+ * conversion with its factors worked out beforehand. The host has a floating
+ * point unit; the MSP430 does not, so on the target the gap is far larger.
+ *
+ * Usage: adc_units_bench [block_samples] [iterations]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <msp430.h>
+
+#include "bench.h"
+#include "ADC_Units.h"
+
+#define ADC_UNITS_BENCH_CODES       4096u
+#define ADC_UNITS_BENCH_BLOCK       256u    // An ADC_Capture.h half at the default length
+#define ADC_UNITS_BENCH_ITERATIONS  2000u
+#define ADC_UNITS_BENCH_DEVICES     200u
+
+static uint16_t codes[ADC_UNITS_BENCH_CODES];
+static int16_t values[ADC_UNITS_BENCH_CODES];
+static int16_t blockValues[ADC_UNITS_BENCH_CODES];
+static float floatValues[ADC_UNITS_BENCH_CODES];
+static uint32_t seed = 0x0ADC0415u;
+
+// Board channels: rail dividers, current sense amplifiers, a tiny and a saturating one
+static const struct {
+    const char *name;
+    sAdcUnitsChannel_t channel;
+} channels[] = {
+    {"pin mV",           {1, 1, 0}},
+    {"VBAT 2:1 mV",      {2, 1, 0}},
+    {"5V 3:2 mV",        {3, 2, 0}},
+    {"I 0.5V/A mA",      {2, 1, -50}},
+    {"I 1.32V/A mA",     {25, 33, 12}},
+    {"I 20mV/A mA",      {50, 1, 0}},
+    {"mV / 64",          {1, 64, 0}},
+    {"x13 mV, saturates", {13, 1, -4000}},
+};
+
+//***************************TLV table**********************************************************
+
+static void WriteTlv(uint16_t address, uint8_t tag, const uint16_t *data, uint8_t words) {
+    uint8_t i;
+
+    HOST_REG8(address) = tag;
+    HOST_REG8(address + 1) = 2 * words;
+    for (i = 0; i < words; i++)
+        HOST_REG16(address + 2 + 2 * i) = data[i];
+}
+
+// FR5969 layout: die record, ADC12 calibration, REF calibration, then erased memory
+static void WriteDevice(uint16_t gain, int16_t offset, const uint16_t refFactors[3], int withRef) {
+    static const uint16_t die[5] = {0x1234, 0x5678, 0x0009, 0x0017, 0x0000};
+    const uint16_t adc[9] = {gain, (uint16_t)offset, 0x0800, 0x09C0, 0x04E0, 0x05E0, 0x03E0, 0x04B0, 0};
+    uint16_t address = TLV_START;
+
+    memset(&host_reg_file[TLV_START], 0xFF, TLV_END + 1 - TLV_START);
+    WriteTlv(address, 0x08, die, 5);
+    address += 2 + 10;
+    WriteTlv(address, TLV_ADC12CAL, adc, 9);
+    address += 2 + 18;
+    if (withRef)
+        WriteTlv(address, TLV_REFCAL, refFactors, 3);
+}
+
+static int CheckCalibrationRead(void) {
+    static const uint16_t refs[3] = {0x7F10, 0x8123, 0x7E99};
+    sAdcCalibration_t cal;
+    uint8_t reference;
+
+    WriteDevice(0x80A5, -7, refs, 1);
+    for (reference = ADC_UNITS_REF_AVCC; reference <= ADC_UNITS_REF_2V5; reference++) {
+        static const uint16_t millivolts[4] = {3300, 1200, 2000, 2500};
+        uint16_t factor = reference == ADC_UNITS_REF_AVCC ? 0x8000 : refs[reference - 1];
+
+        if (ADC_CalibrationRead(&cal, reference, 3300) != 0 || cal.gain != 0x80A5 || cal.offset != -7 ||
+            cal.refFactor != factor || cal.refMillivolts != millivolts[reference]) {
+            fprintf(stderr, "FAIL: TLV calibration for reference %u read as %04X %d %04X %u\n",
+                    reference, cal.gain, cal.offset, cal.refFactor, cal.refMillivolts);
+            return 0;
+        }
+    }
+
+    // No REF record: AVCC does not need one, the internal references do
+    WriteDevice(0x80A5, -7, refs, 0);
+    if (ADC_CalibrationRead(&cal, ADC_UNITS_REF_AVCC, 3300) != 0) {
+        fprintf(stderr, "FAIL: AVCC calibration needs a REF record\n");
+        return 0;
+    }
+    if (ADC_CalibrationRead(&cal, ADC_UNITS_REF_2V0, 3300) == 0 || cal.refFactor != 0x8000 || cal.gain != 0x80A5) {
+        fprintf(stderr, "FAIL: a missing REF record was not reported or not left at 1.0\n");
+        return 0;
+    }
+    if (ADC_CalibrationRead(&cal, ADC_UNITS_REF_2V5 + 1, 3300) == 0) {
+        fprintf(stderr, "FAIL: an unknown reference was accepted\n");
+        return 0;
+    }
+    return 1;
+}
+
+//***************************Accuracy***********************************************************
+
+static double Reference(const sAdcCalibration_t *cal, const sAdcUnitsChannel_t *channel, uint16_t code) {
+    double corrected = ((double)code * cal->gain / 32768.0 + cal->offset) * cal->refFactor / 32768.0;
+
+    return corrected * cal->refMillivolts / 4096.0 * channel->multiplier / channel->divider + channel->offset;
+}
+
+static double Saturated(double value) {
+    return value > 32767.0 ? 32767.0 : value < -32768.0 ? -32768.0 : value;
+}
+
+// Worst error against the double chain, in units; negative on a failure
+static double CheckChannel(const sAdcCalibration_t *cal, const sAdcUnitsChannel_t *channel, const char *name,
+                           uint32_t *roundedExact, uint32_t *total) {
+    sAdcUnits_t units;
+    double fullScale = fabs(Reference(cal, channel, 4095) - Reference(cal, channel, 0));
+    double bound = 0.5 + fullScale / 32768.0 + 1e-6, worst = 0;
+    uint32_t i;
+
+    if (ADC_UnitsInit(&units, cal, channel) != 0) {
+        fprintf(stderr, "FAIL: %s rejected with gain %04X offset %d ref %04X %u mV\n", name,
+                cal->gain, cal->offset, cal->refFactor, cal->refMillivolts);
+        return -1;
+    }
+
+    for (i = 0; i < ADC_UNITS_BENCH_CODES; i++)
+        codes[i] = (uint16_t)i;
+    ADC_UnitsConvertBlock(&units, codes, blockValues, ADC_UNITS_BENCH_CODES);
+
+    for (i = 0; i < ADC_UNITS_BENCH_CODES; i++) {
+        double exact = Saturated(Reference(cal, channel, (uint16_t)i));
+        double error = fabs(blockValues[i] - exact);
+
+        values[i] = ADC_UnitsConvert(&units, (uint16_t)i);
+        if (values[i] != blockValues[i]) {
+            fprintf(stderr, "FAIL: %s code %u: ADC_UnitsConvert %d, block %d\n", name, i, values[i], blockValues[i]);
+            return -1;
+        }
+        if (error > bound || (fullScale < 8192 && fabs(blockValues[i] - floor(exact + 0.5)) > 1)) {
+            fprintf(stderr, "FAIL: %s code %u gave %d, %.3f expected (gain %04X offset %d ref %04X %u mV)\n",
+                    name, i, blockValues[i], exact, cal->gain, cal->offset, cal->refFactor, cal->refMillivolts);
+            return -1;
+        }
+        if (error > worst)
+            worst = error;
+        *roundedExact += blockValues[i] == floor(exact + 0.5);
+        (*total)++;
+    }
+
+    // In place, over the codes themselves
+    memcpy(values, codes, sizeof(codes));
+    ADC_UnitsConvertBlock(&units, (const uint16_t *)values, values, ADC_UNITS_BENCH_CODES);
+    if (memcmp(values, blockValues, sizeof(values)) != 0) {
+        fprintf(stderr, "FAIL: %s converted in place differs\n", name);
+        return -1;
+    }
+    return worst;
+}
+
+static int CheckAccuracy(void) {
+    static const uint16_t refMillivolts[4] = {3300, 1200, 2000, 2500};
+    uint8_t c;
+
+    printf("%-18s %14s %14s\n", "channel", "worst error", "exactly rounded");
+    for (c = 0; c < sizeof(channels) / sizeof(channels[0]); c++) {
+        uint32_t roundedExact = 0, total = 0, device;
+        double worst = 0;
+
+        for (device = 0; device < ADC_UNITS_BENCH_DEVICES; device++) {
+            sAdcCalibration_t cal;
+            double error;
+
+            // Production spread: gain within 2.5 %, offset within 20 codes, reference factor within 3 %
+            cal.gain = (uint16_t)(0x8000 - 800 + bench_rand(&seed) % 1601);
+            cal.offset = (int16_t)((int32_t)(bench_rand(&seed) % 41) - 20);
+            cal.refFactor = (uint16_t)(0x8000 - 1000 + bench_rand(&seed) % 2001);
+            cal.refMillivolts = refMillivolts[device % 4];
+            if (device % 4 == ADC_UNITS_REF_AVCC)
+                cal.refFactor = 0x8000;
+
+            error = CheckChannel(&cal, &channels[c].channel, channels[c].name, &roundedExact, &total);
+            if (error < 0)
+                return 0;
+            if (error > worst)
+                worst = error;
+        }
+        printf("%-18s %10.3f units %13.2f%%\n", channels[c].name, worst, 100.0 * roundedExact / total);
+    }
+    return 1;
+}
+
+static int CheckInvalid(void) {
+    static const struct {
+        sAdcCalibration_t cal;
+        sAdcUnitsChannel_t channel;
+        const char *what;
+    } cases[] = {
+        {{0x8000, 0, 0x8000, 3300}, {1, 0, 0},     "a divider of 0"},
+        {{0x8000, 0, 0x8000, 4096}, {1, 1, 0},     "a reference above ADC_UNITS_MAX_REF_MV"},
+        {{0x8000, 0, 0x8000, 3300}, {0, 1, 0},     "a multiplier of 0"},
+        {{0x8000, 0, 0x8000, 4095}, {65535, 1, 0}, "more than 0x7FFF units per code"},
+        {{0x0001, 0, 0x0001, 1},    {1, 65535, 0}, "less than 2^-30 units per code"},
+    };
+    sAdcUnits_t units;
+    unsigned i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (ADC_UnitsInit(&units, &cases[i].cal, &cases[i].channel) == 0) {
+            fprintf(stderr, "FAIL: ADC_UnitsInit accepted %s\n", cases[i].what);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//***************************Timing*************************************************************
+
+// What the conversion costs in float, factors worked out beforehand
+static void FloatConvertBlock(float scale, float bias, const uint16_t *input, float *output, uint32_t count) {
+    uint32_t i;
+    for (i = 0; i < count; i++)
+        output[i] = input[i] * scale + bias;
+}
+
+int main(int argc, char **argv) {
+    uint32_t block = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : ADC_UNITS_BENCH_BLOCK;
+    uint32_t iterations = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : ADC_UNITS_BENCH_ITERATIONS;
+    uint64_t overhead = bench_cycles_overhead(), best, bestFloat;
+    const sAdcCalibration_t cal = {0x8123, -5, 0x7F10, 2500};
+    sAdcUnits_t units, sequence[8];
+    int16_t sequenceValues[8];
+    volatile int32_t sink = 0;
+    float floatScale, floatBias;
+    uint32_t i, it;
+
+    if (block == 0 || block > ADC_UNITS_BENCH_CODES || iterations == 0) {
+        fprintf(stderr, "usage: %s [block_samples 1..%u] [iterations]\n", argv[0], ADC_UNITS_BENCH_CODES);
+        return 1;
+    }
+
+    hostRegReset();
+    if (!CheckCalibrationRead() || !CheckAccuracy() || !CheckInvalid())
+        return 1;
+
+    // One code per channel, each with its own conversion
+    for (i = 0; i < 8; i++) {
+        ADC_UnitsInit(&sequence[i], &cal, &channels[i].channel);
+        codes[i] = (uint16_t)(bench_rand(&seed) % 4096);
+    }
+    ADC_UnitsConvertSequence(sequence, codes, sequenceValues, 8);
+    for (i = 0; i < 8; i++) {
+        if (sequenceValues[i] != ADC_UnitsConvert(&sequence[i], codes[i])) {
+            fprintf(stderr, "FAIL: ADC_UnitsConvertSequence differs on channel %u\n", i);
+            return 1;
+        }
+    }
+    printf("adc_units_bench: TLV calibration, conversions and saturation match the reference\n");
+
+    ADC_UnitsInit(&units, &cal, &channels[1].channel);
+    floatScale = (float)(Reference(&cal, &channels[1].channel, 1) - Reference(&cal, &channels[1].channel, 0));
+    floatBias = (float)Reference(&cal, &channels[1].channel, 0);
+    for (i = 0; i < block; i++)
+        codes[i] = (uint16_t)(bench_rand(&seed) % 4096);
+    printf("%u sample blocks, best of %u runs:\n", block, iterations);
+
+    best = UINT64_MAX;
+    for (it = 0; it < iterations; it++) {
+        uint64_t t0, t1;
+        t0 = bench_cycles();
+        for (i = 0; i < block; i++)
+            values[i] = ADC_UnitsConvert(&units, codes[i]);
+        t1 = bench_cycles();
+        sink += values[block - 1];
+        if (t1 - t0 - overhead < best)
+            best = t1 - t0 - overhead;
+    }
+    printf("  %-28s %8.2f cycles/sample\n", "ADC_UnitsConvert", (double)best / block);
+
+    best = UINT64_MAX;
+    for (it = 0; it < iterations; it++) {
+        uint64_t t0, t1;
+        t0 = bench_cycles();
+        ADC_UnitsConvertBlock(&units, codes, values, (uint16_t)block);
+        t1 = bench_cycles();
+        sink += values[block - 1];
+        if (t1 - t0 - overhead < best)
+            best = t1 - t0 - overhead;
+    }
+    printf("  %-28s %8.2f cycles/sample\n", "ADC_UnitsConvertBlock", (double)best / block);
+
+    bestFloat = UINT64_MAX;
+    for (it = 0; it < iterations; it++) {
+        uint64_t t0, t1;
+        t0 = bench_cycles();
+        FloatConvertBlock(floatScale, floatBias, codes, floatValues, block);
+        t1 = bench_cycles();
+        sink += (int32_t)floatValues[block - 1];
+        if (t1 - t0 - overhead < bestFloat)
+            bestFloat = t1 - t0 - overhead;
+    }
+    printf("  %-28s %8.2f cycles/sample (host FPU)\n", "float reference", (double)bestFloat / block);
+
+    (void)sink;
+    return 0;
+}
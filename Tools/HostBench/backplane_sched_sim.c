@@ -0,0 +1,487 @@
+/**
+ * @file backplane_sched_sim.c
+ * @brief Duty cycle and event latency of the Backplane scheduler, countdown and OBC polling.
+ *
+ * The real timer.c, scheduler.c, i2c.c and the RTC_B / GPIO driverlib run on
+ * the host register file. The simulation plays the parts of the hardware
+ * around them:
+ *  - RTC_B: the alarm at the time the firmware wrote into the alarm
+ *    registers, the minute event and RTCRDYIFG every second, each only
+ *    reaching the CPU if the firmware enabled it
+ *  - the OBC: once the countdown is over, an I2C master on
+ *    hal/eusci_b_model.c polls the Backplane commands at their own periods,
+ *    writing [ID, stop] and reading the response back a while later. It also
+ *    sends an unknown ID and a command of the wrong size. Each one must get
+ *    its error code back, CommandUnavailable for the known commands as no
+ *    response format is defined yet.
+ *
+ * Time is in seconds, CPU work in MCLK cycles. An ISR runs at the time its
+ * flag is raised, preempting the main loop, and posts events. The main loop
+ * dispatches one pending event at a time, highest priority first, and sleeps
+ * in LPM3 as soon as nothing is pending. An ISR that finds the CPU asleep
+ * pays the LPM3 wake-up first.
+ *
+ * The cost model is the one of i2c_slave_timing_sim: interrupt entry and RETI
+ * from the FR5969 user's guide, 3 cycles per peripheral register access as
+ * counted by the register file, and a fixed amount of RAM work per ISR and
+ * per handler. The currents are FR5969 datasheet typicals. All of them are
+ * #defines below, to be calibrated against the target.
+ *
+ * Usage: backplane_sched_sim [minutes_deployed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <msp430.h>
+
+#include "timer.h"
+#include "scheduler.h"
+#include "i2c.h"
+#include "eusci_b_model.h"
+#include "msp430_cycles.h"
+#include "bench.h"
+
+#define SIM_MCLK_HZ                 1e6     /**< DCO reset default, the Backplane does not change it */
+#define SIM_MINUTES_DEPLOYED        30
+#define SIM_I2C_HZ                  100e3
+#define SIM_OBC_BOOT_S              2.0     /**< CDH power on to its first poll */
+#define SIM_READ_DELAY_S            1e-3    /**< Command write STOP to the response read START */
+#define SIM_UNKNOWN_ID              0x7F    /**< Not in BACKPLANE_COMMANDS */
+
+// CPU cost model, in MCLK cycles, on top of msp430_cycles.h
+#define ISR_BODY_CYCLES             20      /**< RAM work: ring push, schedulerPost */
+#define LPM3_WAKE_CYCLES            10      /**< DCO restart out of LPM3 */
+#define DISPATCH_CYCLES             40      /**< Pending scan, interrupts off and on, indirect call */
+#define HANDLER_BODY_CYCLES         30
+#define HANDLER_CYCLES_PER_BYTE     60      /**< processI2C -> commandByte -> commandHandler */
+#define IDLE_CYCLES                 12      /**< Pending check and the LPM3 entry */
+
+// Supply current, FR5969 datasheet typicals at 3 V
+#define AM_CURRENT_UA               126.0   /**< Active at 1 MHz, FRAM, no wait states */
+#define LPM3_CURRENT_UA             0.7     /**< LFXT and RTC_B running */
+#define LPM0_CURRENT_UA             70.0    /**< DCO running at 1 MHz */
+
+void RTC_B_ISR(void);
+void USCI_B0_ISR(void);
+
+static double mclk_hz = SIM_MCLK_HZ;
+
+//***************************Statistics***************************************************
+
+enum {
+    PHASE_COUNTDOWN,
+    PHASE_DEPLOYED,
+    PHASE_COUNT
+};
+
+static const char *phase_names[PHASE_COUNT] = {"countdown", "deployed"};
+
+#define BACKPLANE_EVENT_NAME(Name, handler)     #Name,
+
+static const char *event_names[BACKPLANE_EVENT_COUNT] = {
+    BACKPLANE_EVENTS(BACKPLANE_EVENT_NAME)
+};
+
+typedef struct {
+    double active_s;
+    uint32_t isrs;
+    uint32_t wakeups;           /**< ISRs taken out of LPM3 */
+    uint32_t handlers;
+} sPhaseStats_t;
+
+typedef struct {
+    uint32_t runs;
+    double latency_sum;         /**< Post to handler start */
+    double latency_max;
+    double cycles_max;
+} sEventStats_t;
+
+static sPhaseStats_t phases[PHASE_COUNT];
+static sEventStats_t events[BACKPLANE_EVENT_COUNT];
+static uint8_t phase = PHASE_COUNTDOWN;
+static double phase_start[PHASE_COUNT];
+
+//***************************CPU**********************************************************
+
+static double cpu_free = 0;         /**< The CPU is busy until then, asleep after if nothing is pending */
+static double posted_at[BACKPLANE_EVENT_COUNT];
+static uint32_t deployments = 0;
+static double deployed_at = -1;
+
+static void Spend(double cycles) {
+    cpu_free += cycles / mclk_hz;
+    phases[phase].active_s += cycles / mclk_hz;
+}
+
+static void RunIsr(void (*isr)(void), double at) {
+    uint16_t before = schedulerPending();
+    uint16_t posted;
+    uint32_t accesses = host_reg_accesses;
+    uint8_t e;
+
+    phases[phase].isrs++;
+    if (cpu_free <= at) {
+        // Nothing pending either: the main loop drains the queue before sleeping
+        cpu_free = at;
+        phases[phase].wakeups++;
+        Spend(LPM3_WAKE_CYCLES);
+    }
+
+    isr();
+    hostRegSync();
+    Spend(ISR_ACCEPT_CYCLES + ISR_FRAME_CYCLES + ISR_RETURN_CYCLES + ISR_BODY_CYCLES +
+          (host_reg_accesses - accesses) * ISR_REG_ACCESS_CYCLES);
+
+    // A merged post keeps the time of the first one
+    posted = schedulerPending() & ~before;
+    for (e = 0; e < BACKPLANE_EVENT_COUNT; e++)
+        if (posted & (1u << e))
+            posted_at[e] = at;
+}
+
+// The eUSCI raises its flags from inside the firmware's own register
+// writes, so they are checked after each ISR and handler
+static void ServicePeripherals(double at) {
+    uint8_t guard = 0;
+
+    while (eusciModelInterruptPending()) {
+        RunIsr(USCI_B0_ISR, (cpu_free > at) ? cpu_free : at);
+        if (++guard > 16)
+            FAIL("USCI_B0_ISR leaves its interrupt pending");
+    }
+}
+
+static void PollsInit(double at);
+
+static void RunHandler(void) {
+    uint16_t waiting = schedulerPending();
+    uint8_t expected = 0;
+    uint8_t bytes = i2cRxPending();
+    uint32_t accesses = host_reg_accesses;
+    double start = cpu_free, cycles;
+    uint8_t e;
+
+    while (!(waiting & (1u << expected)))
+        expected++;
+
+    e = schedulerDispatch();
+    hostRegSync();
+    if (e != expected)
+        FAIL("dispatched %u with %u pending (mask 0x%04x)", e, expected, waiting);
+
+    cycles = DISPATCH_CYCLES + HANDLER_BODY_CYCLES + (host_reg_accesses - accesses) * ISR_REG_ACCESS_CYCLES;
+    if (e == EVENT_I2C_RX)
+        cycles += bytes * HANDLER_CYCLES_PER_BYTE;
+    Spend(cycles);
+    if (schedulerPending() == 0)
+        Spend(IDLE_CYCLES);
+
+    phases[phase].handlers++;
+    events[e].runs++;
+    events[e].latency_sum += start - posted_at[e];
+    if (start - posted_at[e] > events[e].latency_max)
+        events[e].latency_max = start - posted_at[e];
+    if (cycles > events[e].cycles_max)
+        events[e].cycles_max = cycles;
+
+    if (e == EVENT_DEPLOY) {
+        deployments++;
+        deployed_at = posted_at[e];
+        phase = PHASE_DEPLOYED;
+        phase_start[PHASE_DEPLOYED] = deployed_at;
+        PollsInit(deployed_at + SIM_OBC_BOOT_S);
+    }
+    ServicePeripherals(cpu_free);
+}
+
+//***************************RTC**********************************************************
+
+static uint8_t Bcd(uint8_t value) {
+    return (value >> 4) * 10 + (value & 0x0F);
+}
+
+static uint16_t Ctl01(void) {
+    hostRegSync();
+    return HOST_REG16(RTC_B_BASE + OFS_RTCCTL01);
+}
+
+// The flag only reaches the CPU if its enable is set, RTCxxIE is RTCxxIFG << 4
+static uint8_t FireRtc(uint16_t flag, uint16_t vector, double at) {
+    if (!(Ctl01() & (flag << 4)))
+        return 0;
+
+    HOST_REG16(RTC_B_BASE + OFS_RTCCTL01) |= flag;
+    HOST_REG16(RTC_B_BASE + OFS_RTCIV) = vector;
+    RunIsr(RTC_B_ISR, at);
+    // Reading RTCIV clears the flag it reported
+    HOST_REG16(RTC_B_BASE + OFS_RTCCTL01) &= ~flag;
+    HOST_REG16(RTC_B_BASE + OFS_RTCIV) = RTCIV_NONE;
+    return 1;
+}
+
+//***************************OBC**********************************************************
+
+typedef struct {
+    uint8_t id;
+    uint8_t cmd_size;           /**< ID, zero padding, stop condition */
+    uint8_t resp_size;
+    uint8_t error;              /**< Expected error code, 0 for a response */
+    double period_s;
+    double next_s;
+    uint32_t polls;
+} sPoll_t;
+
+// No command has a response format yet: every one answers CommandUnavailable
+#define BACKPLANE_POLL(Name, id, cmd_size, resp_size) \
+    {Name, cmd_size, BACKPLANE_ERROR_RESP_SIZE, CommandUnavailable, 0, 0, 0},
+
+static sPoll_t polls[] = {
+    BACKPLANE_COMMANDS(BACKPLANE_POLL)
+    {SIM_UNKNOWN_ID, 2, BACKPLANE_ERROR_RESP_SIZE, CommandUnknown, 0, 0, 0},
+    {SystemStatus, SystemStatusSize + 1, BACKPLANE_ERROR_RESP_SIZE, CommandBadSize, 0, 0, 0},
+};
+
+#define POLL_COUNT  (sizeof(polls) / sizeof(polls[0]))
+
+enum {
+    BUS_IDLE,
+    BUS_WRITE,          /**< Command byte `index` ends at `at` */
+    BUS_WRITE_STOP,
+    BUS_READ_START,
+    BUS_READ,           /**< Response byte `index` ends at `at` */
+    BUS_READ_STOP,
+};
+
+static struct {
+    uint8_t state;
+    sPoll_t *poll;
+    uint8_t index;
+    double at;
+    uint8_t response[MAX_BUFFER_SIZE];
+    double stretch_max;
+    uint32_t responses;
+} bus = {BUS_IDLE, NULL, 0, 0, {0}, 0, 0};
+
+static double bit_s;
+
+static void PollsInit(double at) {
+    uint8_t i;
+
+    for (i = 0; i < POLL_COUNT; i++) {
+        switch (polls[i].id) {
+            case SystemStatus:          polls[i].period_s = 1; break;
+            case HealthCheck:           polls[i].period_s = 10; break;
+            case Temperature:           polls[i].period_s = 60; break;
+            default:                    polls[i].period_s = 0; break;  // Only sent after a telecommand
+        }
+        // The ones the OBC gets wrong, now and then
+        if (polls[i].error == CommandUnknown || polls[i].error == CommandBadSize)
+            polls[i].period_s = 30;
+        // Stagger the first ones so two polls never share a second boundary
+        polls[i].next_s = at + i * 0.25;
+    }
+}
+
+static void CheckResponse(const sPoll_t *poll) {
+    if (bus.response[poll->resp_size - 1] != STOP_CONDITION)
+        FAIL("response to 0x%02x does not end in the stop condition", poll->id);
+    if (poll->error != 0 && bus.response[0] != poll->error)
+        FAIL("0x%02x (%u bytes) answered 0x%02x, not error 0x%02x", poll->id, poll->cmd_size,
+             bus.response[0], poll->error);
+    bus.responses++;
+}
+
+static double BusNext(void) {
+    double next = 1e30;
+    uint8_t i;
+
+    if (bus.state != BUS_IDLE)
+        return bus.at;
+    if (deployed_at < 0)
+        return next;
+    for (i = 0; i < POLL_COUNT; i++)
+        if (polls[i].period_s > 0 && polls[i].next_s < next)
+            next = polls[i].next_s;
+    return next;
+}
+
+// One step of the master at bus.at, stretching while the slave is behind
+static void BusStep(void) {
+    uint8_t i;
+
+    switch (bus.state) {
+        case BUS_IDLE:
+            for (i = 0; i < POLL_COUNT; i++)
+                if (polls[i].period_s > 0 && polls[i].next_s <= bus.at)
+                    break;
+            bus.poll = &polls[i];
+            bus.poll->next_s += bus.poll->period_s;
+            bus.poll->polls++;
+            eusciModelStart(0);
+            bus.index = 0;
+            bus.at += 10 * bit_s;     // START and the address byte
+            bus.state = BUS_WRITE;
+            break;
+        case BUS_WRITE: {
+            uint8_t data = (bus.index == 0) ? bus.poll->id : (bus.index + 1 == bus.poll->cmd_size) ? STOP_CONDITION : 0;
+
+            if (!eusciModelReceive(data))
+                FAIL("UCB0RXBUF still full at %.6f s", bus.at);
+            if (++bus.index == bus.poll->cmd_size)
+                bus.state = BUS_WRITE_STOP;
+            bus.at += (bus.state == BUS_WRITE) ? 9 * bit_s : bit_s;
+            break;
+        }
+        case BUS_WRITE_STOP:
+            eusciModelStop();
+            bus.at += SIM_READ_DELAY_S;
+            bus.state = BUS_READ_START;
+            break;
+        case BUS_READ_START:
+            eusciModelStart(1);
+            bus.index = 0;
+            bus.at += 19 * bit_s;     // START, the address byte and the first data byte
+            bus.state = BUS_READ;
+            break;
+        case BUS_READ: {
+            double held = 0;
+
+            while (!eusciModelTransmit(&bus.response[bus.index])) {
+                // SCL held until the CPU loads UCB0TXBUF
+                if (cpu_free <= bus.at && schedulerPending() == 0 && !eusciModelInterruptPending())
+                    FAIL("the slave never loads the response to 0x%02x", bus.poll->id);
+                held = cpu_free - bus.at;
+                bus.at = cpu_free;
+                ServicePeripherals(bus.at);
+                while (schedulerPending() != 0)
+                    RunHandler();
+            }
+            if (held > bus.stretch_max)
+                bus.stretch_max = held;
+            if (++bus.index == bus.poll->resp_size)
+                bus.state = BUS_READ_STOP;
+            bus.at += (bus.state == BUS_READ) ? 9 * bit_s : bit_s;
+            break;
+        }
+        case BUS_READ_STOP:
+            eusciModelStop();
+            CheckResponse(bus.poll);
+            bus.state = BUS_IDLE;
+            break;
+    }
+}
+
+//***************************Simulation***************************************************
+
+int main(int argc, char **argv) {
+    double minutes_deployed = (argc > 1) ? atof(argv[1]) : SIM_MINUTES_DEPLOYED;
+    double alarm_s, minute_s, second_s, end_s, now;
+    uint8_t start_seconds, e, i;
+
+    bit_s = 1 / SIM_I2C_HZ;
+
+    hostRegReset();
+    eusciModelInit();
+    init_App();
+    hostRegSync();
+
+    // The countdown as the firmware programmed it into the calendar
+    start_seconds = Bcd(HOST_REG8(RTC_B_BASE + OFS_RTCTIM0_L));
+    alarm_s = (Bcd(HOST_REG8(RTC_B_BASE + OFS_RTCAMINHR_L) & 0x7F) -
+               Bcd(HOST_REG8(RTC_B_BASE + OFS_RTCTIM0_H))) * 60.0 - start_seconds;
+    if (alarm_s <= 0)
+        FAIL("the alarm is not after the start time");
+    if (Ctl01() & RTCHOLD)
+        FAIL("RTC_B is still held");
+
+    minute_s = 60.0 - start_seconds;
+    second_s = 1.0;
+    end_s = alarm_s + minutes_deployed * 60.0;
+    now = 0;
+
+    printf("backplane_sched_sim: MCLK %.0f Hz, I2C %.0f kHz, countdown %.0f s, %.0f min deployed\n",
+           mclk_hz, SIM_I2C_HZ / 1e3, alarm_s, minutes_deployed);
+
+    while (1) {
+        double bus_next = BusNext();
+
+        // The main loop runs whenever the CPU is free before the next interrupt
+        if (schedulerPending() != 0) {
+            double next = second_s;
+
+            if (minute_s < next) next = minute_s;
+            if (bus_next < next) next = bus_next;
+            if (cpu_free <= next) {
+                RunHandler();
+                continue;
+            }
+        }
+
+        // Next hardware event, RTC first at equal times as its flags are raised by the same clock edge
+        if (second_s <= minute_s && second_s <= bus_next) {
+            now = second_s;
+            if (now > end_s)
+                break;
+            if (FireRtc(RTCRDYIFG, RTCIV_RTCRDYIFG, now))
+                FAIL("RTCRDYIFG interrupt enabled, it wakes the CPU every second");
+            second_s += 1.0;
+            continue;
+        }
+        if (minute_s <= bus_next) {
+            now = minute_s;
+            // RTCIV reports the time event before the alarm
+            if (FireRtc(RTCTEVIFG, RTCIV_RTCTEVIFG, now))
+                FAIL("RTCTEVIFG interrupt enabled, nothing uses the minute event");
+            if (now >= alarm_s && now < alarm_s + 1)
+                FireRtc(RTCAIFG, RTCIV_RTCAIFG, now);
+            minute_s += 60.0;
+            continue;
+        }
+
+        if (bus.state == BUS_IDLE)
+            bus.at = bus_next;
+        now = bus.at;
+        BusStep();
+        ServicePeripherals(now);
+    }
+
+    if (deployments != 1)
+        FAIL("deployed %u times", deployments);
+    if (deployed_at != alarm_s)
+        FAIL("deployed at %.3f s, the alarm is at %.3f s", deployed_at, alarm_s);
+    if (Ctl01() & RTCAIE)
+        FAIL("the alarm interrupt is still enabled after deployment");
+    for (i = 0; i < POLL_COUNT; i++)
+        if (polls[i].period_s > 0 && polls[i].polls == 0)
+            FAIL("0x%02x (%u bytes) was never sent", polls[i].id, polls[i].cmd_size);
+
+    printf("\n%-10s %9s %9s %10s %10s %11s %12s %12s\n",
+           "phase", "length s", "ISRs", "wakeups/s", "duty %", "avg uA", "LPM0 loop uA", "handlers");
+    for (i = 0; i < PHASE_COUNT; i++) {
+        double length = ((i + 1 < PHASE_COUNT) ? phase_start[i + 1] : end_s) - phase_start[i];
+        double duty = phases[i].active_s / length;
+        double lpm3 = duty * AM_CURRENT_UA + (1 - duty) * LPM3_CURRENT_UA;
+        double lpm0 = duty * AM_CURRENT_UA + (1 - duty) * LPM0_CURRENT_UA;
+
+        printf("%-10s %9.0f %9u %10.3f %10.4f %11.2f %12.2f %12u\n",
+               phase_names[i], length, phases[i].isrs, phases[i].wakeups / length,
+               100 * duty, lpm3, lpm0, phases[i].handlers);
+    }
+
+    printf("\n%-18s %7s %12s %12s %11s\n", "event", "runs", "mean lat us", "max lat us", "max cycles");
+    for (e = 0; e < BACKPLANE_EVENT_COUNT; e++) {
+        printf("%-18s %7u %12.1f %12.1f %11.0f\n", event_names[e], events[e].runs,
+               events[e].runs ? 1e6 * events[e].latency_sum / events[e].runs : 0,
+               1e6 * events[e].latency_max, events[e].cycles_max);
+    }
+
+    printf("\n%u responses checked", bus.responses);
+    for (i = 0; i < POLL_COUNT; i++)
+        if (polls[i].period_s > 0)
+            printf(", 0x%02x x%u", polls[i].id, polls[i].polls);
+    printf(", longest SCL stretch %.1f us, %u posts merged into a pending event\n",
+           1e6 * bus.stretch_max, schedulerMerged());
+    printf("\"avg uA\" sleeps in LPM3 between events, \"LPM0 loop uA\" is the same work idling in LPM0 like the old run() loop\n");
+    return 0;
+}
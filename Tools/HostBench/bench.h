@@ -0,0 +1,94 @@
+/**
+ * @file bench.h
+ * @brief Timing, random number and failure helpers shared by the host-side
+ *        benchmarks.
+ *
+ * Cycle counts come from the x86 time stamp counter when available. On other
+ * hosts the monotonic clock in nanoseconds is used instead, so "cycles" should
+ * be read as "ticks" there.
+ */
+
+#ifndef _BENCH_
+#define _BENCH_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#else
+#define BENCH_HAS_TSC 0
+#endif
+
+/**
+ * @brief Returns the current cycle counter (or nanoseconds without a TSC).
+ *
+ * The counter read is fenced on both sides so that short code sequences are
+ * not reordered across it.
+ */
+static inline uint64_t bench_cycles(void)
+{
+#if BENCH_HAS_TSC
+    uint64_t t;
+    _mm_lfence();
+    t = __rdtsc();
+    _mm_lfence();
+    return t;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Returns the monotonic wall clock in seconds.
+ */
+static inline double bench_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Smallest back-to-back difference of two bench_cycles() calls.
+ *
+ * Subtracted from per-call measurements so the reported latency does not
+ * include the cost of reading the counter itself.
+ */
+static inline uint64_t bench_cycles_overhead(void)
+{
+    uint64_t best = UINT64_MAX;
+    int i;
+    for (i = 0; i < 10000; i++) {
+        uint64_t t0 = bench_cycles();
+        uint64_t t1 = bench_cycles();
+        if (t1 - t0 < best)
+            best = t1 - t0;
+    }
+    return best;
+}
+
+/**
+ * @brief xorshift32 generator, deterministic for a given seed.
+ */
+static inline uint32_t bench_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Prints a FAIL line on stderr and exits with status 1.
+ */
+#define FAIL(...)   do { fprintf(stderr, "FAIL: " __VA_ARGS__); fprintf(stderr, "\n"); exit(1); } while (0)
+
+#endif // _BENCH_
@@ -0,0 +1,100 @@
+/**
+ * @file crc_bench.c
+ * @brief Bit-exactness check and payload size sweep for TINYPROTOCOL_CalculateCRC.
+ *
+ * Built once per TINYPROTOCOL_CRC_SLICES setting. Every buffer length from 0
+ * to 255 at every alignment is compared against a bit-by-bit AUTOSAR CRC8 and
+ * against the byte-wise crc_lookup_table loop, then the cycles per byte of
+ * both are printed for a sweep of payload sizes.
+ *
+ * Usage: crc_bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "tinyprotocol.h"
+
+#define CRC_BENCH_ITERATIONS    200000u
+#define CRC_BENCH_BUFFERS       64
+#define CRC_BENCH_MAX_LEN       255
+
+static uint8_t data[CRC_BENCH_BUFFERS][CRC_BENCH_MAX_LEN + 8];
+
+// Polynomial definition of the CRC, independent of any table
+static uint8_t ReferenceCRCBitwise(const uint8_t* buffer, uint8_t buffer_size) {
+    uint8_t crc = crc_init_value;
+    uint8_t i, bit;
+    for (i = 0; i < buffer_size; i++) {
+        crc ^= buffer[i];
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x2F) : (uint8_t)(crc << 1);
+    }
+    return crc ^ crc_xor_value;
+}
+
+// The original one-table loop, used as the speed baseline
+static uint8_t ReferenceCRCTable(const uint8_t* buffer, uint8_t buffer_size) {
+    uint8_t crc = crc_init_value;
+    uint8_t i;
+    for (i = 0; i < buffer_size; i++)
+        crc = crc_lookup_table[buffer[i] ^ crc];
+    return crc ^ crc_xor_value;
+}
+
+static int CheckExactness(void) {
+    unsigned len, buf, offset;
+    for (len = 0; len <= CRC_BENCH_MAX_LEN; len++) {
+        for (buf = 0; buf < CRC_BENCH_BUFFERS; buf++) {
+            for (offset = 0; offset < 8; offset++) {
+                const uint8_t *p = &data[buf][offset];
+                uint8_t expected = ReferenceCRCBitwise(p, (uint8_t)len);
+                uint8_t table = ReferenceCRCTable(p, (uint8_t)len);
+                uint8_t actual = TINYPROTOCOL_CalculateCRC(p, (uint8_t)len);
+                if (actual != expected || table != expected) {
+                    fprintf(stderr, "FAIL: len %u buf %u offset %u: got 0x%02X, table 0x%02X, expected 0x%02X\n",
+                            len, buf, offset, actual, table, expected);
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+static double CyclesPerByte(uint8_t (*crc)(const uint8_t*, uint8_t), uint8_t len, uint32_t iterations) {
+    volatile uint8_t sink = 0;
+    uint64_t c0 = bench_cycles();
+    uint32_t i;
+    for (i = 0; i < iterations; i++)
+        sink ^= crc(data[i % CRC_BENCH_BUFFERS], len);
+    uint64_t c1 = bench_cycles();
+    (void)sink;
+    return (double)(c1 - c0) / ((double)iterations * len);
+}
+
+int main(int argc, char **argv) {
+    static const uint8_t sizes[] = {1, 2, 3, 4, 7, 8, 11, 16, 32, 64, 128, 255};
+    uint32_t iterations = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : CRC_BENCH_ITERATIONS;
+    uint32_t rng = 0xC8C8;
+    unsigned i, j;
+
+    for (i = 0; i < CRC_BENCH_BUFFERS; i++)
+        for (j = 0; j < sizeof(data[i]); j++)
+            data[i][j] = (uint8_t)bench_rand(&rng);
+
+    if (!CheckExactness())
+        return 1;
+
+    printf("tinyprotocol CRC8 benchmark, TINYPROTOCOL_CRC_SLICES=%d (bit-exact for len 0..%d)\n",
+           TINYPROTOCOL_CRC_SLICES, CRC_BENCH_MAX_LEN);
+    printf("  %5s  %12s  %12s  %7s\n", "len", "table/byte", "slices/byte", "speedup");
+    for (i = 0; i < sizeof(sizes); i++) {
+        double base = CyclesPerByte(ReferenceCRCTable, sizes[i], iterations);
+        double fast = CyclesPerByte(TINYPROTOCOL_CalculateCRC, sizes[i], iterations);
+        printf("  %5u  %12.2f  %12.2f  %6.2fx\n", sizes[i], base, fast, base / fast);
+    }
+
+    return 0;
+}
@@ -0,0 +1,363 @@
+/**
+ * @file driver_hal_bench.c
+ * @brief Runs the MSP430 drivers on the host register file.
+ *
+ * The driver sources in DRIVERS/MSP430 and the board setup in APP/PDS_App/bsp.c
+ * are linked unmodified against hal/msp430.h. Each case resets the register
+ * file, attaches the peripheral models it needs, calls the driver and checks
+ * the registers it left behind against the FR5969 user's guide.
+ *
+ * For every call the bench reports how many register accesses it makes, a
+ * rough stand-in for its cost on the MSP430, and how long it takes on the
+ * host including the register file (best of many calls).
+ *
+ * Usage: driver_hal_bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <msp430.h>
+
+#include "bench.h"
+#include "adc12_model.h"
+#include "ADC_Read.h"
+#include "PWM.h"
+#include "timer_a.h"
+#include "gpio.h"
+#include "pmm.h"
+#include "rtc_b.h"
+#include "i2c.h"
+#include "bsp.h"
+
+#define DRIVER_ITERATIONS       20000u
+#define DRIVER_ADC_CHANNEL      3       /**< P1.3 is A3 */
+#define DRIVER_ADC_CODE         2345
+#define DRIVER_ADC_CHANNEL_2    5       /**< P1.5 is A5, read from ADC12MEM5 */
+#define DRIVER_ADC_CODE_2       1234
+#define DRIVER_RAIL_CODE(rail)  (1000 + 321 * (rail))
+
+//***************************Peripheral models********************************************
+
+// RTC_B_getCalendarTime() waits for RTCRDY, which the counters raise once a second
+static void RtcReadyOnRead(uint16_t address) {
+    (void)address;
+    HOST_REG16(RTC_B_BASE + OFS_RTCCTL01) |= RTCRDY;
+}
+
+static void AttachRtc(void) {
+    hostRegHook(RTC_B_BASE + OFS_RTCCTL01, RTC_B_BASE + OFS_RTCCTL01_H, RtcReadyOnRead, NULL);
+}
+
+void ADC12_ISR(void);
+
+static uint32_t lpm_entries;
+
+// The firmware only sleeps to wait for the ADC, which has already converted
+static void WakeOnAdc(void) {
+    lpm_entries++;
+    if (!adcModelInterruptPending()) {
+        fprintf(stderr, "FAIL: LPM0 entered with no ADC interrupt pending, the CPU would never wake\n");
+        exit(1);
+    }
+    ADC12_ISR();
+}
+
+static void RxProcNone(uint8_t data) {
+    (void)data;
+}
+
+static int16_t TxNextNone(uint8_t *data) {
+    *data = 0;
+    return 0;
+}
+
+//***************************Cases********************************************************
+
+static const Calendar calendar = {
+    .Seconds = 42, .Minutes = 17, .Hours = 9,
+    .DayOfWeek = 3, .DayOfMonth = 14, .Month = 5, .Year = 2025
+};
+
+static uint16_t adc_result;
+static uint16_t rail_results[PDS_RAIL_COUNT];
+static uint8_t pin_value;
+static Calendar calendar_read;
+static sI2cConfigCb_t i2c_config = {
+    .Rx_Proc_Data = RxProcNone,
+    .Tx_Next_Data = TxNextNone,
+    .slave_addr = SLAVE_ADDR
+};
+
+static void SetupNone(void) {
+}
+
+static void SetupInputPin(void) {
+    HOST_REG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PAIN_L) = BIT3;
+}
+
+static void SetupAdc(void) {
+    adcModelInit();
+    adcModelSetInput(DRIVER_ADC_CHANNEL, DRIVER_ADC_CODE);
+    ADC_init_Standard();
+    ADC_PinSelect(P1_3, ADC12_B_MEMORY_0);
+}
+
+static void SetupAdcMemory5(void) {
+    SetupAdc();
+    adcModelSetInput(DRIVER_ADC_CHANNEL_2, DRIVER_ADC_CODE_2);
+    ADC_PinSelect(P1_5, ADC12_B_MEMORY_5);
+}
+
+#define RAIL_INPUT(Name, adc_pin, port, pin, low, high) adcModelSetInput(adc_pin, DRIVER_RAIL_CODE(Name));
+
+static void SetupRails(void) {
+    adcModelInit();
+    PDS_RAILS(RAIL_INPUT)
+    hostLowPowerHook(WakeOnAdc);
+    lpm_entries = 0;
+    initAdc();
+}
+
+static void SetupRtcRead(void) {
+    AttachRtc();
+    RTC_B_initCalendar(RTC_B_BASE, (Calendar *)&calendar, RTC_B_FORMAT_BINARY);
+}
+
+static void SetupLockedPorts(void) {
+    HOST_REG16(PMM_BASE + OFS_PM5CTL0) = LOCKLPM5;
+}
+
+static void CallSetAsOutputPin(void) {
+    GPIO_setAsOutputPin(GPIO_PORT_P1, GPIO_PIN0);
+}
+
+static void CallSetOutputHigh(void) {
+    GPIO_setOutputHighOnPin(GPIO_PORT_P2, GPIO_PIN3);
+}
+
+static void CallPeripheralOutput(void) {
+    GPIO_setAsPeripheralModuleFunctionOutputPin(GPIO_PORT_P1, GPIO_PIN6 | GPIO_PIN7,
+                                                GPIO_SECONDARY_MODULE_FUNCTION);
+}
+
+static void CallGetInput(void) {
+    pin_value = GPIO_getInputPinValue(GPIO_PORT_P1, GPIO_PIN3);
+}
+
+static void CallPwmGenerate(void) {
+    PWM_Generate(1000, 250, CompareRegister_1);
+}
+
+static void CallTimerAPwm(void) {
+    Timer_A_outputPWMParam param = {
+        .clockSource = TIMER_A_CLOCKSOURCE_SMCLK,
+        .clockSourceDivider = TIMER_A_CLOCKSOURCE_DIVIDER_1,
+        .timerPeriod = 400,
+        .compareRegister = TIMER_A_CAPTURECOMPARE_REGISTER_1,
+        .compareOutputMode = TIMER_A_OUTPUTMODE_RESET_SET,
+        .dutyCycle = 100
+    };
+    Timer_A_outputPWM(TIMER_A0_BASE, &param);
+}
+
+static void CallAdcInit(void) {
+    ADC_init_Standard();
+}
+
+static void CallReadAdc(void) {
+    adc_result = Read_ADC(ADC12_B_MEMORY_0);
+}
+
+static void CallReadAdcMemory5(void) {
+    adc_result = Read_ADC(ADC12_B_MEMORY_5);
+}
+
+// The rails one at a time, polling each conversion
+static void CallReadAdcRails(void) {
+    uint8_t rail;
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++)
+        rail_results[rail] = Read_ADC(rail << 1);
+}
+
+// The rails with one trigger, in LPM0 until ADC12_ISR
+static void CallSampleRails(void) {
+    samplePdsRails(rail_results);
+}
+
+static void CallRtcInit(void) {
+    RTC_B_initCalendar(RTC_B_BASE, (Calendar *)&calendar, RTC_B_FORMAT_BINARY);
+}
+
+static void CallRtcRead(void) {
+    calendar_read = RTC_B_getCalendarTime(RTC_B_BASE);
+}
+
+static void CallUnlockLpm5(void) {
+    PMM_unlockLPM5();
+}
+
+static void CallClockInit(void) {
+    initClockTo16MHz();
+}
+
+static void CallI2cInit(void) {
+    initI2C(&i2c_config);
+}
+
+static int CheckSetAsOutputPin(void) {
+    return (P1DIR & BIT0) && !(P1SEL0 & BIT0) && !(P1SEL1 & BIT0) && P2DIR == 0;
+}
+
+static int CheckSetOutputHigh(void) {
+    return P2OUT == BIT3 && P1OUT == 0;
+}
+
+static int CheckPeripheralOutput(void) {
+    return (P1DIR & (BIT6 | BIT7)) == (BIT6 | BIT7) && P1SEL1 == (BIT6 | BIT7) && P1SEL0 == 0;
+}
+
+static int CheckGetInput(void) {
+    return pin_value == GPIO_INPUT_PIN_HIGH;
+}
+
+static int CheckPwmGenerate(void) {
+    return TB0CCR0 == 1000 && TB0CCR1 == 250 && (TB0CCTL1 & OUTMOD_7) == OUTMOD_7 &&
+           (TB0CTL & (TBSSEL__SMCLK | MC__UP)) == (TBSSEL__SMCLK | MC__UP);
+}
+
+static int CheckTimerAPwm(void) {
+    return TA0CCR0 == 400 && TA0CCR1 == 100 && (TA0CCTL1 & OUTMOD_7) == OUTMOD_7 &&
+           (TA0CTL & (TASSEL__SMCLK | MC__UP)) == (TASSEL__SMCLK | MC__UP);
+}
+
+static int CheckAdcInit(void) {
+    return (ADC12CTL0 & (ADC12ON | ADC12SHT0_2)) == (ADC12ON | ADC12SHT0_2) &&
+           (ADC12CTL1 & (ADC12SSEL_3 | ADC12SHP)) == (ADC12SSEL_3 | ADC12SHP);
+}
+
+static int CheckReadAdc(void) {
+    return adc_result == DRIVER_ADC_CODE && adcModelConversions() > 0;
+}
+
+static int CheckReadAdcMemory5(void) {
+    return adc_result == DRIVER_ADC_CODE_2;
+}
+
+static int CheckRails(void) {
+    uint8_t rail;
+    for (rail = 0; rail < PDS_RAIL_COUNT; rail++) {
+        if (rail_results[rail] != DRIVER_RAIL_CODE(rail))
+            return 0;
+    }
+    return !(ADC12IFGR2 & ADC12OVIFG);
+}
+
+static int CheckSampleRails(void) {
+    uint16_t last = HWREG16(ADC12_B_BASE + OFS_ADC12MCTL0 + 2 * (PDS_RAIL_COUNT - 1));
+
+    return CheckRails() && lpm_entries > 0 && (ADC12CTL1 & ADC12CONSEQ_3) == ADC12CONSEQ_1 &&
+           (last & ADC12EOS) && (ADC12CTL0 & ADC12MSC);
+}
+
+static int CheckRtcRead(void) {
+    return calendar_read.Seconds == calendar.Seconds && calendar_read.Minutes == calendar.Minutes &&
+           calendar_read.Hours == calendar.Hours && calendar_read.DayOfWeek == calendar.DayOfWeek &&
+           calendar_read.DayOfMonth == calendar.DayOfMonth && calendar_read.Month == calendar.Month &&
+           calendar_read.Year == calendar.Year;
+}
+
+// RTC_B_initCalendar only writes, so read the calendar back through the driver
+static int CheckRtcInit(void) {
+    CallRtcRead();
+    return CheckRtcRead();
+}
+
+static int CheckUnlockLpm5(void) {
+    return (PM5CTL0 & LOCKLPM5) == 0;
+}
+
+static int CheckClockInit(void) {
+    return CSCTL1 == (DCORSEL | DCOFSEL_4) && CSCTL2 == (SELA__VLOCLK | SELS__DCOCLK | SELM__DCOCLK) &&
+           CSCTL0_H == 0 && FRCTL0 == (FRCTLPW | NWAITS_1);
+}
+
+static int CheckI2cInit(void) {
+    return UCB0CTLW0 == (UCMODE_3 | UCSYNC) && UCB0I2COA0 == (SLAVE_ADDR | UCOAEN) &&
+           UCB0IE == (UCSTPIE | UCRXIE | UCTXIE);
+}
+
+typedef struct {
+    const char *name;
+    void (*setup)(void);        /**< Runs once after the register file is reset */
+    void (*call)(void);         /**< Driver call being measured, must be repeatable */
+    int (*check)(void);
+} sDriverCase_t;
+
+static const sDriverCase_t cases[] = {
+    {"GPIO_setAsOutputPin",          SetupNone,        CallSetAsOutputPin,   CheckSetAsOutputPin},
+    {"GPIO_setOutputHighOnPin",      SetupNone,        CallSetOutputHigh,    CheckSetOutputHigh},
+    {"GPIO_setAsPeripheral...Output", SetupNone,       CallPeripheralOutput, CheckPeripheralOutput},
+    {"GPIO_getInputPinValue",        SetupInputPin,    CallGetInput,         CheckGetInput},
+    {"PWM_Generate",                 SetupNone,        CallPwmGenerate,      CheckPwmGenerate},
+    {"Timer_A_outputPWM",            SetupNone,        CallTimerAPwm,        CheckTimerAPwm},
+    {"ADC_init_Standard",            SetupNone,        CallAdcInit,          CheckAdcInit},
+    {"Read_ADC",                     SetupAdc,         CallReadAdc,          CheckReadAdc},
+    {"Read_ADC(ADC12_B_MEMORY_5)",   SetupAdcMemory5,  CallReadAdcMemory5,   CheckReadAdcMemory5},
+    {"Read_ADC, every PDS rail",     SetupRails,       CallReadAdcRails,     CheckRails},
+    {"samplePdsRails (sequence)",    SetupRails,       CallSampleRails,      CheckSampleRails},
+    {"RTC_B_initCalendar",           AttachRtc,        CallRtcInit,          CheckRtcInit},
+    {"RTC_B_getCalendarTime",        SetupRtcRead,     CallRtcRead,          CheckRtcRead},
+    {"PMM_unlockLPM5",               SetupLockedPorts, CallUnlockLpm5,       CheckUnlockLpm5},
+    {"initClockTo16MHz",             SetupNone,        CallClockInit,        CheckClockInit},
+    {"initI2C",                      SetupNone,        CallI2cInit,          CheckI2cInit},
+};
+
+static int RunCase(const sDriverCase_t *c, uint32_t iterations, uint64_t overhead) {
+    uint64_t best = UINT64_MAX;
+    uint32_t accesses, i;
+    int ok;
+
+    hostRegReset();
+    c->setup();
+
+    accesses = host_reg_accesses;
+    c->call();
+    hostRegSync();
+    accesses = host_reg_accesses - accesses;
+
+    ok = c->check();
+
+    for (i = 0; i < iterations; i++) {
+        uint64_t t0 = bench_cycles();
+        c->call();
+        uint64_t t1 = bench_cycles();
+        if (t1 - t0 < best)
+            best = t1 - t0;
+    }
+    hostRegSync();
+    if (ok)
+        ok = c->check();
+
+    printf("  %-30s %9u %11.0f\n", c->name, accesses,
+           (double)(best > overhead ? best - overhead : 0));
+    if (!ok)
+        fprintf(stderr, "FAIL: %s left the registers in the wrong state\n", c->name);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    uint32_t iterations = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : DRIVER_ITERATIONS;
+    uint64_t overhead = bench_cycles_overhead();
+    unsigned c;
+    int ok = 1;
+
+    printf("MSP430 drivers on the host register file, best of %u calls\n", iterations);
+    printf("  %-30s %9s %11s\n", "driver call", "accesses", "host cyc");
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+        ok &= RunCase(&cases[c], iterations, overhead);
+
+    return ok ? 0 : 1;
+}
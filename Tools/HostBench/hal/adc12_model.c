@@ -0,0 +1,179 @@
+/**
+ * @file adc12_model.c
+ * @brief ADC12_B model on the host register file.
+ */
+
+#include <stddef.h>
+
+#include <msp430.h>
+
+#include "adc12_model.h"
+
+#define ADC12_CHANNELS      32
+#define ADC12_MEMORIES      32
+
+#define ADC12_REG(offset)   HOST_REG16(ADC12_B_BASE + (offset))
+
+// ADC12IV sources before the memory flags, highest priority first
+static const struct {
+    uint16_t flag;
+    uint16_t vector;
+} priorities[] = {
+    {ADC12OVIFG,  ADC12IV_ADC12OVIFG},
+    {ADC12TOVIFG, ADC12IV_ADC12TOVIFG},
+    {ADC12HIIFG,  ADC12IV_ADC12HIIFG},
+    {ADC12LOIFG,  ADC12IV_ADC12LOIFG},
+    {ADC12INIFG,  ADC12IV_ADC12INIFG},
+};
+
+static uint16_t inputs[ADC12_CHANNELS];
+static uint32_t conversions = 0;
+static int8_t sequence_next = -1;   /**< Next register of a one-per-trigger sequence, -1 from CSTARTADD */
+
+static uint16_t Scale(uint16_t code) {
+    switch (ADC12_REG(OFS_ADC12CTL2) & ADC12RES_3) {
+        case ADC12RES_0: return code >> 4;     // 8 bit
+        case ADC12RES_1: return code >> 2;     // 10 bit
+        default:         return code;          // 12 bit
+    }
+}
+
+// ADC12IFGR0 holds the flags of MEM0..15, ADC12IFGR1 those of MEM16..31
+static uint16_t MemoryFlagRegister(uint8_t mem) {
+    return (mem < 16) ? OFS_ADC12IFGR0 : OFS_ADC12IFGR1;
+}
+
+// Binary unsigned results only, ADC12DF is not modelled
+static void CompareWindow(uint16_t result) {
+    if (result > ADC12_REG(OFS_ADC12HI))
+        ADC12_REG(OFS_ADC12IFGR2) |= ADC12HIIFG;
+    else if (result < ADC12_REG(OFS_ADC12LO))
+        ADC12_REG(OFS_ADC12IFGR2) |= ADC12LOIFG;
+    else
+        ADC12_REG(OFS_ADC12IFGR2) |= ADC12INIFG;
+}
+
+static void Convert(void) {
+    uint16_t ctl1 = ADC12_REG(OFS_ADC12CTL1);
+    uint8_t sequence = (ctl1 & ADC12CONSEQ_1) != 0;     // CONSEQ_1 and CONSEQ_3 walk up to EOS
+    uint8_t start = ADC12_REG(OFS_ADC12CTL3) & ADC12CSTARTADD_31;
+    uint8_t mem = start;
+
+    // A timer trigger without ADC12MSC converts a single register of the sequence
+    uint8_t stepped = sequence && (ctl1 & ADC12SHS_7) != ADC12SHS_0 && !(ADC12_REG(OFS_ADC12CTL0) & ADC12MSC);
+
+    if (stepped && sequence_next >= 0)
+        mem = (uint8_t)sequence_next;
+
+    for (;;) {
+        uint16_t mctl = ADC12_REG(OFS_ADC12MCTL0 + 2 * mem);
+        uint16_t flag = 1u << (mem % 16);
+
+        // A result nobody read is overwritten
+        if (ADC12_REG(MemoryFlagRegister(mem)) & flag)
+            ADC12_REG(OFS_ADC12IFGR2) |= ADC12OVIFG;
+
+        ADC12_REG(OFS_ADC12MEM0 + 2 * mem) = Scale(inputs[mctl & 0x1F]);
+        ADC12_REG(MemoryFlagRegister(mem)) |= flag;
+        if (mctl & ADC12WINC)
+            CompareWindow(ADC12_REG(OFS_ADC12MEM0 + 2 * mem));
+        conversions++;
+
+        if (stepped) {
+            sequence_next = ((mctl & ADC12EOS) || mem == ADC12_MEMORIES - 1) ? (int8_t)start : (int8_t)(mem + 1);
+            break;
+        }
+        if (!sequence || (mctl & ADC12EOS) || mem == ADC12_MEMORIES - 1)
+            break;
+        mem++;
+    }
+
+    ADC12_REG(OFS_ADC12CTL0) &= ~ADC12SC;
+}
+
+static void WriteCtl0(uint16_t address, uint16_t old_value, uint16_t new_value) {
+    uint16_t ctl0 = ADC12_REG(OFS_ADC12CTL0);
+
+    (void)address;
+
+    // Enabling conversions restarts a stepped sequence at ADC12CSTARTADD
+    if (!(old_value & ADC12ENC) && (new_value & ADC12ENC))
+        sequence_next = -1;
+
+    if ((ctl0 & (ADC12ON | ADC12ENC | ADC12SC)) != (ADC12ON | ADC12ENC | ADC12SC))
+        return;
+
+    // ADC12SC only starts a conversion when it is the sample-and-hold source
+    if ((ADC12_REG(OFS_ADC12CTL1) & ADC12SHS_7) == ADC12SHS_0)
+        Convert();
+    else
+        ADC12_REG(OFS_ADC12CTL0) &= ~ADC12SC;
+}
+
+// Reading ADC12MEMx clears its ADC12IFGx
+static void ReadMemory(uint16_t address) {
+    uint8_t mem = (address - (ADC12_B_BASE + OFS_ADC12MEM0)) / 2;
+
+    ADC12_REG(MemoryFlagRegister(mem)) &= ~(1u << (mem % 16));
+}
+
+// Accessing ADC12IV only clears the overflow conditions, every other flag
+// stays set until software clears it or, for ADC12IFGx, reads ADC12MEMx
+static void ReadVector(uint16_t address) {
+    uint16_t pending = ADC12_REG(OFS_ADC12IFGR2) & ADC12_REG(OFS_ADC12IER2);
+    uint16_t memories[2];
+    uint8_t i;
+
+    (void)address;
+    memories[0] = ADC12_REG(OFS_ADC12IFGR0) & ADC12_REG(OFS_ADC12IER0);
+    memories[1] = ADC12_REG(OFS_ADC12IFGR1) & ADC12_REG(OFS_ADC12IER1);
+
+    for (i = 0; i < sizeof(priorities) / sizeof(priorities[0]); i++) {
+        if (pending & priorities[i].flag) {
+            ADC12_REG(OFS_ADC12IV) = priorities[i].vector;
+            if (priorities[i].flag & (ADC12OVIFG | ADC12TOVIFG))
+                ADC12_REG(OFS_ADC12IFGR2) &= ~priorities[i].flag;
+            return;
+        }
+    }
+    for (i = 0; i < ADC12_MEMORIES; i++) {
+        if (memories[i / 16] & (1u << (i % 16))) {
+            ADC12_REG(OFS_ADC12IV) = ADC12IV_ADC12IFG0 + 2 * i;
+            return;
+        }
+    }
+    ADC12_REG(OFS_ADC12IV) = (pending & ADC12RDYIFG) ? ADC12IV_ADC12RDYIFG : ADC12IV_NONE;
+}
+
+void adcModelInit(void) {
+    conversions = 0;
+    sequence_next = -1;
+    hostRegHook(ADC12_B_BASE + OFS_ADC12CTL0, ADC12_B_BASE + OFS_ADC12CTL0_H, NULL, WriteCtl0);
+    hostRegHook(ADC12_B_BASE + OFS_ADC12IV, ADC12_B_BASE + OFS_ADC12IV + 1, ReadVector, NULL);
+    hostRegHook(ADC12_B_BASE + OFS_ADC12MEM0, ADC12_B_BASE + OFS_ADC12MEM0 + 2 * ADC12_MEMORIES - 1,
+                ReadMemory, NULL);
+}
+
+void adcModelSetInput(uint8_t channel, uint16_t code) {
+    inputs[channel % ADC12_CHANNELS] = code & 0x0FFF;
+}
+
+uint8_t adcModelTrigger(void) {
+    hostRegSync();
+    if ((ADC12_REG(OFS_ADC12CTL0) & (ADC12ON | ADC12ENC)) != (ADC12ON | ADC12ENC))
+        return 0;
+
+    Convert();
+    return 1;
+}
+
+uint32_t adcModelConversions(void) {
+    return conversions;
+}
+
+uint8_t adcModelInterruptPending(void) {
+    hostRegSync();
+    return (ADC12_REG(OFS_ADC12IFGR0) & ADC12_REG(OFS_ADC12IER0)) ||
+           (ADC12_REG(OFS_ADC12IFGR1) & ADC12_REG(OFS_ADC12IER1)) ||
+           (ADC12_REG(OFS_ADC12IFGR2) & ADC12_REG(OFS_ADC12IER2));
+}
@@ -0,0 +1,54 @@
+/**
+ * @file adc12_model.h
+ * @brief ADC12_B model on the host register file.
+ *
+ * Setting ADC12SC with ADC12ENC and ADC12ON converts at once (when ADC12SC
+ * is the sample-and-hold source, otherwise see adcModelTrigger()): every memory
+ * register of the sequence gets the value set for its input channel, scaled to
+ * the selected resolution, and its ADC12IFGx flag is raised. ADC12BUSY is
+ * never seen set and ADC12SC clears itself, as in pulse sample mode. A
+ * repeated mode runs its sequence once per trigger, or, with a timer trigger
+ * and ADC12MSC clear, one register of it per trigger. A register with ADC12WINC
+ * set also raises ADC12HIIFG, ADC12LOIFG or ADC12INIFG against the window in
+ * ADC12HI / ADC12LO.
+ *
+ * Interrupt flags behave as on the FR5969:
+ *  - reading ADC12MEMx clears ADC12IFGx. Converting into a register whose
+ *    flag is still set raises ADC12OVIFG.
+ *  - ADC12IV reports the highest priority flag that is both set and enabled
+ *    and only clears the overflow flags, the ISR clears the others
+ */
+
+#ifndef _HOST_ADC12_MODEL_
+#define _HOST_ADC12_MODEL_
+
+#include <stdint.h>
+
+/**
+ * @brief Attaches the model to the ADC12_B registers. Call after hostRegReset().
+ */
+void adcModelInit(void);
+
+/**
+ * @brief Sets the level of an input channel, as a 12 bit code (0..4095).
+ */
+void adcModelSetInput(uint8_t channel, uint16_t code);
+
+/**
+ * @brief A rising edge of the timer output selected by ADC12SHSx.
+ *
+ * @return 1 if it converted, 0 if the ADC is off or not enabled
+ */
+uint8_t adcModelTrigger(void);
+
+/**
+ * @brief Conversions done since adcModelInit().
+ */
+uint32_t adcModelConversions(void);
+
+/**
+ * @brief Non-zero while an enabled ADC12_B interrupt is pending.
+ */
+uint8_t adcModelInterruptPending(void);
+
+#endif // _HOST_ADC12_MODEL_
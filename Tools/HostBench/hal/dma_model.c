@@ -0,0 +1,150 @@
+/**
+ * @file dma_model.c
+ * @brief DMA controller model on the host register file.
+ */
+
+#include <stddef.h>
+
+#include <msp430.h>
+
+#include "dma_model.h"
+
+#define DMA_REG(offset)     HOST_REG16(DMA_BASE + (offset))
+#define CHANNEL_REG(channel, offset) DMA_REG((channel) * DMA_CHANNEL_SIZE + (offset))
+
+typedef struct {
+    uintptr_t source;
+    uintptr_t destination;
+    uint16_t size;
+} sDmaChannel_t;
+
+static sDmaChannel_t channels[DMA_CHANNELS];
+static uint32_t transfers = 0;
+
+static void Load(uint8_t channel) {
+    uint16_t base = DMA_BASE + channel * DMA_CHANNEL_SIZE;
+
+    channels[channel].source = hostReadAddress(base + OFS_DMA0SA);
+    channels[channel].destination = hostReadAddress(base + OFS_DMA0DA);
+    channels[channel].size = HOST_REG16(base + OFS_DMA0SZ);
+}
+
+// DMAxTSEL of the channel, five bits each, channel 2 in DMACTL1
+static uint8_t TriggerSelect(uint8_t channel) {
+    uint16_t ctl = DMA_REG(OFS_DMACTL0 + 2 * (channel / 2));
+    return (ctl >> (8 * (channel % 2))) & DMA0TSEL_31;
+}
+
+static uint16_t Read(uintptr_t address, uint8_t byte) {
+    if (address < HOST_REG_SPACE) {
+        hostRegBusAccess((uint16_t)address, byte ? 1 : 2);
+        return byte ? HOST_REG8(address) : HOST_REG16(address);
+    }
+    return byte ? *(uint8_t *)address : *(uint16_t *)address;
+}
+
+static void Write(uintptr_t address, uint8_t byte, uint16_t value) {
+    if (address < HOST_REG_SPACE) {
+        hostRegBusAccess((uint16_t)address, byte ? 1 : 2);
+        if (byte)
+            HOST_REG8(address) = (uint8_t)value;
+        else
+            HOST_REG16(address) = value;
+        return;
+    }
+    if (byte)
+        *(uint8_t *)address = (uint8_t)value;
+    else
+        *(uint16_t *)address = value;
+}
+
+static uintptr_t Step(uintptr_t address, uint16_t incr, uint8_t byte) {
+    uint8_t size = byte ? 1 : 2;
+
+    switch (incr) {
+        case DMADSTINCR_2: return address - size;  // DMASRCINCR_x are these shifted down by two
+        case DMADSTINCR_3: return address + size;
+        default:           return address;
+    }
+}
+
+static void WriteControl(uint16_t address, uint16_t old_value, uint16_t new_value) {
+    uint16_t offset = address - DMA_BASE - OFS_DMA0CTL;
+    uint8_t channel = offset / DMA_CHANNEL_SIZE;
+
+    // Only DMAxCTL itself, DMAEN is in its low byte
+    if (offset % DMA_CHANNEL_SIZE != 0 || channel >= DMA_CHANNELS)
+        return;
+    if (!(old_value & DMAEN) && (new_value & DMAEN))
+        Load(channel);
+}
+
+static void ReadVector(uint16_t address) {
+    uint8_t channel;
+
+    (void)address;
+    DMA_REG(OFS_DMAIV) = DMAIV_NONE;
+    for (channel = 0; channel < DMA_CHANNELS; channel++) {
+        uint16_t ctl = CHANNEL_REG(channel, OFS_DMA0CTL);
+        if ((ctl & (DMAIE | DMAIFG)) == (DMAIE | DMAIFG)) {
+            DMA_REG(OFS_DMAIV) = DMAIV_DMA0IFG + 2 * channel;
+            CHANNEL_REG(channel, OFS_DMA0CTL) = ctl & ~DMAIFG;
+            return;
+        }
+    }
+}
+
+void dmaModelInit(void) {
+    transfers = 0;
+    hostRegHook(DMA_BASE + OFS_DMAIV, DMA_BASE + OFS_DMAIV + 1, ReadVector, NULL);
+    hostRegHook(DMA_BASE + OFS_DMA0CTL, DMA_BASE + OFS_DMA0CTL + DMA_CHANNELS * DMA_CHANNEL_SIZE - 1,
+                NULL, WriteControl);
+}
+
+uint8_t dmaModelTrigger(uint8_t trigger) {
+    uint8_t channel, count = 0;
+
+    hostRegSync();
+    for (channel = 0; channel < DMA_CHANNELS; channel++) {
+        sDmaChannel_t *c = &channels[channel];
+        uint16_t ctl = CHANNEL_REG(channel, OFS_DMA0CTL);
+        uint16_t value;
+
+        if (!(ctl & DMAEN) || TriggerSelect(channel) != trigger)
+            continue;
+
+        value = Read(c->source, (ctl & DMASRCBYTE) != 0);
+        Write(c->destination, (ctl & DMADSTBYTE) != 0, value);
+        hostRegSync();
+        c->source = Step(c->source, (ctl & DMASRCINCR_3) << 2, (ctl & DMASRCBYTE) != 0);
+        c->destination = Step(c->destination, ctl & DMADSTINCR_3, (ctl & DMADSTBYTE) != 0);
+        transfers++;
+        count++;
+
+        if (--c->size == 0) {
+            ctl |= DMAIFG;
+            if ((ctl & DMADT_4) == DMADT_4)
+                Load(channel);
+            else
+                ctl &= ~DMAEN;
+            CHANNEL_REG(channel, OFS_DMA0CTL) = ctl;
+        }
+    }
+    return count;
+}
+
+uint8_t dmaModelInterruptPending(void) {
+    uint8_t channel;
+
+    hostRegSync();
+    for (channel = 0; channel < DMA_CHANNELS; channel++) {
+        uint16_t ctl = CHANNEL_REG(channel, OFS_DMA0CTL);
+        if ((ctl & (DMAIE | DMAIFG)) == (DMAIE | DMAIFG))
+            return 1;
+    }
+    return 0;
+}
+
+uint32_t dmaModelTransfers(void) {
+    return transfers;
+}
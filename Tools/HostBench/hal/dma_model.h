@@ -0,0 +1,50 @@
+/**
+ * @file dma_model.h
+ * @brief DMA controller model on the host register file.
+ *
+ * Enabling a channel (DMAEN 0 -> 1) copies DMAxSA, DMAxDA and DMAxSZ into
+ * working registers. Each trigger that matches the channel's DMAxTSEL then
+ * moves one byte or word, steps the working addresses and counts the size
+ * down. At zero DMAIFG is raised, and a repeated mode reloads the working
+ * registers from DMAxSA / DMAxDA / DMAxSZ as they are at that moment, so
+ * software can point the next block elsewhere while the current one runs.
+ *
+ * Addresses below HOST_REG_SPACE are register file addresses, the transfer
+ * goes through hostRegBusAccess() and runs the peripheral hooks (reading
+ * ADC12MEMx clears its flag). Anything else is a host pointer, as written by
+ * __data16_write_addr().
+ *
+ * Only the single and repeated single transfer modes are modelled. Reading
+ * DMAIV reports and clears the highest priority enabled DMAIFG.
+ */
+
+#ifndef _HOST_DMA_MODEL_
+#define _HOST_DMA_MODEL_
+
+#include <stdint.h>
+
+#define DMA_MODEL_TRANSFER_CYCLES   2   /**< MCLK cycles one transfer takes from the CPU */
+
+/**
+ * @brief Attaches the model to the DMA registers. Call after hostRegReset().
+ */
+void dmaModelInit(void);
+
+/**
+ * @brief A trigger source fires, DMA0TSEL__ADC12IFG for instance.
+ *
+ * @return The number of transfers made, one per enabled channel it triggers
+ */
+uint8_t dmaModelTrigger(uint8_t trigger);
+
+/**
+ * @brief Non-zero while an enabled DMA interrupt is pending.
+ */
+uint8_t dmaModelInterruptPending(void);
+
+/**
+ * @brief Transfers made since dmaModelInit().
+ */
+uint32_t dmaModelTransfers(void);
+
+#endif // _HOST_DMA_MODEL_
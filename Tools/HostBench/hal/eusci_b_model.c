@@ -0,0 +1,115 @@
+/**
+ * @file eusci_b_model.c
+ * @brief eUSCI_B0 I2C slave model on the host register file.
+ */
+
+#include <stddef.h>
+
+#include <msp430.h>
+
+#include "eusci_b_model.h"
+
+#define EUSCI_REG(offset)   HOST_REG16(EUSCI_B0_BASE + (offset))
+
+// Interrupt flags in UCB0IV priority order, highest first
+static const struct {
+    uint16_t flag;
+    uint16_t vector;
+} priorities[] = {
+    {UCALIFG,   USCI_I2C_UCALIFG},
+    {UCNACKIFG, USCI_I2C_UCNACKIFG},
+    {UCSTTIFG,  USCI_I2C_UCSTTIFG},
+    {UCSTPIFG,  USCI_I2C_UCSTPIFG},
+    {UCRXIFG0,  USCI_I2C_UCRXIFG0},
+    {UCTXIFG0,  USCI_I2C_UCTXIFG0},
+};
+
+static uint8_t rx_full = 0;
+static uint8_t tx_loaded = 0;
+
+static void ReadVector(uint16_t address) {
+    uint16_t pending = EUSCI_REG(OFS_UCBxIFG) & EUSCI_REG(OFS_UCBxIE);
+    uint8_t i;
+
+    (void)address;
+    EUSCI_REG(OFS_UCBxIV) = USCI_NONE;
+    for (i = 0; i < sizeof(priorities) / sizeof(priorities[0]); i++) {
+        if (pending & priorities[i].flag) {
+            EUSCI_REG(OFS_UCBxIV) = priorities[i].vector;
+            EUSCI_REG(OFS_UCBxIFG) &= ~priorities[i].flag;
+            return;
+        }
+    }
+}
+
+static void ReadRxBuf(uint16_t address) {
+    (void)address;
+    rx_full = 0;
+    EUSCI_REG(OFS_UCBxIFG) &= ~UCRXIFG0;
+}
+
+static void AccessTxBuf(uint16_t address) {
+    (void)address;
+    tx_loaded = 1;
+    EUSCI_REG(OFS_UCBxIFG) &= ~UCTXIFG0;
+}
+
+void eusciModelInit(void) {
+    rx_full = 0;
+    tx_loaded = 0;
+    hostRegHook(EUSCI_B0_BASE + OFS_UCBxIV, EUSCI_B0_BASE + OFS_UCBxIV + 1, ReadVector, NULL);
+    hostRegHook(EUSCI_B0_BASE + OFS_UCBxRXBUF, EUSCI_B0_BASE + OFS_UCBxRXBUF + 1, ReadRxBuf, NULL);
+    hostRegHook(EUSCI_B0_BASE + OFS_UCBxTXBUF, EUSCI_B0_BASE + OFS_UCBxTXBUF + 1, AccessTxBuf, NULL);
+}
+
+void eusciModelStart(uint8_t read) {
+    hostRegSync();
+    EUSCI_REG(OFS_UCBxSTATW) |= UCBBUSY;
+    EUSCI_REG(OFS_UCBxIFG) |= UCSTTIFG;
+    if (read) {
+        tx_loaded = 0;
+        EUSCI_REG(OFS_UCBxIFG) |= UCTXIFG0;
+    }
+}
+
+uint8_t eusciModelReceive(uint8_t data) {
+    hostRegSync();
+    if (rx_full)
+        return 0;
+
+    EUSCI_REG(OFS_UCBxRXBUF) = data;
+    EUSCI_REG(OFS_UCBxIFG) |= UCRXIFG0;
+    rx_full = 1;
+    return 1;
+}
+
+uint8_t eusciModelTransmit(uint8_t *data) {
+    hostRegSync();
+    if (!tx_loaded)
+        return 0;
+
+    *data = (uint8_t)EUSCI_REG(OFS_UCBxTXBUF);
+    tx_loaded = 0;
+    EUSCI_REG(OFS_UCBxIFG) |= UCTXIFG0;
+    return 1;
+}
+
+void eusciModelStop(void) {
+    hostRegSync();
+    tx_loaded = 0;
+    EUSCI_REG(OFS_UCBxIFG) = (EUSCI_REG(OFS_UCBxIFG) & ~UCTXIFG0) | UCSTPIFG;
+    EUSCI_REG(OFS_UCBxSTATW) &= ~UCBBUSY;
+}
+
+uint8_t eusciModelInterruptPending(void) {
+    hostRegSync();
+    return (EUSCI_REG(OFS_UCBxIFG) & EUSCI_REG(OFS_UCBxIE)) != 0;
+}
+
+uint8_t eusciModelRxFull(void) {
+    return rx_full;
+}
+
+uint8_t eusciModelTxLoaded(void) {
+    return tx_loaded;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file eusci_b_model.h
+ * @brief eUSCI_B0 I2C slave model on the host register file.
+ *
+ * The bus side (a simulated master) moves bytes in and out with the calls
+ * below, and the firmware side sees what a real eUSCI_B0 slave shows it:
+ *  - UCB0IV reports the highest priority flag that is both set and enabled,
+ *    and reading it clears that flag
+ *  - reading UCB0RXBUF clears UCRXIFG0 and frees the receive buffer
+ *  - accessing UCB0TXBUF clears UCTXIFG0 and marks the transmit buffer
+ *    loaded. The firmware only ever writes it, and the register file cannot
+ *    see a write of an unchanged value, so any access counts as the write.
+ *
+ * Clock stretching is up to the caller: a byte cannot be received while the
+ * receive buffer is full, or sent before the transmit buffer is loaded, and
+ * the master has to hold SCL until the firmware catches up.
+ */
+
+#ifndef _HOST_EUSCI_B_MODEL_
+#define _HOST_EUSCI_B_MODEL_
+
+#include <stdint.h>
+
+/**
+ * @brief Attaches the model to the eUSCI_B0 registers. Call after hostRegReset().
+ */
+void eusciModelInit(void);
+
+/**
+ * @brief START (or repeated START) followed by the slave's own address.
+ *
+ * For a master read this also raises UCTXIFG0: the slave holds SCL from here
+ * until the first byte is loaded.
+ */
+void eusciModelStart(uint8_t read);
+
+/**
+ * @brief Moves a received byte into UCB0RXBUF and raises UCRXIFG0.
+ *
+ * @return 0 if the receive buffer still holds the previous byte, in which case
+ * nothing happens and the master has to stretch
+ */
+uint8_t eusciModelReceive(uint8_t data);
+
+/**
+ * @brief Moves the loaded UCB0TXBUF byte into the shift register.
+ *
+ * UCTXIFG0 is raised again at once, so the firmware can load the next byte
+ * while this one is on the bus.
+ *
+ * @return 0 if no byte was loaded, in which case the master has to stretch
+ */
+uint8_t eusciModelTransmit(uint8_t *data);
+
+/**
+ * @brief STOP condition: raises UCSTPIFG. A byte loaded for a read the
+ * master ended is dropped, together with its UCTXIFG0.
+ */
+void eusciModelStop(void);
+
+/**
+ * @brief Non-zero while an enabled eUSCI_B0 interrupt is pending.
+ */
+uint8_t eusciModelInterruptPending(void);
+
+/**
+ * @brief Non-zero while UCB0RXBUF holds a byte the firmware has not read.
+ */
+uint8_t eusciModelRxFull(void);
+
+/**
+ * @brief Non-zero while UCB0TXBUF holds a byte for the next master read.
+ */
+uint8_t eusciModelTxLoaded(void);
+
+#endif // _HOST_EUSCI_B_MODEL_
@@ -0,0 +1,849 @@
+/**
+ * @file msp430.h
+ * @brief Host stand-in for the TI device header, for building MSP430 sources on Linux.
+ *
+ * Models an MSP430FR5969. The whole 64 KiB address space is an in-memory
+ * register file (msp430_host.c), and every HWREG8/16/32 access and every named
+ * register (P1OUT, UCB0IV, ...) goes through hostRegAccess(). That is how the
+ * unmodified DRIVERS/MSP430 sources and their TI driverlib helpers link into
+ * host binaries.
+ *
+ * Peripheral models attach read / write hooks to address ranges:
+ *  - the read hook runs before every access to the range, so it can update a
+ *    status or result register the driver is about to read
+ *  - the write hook runs once the access is over, at the next register access
+ *    or hostRegSync(). It sees the old and new value and only fires when the
+ *    value changed; writing a register's current value again is not seen.
+ * Models use HOST_REG8/HOST_REG16 to touch registers without running hooks.
+ *
+ * Only the registers, bits and intrinsics used by the repo's sources are
+ * provided, with the FR5969 addresses and values.
+ */
+
+#ifndef _HOST_MSP430_
+#define _HOST_MSP430_
+
+#include <stdint.h>
+
+//*******************************************************************************
+// Intrinsics *******************************************************************
+//*******************************************************************************
+
+// ISRs become ordinary functions the simulation calls directly
+#define interrupt(vector)           used
+#define __even_in_range(x, y)       (x)
+
+// Status register: the simulation is single threaded. Entering a low power
+// mode calls the hook set with hostLowPowerHook(), where the simulation runs
+// whatever would wake the CPU; leaving one has no effect.
+#define GIE                         (0x0008)
+#define CPUOFF                      (0x0010)
+#define SCG0                        (0x0040)
+#define SCG1                        (0x0080)
+#define LPM0_bits                   (CPUOFF)
+#define LPM3_bits                   (SCG1 + SCG0 + CPUOFF)
+#define __bis_SR_register(x)        hostEnterLowPower(x)
+#define __bic_SR_register_on_exit(x) ((void)(x))
+#define __disable_interrupt()       ((void)0)
+#define __get_SR_register()         ((uint16_t)GIE)     /**< Interrupts are never off on the host */
+#define __enable_interrupt()        ((void)0)
+#define __no_operation()            ((void)0)
+#define __delay_cycles(x)           ((void)(x))
+
+// Address registers (DMAxSA / DMAxDA) are written with this intrinsic. A host
+// pointer does not fit the register, so the full value is kept aside for the
+// peripheral models, see hostReadAddress().
+#define __data16_write_addr(addr, src) hostWriteAddress((uint16_t)(addr), (uintptr_t)(src))
+
+//*******************************************************************************
+// Register file ****************************************************************
+//*******************************************************************************
+
+#define HOST_REG_SPACE              (0x10000)
+
+typedef void (*HostLowPowerHook)(void);
+typedef void (*HostRegReadHook)(uint16_t address);
+typedef void (*HostRegWriteHook)(uint16_t address, uint16_t old_value, uint16_t new_value);
+
+extern uint8_t host_reg_file[HOST_REG_SPACE];
+extern uint32_t host_reg_accesses;      /**< Accesses through HWREG / named registers since the last reset */
+
+volatile void *hostRegAccess(uint16_t address, uint8_t width);
+
+/**
+ * @brief Sets the hook run when the firmware turns the CPU off (CPUOFF in
+ * __bis_SR_register). It has to raise the interrupt the firmware waits for.
+ */
+void hostLowPowerHook(HostLowPowerHook hook);
+
+void hostEnterLowPower(uint16_t bits);
+
+/**
+ * @brief Zeroes every register, removes all hooks, the low power one
+ * included, and clears the access count.
+ */
+void hostRegReset(void);
+
+/**
+ * @brief Attaches hooks to the registers in [first, last]. Either may be NULL.
+ *
+ * @return 0 on success, -1 when the hook table is full
+ */
+int hostRegHook(uint16_t first, uint16_t last, HostRegReadHook read, HostRegWriteHook write);
+
+/**
+ * @brief An access by another bus master, the DMA controller: runs the hooks
+ * like hostRegAccess() but is not counted in host_reg_accesses.
+ */
+volatile void *hostRegBusAccess(uint16_t address, uint8_t width);
+
+void hostWriteAddress(uint16_t address, uintptr_t value);
+
+/**
+ * @brief Reads back an address register written with __data16_write_addr().
+ *
+ * @return The value written, a host pointer or a register file address
+ * (below HOST_REG_SPACE)
+ */
+uintptr_t hostReadAddress(uint16_t address);
+
+/**
+ * @brief Delivers the write hook of the last access, if it is still pending.
+ *
+ * Call it after driver code returns, before checking what it wrote.
+ */
+void hostRegSync(void);
+
+// Used by the drivers through hw_memmap.h, which keeps these definitions
+#define HWREG8(x)                   (*(volatile uint8_t *)hostRegAccess((uint16_t)(x), 1))
+#define HWREG16(x)                  (*(volatile uint16_t *)hostRegAccess((uint16_t)(x), 2))
+#define HWREG32(x)                  (*(volatile uint32_t *)hostRegAccess((uint16_t)(x), 4))
+
+// Raw access for peripheral models, no hooks and not counted
+#define HOST_REG8(x)                (*(volatile uint8_t *)&host_reg_file[(uint16_t)(x)])
+#define HOST_REG16(x)               (*(volatile uint16_t *)&host_reg_file[(uint16_t)(x)])
+
+//*******************************************************************************
+// Bits *************************************************************************
+//*******************************************************************************
+
+#define BIT0                        (0x0001)
+#define BIT1                        (0x0002)
+#define BIT2                        (0x0004)
+#define BIT3                        (0x0008)
+#define BIT4                        (0x0010)
+#define BIT5                        (0x0020)
+#define BIT6                        (0x0040)
+#define BIT7                        (0x0080)
+#define BIT8                        (0x0100)
+#define BIT9                        (0x0200)
+#define BITA                        (0x0400)
+#define BITB                        (0x0800)
+#define BITC                        (0x1000)
+#define BITD                        (0x2000)
+#define BITE                        (0x4000)
+#define BITF                        (0x8000)
+
+//*******************************************************************************
+// Peripheral map ***************************************************************
+//*******************************************************************************
+
+#define __MSP430_HAS_PMM_FRAM__
+#define __MSP430_HAS_FRAM__
+#define __MSP430_HAS_WDT_A__
+#define __MSP430_HAS_CS__
+#define __MSP430_HAS_PORT1_R__
+#define __MSP430_HAS_PORT2_R__
+#define __MSP430_HAS_PORTA_R__
+#define __MSP430_HAS_PORT3_R__
+#define __MSP430_HAS_PORT4_R__
+#define __MSP430_HAS_PORTB_R__
+#define __MSP430_HAS_PORTJ_R__
+#define __MSP430_HAS_TxA7__
+#define __MSP430_HAS_T0A3__
+#define __MSP430_HAS_T1A3__
+#define __MSP430_HAS_T2A2__
+#define __MSP430_HAS_T3A5__
+#define __MSP430_HAS_TxB7__
+#define __MSP430_HAS_T0B7__
+#define __MSP430_HAS_RTC_B__
+#define __MSP430_HAS_EUSCI_B0__
+#define __MSP430_HAS_ADC12_B__
+#define __MSP430_HAS_DMAX_3__
+
+#define __MSP430_BASEADDRESS_PMM_FRAM__     0x0120
+#define __MSP430_BASEADDRESS_FRAM__         0x0140
+#define __MSP430_BASEADDRESS_WDT_A__        0x015C
+#define __MSP430_BASEADDRESS_CS__           0x0160
+#define __MSP430_BASEADDRESS_PORT1_R__      0x0200
+#define __MSP430_BASEADDRESS_PORT2_R__      0x0200
+#define __MSP430_BASEADDRESS_PORTA_R__      0x0200
+#define __MSP430_BASEADDRESS_PORT3_R__      0x0220
+#define __MSP430_BASEADDRESS_PORT4_R__      0x0220
+#define __MSP430_BASEADDRESS_PORTB_R__      0x0220
+#define __MSP430_BASEADDRESS_PORTJ_R__      0x0320
+#define __MSP430_BASEADDRESS_T0A3__         0x0340
+#define __MSP430_BASEADDRESS_T1A3__         0x0380
+#define __MSP430_BASEADDRESS_T0B7__         0x03C0
+#define __MSP430_BASEADDRESS_T2A2__         0x0400
+#define __MSP430_BASEADDRESS_T3A5__         0x0440
+#define __MSP430_BASEADDRESS_RTC_B__        0x04A0
+#define __MSP430_BASEADDRESS_DMAX_3__       0x0500
+#define __MSP430_BASEADDRESS_EUSCI_B0__     0x0640
+#define __MSP430_BASEADDRESS_ADC12_B__      0x0800
+
+// driverlib base address names
+#define PMM_BASE                    __MSP430_BASEADDRESS_PMM_FRAM__
+#define WDT_A_BASE                  __MSP430_BASEADDRESS_WDT_A__
+#define CS_BASE                     __MSP430_BASEADDRESS_CS__
+#define TIMER_A0_BASE               __MSP430_BASEADDRESS_T0A3__
+#define TIMER_A1_BASE               __MSP430_BASEADDRESS_T1A3__
+#define TIMER_A2_BASE               __MSP430_BASEADDRESS_T2A2__
+#define TIMER_A3_BASE               __MSP430_BASEADDRESS_T3A5__
+#define TIMER_B0_BASE               __MSP430_BASEADDRESS_T0B7__
+#define RTC_B_BASE                  __MSP430_BASEADDRESS_RTC_B__
+#define EUSCI_B0_BASE               __MSP430_BASEADDRESS_EUSCI_B0__
+#define ADC12_B_BASE                __MSP430_BASEADDRESS_ADC12_B__
+#define DMA_BASE                    __MSP430_BASEADDRESS_DMAX_3__
+
+//*******************************************************************************
+// PMM, FRAM, WDT_A, CS *********************************************************
+//*******************************************************************************
+
+#define OFS_PMMCTL0                 (0x0000)
+#define OFS_PMMCTL0_L               OFS_PMMCTL0
+#define OFS_PMMCTL0_H               OFS_PMMCTL0+1
+#define OFS_PMMIFG                  (0x000A)
+#define OFS_PM5CTL0                 (0x0010)
+
+#define PMMPW                       (0xA500)
+#define PMMPW_H                     (0xA5)
+#define PMMSWBOR                    (0x0004)
+#define PMMSWPOR                    (0x0008)
+#define PMMREGOFF                   (0x0010)
+#define SVSHE                       (0x0040)
+#define PMMBORIFG                   (0x0100)
+#define PMMRSTIFG                   (0x0200)
+#define PMMPORIFG                   (0x0400)
+#define SVSHIFG                     (0x2000)
+#define PMMLPM5IFG                  (0x8000)
+#define LOCKLPM5                    (0x0001)
+
+#define PM5CTL0                     HWREG16(PMM_BASE + OFS_PM5CTL0)
+
+#define FRCTL0                      HWREG16(__MSP430_BASEADDRESS_FRAM__ + 0x0000)
+#define FRCTLPW                     (0xA500)
+#define NWAITS_0                    (0x0000)
+#define NWAITS_1                    (0x0010)
+#define NWAITS_2                    (0x0020)
+
+#define WDTCTL                      HWREG16(WDT_A_BASE + 0x0000)
+#define WDTPW                       (0x5A00)
+#define WDTHOLD                     (0x0080)
+#define WDTCNTCL                    (0x0008)
+
+#define CSCTL0                      HWREG16(CS_BASE + 0x0000)
+#define CSCTL0_H                    HWREG8(CS_BASE + 0x0001)
+#define CSCTL1                      HWREG16(CS_BASE + 0x0002)
+#define CSCTL2                      HWREG16(CS_BASE + 0x0004)
+#define CSCTL3                      HWREG16(CS_BASE + 0x0006)
+#define CSCTL4                      HWREG16(CS_BASE + 0x0008)
+#define CSCTL5                      HWREG16(CS_BASE + 0x000A)
+#define CSKEY                       (0xA500)
+#define DCORSEL                     (0x0040)
+#define DCOFSEL_0                   (0x0000)
+#define DCOFSEL_3                   (0x0006)
+#define DCOFSEL_4                   (0x0008)
+#define DCOFSEL_6                   (0x000C)
+#define SELA__LFXTCLK               (0x0000)
+#define SELA__VLOCLK                (0x0100)
+#define SELS__VLOCLK                (0x0010)
+#define SELS__DCOCLK                (0x0030)
+#define SELM__VLOCLK                (0x0001)
+#define SELM__DCOCLK                (0x0003)
+#define DIVA__1                     (0x0000)
+#define DIVS__1                     (0x0000)
+#define DIVM__1                     (0x0000)
+#define LFXTOFF                     (0x0001)    /**< CSCTL4 */
+#define LFXTOFFG                    (0x0001)    /**< CSCTL5 */
+
+#define SFRIFG1                     HWREG16(0x0102)
+#define OFIFG                       (0x0002)
+
+//*******************************************************************************
+// Digital I/O ******************************************************************
+//*******************************************************************************
+
+// Port pairs share 16 bit registers: P1 is the low byte of PA, P2 the high byte
+#define OFS_PAIN                    (0x0000)
+#define OFS_PAIN_L                  OFS_PAIN
+#define OFS_PAIN_H                  OFS_PAIN+1
+#define OFS_PAOUT                   (0x0002)
+#define OFS_PAOUT_L                 OFS_PAOUT
+#define OFS_PAOUT_H                 OFS_PAOUT+1
+#define OFS_PADIR                   (0x0004)
+#define OFS_PADIR_L                 OFS_PADIR
+#define OFS_PADIR_H                 OFS_PADIR+1
+#define OFS_PAREN                   (0x0006)
+#define OFS_PAREN_L                 OFS_PAREN
+#define OFS_PAREN_H                 OFS_PAREN+1
+#define OFS_PASEL0                  (0x000A)
+#define OFS_PASEL0_L                OFS_PASEL0
+#define OFS_PASEL0_H                OFS_PASEL0+1
+#define OFS_PASEL1                  (0x000C)
+#define OFS_PASEL1_L                OFS_PASEL1
+#define OFS_PASEL1_H                OFS_PASEL1+1
+#define OFS_P1IV                    (0x000E)
+#define OFS_PASELC                  (0x0016)
+#define OFS_PAIES                   (0x0018)
+#define OFS_PAIES_L                 OFS_PAIES
+#define OFS_PAIES_H                 OFS_PAIES+1
+#define OFS_PAIE                    (0x001A)
+#define OFS_PAIE_L                  OFS_PAIE
+#define OFS_PAIE_H                  OFS_PAIE+1
+#define OFS_PAIFG                   (0x001C)
+#define OFS_PAIFG_L                 OFS_PAIFG
+#define OFS_PAIFG_H                 OFS_PAIFG+1
+#define OFS_P2IV                    (0x001E)
+
+#define P1IN                        HWREG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PAIN_L)
+#define P1OUT                       HWREG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PAOUT_L)
+#define P1DIR                       HWREG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PADIR_L)
+#define P1REN                       HWREG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PAREN_L)
+#define P1SEL0                      HWREG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PASEL0_L)
+#define P1SEL1                      HWREG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PASEL1_L)
+#define P1IES                       HWREG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PAIES_L)
+#define P1IE                        HWREG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PAIE_L)
+#define P1IFG                       HWREG8(__MSP430_BASEADDRESS_PORT1_R__ + OFS_PAIFG_L)
+#define P2IN                        HWREG8(__MSP430_BASEADDRESS_PORT2_R__ + OFS_PAIN_H)
+#define P2OUT                       HWREG8(__MSP430_BASEADDRESS_PORT2_R__ + OFS_PAOUT_H)
+#define P2DIR                       HWREG8(__MSP430_BASEADDRESS_PORT2_R__ + OFS_PADIR_H)
+#define P2SEL0                      HWREG8(__MSP430_BASEADDRESS_PORT2_R__ + OFS_PASEL0_H)
+#define P2SEL1                      HWREG8(__MSP430_BASEADDRESS_PORT2_R__ + OFS_PASEL1_H)
+#define P3OUT                       HWREG8(__MSP430_BASEADDRESS_PORT3_R__ + OFS_PAOUT_L)
+#define P3DIR                       HWREG8(__MSP430_BASEADDRESS_PORT3_R__ + OFS_PADIR_L)
+#define P4OUT                       HWREG8(__MSP430_BASEADDRESS_PORT4_R__ + OFS_PAOUT_H)
+#define P4DIR                       HWREG8(__MSP430_BASEADDRESS_PORT4_R__ + OFS_PADIR_H)
+
+//*******************************************************************************
+// Timer_A / Timer_B ************************************************************
+//*******************************************************************************
+
+#define OFS_TAxCTL                  (0x0000)
+#define OFS_TAxCCTL0                (0x0002)
+#define OFS_TAxCCTL1                (0x0004)
+#define OFS_TAxCCTL2                (0x0006)
+#define OFS_TAxR                    (0x0010)
+#define OFS_TAxCCR0                 (0x0012)
+#define OFS_TAxCCR1                 (0x0014)
+#define OFS_TAxCCR2                 (0x0016)
+#define OFS_TAxIV                   (0x002E)
+#define OFS_TAxEX0                  (0x0020)
+
+#define OFS_TBxCTL                  (0x0000)
+#define OFS_TBxCCTL0                (0x0002)
+#define OFS_TBxCCTL1                (0x0004)
+#define OFS_TBxCCTL2                (0x0006)
+#define OFS_TBxR                    (0x0010)
+#define OFS_TBxCCR0                 (0x0012)
+#define OFS_TBxCCR1                 (0x0014)
+#define OFS_TBxCCR2                 (0x0016)
+#define OFS_TBxIV                   (0x002E)
+#define OFS_TBxEX0                  (0x0020)
+
+// TAxCTL / TBxCTL
+#define TAIFG                       (0x0001)
+#define TAIE                        (0x0002)
+#define TACLR                       (0x0004)
+#define TBIFG                       (0x0001)
+#define TBIE                        (0x0002)
+#define TBCLR                       (0x0004)
+#define MC_0                        (0x0000)
+#define MC_1                        (0x0010)
+#define MC_2                        (0x0020)
+#define MC_3                        (0x0030)
+#define MC__STOP                    MC_0
+#define MC__UP                      MC_1
+#define MC__CONTINUOUS              MC_2
+#define MC__UPDOWN                  MC_3
+#define ID_0                        (0x0000)
+#define ID_1                        (0x0040)
+#define ID_2                        (0x0080)
+#define ID_3                        (0x00C0)
+#define ID__1                       ID_0
+#define ID__2                       ID_1
+#define ID__4                       ID_2
+#define ID__8                       ID_3
+#define TASSEL_0                    (0x0000)
+#define TASSEL_1                    (0x0100)
+#define TASSEL_2                    (0x0200)
+#define TASSEL_3                    (0x0300)
+#define TASSEL__TACLK               TASSEL_0
+#define TASSEL__ACLK                TASSEL_1
+#define TASSEL__SMCLK               TASSEL_2
+#define TASSEL__INCLK               TASSEL_3
+#define TBSSEL_0                    (0x0000)
+#define TBSSEL_1                    (0x0100)
+#define TBSSEL_2                    (0x0200)
+#define TBSSEL_3                    (0x0300)
+#define TBSSEL__TBCLK               TBSSEL_0
+#define TBSSEL__ACLK                TBSSEL_1
+#define TBSSEL__SMCLK               TBSSEL_2
+#define TBSSEL__INCLK               TBSSEL_3
+#define CNTL_0                      (0x0000)
+#define CNTL_1                      (0x0800)
+#define CNTL_2                      (0x1000)
+#define CNTL_3                      (0x1800)
+#define TBCLGRP_0                   (0x0000)
+#define TBCLGRP_1                   (0x2000)
+#define TBCLGRP_2                   (0x4000)
+#define TBCLGRP_3                   (0x6000)
+
+// TAxCCTLn / TBxCCTLn
+#define CCIFG                       (0x0001)
+#define COV                         (0x0002)
+#define OUT                         (0x0004)
+#define CCI                         (0x0008)
+#define CCIE                        (0x0010)
+#define OUTMOD_0                    (0x0000)
+#define OUTMOD_1                    (0x0020)
+#define OUTMOD_2                    (0x0040)
+#define OUTMOD_3                    (0x0060)
+#define OUTMOD_4                    (0x0080)
+#define OUTMOD_5                    (0x00A0)
+#define OUTMOD_6                    (0x00C0)
+#define OUTMOD_7                    (0x00E0)
+#define CAP                         (0x0100)
+#define CLLD_0                      (0x0000)
+#define CLLD_1                      (0x0200)
+#define CLLD_2                      (0x0400)
+#define CLLD_3                      (0x0600)
+#define SCCI                        (0x0400)
+#define SCS                         (0x0800)
+#define CCIS_0                      (0x0000)
+#define CCIS_1                      (0x1000)
+#define CCIS_2                      (0x2000)
+#define CCIS_3                      (0x3000)
+#define CM_0                        (0x0000)
+#define CM_1                        (0x4000)
+#define CM_2                        (0x8000)
+#define CM_3                        (0xC000)
+
+// TAxEX0 / TBxEX0
+#define TAIDEX_0                    (0x0000)
+#define TAIDEX_7                    (0x0007)
+#define TBIDEX_0                    (0x0000)
+#define TBIDEX_7                    (0x0007)
+
+#define TA0CTL                      HWREG16(TIMER_A0_BASE + OFS_TAxCTL)
+#define TA0CCTL0                    HWREG16(TIMER_A0_BASE + OFS_TAxCCTL0)
+#define TA0CCTL1                    HWREG16(TIMER_A0_BASE + OFS_TAxCCTL1)
+#define TA0EX0                      HWREG16(TIMER_A0_BASE + OFS_TAxEX0)
+#define TA0R                        HWREG16(TIMER_A0_BASE + OFS_TAxR)
+#define TA0CCR0                     HWREG16(TIMER_A0_BASE + OFS_TAxCCR0)
+#define TA0CCR1                     HWREG16(TIMER_A0_BASE + OFS_TAxCCR1)
+#define TA0IV                       HWREG16(TIMER_A0_BASE + OFS_TAxIV)
+#define TB0CTL                      HWREG16(TIMER_B0_BASE + OFS_TBxCTL)
+#define TB0CCTL0                    HWREG16(TIMER_B0_BASE + OFS_TBxCCTL0)
+#define TB0CCTL1                    HWREG16(TIMER_B0_BASE + OFS_TBxCCTL1)
+#define TB0R                        HWREG16(TIMER_B0_BASE + OFS_TBxR)
+#define TB0CCR0                     HWREG16(TIMER_B0_BASE + OFS_TBxCCR0)
+#define TB0CCR1                     HWREG16(TIMER_B0_BASE + OFS_TBxCCR1)
+#define TB0IV                       HWREG16(TIMER_B0_BASE + OFS_TBxIV)
+
+//*******************************************************************************
+// RTC_B ************************************************************************
+//*******************************************************************************
+
+#define OFS_RTCCTL01                (0x0000)
+#define OFS_RTCCTL01_L              OFS_RTCCTL01
+#define OFS_RTCCTL01_H              OFS_RTCCTL01+1
+#define OFS_RTCCTL23                (0x0002)
+#define OFS_RTCCTL23_L              OFS_RTCCTL23
+#define OFS_RTCCTL23_H              OFS_RTCCTL23+1
+#define OFS_RTCPS0CTL               (0x0008)
+#define OFS_RTCPS0CTL_L             OFS_RTCPS0CTL
+#define OFS_RTCPS0CTL_H             OFS_RTCPS0CTL+1
+#define OFS_RTCPS1CTL               (0x000A)
+#define OFS_RTCPS1CTL_L             OFS_RTCPS1CTL
+#define OFS_RTCPS1CTL_H             OFS_RTCPS1CTL+1
+#define OFS_RTCPS                   (0x000C)
+#define OFS_RTCPS_L                 OFS_RTCPS
+#define OFS_RTCPS_H                 OFS_RTCPS+1
+#define OFS_RTCIV                   (0x000E)
+#define OFS_RTCTIM0                 (0x0010)
+#define OFS_RTCTIM0_L               OFS_RTCTIM0
+#define OFS_RTCTIM0_H               OFS_RTCTIM0+1
+#define OFS_RTCTIM1                 (0x0012)
+#define OFS_RTCTIM1_L               OFS_RTCTIM1
+#define OFS_RTCTIM1_H               OFS_RTCTIM1+1
+#define OFS_RTCDATE                 (0x0014)
+#define OFS_RTCDATE_L               OFS_RTCDATE
+#define OFS_RTCDATE_H               OFS_RTCDATE+1
+#define OFS_RTCYEAR                 (0x0016)
+#define OFS_RTCAMINHR               (0x0018)
+#define OFS_RTCAMINHR_L             OFS_RTCAMINHR
+#define OFS_RTCAMINHR_H             OFS_RTCAMINHR+1
+#define OFS_RTCADOWDAY              (0x001A)
+#define OFS_RTCADOWDAY_L            OFS_RTCADOWDAY
+#define OFS_RTCADOWDAY_H            OFS_RTCADOWDAY+1
+#define OFS_BIN2BCD                 (0x001C)
+#define OFS_BCD2BIN                 (0x001E)
+
+// RTCCTL01
+#define RTCRDYIFG                   (0x0001)
+#define RTCAIFG                     (0x0002)
+#define RTCTEVIFG                   (0x0004)
+#define RTCOFIFG                    (0x0008)
+#define RTCRDYIE                    (0x0010)
+#define RTCAIE                      (0x0020)
+#define RTCTEVIE                    (0x0040)
+#define RTCOFIE                     (0x0080)
+#define RTCTEV_0                    (0x0000)
+#define RTCTEV_1                    (0x0100)
+#define RTCTEV_2                    (0x0200)
+#define RTCTEV_3                    (0x0300)
+#define RTCRDY                      (0x1000)
+#define RTCMODE                     (0x2000)
+#define RTCHOLD                     (0x4000)
+#define RTCBCD                      (0x8000)
+#define RTCRDY_H                    (0x10)
+#define RTCHOLD_H                   (0x40)
+
+// RTCCTL23
+#define RTCCALS                     (0x0080)
+#define RTCCALF_0                   (0x0000)
+#define RTCCALF_1                   (0x0100)
+#define RTCCALF_2                   (0x0200)
+#define RTCCALF_3                   (0x0300)
+
+// RTCPS0CTL / RTCPS1CTL
+#define RT0PSIFG                    (0x0001)
+#define RT0PSIE                     (0x0002)
+#define RT0IP_0                     (0x0000)
+#define RT0IP_7                     (0x001C)
+#define RT1PSIFG                    (0x0001)
+#define RT1PSIE                     (0x0002)
+#define RT1IP_0                     (0x0000)
+#define RT1IP_7                     (0x001C)
+
+#define RTCCTL01                    HWREG16(RTC_B_BASE + OFS_RTCCTL01)
+#define RTCIV                       HWREG16(RTC_B_BASE + OFS_RTCIV)
+
+// RTCIV
+#define RTCIV_NONE                  (0x0000)
+#define RTCIV_RTCRDYIFG             (0x0002)
+#define RTCIV_RTCTEVIFG             (0x0004)
+#define RTCIV_RTCAIFG               (0x0006)
+
+//*******************************************************************************
+// eUSCI_B0 (I2C mode) **********************************************************
+//*******************************************************************************
+
+#define OFS_UCBxCTLW0               (0x0000)
+#define OFS_UCBxCTLW1               (0x0002)
+#define OFS_UCBxBRW                 (0x0006)
+#define OFS_UCBxSTATW               (0x0008)
+#define OFS_UCBxTBCNT               (0x000A)
+#define OFS_UCBxRXBUF               (0x000C)
+#define OFS_UCBxTXBUF               (0x000E)
+#define OFS_UCBxI2COA0              (0x0014)
+#define OFS_UCBxADDRX               (0x001C)
+#define OFS_UCBxI2CSA               (0x0020)
+#define OFS_UCBxIE                  (0x002A)
+#define OFS_UCBxIFG                 (0x002C)
+#define OFS_UCBxIV                  (0x002E)
+
+#define UCB0CTLW0                   HWREG16(EUSCI_B0_BASE + OFS_UCBxCTLW0)
+#define UCB0CTLW1                   HWREG16(EUSCI_B0_BASE + OFS_UCBxCTLW1)
+#define UCB0BRW                     HWREG16(EUSCI_B0_BASE + OFS_UCBxBRW)
+#define UCB0STATW                   HWREG16(EUSCI_B0_BASE + OFS_UCBxSTATW)
+#define UCB0RXBUF                   HWREG16(EUSCI_B0_BASE + OFS_UCBxRXBUF)
+#define UCB0TXBUF                   HWREG16(EUSCI_B0_BASE + OFS_UCBxTXBUF)
+#define UCB0I2COA0                  HWREG16(EUSCI_B0_BASE + OFS_UCBxI2COA0)
+#define UCB0I2CSA                   HWREG16(EUSCI_B0_BASE + OFS_UCBxI2CSA)
+#define UCB0IE                      HWREG16(EUSCI_B0_BASE + OFS_UCBxIE)
+#define UCB0IFG                     HWREG16(EUSCI_B0_BASE + OFS_UCBxIFG)
+#define UCB0IV                      HWREG16(EUSCI_B0_BASE + OFS_UCBxIV)
+
+// UCBxCTLW0
+#define UCSWRST                     (0x0001)
+#define UCTXSTT                     (0x0002)
+#define UCTXSTP                     (0x0004)
+#define UCTXNACK                    (0x0008)
+#define UCTR                        (0x0010)
+#define UCTXACK                     (0x0020)
+#define UCSYNC                      (0x0100)
+#define UCMODE_3                    (0x0600)
+#define UCMST                       (0x0800)
+
+// UCBxSTATW
+#define UCBBUSY                     (0x0010)
+#define UCSCLLOW                    (0x0040)
+
+// UCBxI2COA0
+#define UCOAEN                      (0x0400)
+
+// UCBxIE / UCBxIFG
+#define UCRXIE0                     (0x0001)
+#define UCTXIE0                     (0x0002)
+#define UCSTTIE                     (0x0004)
+#define UCSTPIE                     (0x0008)
+#define UCALIE                      (0x0010)
+#define UCNACKIE                    (0x0020)
+#define UCRXIE                      UCRXIE0
+#define UCTXIE                      UCTXIE0
+#define UCRXIFG0                    (0x0001)
+#define UCTXIFG0                    (0x0002)
+#define UCSTTIFG                    (0x0004)
+#define UCSTPIFG                    (0x0008)
+#define UCALIFG                     (0x0010)
+#define UCNACKIFG                   (0x0020)
+#define UCRXIFG                     UCRXIFG0
+#define UCTXIFG                     UCTXIFG0
+
+// UCBxIV
+#define USCI_NONE                   (0x00)
+#define USCI_I2C_UCALIFG            (0x02)
+#define USCI_I2C_UCNACKIFG          (0x04)
+#define USCI_I2C_UCSTTIFG           (0x06)
+#define USCI_I2C_UCSTPIFG           (0x08)
+#define USCI_I2C_UCRXIFG3           (0x0A)
+#define USCI_I2C_UCTXIFG3           (0x0C)
+#define USCI_I2C_UCRXIFG2           (0x0E)
+#define USCI_I2C_UCTXIFG2           (0x10)
+#define USCI_I2C_UCRXIFG1           (0x12)
+#define USCI_I2C_UCTXIFG1           (0x14)
+#define USCI_I2C_UCRXIFG0           (0x16)
+#define USCI_I2C_UCTXIFG0           (0x18)
+#define USCI_I2C_UCBCNTIFG          (0x1A)
+#define USCI_I2C_UCCLTOIFG          (0x1C)
+#define USCI_I2C_UCBIT9IFG          (0x1E)
+
+//*******************************************************************************
+// ADC12_B **********************************************************************
+//*******************************************************************************
+
+#define OFS_ADC12CTL0               (0x0000)
+#define OFS_ADC12CTL0_L             OFS_ADC12CTL0
+#define OFS_ADC12CTL0_H             OFS_ADC12CTL0+1
+#define OFS_ADC12CTL1               (0x0002)
+#define OFS_ADC12CTL1_L             OFS_ADC12CTL1
+#define OFS_ADC12CTL1_H             OFS_ADC12CTL1+1
+#define OFS_ADC12CTL2               (0x0004)
+#define OFS_ADC12CTL2_L             OFS_ADC12CTL2
+#define OFS_ADC12CTL2_H             OFS_ADC12CTL2+1
+#define OFS_ADC12CTL3               (0x0006)
+#define OFS_ADC12CTL3_L             OFS_ADC12CTL3
+#define OFS_ADC12CTL3_H             OFS_ADC12CTL3+1
+#define OFS_ADC12LO                 (0x0008)
+#define OFS_ADC12HI                 (0x000A)
+#define OFS_ADC12IFGR0              (0x000C)
+#define OFS_ADC12IFGR1              (0x000E)
+#define OFS_ADC12IFGR2              (0x0010)
+#define OFS_ADC12IER0               (0x0012)
+#define OFS_ADC12IER1               (0x0014)
+#define OFS_ADC12IER2               (0x0016)
+#define OFS_ADC12IV                 (0x0018)
+#define OFS_ADC12MCTL0              (0x0020)    /**< MCTL1..31 follow, 2 bytes apart */
+#define OFS_ADC12MEM0               (0x0060)    /**< MEM1..31 follow, 2 bytes apart */
+
+// ADC12CTL0
+#define ADC12SC                     (0x0001)
+#define ADC12ENC                    (0x0002)
+#define ADC12ON                     (0x0010)
+#define ADC12MSC                    (0x0080)
+#define ADC12SHT0_0                 (0x0000)
+#define ADC12SHT0_1                 (0x0100)
+#define ADC12SHT0_2                 (0x0200)
+#define ADC12SHT0_15                (0x0F00)
+#define ADC12SHT1_0                 (0x0000)
+#define ADC12SHT1_15                (0xF000)
+
+// ADC12CTL1
+#define ADC12BUSY                   (0x0001)
+#define ADC12CONSEQ_0               (0x0000)
+#define ADC12CONSEQ_1               (0x0002)
+#define ADC12CONSEQ_2               (0x0004)
+#define ADC12CONSEQ_3               (0x0006)
+#define ADC12SSEL_0                 (0x0000)
+#define ADC12SSEL_1                 (0x0008)
+#define ADC12SSEL_2                 (0x0010)
+#define ADC12SSEL_3                 (0x0018)
+#define ADC12DIV_0                  (0x0000)
+#define ADC12DIV_7                  (0x00E0)
+#define ADC12ISSH                   (0x0100)
+#define ADC12SHP                    (0x0200)
+#define ADC12SHS_0                  (0x0000)
+#define ADC12SHS_1                  (0x0400)
+#define ADC12SHS_7                  (0x1C00)
+#define ADC12PDIV__1                (0x0000)
+#define ADC12PDIV__4                (0x2000)
+#define ADC12PDIV__32               (0x4000)
+#define ADC12PDIV__64               (0x6000)
+
+// ADC12CTL2
+#define ADC12PWRMD                  (0x0001)
+#define ADC12DF                     (0x0008)
+#define ADC12RES_0                  (0x0000)
+#define ADC12RES_1                  (0x0010)
+#define ADC12RES_2                  (0x0020)
+#define ADC12RES_3                  (0x0030)
+
+// ADC12CTL3
+#define ADC12CSTARTADD_0            (0x0000)
+#define ADC12CSTARTADD_31           (0x001F)
+#define ADC12BATMAP                 (0x0040)
+#define ADC12TCMAP                  (0x0080)
+
+// ADC12MCTLx
+#define ADC12INCH_0                 (0x0000)
+#define ADC12INCH_1                 (0x0001)
+#define ADC12INCH_2                 (0x0002)
+#define ADC12INCH_3                 (0x0003)
+#define ADC12INCH_4                 (0x0004)
+#define ADC12INCH_5                 (0x0005)
+#define ADC12INCH_6                 (0x0006)
+#define ADC12INCH_7                 (0x0007)
+#define ADC12INCH_8                 (0x0008)
+#define ADC12INCH_9                 (0x0009)
+#define ADC12INCH_10                (0x000A)
+#define ADC12INCH_11                (0x000B)
+#define ADC12INCH_12                (0x000C)
+#define ADC12INCH_13                (0x000D)
+#define ADC12INCH_14                (0x000E)
+#define ADC12INCH_15                (0x000F)
+#define ADC12INCH_30                (0x001E)
+#define ADC12INCH_31                (0x001F)
+#define ADC12EOS                    (0x0080)
+#define ADC12VRSEL_0                (0x0000)
+#define ADC12VRSEL_1                (0x0100)
+#define ADC12DIF                    (0x2000)
+#define ADC12WINC                   (0x4000)
+
+// ADC12IFGR2 / ADC12IER2
+#define ADC12INIFG                  (0x0002)
+#define ADC12LOIFG                  (0x0004)
+#define ADC12HIIFG                  (0x0008)
+#define ADC12OVIFG                  (0x0010)
+#define ADC12TOVIFG                 (0x0020)
+#define ADC12RDYIFG                 (0x0040)
+#define ADC12INIE                   (0x0002)
+#define ADC12LOIE                   (0x0004)
+#define ADC12HIIE                   (0x0008)
+#define ADC12OVIE                   (0x0010)
+#define ADC12TOVIE                  (0x0020)
+#define ADC12RDYIE                  (0x0040)
+
+// ADC12IV
+#define ADC12IV_NONE                (0x0000)
+#define ADC12IV_ADC12OVIFG          (0x0002)
+#define ADC12IV_ADC12TOVIFG         (0x0004)
+#define ADC12IV_ADC12HIIFG          (0x0006)
+#define ADC12IV_ADC12LOIFG          (0x0008)
+#define ADC12IV_ADC12INIFG          (0x000A)
+#define ADC12IV_ADC12IFG0           (0x000C)    /**< IFG1..31 follow, 2 apart */
+#define ADC12IV_ADC12RDYIFG         (0x004C)
+
+#define ADC12CTL0                   HWREG16(ADC12_B_BASE + OFS_ADC12CTL0)
+#define ADC12CTL1                   HWREG16(ADC12_B_BASE + OFS_ADC12CTL1)
+#define ADC12CTL2                   HWREG16(ADC12_B_BASE + OFS_ADC12CTL2)
+#define ADC12CTL3                   HWREG16(ADC12_B_BASE + OFS_ADC12CTL3)
+#define ADC12LO                     HWREG16(ADC12_B_BASE + OFS_ADC12LO)
+#define ADC12HI                     HWREG16(ADC12_B_BASE + OFS_ADC12HI)
+#define ADC12IFGR0                  HWREG16(ADC12_B_BASE + OFS_ADC12IFGR0)
+#define ADC12IFGR1                  HWREG16(ADC12_B_BASE + OFS_ADC12IFGR1)
+#define ADC12IFGR2                  HWREG16(ADC12_B_BASE + OFS_ADC12IFGR2)
+#define ADC12IER0                   HWREG16(ADC12_B_BASE + OFS_ADC12IER0)
+#define ADC12IER2                   HWREG16(ADC12_B_BASE + OFS_ADC12IER2)
+#define ADC12IV                     HWREG16(ADC12_B_BASE + OFS_ADC12IV)
+#define ADC12MEM0                   HWREG16(ADC12_B_BASE + OFS_ADC12MEM0)
+
+//*******************************************************************************
+// DMA **************************************************************************
+//*******************************************************************************
+
+#define OFS_DMACTL0                 (0x0000)
+#define OFS_DMACTL1                 (0x0002)
+#define OFS_DMACTL4                 (0x0008)
+#define OFS_DMAIV                   (0x000E)
+#define OFS_DMA0CTL                 (0x0010)    /**< Channels 1 and 2 follow, 0x10 apart */
+#define OFS_DMA0SA                  (0x0012)
+#define OFS_DMA0DA                  (0x0016)
+#define OFS_DMA0SZ                  (0x001A)
+#define OFS_DMA1CTL                 (0x0020)
+#define OFS_DMA1SA                  (0x0022)
+#define OFS_DMA1DA                  (0x0026)
+#define OFS_DMA1SZ                  (0x002A)
+#define DMA_CHANNEL_SIZE            (0x0010)
+#define DMA_CHANNELS                (3)
+
+// DMACTL0
+#define DMA0TSEL_31                 (0x001F)
+#define DMA0TSEL__DMAREQ            (0x0000)
+#define DMA0TSEL__TA0CCR0           (0x0001)    /**< TA0CCR0 CCIFG */
+#define DMA0TSEL__ADC12IFG          (0x001A)    /**< ADC12 end of conversion */
+#define DMA1TSEL_31                 (0x1F00)
+#define DMA1TSEL__TA0CCR0           (0x0100)
+
+// DMAxCTL
+#define DMAREQ                      (0x0001)
+#define DMAABORT                    (0x0002)
+#define DMAIE                       (0x0004)
+#define DMAIFG                      (0x0008)
+#define DMAEN                       (0x0010)
+#define DMALEVEL                    (0x0020)
+#define DMASRCBYTE                  (0x0040)
+#define DMADSTBYTE                  (0x0080)
+#define DMASRCINCR_0                (0x0000)
+#define DMASRCINCR_2                (0x0200)
+#define DMASRCINCR_3                (0x0300)
+#define DMADSTINCR_0                (0x0000)
+#define DMADSTINCR_2                (0x0800)
+#define DMADSTINCR_3                (0x0C00)
+#define DMADT_0                     (0x0000)    /**< Single transfer */
+#define DMADT_1                     (0x1000)    /**< Block transfer */
+#define DMADT_4                     (0x4000)    /**< Repeated single transfer */
+#define DMADT_5                     (0x5000)    /**< Repeated block transfer */
+
+// DMAIV
+#define DMAIV_NONE                  (0x0000)
+#define DMAIV_DMA0IFG               (0x0002)
+#define DMAIV_DMA1IFG               (0x0004)
+#define DMAIV_DMA2IFG               (0x0006)
+
+#define DMACTL0                     HWREG16(DMA_BASE + OFS_DMACTL0)
+#define DMAIV                       HWREG16(DMA_BASE + OFS_DMAIV)
+#define DMA0CTL                     HWREG16(DMA_BASE + OFS_DMA0CTL)
+#define DMA0SZ                      HWREG16(DMA_BASE + OFS_DMA0SZ)
+#define DMA1CTL                     HWREG16(DMA_BASE + OFS_DMA1CTL)
+#define DMA1SZ                      HWREG16(DMA_BASE + OFS_DMA1SZ)
+
+//*******************************************************************************
+// TLV descriptors **************************************************************
+//*******************************************************************************
+
+// Calibration data written at production into information memory, as tag,
+// length, data records. Host simulations write their own table here.
+#define TLV_START                   (0x1A08)
+#define TLV_END                     (0x1AFF)
+#define TLV_ADC12CAL                (0x11)  /**< Gain factor, offset, temperature sensor */
+#define TLV_REFCAL                  (0x12)  /**< 1.2 V, 2.0 V and 2.5 V reference factors */
+
+//*******************************************************************************
+// Interrupt vectors ************************************************************
+//*******************************************************************************
+
+// Only used to name ISRs, which are plain functions on the host
+#define RTC_VECTOR                  (31)
+#define PORT1_VECTOR                (39)
+#define TIMER1_A0_VECTOR            (41)
+#define DMA_VECTOR                  (42)
+#define TIMER0_A1_VECTOR            (44)
+#define TIMER0_A0_VECTOR            (45)
+#define ADC12_VECTOR                (46)
+#define USCI_B0_VECTOR              (47)
+#define TIMER0_B1_VECTOR            (50)
+#define TIMER0_B0_VECTOR            (51)
+
+#endif // _HOST_MSP430_
@@ -0,0 +1,18 @@
+/**
+ * @file msp430_cycles.h
+ * @brief MSP430 CPU cost model the cycle-counting simulations share.
+ *
+ * Costs in MCLK cycles of taking and leaving an interrupt on the FR5969 and
+ * of touching a peripheral register. What an ISR does in between depends on
+ * the driver, each simulation counts that itself.
+ */
+
+#ifndef _HOST_MSP430_CYCLES_
+#define _HOST_MSP430_CYCLES_
+
+#define ISR_ACCEPT_CYCLES           6       /**< Interrupt latency, PC and SR pushed */
+#define ISR_RETURN_CYCLES           5       /**< RETI */
+#define ISR_FRAME_CYCLES            24      /**< R12-R15 save and restore, IV jump table */
+#define ISR_REG_ACCESS_CYCLES       3       /**< One &absolute operand */
+
+#endif // _HOST_MSP430_CYCLES_
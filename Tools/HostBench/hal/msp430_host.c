@@ -0,0 +1,162 @@
+/**
+ * @file msp430_host.c
+ * @brief Register file behind the host msp430.h.
+ */
+
+#include <string.h>
+
+#include <msp430.h>
+
+#define HOST_REG_MAX_HOOKS  16
+#define HOST_MAX_ADDRESSES  8
+
+typedef struct {
+    uint16_t first, last;
+    HostRegReadHook read;
+    HostRegWriteHook write;
+} sHostRegHook_t;
+
+uint8_t host_reg_file[HOST_REG_SPACE] __attribute__((aligned(4)));
+uint32_t host_reg_accesses = 0;
+
+static sHostRegHook_t hooks[HOST_REG_MAX_HOOKS];
+static uint8_t hook_count = 0;
+static uint8_t in_hook = 0;             /**< Accesses made by a hook run no hooks */
+static HostLowPowerHook low_power = NULL;
+
+// Full values of the address registers written with __data16_write_addr()
+static struct {
+    uint16_t address;
+    uintptr_t value;
+} addresses[HOST_MAX_ADDRESSES];
+static uint8_t address_count = 0;
+
+// The access whose write hook has not been delivered yet
+static const sHostRegHook_t *pending = NULL;
+static uint16_t pending_address;
+static uint8_t pending_width;
+static uint16_t pending_value;
+
+static const sHostRegHook_t *FindHook(uint16_t address) {
+    uint8_t i;
+    for (i = 0; i < hook_count; i++) {
+        if (address >= hooks[i].first && address <= hooks[i].last)
+            return &hooks[i];
+    }
+    return NULL;
+}
+
+static uint16_t Peek(uint16_t address, uint8_t width) {
+    return (width == 1) ? HOST_REG8(address) : HOST_REG16(address);
+}
+
+void hostRegSync(void) {
+    const sHostRegHook_t *hook = pending;
+    uint16_t value;
+
+    if (hook == NULL)
+        return;
+    pending = NULL;
+
+    value = Peek(pending_address, pending_width);
+    if (value != pending_value && hook->write != NULL) {
+        in_hook = 1;
+        hook->write(pending_address, pending_value, value);
+        in_hook = 0;
+    }
+}
+
+volatile void *hostRegBusAccess(uint16_t address, uint8_t width) {
+    const sHostRegHook_t *hook;
+
+    if (in_hook)
+        return &host_reg_file[address];
+
+    hostRegSync();
+
+    hook = FindHook(address);
+    if (hook != NULL) {
+        if (hook->read != NULL) {
+            in_hook = 1;
+            hook->read(address);
+            in_hook = 0;
+        }
+        pending = hook;
+        pending_address = address;
+        pending_width = width;
+        pending_value = Peek(address, width);
+    }
+
+    return &host_reg_file[address];
+}
+
+volatile void *hostRegAccess(uint16_t address, uint8_t width) {
+    if (!in_hook)
+        host_reg_accesses++;
+    return hostRegBusAccess(address, width);
+}
+
+void hostRegReset(void) {
+    memset(host_reg_file, 0, sizeof(host_reg_file));
+    hook_count = 0;
+    pending = NULL;
+    low_power = NULL;
+    address_count = 0;
+    host_reg_accesses = 0;
+}
+
+int hostRegHook(uint16_t first, uint16_t last, HostRegReadHook read, HostRegWriteHook write) {
+    if (hook_count == HOST_REG_MAX_HOOKS)
+        return -1;
+
+    hooks[hook_count].first = first;
+    hooks[hook_count].last = last;
+    hooks[hook_count].read = read;
+    hooks[hook_count].write = write;
+    hook_count++;
+    return 0;
+}
+
+void hostLowPowerHook(HostLowPowerHook hook) {
+    low_power = hook;
+}
+
+void hostEnterLowPower(uint16_t bits) {
+    hostRegSync();
+    if ((bits & CPUOFF) && low_power != NULL)
+        low_power();
+}
+
+// The register keeps the low 32 bits, as far as a 20 bit register goes
+void hostWriteAddress(uint16_t address, uintptr_t value) {
+    uint8_t i;
+
+    host_reg_accesses++;
+    hostRegSync();
+    HOST_REG16(address) = (uint16_t)value;
+    HOST_REG16(address + 2) = (uint16_t)(value >> 16);
+
+    for (i = 0; i < address_count; i++) {
+        if (addresses[i].address == address)
+            break;
+    }
+    if (i == address_count) {
+        if (address_count == HOST_MAX_ADDRESSES)
+            return;
+        address_count++;
+    }
+    addresses[i].address = address;
+    addresses[i].value = value;
+}
+
+uintptr_t hostReadAddress(uint16_t address) {
+    uintptr_t low = HOST_REG16(address) | ((uintptr_t)HOST_REG16(address + 2) << 16);
+    uint8_t i;
+
+    // Unless the register was written some other way since
+    for (i = 0; i < address_count; i++) {
+        if (addresses[i].address == address && (uint32_t)addresses[i].value == low)
+            return addresses[i].value;
+    }
+    return low;
+}
@@ -0,0 +1,5 @@
+/**
+ * @file msp430fr5xx_6xxgeneric.h
+ * @brief Included by hw_memmap.h. On the host every offset and bit it would
+ * provide is already defined by msp430.h.
+ */
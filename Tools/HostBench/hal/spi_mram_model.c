@@ -0,0 +1,205 @@
+/**
+ * @file spi_mram_model.c
+ * @brief S3A3204V0M SPI MRAM model, with the time the bus takes.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "spi_mram_model.h"
+#include "lfs_mrambd.h"
+
+#define CMD_WRSR    0x01
+#define CMD_WRITE   0x02
+#define CMD_READ    0x03
+#define CMD_WRDI    0x04
+#define CMD_RDSR    0x05
+#define CMD_WREN    0x06
+#define CMD_RDUID   0x4C
+#define CMD_RDID    0x9F
+
+#define STATUS_WEL  0x02
+#define ADDR_BYTES  3
+
+typedef enum {
+    MRAM_IDLE,          // CS high
+    MRAM_COMMAND,       // Selected, waiting for the command
+    MRAM_ADDRESS,       // Shifting in the address
+    MRAM_DATA,          // Streaming, the command says which way
+    MRAM_IGNORE         // Nothing more to do until CS goes high
+} eMramState_t;
+
+static uint8_t array[MRAM_MODEL_SIZE];
+static sMramModelTiming_t timing;
+static sMramModelStats_t stats;
+
+static eMramState_t state = MRAM_IDLE;
+static uint8_t command;
+static uint8_t addressBytes;
+static uint32_t address;
+static uint32_t dataBytes;     // Bytes since the address, for the ID commands
+static uint8_t status;
+
+void mramModelInit(const sMramModelTiming_t *config) {
+    static const sMramModelTiming_t defaults = {
+        .sckHz = 1000000,
+        .selectNs = MRAM_MODEL_SELECT_NS,
+        .callNs = MRAM_MODEL_CALL_NS
+    };
+
+    timing = config ? *config : defaults;
+    if (timing.sckHz == 0)
+        timing.sckHz = defaults.sckHz;
+
+    memset(array, 0, sizeof(array));
+    state = MRAM_IDLE;
+    status = 0;
+    mramModelClearStats();
+}
+
+const struct lfs_mrambd_config *mramModelFixture(uint32_t sckHz) {
+    static const struct lfs_mrambd_config port = {
+        .select = mramModelSelect,
+        .deselect = mramModelDeselect,
+        .transfer = mramModelTransfer,
+        .port = NULL,
+        .addr_size = ADDR_BYTES
+    };
+    sMramModelTiming_t config = {sckHz, MRAM_MODEL_SELECT_NS, MRAM_MODEL_CALL_NS};
+
+    mramModelInit(&config);
+    return &port;
+}
+
+void mramModelSelect(void *port) {
+    (void)port;
+    stats.selects++;
+    stats.ns += timing.selectNs;
+    state = MRAM_COMMAND;
+}
+
+void mramModelDeselect(void *port) {
+    (void)port;
+    if (state != MRAM_IDLE && command == CMD_WRITE && (status & STATUS_WEL)) {
+        if (state == MRAM_DATA)
+            stats.writes++;
+        status &= ~STATUS_WEL;
+    }
+    state = MRAM_IDLE;
+    command = 0;
+}
+
+static uint8_t Command(uint8_t mosi) {
+    command = mosi;
+    addressBytes = 0;
+    address = 0;
+    dataBytes = 0;
+
+    switch (command) {
+    case CMD_WREN:
+        status |= STATUS_WEL;
+        state = MRAM_IGNORE;
+        break;
+    case CMD_WRDI:
+        status &= ~STATUS_WEL;
+        state = MRAM_IGNORE;
+        break;
+    case CMD_READ:
+        state = MRAM_ADDRESS;
+        stats.reads++;
+        break;
+    case CMD_WRITE:
+        state = MRAM_ADDRESS;
+        if (!(status & STATUS_WEL)) {
+            stats.rejected++;
+            state = MRAM_IGNORE;
+        }
+        break;
+    case CMD_RDSR:
+    case CMD_RDID:
+    case CMD_RDUID:
+        state = MRAM_DATA;
+        break;
+    case CMD_WRSR:
+        state = MRAM_IGNORE;    // Block protection is not modelled
+        break;
+    default:
+        stats.unknown++;
+        state = MRAM_IGNORE;
+        break;
+    }
+    return 0;
+}
+
+static uint8_t Data(uint8_t mosi) {
+    uint8_t miso = 0;
+
+    switch (command) {
+    case CMD_READ:
+        miso = array[address];
+        address = (address + 1) % MRAM_MODEL_SIZE;
+        break;
+    case CMD_WRITE:
+        array[address] = mosi;
+        address = (address + 1) % MRAM_MODEL_SIZE;
+        break;
+    case CMD_RDSR:
+        miso = status;
+        break;
+    case CMD_RDID:
+        miso = dataBytes < 4 ? (uint8_t)(MRAM_MODEL_DEVICE_ID >> (24 - 8 * dataBytes)) : 0;
+        break;
+    case CMD_RDUID:
+        miso = dataBytes < 8 ? (uint8_t)(0xA5 ^ (dataBytes * 0x1D)) : 0;
+        break;
+    }
+    dataBytes++;
+    return miso;
+}
+
+static uint8_t Clock(uint8_t mosi) {
+    switch (state) {
+    case MRAM_COMMAND:
+        return Command(mosi);
+    case MRAM_ADDRESS:
+        address = (address << 8) | mosi;
+        if (++addressBytes == ADDR_BYTES) {
+            address %= MRAM_MODEL_SIZE;
+            state = MRAM_DATA;
+        }
+        return 0;
+    case MRAM_DATA:
+        return Data(mosi);
+    default:
+        return 0xFF;    // SO floats while deselected
+    }
+}
+
+void mramModelTransfer(void *port, const uint8_t *tx, uint8_t *rx, uint32_t size) {
+    (void)port;
+    stats.calls++;
+    stats.bytes += size;
+    stats.ns += timing.callNs + ((uint64_t)size * 8 * 1000000000ULL + timing.sckHz - 1) / timing.sckHz;
+
+    for (uint32_t i = 0; i < size; i++) {
+        uint8_t miso = Clock(tx ? tx[i] : 0);
+        if (rx)
+            rx[i] = miso;
+    }
+}
+
+void mramModelDelayUs(uint32_t us) {
+    stats.ns += (uint64_t)us * 1000;
+}
+
+const sMramModelStats_t *mramModelStats(void) {
+    return &stats;
+}
+
+void mramModelClearStats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+uint8_t *mramModelArray(void) {
+    return array;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file spi_mram_model.h
+ * @brief S3A3204V0M SPI MRAM model, with the time the bus takes.
+ *
+ * The model decodes the bytes clocked between a select and a deselect as the
+ * chip does:
+ *  - WREN (0x06) sets the write enable latch, WRDI (0x04) clears it. A WRITE
+ *    transaction clears it when CS goes high, so each write needs its own
+ *    WREN. A WRITE without the latch set is ignored and counted as rejected.
+ *  - READ (0x03) and WRITE (0x02) take a 3 byte address, then stream bytes
+ *    from or to consecutive addresses for as long as CS stays low, wrapping
+ *    at the end of the array.
+ *  - RDSR (0x05) returns the status register (WEL in bit 1), RDID (0x9F) the
+ *    4 byte device ID and RDUID (0x4C) an 8 byte unique ID.
+ * Writes take effect at once: MRAM has no busy time and no erase.
+ *
+ * The time is the SPI clock for every byte, plus a fixed cost per select
+ * (claiming the bus and the CS edges) and per transfer call into the SPI
+ * driver, which is what dominates byte-at-a-time code on the Pico.
+ *
+ * The select, deselect and transfer functions have the signatures of the
+ * lfs_mrambd port (Tools/MramLittleFsPicoDemo/lfs_mrambd.h), the port
+ * argument is unused. mramModelFixture() hands them out as that port.
+ */
+
+#ifndef _HOST_SPI_MRAM_MODEL_
+#define _HOST_SPI_MRAM_MODEL_
+
+#include <stdint.h>
+
+struct lfs_mrambd_config;
+
+#define MRAM_MODEL_SIZE         0x400000UL  /**< 32 Mbit */
+#define MRAM_MODEL_DEVICE_ID    0x0E860403UL
+
+/**
+ * @brief Bus timing. The defaults are for the Pico demo: 1 MHz SCK and the
+ * Arduino mbed SPI driver.
+ */
+typedef struct {
+    uint32_t sckHz;         /**< SPI clock, 1 MHz when 0 */
+    uint32_t selectNs;      /**< Per select: beginTransaction, CS low and high, endTransaction */
+    uint32_t callNs;        /**< Per transfer call, whatever its length */
+} sMramModelTiming_t;
+
+#define MRAM_MODEL_SELECT_NS    3000
+#define MRAM_MODEL_CALL_NS      1000
+
+typedef struct {
+    uint64_t ns;            /**< Bus time, including delays */
+    uint64_t bytes;         /**< Bytes clocked */
+    uint32_t selects;       /**< CS assertions */
+    uint32_t calls;         /**< Transfer calls */
+    uint32_t reads;         /**< READ transactions */
+    uint32_t writes;        /**< WRITE transactions that wrote */
+    uint32_t rejected;      /**< WRITE transactions without the write enable latch */
+    uint32_t unknown;       /**< Transactions with an unknown command */
+} sMramModelStats_t;
+
+/**
+ * @brief Clears the array to zero, the latch and the statistics.
+ *
+ * @param timing NULL for the defaults
+ */
+void mramModelInit(const sMramModelTiming_t *timing);
+
+/**
+ * @brief Bench fixture: mramModelInit() at sckHz with the default select and
+ * call costs.
+ *
+ * @param sckHz SPI clock, 1 MHz when 0
+ * @return the lfs_mrambd port onto the model
+ */
+const struct lfs_mrambd_config *mramModelFixture(uint32_t sckHz);
+
+/**
+ * @brief Asserts CS.
+ */
+void mramModelSelect(void *port);
+
+/**
+ * @brief Releases CS, which completes a WRITE.
+ */
+void mramModelDeselect(void *port);
+
+/**
+ * @brief Clocks size bytes while selected: tx out (zeros when NULL), MISO
+ * into rx unless it is NULL. One driver call.
+ */
+void mramModelTransfer(void *port, const uint8_t *tx, uint8_t *rx, uint32_t size);
+
+/**
+ * @brief Time spent by the host in delay() between transactions.
+ */
+void mramModelDelayUs(uint32_t us);
+
+/**
+ * @brief Statistics since mramModelInit() or mramModelClearStats().
+ */
+const sMramModelStats_t *mramModelStats(void);
+
+void mramModelClearStats(void);
+
+/**
+ * @brief The array, for checking contents without going over the bus.
+ */
+uint8_t *mramModelArray(void);
+
+#endif // _HOST_SPI_MRAM_MODEL_
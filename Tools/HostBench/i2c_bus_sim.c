@@ -0,0 +1,461 @@
+/**
+ * @file i2c_bus_sim.c
+ * @brief Virtual SAMV71 master polling the MSP430 subsystems on one shared I2C bus.
+ *
+ * The master encodes every frame with the tinyprotocol master functions
+ * (TINYPROTOCOL_SendTelecommand, TINYPROTOCOL_SendTelemetryRequest) and runs
+ * a polling schedule against the slaves on the bus:
+ *  - PDS: the real AppComm.c / i2c.c / tinyprotocol.c through USCI_B0_ISR
+ *  - Backplane: a model of the commandHandler() in APP/BACKPLANE/timer.c. It
+ *    takes [ID, STOP_CONDITION] and answers [error code, STOP_CONDITION], the
+ *    only answers timer.c gives until the command document defines the
+ *    response payloads
+ *
+ * The schedule is a script, one poll per line:
+ *
+ *     <period ms> <slave> tlm <command>
+ *     <period ms> <slave> tc <command> [argument bytes in hex]
+ *
+ * A telemetry poll is a request write followed by a response read, a
+ * telecommand poll a single write. Each slave frames its requests its own way:
+ * tinyprotocol for the PDS, the stop condition for the Backplane. Each poll falls due once per period; the
+ * master runs the oldest due poll as soon as the bus is free, so late polls
+ * queue up behind each other.
+ *
+ * Bus time is counted the way tlm_burst_bench counts it: 9 SCL periods per
+ * byte including the address, one each for START and STOP, tBUF between
+ * transactions, and a fixed master turnaround before a response read. A
+ * slave that has not finished parsing the request when the read starts holds
+ * SCL low until it has (its processing time below).
+ *
+ * Reported per SCL rate: polls per second against the schedule's target,
+ * bus utilization, and per slave the response latency from the poll falling
+ * due to the last response byte, plus polls that were still waiting when
+ * their next period began. Every response is checked: the PDS ones for CRC
+ * and length, and the system status must carry the last arguments sent to it;
+ * the Backplane ones must be CommandUnavailable and end on the stop condition.
+ *
+ * Usage: i2c_bus_sim [schedule_file] [seconds] [turnaround_us]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comm_master.h"
+#include "pds_master.h"
+#include "bsp.h"
+#include "timer.h"
+
+#define BUS_SIM_SECONDS         10.0
+#define BUS_SIM_TURNAROUND_US   50.0    /**< SAMV71 between request write and response read */
+#define BUS_SIM_MAX_POLLS       32
+#define BUS_SIM_MAX_FRAME       64
+#define BUS_SIM_MAX_LINE        128
+
+// Default schedule: PDS housekeeping every 100 ms, slower Backplane checks
+static const char default_schedule[] =
+    "# period_ms slave kind command [args]\n"
+    "100  PDS       tlm SYSTEM_STATUS\n"
+    "100  PDS       tlm CONVERTER_MONITOR\n"
+    "250  PDS       tlm HEALTH_CHECK\n"
+    "1000 PDS       tc  SYSTEM_STATUS 5aa5\n"
+    "1000 PDS       tlm TELECOMMAND_ACK\n"
+    "1000 PDS       tlm RAIL_FAULTS\n"
+    "500  BACKPLANE tlm SystemStatus\n"
+    "1000 BACKPLANE tlm HealthCheck\n"
+    "1000 BACKPLANE tlm Temperature\n";
+
+//***************************Slaves*******************************************************
+
+typedef struct {
+    const char *name;
+    uint8_t id;
+    uint8_t arg_size;           /**< Telecommand argument bytes */
+    uint16_t frame_size;        /**< Response bytes the master reads back */
+} sCommand_t;
+
+typedef struct {
+    const char *name;
+    uint8_t address;
+    double processing_us;       /**< Request received to response ready */
+    const sCommand_t *commands;
+    uint8_t command_count;
+    void (*request)(const sCommand_t *command, uint8_t telecommand, const uint8_t *args);
+    void (*write)(const uint8_t *data, uint8_t size);
+    void (*read)(uint8_t *data, uint16_t size);
+    int (*check)(const sCommand_t *command, const uint8_t *response);
+} sVirtualSlave_t;
+
+// The master builds each request here, then writes it to the slave
+static uint8_t frame[BUS_SIM_MAX_FRAME];
+static uint8_t frame_size = 0;
+
+static int16_t CaptureFrame(const uint8_t* buffer, uint8_t size) {
+    memcpy(&frame[frame_size], buffer, size);
+    frame_size += size;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static const struct TINYPROTOCOL_Config masterConfig = {
+    .TINYPROTOCOL_WriteBuffer = CaptureFrame
+};
+
+// PDS, the firmware itself. Each transaction is delivered whole, so the
+// request is parsed before the read that follows it.
+#define PDS_SIM_COMMAND(ID, Name, cmd_len, resp_len)    {#ID, ID##_ID, cmd_len, ID##_RESP_FRAME_LEN},
+
+static const sCommand_t pds_commands[] = {
+    PDS_COMMANDS(PDS_SIM_COMMAND)
+};
+
+static uint8_t status_args[SYSTEM_STATUS_CMD_LEN];
+static uint8_t status_args_sent = 0;
+
+static void PdsRequest(const sCommand_t *command, uint8_t telecommand, const uint8_t *args) {
+    if (telecommand) {
+        TINYPROTOCOL_SendTelecommand(&masterConfig, command->id, args, command->arg_size);
+        if (command->id == SYSTEM_STATUS_ID) {
+            memcpy(status_args, args, sizeof(status_args));
+            status_args_sent = 1;
+        }
+    } else {
+        TINYPROTOCOL_SendTelemetryRequest(&masterConfig, command->id);
+    }
+}
+
+static void PdsWrite(const uint8_t *data, uint8_t size) {
+    MasterWrite(data, size);
+}
+
+static void PdsRead(uint8_t *data, uint16_t size) {
+    MasterRead(data, size);
+}
+
+static int PdsCheck(const sCommand_t *command, const uint8_t *response) {
+    uint16_t size = command->frame_size;
+
+    if (TINYPROTOCOL_CalculateCRC(response, (uint8_t)(size - 1)) != response[size - 1]) {
+        fprintf(stderr, "FAIL: PDS %s response has a bad CRC\n", command->name);
+        return 0;
+    }
+    if (command->id == SYSTEM_STATUS_ID && status_args_sent &&
+        memcmp(&response[3], status_args, sizeof(status_args)) != 0) {
+        fprintf(stderr, "FAIL: PDS system status does not carry the last telecommand\n");
+        return 0;
+    }
+    return 1;
+}
+
+// Backplane: requests are [ID, STOP_CONDITION] with the command size from
+// timer.h. Every handler in timer.c answers CommandUnavailable for now, so
+// the master reads back an error response.
+#define BACKPLANE_SIM_COMMAND(Name, id, cmd_size, resp_size) \
+    {#Name, id, (cmd_size) - 2, BACKPLANE_ERROR_RESP_SIZE},
+
+static const sCommand_t backplane_commands[] = {
+    BACKPLANE_COMMANDS(BACKPLANE_SIM_COMMAND)
+};
+
+static uint8_t backplane_response[BACKPLANE_ERROR_RESP_SIZE];
+static uint16_t backplane_response_size = 0;
+
+static const sCommand_t *FindCommand(const sCommand_t *commands, uint8_t count, const char *name, uint8_t id) {
+    uint8_t i;
+    for (i = 0; i < count; i++) {
+        if ((name != NULL) ? strcmp(commands[i].name, name) == 0 : commands[i].id == id)
+            return &commands[i];
+    }
+    return NULL;
+}
+
+static void BackplaneRequest(const sCommand_t *command, uint8_t telecommand, const uint8_t *args) {
+    frame[frame_size++] = command->id;
+    if (telecommand) {
+        memcpy(&frame[frame_size], args, command->arg_size);
+        frame_size += command->arg_size;
+    }
+    frame[frame_size++] = STOP_CONDITION;
+}
+
+// Same checks as commandHandler(): known ID, stop condition at the command size
+static void BackplaneWrite(const uint8_t *data, uint8_t size) {
+    const sCommand_t *command = FindCommand(backplane_commands,
+                                            sizeof(backplane_commands) / sizeof(backplane_commands[0]),
+                                            NULL, data[0]);
+
+    if (command == NULL)
+        backplane_response[0] = CommandUnknown;
+    else if (size != command->arg_size + 2 || data[size - 1] != STOP_CONDITION)
+        backplane_response[0] = CommandBadSize;
+    else
+        backplane_response[0] = CommandUnavailable;
+    backplane_response[1] = STOP_CONDITION;
+    backplane_response_size = BACKPLANE_ERROR_RESP_SIZE;
+}
+
+static void BackplaneRead(uint8_t *data, uint16_t size) {
+    uint16_t i;
+    for (i = 0; i < size; i++)
+        data[i] = (i < backplane_response_size) ? backplane_response[i] : 0xFF;
+    backplane_response_size = 0;
+}
+
+static int BackplaneCheck(const sCommand_t *command, const uint8_t *response) {
+    if (response[0] != CommandUnavailable || response[1] != STOP_CONDITION) {
+        fprintf(stderr, "FAIL: BACKPLANE %s answered %02x %02x, expected %02x %02x\n", command->name,
+                response[0], response[1], CommandUnavailable, STOP_CONDITION);
+        return 0;
+    }
+    return 1;
+}
+
+static const sVirtualSlave_t slaves[] = {
+    {"PDS", SLAVE_ADDR, 25.0, pds_commands, sizeof(pds_commands) / sizeof(pds_commands[0]),
+     PdsRequest, PdsWrite, PdsRead, PdsCheck},
+    {"BACKPLANE", I2C_ADDR_BACKPLANE, 25.0, backplane_commands,
+     sizeof(backplane_commands) / sizeof(backplane_commands[0]),
+     BackplaneRequest, BackplaneWrite, BackplaneRead, BackplaneCheck},
+};
+
+#define SLAVE_COUNT     (sizeof(slaves) / sizeof(slaves[0]))
+
+//***************************Schedule*****************************************************
+
+typedef struct {
+    const sVirtualSlave_t *slave;
+    const sCommand_t *command;
+    uint8_t telecommand;
+    uint8_t args[TINYPROTOCOL_MAX_PAYLOAD_SIZE];
+    double period_s;
+    uint32_t runs;              /**< Periods run so far, the next one falls due at runs * period */
+    double due_s;
+} sPoll_t;
+
+static sPoll_t polls[BUS_SIM_MAX_POLLS];
+static uint8_t poll_count = 0;
+
+static int ParseLine(char *line, unsigned number) {
+    char slave_name[32], kind[8], command_name[32], args[2 * TINYPROTOCOL_MAX_PAYLOAD_SIZE + 2] = "";
+    const sVirtualSlave_t *slave = NULL;
+    double period_ms;
+    sPoll_t *poll;
+    unsigned s, i;
+    int fields;
+
+    line[strcspn(line, "#\r\n")] = '\0';
+    fields = sscanf(line, "%lf %31s %7s %31s %24s", &period_ms, slave_name, kind, command_name, args);
+    if (fields <= 0)
+        return 1;
+    if (fields < 4 || period_ms <= 0 || poll_count == BUS_SIM_MAX_POLLS) {
+        fprintf(stderr, "FAIL: schedule line %u: expected <period ms> <slave> <tlm|tc> <command> [args]\n", number);
+        return 0;
+    }
+
+    for (s = 0; s < SLAVE_COUNT; s++) {
+        if (strcmp(slaves[s].name, slave_name) == 0)
+            slave = &slaves[s];
+    }
+    poll = &polls[poll_count];
+    memset(poll, 0, sizeof(*poll));
+    poll->slave = slave;
+    poll->command = (slave != NULL) ? FindCommand(slave->commands, slave->command_count, command_name, 0) : NULL;
+    poll->telecommand = strcmp(kind, "tc") == 0;
+    poll->period_s = period_ms * 1e-3;
+
+    if (poll->command == NULL || (!poll->telecommand && strcmp(kind, "tlm") != 0)) {
+        fprintf(stderr, "FAIL: schedule line %u: unknown slave, kind or command\n", number);
+        return 0;
+    }
+    if (poll->telecommand) {
+        if (strlen(args) != 2u * poll->command->arg_size) {
+            fprintf(stderr, "FAIL: schedule line %u: %s takes %u argument bytes\n", number,
+                    poll->command->name, poll->command->arg_size);
+            return 0;
+        }
+        for (i = 0; i < poll->command->arg_size; i++) {
+            char byte[3] = {args[2 * i], args[2 * i + 1], '\0'};
+            poll->args[i] = (uint8_t)strtoul(byte, NULL, 16);
+        }
+    }
+
+    poll_count++;
+    return 1;
+}
+
+static int LoadSchedule(const char *path) {
+    char line[BUS_SIM_MAX_LINE];
+    unsigned number = 0;
+
+    if (path == NULL) {
+        const char *p = default_schedule;
+        while (*p) {
+            size_t n = strcspn(p, "\n");
+            memcpy(line, p, n);
+            line[n] = '\0';
+            if (!ParseLine(line, ++number))
+                return 0;
+            p += n + (p[n] == '\n');
+        }
+    } else {
+        FILE *file = fopen(path, "r");
+        int ok = 1;
+        if (file == NULL) {
+            fprintf(stderr, "FAIL: cannot open %s\n", path);
+            return 0;
+        }
+        while (ok && fgets(line, sizeof(line), file) != NULL)
+            ok = ParseLine(line, ++number);
+        fclose(file);
+        if (!ok)
+            return 0;
+    }
+
+    if (poll_count == 0) {
+        fprintf(stderr, "FAIL: empty schedule\n");
+        return 0;
+    }
+    return 1;
+}
+
+//***************************Bus and master***********************************************
+
+typedef struct {
+    uint32_t polls;
+    uint32_t late;              /**< Polls still waiting when their next period began */
+    uint32_t bytes;
+    double latency_sum;
+    double latency_max;
+    double stretch_s;
+} sSlaveStats_t;
+
+static sSlaveStats_t slave_stats[SLAVE_COUNT];
+static double bus_busy_s = 0;
+
+static double TransactionSeconds(uint16_t bytes, double scl_hz) {
+    return (2.0 + 9.0 * (1 + bytes)) / scl_hz;     // START, address, data, STOP
+}
+
+// Runs one poll from time now on, returns when the bus is released
+static int RunPoll(sPoll_t *poll, double now, double scl_hz, double tbuf_s, double turnaround_s, double *end) {
+    sSlaveStats_t *stats = &slave_stats[poll->slave - slaves];
+    uint8_t response[BUS_SIM_MAX_FRAME];
+    double t = now, ready, read_start;
+
+    poll->slave->request(poll->command, poll->telecommand, poll->args);
+    poll->slave->write(frame, frame_size);
+    t += TransactionSeconds(frame_size, scl_hz);
+    bus_busy_s += TransactionSeconds(frame_size, scl_hz);
+    stats->bytes += frame_size;
+    frame_size = 0;
+
+    if (!poll->telecommand) {
+        uint16_t size = poll->command->frame_size;
+
+        // The slave holds SCL after its address until the response is ready
+        ready = t + poll->slave->processing_us * 1e-6;
+        read_start = t + tbuf_s + turnaround_s;
+        t = read_start + TransactionSeconds(size, scl_hz);
+        if (ready > read_start + 10.0 / scl_hz) {
+            double stretch = ready - (read_start + 10.0 / scl_hz);
+            stats->stretch_s += stretch;
+            bus_busy_s += stretch;
+            t += stretch;
+        }
+        bus_busy_s += TransactionSeconds(size, scl_hz);
+        stats->bytes += size;
+
+        poll->slave->read(response, size);
+        if (!poll->slave->check(poll->command, response))
+            return 0;
+    }
+
+    stats->polls++;
+    stats->latency_sum += t - poll->due_s;
+    if (t - poll->due_s > stats->latency_max)
+        stats->latency_max = t - poll->due_s;
+    if (now >= poll->due_s + poll->period_s)
+        stats->late++;
+
+    *end = t + tbuf_s;
+    return 1;
+}
+
+static int RunSchedule(double scl_hz, double seconds, double turnaround_us) {
+    double tbuf_s = (scl_hz > 400e3) ? 0.5e-6 : (scl_hz > 100e3) ? 1.3e-6 : 4.7e-6;
+    double now = 0, target = 0;
+    uint32_t total = 0;
+    unsigned p, s;
+
+    hostRegReset();
+    InitAppComm();
+    memset(slave_stats, 0, sizeof(slave_stats));
+    bus_busy_s = 0;
+    status_args_sent = 0;
+    for (p = 0; p < poll_count; p++) {
+        polls[p].runs = 0;
+        polls[p].due_s = 0;
+        target += 1.0 / polls[p].period_s;
+    }
+
+    for (;;) {
+        sPoll_t *next = &polls[0];
+        for (p = 1; p < poll_count; p++) {
+            if (polls[p].due_s < next->due_s)
+                next = &polls[p];
+        }
+        if (next->due_s >= seconds || now >= seconds)
+            break;
+
+        if (now < next->due_s)
+            now = next->due_s;
+        if (!RunPoll(next, now, scl_hz, tbuf_s, turnaround_us * 1e-6, &now))
+            return 0;
+        next->due_s = ++next->runs * next->period_s;
+    }
+
+    for (s = 0; s < SLAVE_COUNT; s++)
+        total += slave_stats[s].polls;
+    if (now > seconds)
+        seconds = now;      // The last poll ran over
+
+    printf("%.0f kHz SCL: %.1f polls/s (schedule %.1f), bus %.1f%% busy, %.0f polls/s with this mix at 100%%\n",
+           scl_hz / 1e3, total / seconds, target, 100.0 * bus_busy_s / seconds, total / bus_busy_s);
+    printf("  %-10s %5s %6s %8s %9s %12s %12s %5s\n", "slave", "addr", "polls", "polls/s", "bytes/s",
+           "latency avg", "latency max", "late");
+    for (s = 0; s < SLAVE_COUNT; s++) {
+        const sSlaveStats_t *st = &slave_stats[s];
+        printf("  %-10s  0x%02x %6u %8.1f %9.0f %9.1f us %9.1f us %5u\n", slaves[s].name, slaves[s].address,
+               st->polls, st->polls / seconds, st->bytes / seconds,
+               st->polls ? st->latency_sum / st->polls * 1e6 : 0, st->latency_max * 1e6, st->late);
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    static const double scl_rates[] = {100e3, 400e3, 1e6};
+    const char *path = (argc > 1 && strcmp(argv[1], "-") != 0) ? argv[1] : NULL;
+    double seconds = (argc > 2) ? strtod(argv[2], NULL) : BUS_SIM_SECONDS;
+    double turnaround_us = (argc > 3) ? strtod(argv[3], NULL) : BUS_SIM_TURNAROUND_US;
+    unsigned r, s, t;
+
+    for (s = 0; s < SLAVE_COUNT; s++) {
+        for (t = s + 1; t < SLAVE_COUNT; t++) {
+            if (slaves[s].address == slaves[t].address) {
+                fprintf(stderr, "FAIL: %s and %s share address 0x%02x\n", slaves[s].name, slaves[t].name,
+                        slaves[s].address);
+                return 1;
+            }
+        }
+    }
+    if (!LoadSchedule(path))
+        return 1;
+
+    printf("SAMV71 polling %u slaves, %u scheduled polls, %.0f s, %.0f us master turnaround\n",
+           (unsigned)SLAVE_COUNT, poll_count, seconds, turnaround_us);
+    for (r = 0; r < sizeof(scl_rates) / sizeof(scl_rates[0]); r++) {
+        if (!RunSchedule(scl_rates[r], seconds, turnaround_us))
+            return 1;
+    }
+    return 0;
+}
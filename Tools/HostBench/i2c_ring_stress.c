@@ -0,0 +1,181 @@
+/**
+ * @file i2c_ring_stress.c
+ * @brief Stress run of the I2C RX ring (DRIVERS/MSP430/I2C/i2c_ring.h).
+ *
+ * Two phases, both failing on any lost, duplicated or reordered byte:
+ *  - interleaved: one thread randomly alternates bursts of pushes and pops
+ *    against a reference model, covering every fill level and index wrap,
+ *    and checks that overflows are counted exactly
+ *  - threaded:    a producer thread (standing in for the ISR) and a consumer
+ *    thread (the main loop) run concurrently, on separate cores when the host
+ *    has them, otherwise preempting each other at arbitrary points
+ *
+ * The ring relies on volatile accesses for ordering, which is sufficient on
+ * the MSP430 and on x86 hosts.
+ *
+ * Usage: i2c_ring_stress [bytes]
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "i2c_ring.h"
+
+#define RING_STRESS_DEFAULT_BYTES   20000000u
+#define RING_STRESS_OPS             4000000u
+
+static sI2cRing_t ring;
+static uint32_t total_bytes;
+static volatile uint32_t consumer_errors = 0;
+static uint32_t producer_retries = 0;
+
+//***************************Interleaved phase***************************************************
+
+static int RunInterleaved(void) {
+    uint8_t model[I2C_RING_SIZE];
+    uint32_t model_head = 0, model_tail = 0, model_overflows = 0;
+    uint32_t rng = 0x1A2B;
+    uint8_t next_in = 0;
+    uint32_t op;
+    uint64_t push_total = 0, pushes = 0;
+    uint64_t overhead = bench_cycles_overhead();
+
+    i2cRingInit(&ring);
+
+    for (op = 0; op < RING_STRESS_OPS; op++) {
+        uint32_t r = bench_rand(&rng);
+        uint32_t burst = 1 + (r >> 8) % (I2C_RING_SIZE + 4);
+        uint32_t i;
+
+        if (r & 1) {
+            for (i = 0; i < burst; i++) {
+                uint64_t c0 = bench_cycles();
+                uint8_t ok = i2cRingPush(&ring, next_in);
+                uint64_t dt = bench_cycles() - c0;
+                dt = (dt > overhead) ? dt - overhead : 0;
+                push_total += dt;
+                pushes++;
+
+                if (model_head - model_tail == I2C_RING_SIZE) {
+                    model_overflows++;
+                    if (ok) {
+                        fprintf(stderr, "FAIL: push accepted into a full ring\n");
+                        return 0;
+                    }
+                } else {
+                    model[model_head++ % I2C_RING_SIZE] = next_in;
+                    if (!ok) {
+                        fprintf(stderr, "FAIL: push rejected with %u bytes queued\n", model_head - model_tail - 1);
+                        return 0;
+                    }
+                }
+                next_in++;
+            }
+        } else {
+            for (i = 0; i < burst; i++) {
+                uint8_t data;
+                uint8_t ok = i2cRingPeek(&ring, &data);
+                if (model_head == model_tail) {
+                    if (ok) {
+                        fprintf(stderr, "FAIL: peek returned data from an empty ring\n");
+                        return 0;
+                    }
+                    break;
+                }
+                if (!ok || data != model[model_tail % I2C_RING_SIZE]) {
+                    fprintf(stderr, "FAIL: expected 0x%02X at op %u\n", model[model_tail % I2C_RING_SIZE], op);
+                    return 0;
+                }
+                i2cRingDrop(&ring);
+                model_tail++;
+            }
+        }
+
+        if (i2cRingCount(&ring) != model_head - model_tail) {
+            fprintf(stderr, "FAIL: count %u, model %u\n", i2cRingCount(&ring), model_head - model_tail);
+            return 0;
+        }
+    }
+
+    if (ring.overflows != (uint8_t)model_overflows) {
+        fprintf(stderr, "FAIL: %u overflows counted, %u expected\n", ring.overflows, (uint8_t)model_overflows);
+        return 0;
+    }
+
+    printf("  interleaved       %u ops, %llu pushes, %u overflows\n", RING_STRESS_OPS,
+           (unsigned long long)pushes, model_overflows);
+    printf("  push cost         %.1f cycles avg per RX byte queued\n", (double)push_total / pushes);
+    return 1;
+}
+
+//***************************Threaded phase***************************************************
+
+static void *Producer(void *arg) {
+    uint32_t sent = 0;
+    (void)arg;
+    while (sent < total_bytes) {
+        if (i2cRingPush(&ring, (uint8_t)sent)) {
+            sent++;
+        } else {
+            producer_retries++;
+            sched_yield();  // Lets the consumer run on single core hosts
+        }
+    }
+    return NULL;
+}
+
+static void *Consumer(void *arg) {
+    uint32_t received = 0;
+    (void)arg;
+    while (received < total_bytes) {
+        uint8_t data;
+        if (i2cRingPeek(&ring, &data)) {
+            if (data != (uint8_t)received)
+                consumer_errors++;
+            i2cRingDrop(&ring);
+            received++;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static int RunThreaded(void) {
+    pthread_t producer, consumer;
+    double t0, t1;
+
+    i2cRingInit(&ring);
+
+    t0 = bench_seconds();
+    pthread_create(&consumer, NULL, Consumer, NULL);
+    pthread_create(&producer, NULL, Producer, NULL);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    t1 = bench_seconds();
+
+    // Rejected pushes are retried by the producer, so they are not losses
+    if (consumer_errors != 0 || i2cRingCount(&ring) != 0) {
+        fprintf(stderr, "FAIL: %u bytes out of sequence, %u left in the ring\n",
+                consumer_errors, i2cRingCount(&ring));
+        return 0;
+    }
+
+    printf("  threaded          %u bytes in order, %.1f MB/s, %u full-ring retries\n",
+           total_bytes, total_bytes / (t1 - t0) / 1e6, producer_retries);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    total_bytes = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : RING_STRESS_DEFAULT_BYTES;
+
+    printf("I2C RX ring stress (%d byte ring)\n", I2C_RING_SIZE);
+    if (!RunInterleaved())
+        return 1;
+    if (!RunThreaded())
+        return 1;
+    return 0;
+}
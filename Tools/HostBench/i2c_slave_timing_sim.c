@@ -0,0 +1,394 @@
+/**
+ * @file i2c_slave_timing_sim.c
+ * @brief Cycle-approximate timing of the PDS I2C slave at 100 kHz, 400 kHz and 1 MHz.
+ *
+ * A simulated master runs a PDS housekeeping cycle (one telecommand, then a
+ * request and a read for every channel) against the real AppComm.c, i2c.c
+ * and tinyprotocol.c. The eUSCI_B0 side is hal/eusci_b_model.c: the bus
+ * raises UCRXIFG0 / UCTXIFG0 / UCSTPIFG at the SCL edge where the hardware
+ * does, and USCI_B0_ISR reads them back through UCB0IV.
+ *
+ * Time is counted in MCLK cycles. The CPU runs one thing at a time:
+ *  - an ISR as soon as an enabled flag is pending, preempting the main loop
+ *  - otherwise the main loop, which parses the queued bytes (processI2C)
+ *  - otherwise LPM0
+ * The real ISR and processI2C() run at the point in simulated time where
+ * their cost model says they finish, and the bus sees their effect from
+ * then on. A byte cannot be received while UCB0RXBUF is still full, or sent
+ * before UCB0TXBUF is loaded: the slave holds SCL low (stretches) until the
+ * CPU catches up. A received byte that finds UCB0RXBUF full is an overrun:
+ * the eUSCI stalls the bus instead of losing it, a master that does not
+ * support stretching would lose it.
+ *
+ * The ISR's budget per byte is one byte time, 9 SCL periods: a received byte
+ * must be read before the next one is in, and the next byte to send must be
+ * loaded before the current one is out.
+ *
+ * ISR cost is an estimate built from the path the real ISR took: interrupt
+ * entry and RETI from the FR5969 user's guide, the register save and UCB0IV
+ * jump table, 3 cycles per peripheral register access (as counted by the
+ * register file) and a fixed amount of RAM work per vector. Main loop cost is
+ * a per byte estimate for TINYPROTOCOL_ParseByte and its handler. Both are
+ * #defines below, to be calibrated against a scope trace of the target.
+ *
+ * Usage: i2c_slave_timing_sim [mclk_hz] [main_cycles_per_byte] [turnaround_us]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comm_master.h"
+#include "AppComm.h"
+#include "eusci_b_model.h"
+#include "msp430_cycles.h"
+
+#define SIM_MCLK_HZ                 16e6    /**< initClockTo16MHz() */
+#define SIM_MAIN_CYCLES_PER_BYTE    120     /**< processI2C -> TINYPROTOCOL_ParseByte and handlers */
+#define SIM_TURNAROUND_US           0.0     /**< Master time between STOP and the next START, on top of tBUF */
+#define SIM_STRETCH_LIMIT_S         25e-3   /**< SMBus clock low timeout, a longer stretch is a hang */
+#define SIM_MAX_FRAME               64
+
+// CPU cost model, in MCLK cycles, on top of msp430_cycles.h
+#define ISR_RX_CYCLES               20      /**< Ring push, mode update, LPM0 exit on return */
+#define ISR_TX_HOLD_CYCLES          8       /**< Ring count check before holding off */
+#define ISR_TX_LOAD_CYCLES          45      /**< Indirect call to the telemetry byte source */
+#define ISR_STOP_CYCLES             10
+#define ISR_OTHER_CYCLES            2
+#define LPM0_WAKE_CYCLES            10
+#define MAIN_CALL_CYCLES            30      /**< processI2C entry, loop exit, UCTXIE set, LPM0 entry */
+
+void USCI_B0_ISR(void);
+
+//***************************Statistics***************************************************
+
+enum {
+    KIND_TELECOMMAND,
+    KIND_REQUEST,
+    KIND_READ,
+    KIND_COUNT
+};
+
+static const char *kind_names[KIND_COUNT] = {"telecommand write", "telemetry request", "telemetry read"};
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t isrs;
+    double isr_cycles;
+    double isr_max;
+    double latency_max;     /**< Flag raised to ISR done, worst case */
+    uint32_t stalls;        /**< Bytes the slave stretched SCL for */
+    double stretch_cycles;
+    uint32_t overruns;
+} sKindStats_t;
+
+static sKindStats_t stats[KIND_COUNT];
+static sKindStats_t *current = &stats[0];
+
+//***************************CPU**********************************************************
+
+static double main_cycles_per_byte = SIM_MAIN_CYCLES_PER_BYTE;
+
+static double cpu_now = 0;
+static uint8_t asleep = 1;
+static uint8_t job_active = 0;
+static uint8_t job_bytes = 0;
+static double job_left = 0;
+
+// When the flags were raised, and when the buffers were last serviced
+static double rx_flag_at, tx_flag_at, stop_flag_at;
+static double rx_free_at, tx_loaded_at;
+
+static double IsrPathCycles(uint16_t vector, uint8_t loaded) {
+    switch (vector) {
+        case USCI_I2C_UCRXIFG0: return ISR_RX_CYCLES;
+        case USCI_I2C_UCTXIFG0: return loaded ? ISR_TX_LOAD_CYCLES : ISR_TX_HOLD_CYCLES;
+        case USCI_I2C_UCSTPIFG: return ISR_STOP_CYCLES;
+        default:                return ISR_OTHER_CYCLES;
+    }
+}
+
+static void RunIsr(void) {
+    uint8_t rx_was_full = eusciModelRxFull();
+    uint8_t tx_was_loaded = eusciModelTxLoaded();
+    uint32_t accesses = host_reg_accesses;
+    double cycles, raised;
+    uint16_t vector;
+
+    if (asleep)
+        cpu_now += LPM0_WAKE_CYCLES;
+    asleep = 0;
+
+    USCI_B0_ISR();
+    hostRegSync();
+    accesses = host_reg_accesses - accesses;
+    vector = HOST_REG16(EUSCI_B0_BASE + OFS_UCBxIV);
+
+    cycles = ISR_ACCEPT_CYCLES + ISR_FRAME_CYCLES + ISR_RETURN_CYCLES +
+             accesses * ISR_REG_ACCESS_CYCLES +
+             IsrPathCycles(vector, !tx_was_loaded && eusciModelTxLoaded());
+    cpu_now += cycles;
+
+    if (rx_was_full && !eusciModelRxFull())
+        rx_free_at = cpu_now;
+    if (!tx_was_loaded && eusciModelTxLoaded())
+        tx_loaded_at = cpu_now;
+
+    raised = (vector == USCI_I2C_UCRXIFG0) ? rx_flag_at :
+             (vector == USCI_I2C_UCTXIFG0) ? tx_flag_at : stop_flag_at;
+    current->isrs++;
+    current->isr_cycles += cycles;
+    if (cycles > current->isr_max)
+        current->isr_max = cycles;
+    if (cpu_now - raised > current->latency_max)
+        current->latency_max = cpu_now - raised;
+}
+
+// Runs the CPU up to a point in time. An ISR is never split, so the CPU can
+// end up past it.
+static void CpuRun(double until) {
+    while (cpu_now < until) {
+        if (eusciModelInterruptPending()) {
+            RunIsr();
+            continue;
+        }
+
+        if (!job_active && i2cRxPending() != 0) {
+            job_active = 1;
+            job_bytes = i2cRxPending();
+            job_left = MAIN_CALL_CYCLES + job_bytes * main_cycles_per_byte;
+        }
+
+        if (!job_active) {
+            asleep = 1;
+            cpu_now = until;
+            break;
+        }
+
+        if (job_left > until - cpu_now) {
+            job_left -= until - cpu_now;
+            cpu_now = until;
+            break;
+        }
+        cpu_now += job_left;
+        job_left = 0;
+
+        // processI2C keeps going while bytes keep arriving
+        if (i2cRxPending() > job_bytes) {
+            job_left = (i2cRxPending() - job_bytes) * main_cycles_per_byte;
+            job_bytes = i2cRxPending();
+            continue;
+        }
+        ProcessAppComm();
+        job_active = 0;
+    }
+}
+
+//***************************Bus**********************************************************
+
+static double mclk_hz = SIM_MCLK_HZ;
+static double bit_cycles;           /**< One SCL period */
+static double bus_free_cycles;      /**< tBUF plus the master turnaround */
+static double bus_now = 0;
+
+// Holds SCL until the CPU has serviced the buffer, returns false on a hang
+static int Stretch(uint8_t (*ready)(void), const double *ready_at) {
+    double due = bus_now;
+
+    CpuRun(bus_now);
+    while (!ready()) {
+        if (cpu_now - due > SIM_STRETCH_LIMIT_S * mclk_hz) {
+            fprintf(stderr, "FAIL: slave held SCL for more than %.0f ms\n", SIM_STRETCH_LIMIT_S * 1e3);
+            return 0;
+        }
+        CpuRun(cpu_now + 1);
+    }
+
+    if (*ready_at > due) {
+        current->stalls++;
+        current->stretch_cycles += *ready_at - due;
+        bus_now = *ready_at;
+    }
+    return 1;
+}
+
+static uint8_t RxBufferFree(void) {
+    return !eusciModelRxFull();
+}
+
+static int BusWrite(const uint8_t *data, uint8_t size) {
+    uint8_t i;
+
+    current->transactions++;
+    current->bytes += size;
+
+    bus_now += bus_free_cycles + bit_cycles + 9 * bit_cycles;   // START, address, ACK
+    CpuRun(bus_now);
+    eusciModelStart(0);
+
+    for (i = 0; i < size; i++) {
+        bus_now += 8 * bit_cycles;
+        CpuRun(bus_now);
+        if (eusciModelRxFull()) {
+            current->overruns++;
+            if (!Stretch(RxBufferFree, &rx_free_at))
+                return 0;
+        }
+        eusciModelReceive(data[i]);
+        rx_flag_at = bus_now;
+        bus_now += bit_cycles;                                  // ACK
+    }
+
+    bus_now += bit_cycles;                                      // STOP
+    CpuRun(bus_now);
+    eusciModelStop();
+    stop_flag_at = bus_now;
+    return 1;
+}
+
+static int BusRead(uint8_t *data, uint16_t size) {
+    uint16_t i;
+
+    current->transactions++;
+    current->bytes += size;
+
+    bus_now += bus_free_cycles + bit_cycles + 9 * bit_cycles;   // START, address, ACK
+    CpuRun(bus_now);
+    eusciModelStart(1);
+    tx_flag_at = bus_now;
+
+    for (i = 0; i < size; i++) {
+        if (!Stretch(eusciModelTxLoaded, &tx_loaded_at))
+            return 0;
+        eusciModelTransmit(&data[i]);
+        tx_flag_at = bus_now;
+        bus_now += 9 * bit_cycles;                              // 8 bits, master ACK / NACK
+    }
+
+    bus_now += bit_cycles;                                      // STOP
+    CpuRun(bus_now);
+    eusciModelStop();
+    stop_flag_at = bus_now;
+    return 1;
+}
+
+//***************************Master*******************************************************
+
+static uint8_t frame[SIM_MAX_FRAME];
+static uint8_t frame_size = 0;
+
+static int16_t CaptureFrame(const uint8_t* buffer, uint8_t size) {
+    memcpy(&frame[frame_size], buffer, size);
+    frame_size += size;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static const struct TINYPROTOCOL_Config masterConfig = {
+    .TINYPROTOCOL_WriteBuffer = CaptureFrame
+};
+
+static int SendCaptured(int kind) {
+    int ok;
+    current = &stats[kind];
+    ok = BusWrite(frame, frame_size);
+    frame_size = 0;
+    return ok;
+}
+
+static int RunCycle(double scl_hz, double turnaround_us) {
+#define PDS_SIM_CHANNEL(ID, Name, cmd_len, resp_len)    {#ID, PDS_Request##Name, ID##_RESP_FRAME_LEN},
+    static const struct {
+        const char *name;
+        int16_t (*request)(const struct TINYPROTOCOL_Config *cfg);
+        uint16_t frame_len;
+    } channels[] = {
+        PDS_COMMANDS(PDS_SIM_CHANNEL)
+    };
+    static const uint8_t status_args[SYSTEM_STATUS_CMD_LEN] = {0x5A, 0xA5};
+    uint8_t response[SIM_MAX_FRAME];
+    unsigned c;
+
+    hostRegReset();
+    eusciModelInit();
+    InitAppComm();
+    memset(stats, 0, sizeof(stats));
+    cpu_now = bus_now = 0;
+    asleep = 1;
+    job_active = 0;
+    bit_cycles = mclk_hz / scl_hz;
+    bus_free_cycles = ((scl_hz > 400e3) ? 0.5e-6 : (scl_hz > 100e3) ? 1.3e-6 : 4.7e-6) * mclk_hz +
+                      turnaround_us * 1e-6 * mclk_hz;
+
+    PDS_SendSystemStatus(&masterConfig, status_args);
+    if (!SendCaptured(KIND_TELECOMMAND))
+        return 0;
+
+    for (c = 0; c < sizeof(channels) / sizeof(channels[0]); c++) {
+        uint16_t size = channels[c].frame_len;
+
+        channels[c].request(&masterConfig);
+        if (!SendCaptured(KIND_REQUEST))
+            return 0;
+
+        current = &stats[KIND_READ];
+        if (!BusRead(response, size))
+            return 0;
+
+        if (TINYPROTOCOL_CalculateCRC(response, (uint8_t)(size - 1)) != response[size - 1]) {
+            fprintf(stderr, "FAIL: %s response has a bad CRC at %.0f kHz\n", channels[c].name, scl_hz / 1e3);
+            return 0;
+        }
+        if (channels[c].request == PDS_RequestSystemStatus &&
+            (response[3] != status_args[0] || response[4] != status_args[1])) {
+            fprintf(stderr, "FAIL: system status telecommand did not reach the slave\n");
+            return 0;
+        }
+    }
+
+    // Let the last STOP be serviced
+    CpuRun(bus_now + 9 * bit_cycles);
+    return 1;
+}
+
+static void PrintCycle(double scl_hz) {
+    double budget = 9 * bit_cycles;
+    double stretched = 0;
+    uint32_t overruns = 0;
+    int k;
+
+    printf("%.0f kHz SCL, %.1f MHz MCLK: %.0f cycle byte budget, cycle done in %.1f us\n",
+           scl_hz / 1e3, mclk_hz / 1e6, budget, bus_now / mclk_hz * 1e6);
+    printf("  %-18s %5s %6s %5s %8s %8s %11s %7s %10s %9s\n", "transaction", "count", "bytes", "isrs",
+           "isr avg", "isr max", "worst done", "stalls", "stretch us", "overruns");
+    for (k = 0; k < KIND_COUNT; k++) {
+        const sKindStats_t *s = &stats[k];
+        printf("  %-18s %5u %6u %5u %8.1f %8.0f %5.0f (%2.0f%%) %7u %10.1f %9u\n", kind_names[k],
+               s->transactions, s->bytes, s->isrs, s->isrs ? s->isr_cycles / s->isrs : 0, s->isr_max,
+               s->latency_max, 100.0 * s->latency_max / budget, s->stalls, s->stretch_cycles / mclk_hz * 1e6,
+               s->overruns);
+        stretched += s->stretch_cycles;
+        overruns += s->overruns;
+    }
+    printf("  stretched %.1f%% of the cycle, %u overruns\n", 100.0 * stretched / bus_now, overruns);
+}
+
+int main(int argc, char **argv) {
+    static const double scl_rates[] = {100e3, 400e3, 1e6};
+    double turnaround_us;
+    unsigned r;
+
+    mclk_hz = (argc > 1) ? strtod(argv[1], NULL) : SIM_MCLK_HZ;
+    main_cycles_per_byte = (argc > 2) ? strtod(argv[2], NULL) : SIM_MAIN_CYCLES_PER_BYTE;
+    turnaround_us = (argc > 3) ? strtod(argv[3], NULL) : SIM_TURNAROUND_US;
+
+    printf("PDS I2C slave timing, %.0f main loop cycles per byte, %.1f us master turnaround\n",
+           main_cycles_per_byte, turnaround_us);
+
+    for (r = 0; r < sizeof(scl_rates) / sizeof(scl_rates[0]); r++) {
+        if (!RunCycle(scl_rates[r], turnaround_us))
+            return 1;
+        PrintCycle(scl_rates[r]);
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+/**
+ * @file large_frame_bench.c
+ * @brief Framing overhead and parse cost of large frames vs 11 byte fragments.
+ *
+ * Payloads of growing size are sent to the parser twice: split into small
+ * telecommands of at most TINYPROTOCOL_MAX_PAYLOAD_SIZE bytes (what the
+ * application had to do so far), and as one large frame. Both must deliver
+ * the same bytes. The run then checks that a corrupted or oversized large
+ * frame is rejected, and that a large telemetry channel is answered with its
+ * length and a valid CRC, alone and inside a burst.
+ *
+ * Usage: large_frame_bench [repetitions]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "tinyprotocol.h"
+
+#define LARGE_BENCH_REPETITIONS 2000u
+#define LARGE_BENCH_TC_SMALL    TINYPROTOCOL_TC_RESERVED
+#define LARGE_BENCH_TC_LARGE    (TINYPROTOCOL_TC_RESERVED + 1)
+#define LARGE_BENCH_TLM_SMALL   TINYPROTOCOL_TLM_RESERVED
+#define LARGE_BENCH_TLM_LARGE   (TINYPROTOCOL_TLM_RESERVED + 1)
+#define LARGE_BENCH_TLM_SIZE    300
+#define LARGE_BENCH_MAX_STREAM  (2 * TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE)
+
+static uint8_t stream[LARGE_BENCH_MAX_STREAM];
+static size_t stream_len = 0;
+
+static uint8_t large_rx[TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE];
+static uint8_t received[TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE];
+static size_t received_len = 0;
+static uint32_t large_received = 0;
+
+static uint8_t tlm_small[TINYPROTOCOL_MAX_PAYLOAD_SIZE];
+static uint8_t tlm_large[LARGE_BENCH_TLM_SIZE];
+
+static int16_t StreamWriteBuffer(const uint8_t* buffer, uint8_t size) {
+    memcpy(&stream[stream_len], buffer, size);
+    stream_len += size;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static const struct TINYPROTOCOL_Config masterConfig = {
+    .TINYPROTOCOL_WriteBuffer = StreamWriteBuffer
+};
+
+// Reassembles whatever arrives, fragments and large frames alike
+static int16_t CollectTelecommand(uint8_t command, const uint8_t* buffer, uint16_t size) {
+    if (command == LARGE_BENCH_TC_LARGE)
+        large_received++;
+    memcpy(&received[received_len], buffer, size);
+    received_len += size;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static int16_t KeepTelemetryRequest(uint8_t command) {
+    (void)command;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static const struct TINYPROTOCOL_Config slaveConfig = {
+    .TINYPROTOCOL_ProcessTelecommand = CollectTelecommand,
+    .TINYPROTOCOL_ProcessTelemetryRequest = KeepTelemetryRequest
+};
+
+static uint64_t ParseStream(void) {
+    uint64_t c0 = bench_cycles();
+    size_t i;
+    for (i = 0; i < stream_len; i++)
+        TINYPROTOCOL_ParseByte(&slaveConfig, stream[i]);
+    return bench_cycles() - c0;
+}
+
+// Small telecommands have a fixed size, so the last fragment is zero padded
+static void EncodeFragmented(const uint8_t *payload, uint16_t size) {
+    uint8_t fragment[TINYPROTOCOL_MAX_PAYLOAD_SIZE];
+    uint16_t offset;
+
+    stream_len = 0;
+    for (offset = 0; offset < size; offset += TINYPROTOCOL_MAX_PAYLOAD_SIZE) {
+        uint16_t chunk = size - offset;
+        if (chunk > TINYPROTOCOL_MAX_PAYLOAD_SIZE)
+            chunk = TINYPROTOCOL_MAX_PAYLOAD_SIZE;
+        memset(fragment, 0, sizeof(fragment));
+        memcpy(fragment, &payload[offset], chunk);
+        TINYPROTOCOL_SendTelecommand(&masterConfig, LARGE_BENCH_TC_SMALL, fragment, sizeof(fragment));
+    }
+}
+
+// TINYPROTOCOL_CalculateCRC stops at 255 bytes
+static uint8_t LongCRC(const uint8_t *buffer, size_t size) {
+    uint8_t crc = crc_init_value;
+    size_t i;
+    for (i = 0; i < size; i++)
+        crc = crc_lookup_table[buffer[i] ^ crc];
+    return crc ^ crc_xor_value;
+}
+
+static int RunSizes(uint32_t repetitions) {
+    static const uint16_t sizes[] = {11, 16, 64, 255, 512, TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE};
+    static uint8_t payload[TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE];
+    uint32_t rng = 0x1A46E;
+    unsigned s;
+
+    printf("telecommand payload delivery, fragmented into %d byte frames vs one large frame (cyc/B per payload byte)\n",
+           TINYPROTOCOL_MAX_PAYLOAD_SIZE);
+    printf("  %7s  %10s %10s %12s  %10s %10s %12s\n", "payload",
+           "frag bytes", "frag eff", "frag cyc/B", "large bytes", "large eff", "large cyc/B");
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint16_t size = sizes[s];
+        size_t frag_len = 0, large_len = 0;
+        uint64_t frag_best = UINT64_MAX, large_best = UINT64_MAX;
+        uint32_t r;
+        uint16_t i;
+
+        for (i = 0; i < size; i++)
+            payload[i] = (uint8_t)bench_rand(&rng);
+
+        for (r = 0; r < repetitions; r++) {
+            uint64_t dt;
+
+            EncodeFragmented(payload, size);
+            frag_len = stream_len;
+            received_len = 0;
+            dt = ParseStream();
+            if (dt < frag_best)
+                frag_best = dt;
+            if (received_len < size || memcmp(received, payload, size) != 0) {
+                fprintf(stderr, "FAIL: fragmented %u byte payload not delivered intact\n", size);
+                return 0;
+            }
+
+            stream_len = 0;
+            TINYPROTOCOL_SendLargeTelecommand(&masterConfig, LARGE_BENCH_TC_LARGE, payload, size);
+            large_len = stream_len;
+            received_len = 0;
+            dt = ParseStream();
+            if (dt < large_best)
+                large_best = dt;
+            if (received_len != size || memcmp(received, payload, size) != 0) {
+                fprintf(stderr, "FAIL: large %u byte payload not delivered intact\n", size);
+                return 0;
+            }
+        }
+
+        printf("  %7u  %10zu %9.1f%% %12.2f  %10zu %9.1f%% %12.2f\n", size,
+               frag_len, 100.0 * size / frag_len, (double)frag_best / size,
+               large_len, 100.0 * size / large_len, (double)large_best / size);
+    }
+    return 1;
+}
+
+static int RunRejects(void) {
+    uint8_t payload[64] = {0};
+    uint32_t before = large_received;
+
+    // Single bit flip in the payload
+    stream_len = 0;
+    TINYPROTOCOL_SendLargeTelecommand(&masterConfig, LARGE_BENCH_TC_LARGE, payload, sizeof(payload));
+    stream[20] ^= 0x10;
+    ParseStream();
+
+    // Declared length above the registered buffer
+    stream_len = 0;
+    TINYPROTOCOL_SendLargeTelecommand(&masterConfig, LARGE_BENCH_TC_LARGE, large_rx, sizeof(large_rx));
+    stream[2] = 0xFF;
+    stream[3] = 0xFF;
+    stream_len = 4;
+    ParseStream();
+
+    if (large_received != before) {
+        fprintf(stderr, "FAIL: corrupted or oversized large frame was accepted\n");
+        return 0;
+    }
+
+    // The parser must be back in sync for the next frame
+    stream_len = 0;
+    TINYPROTOCOL_SendLargeTelecommand(&masterConfig, LARGE_BENCH_TC_LARGE, payload, sizeof(payload));
+    ParseStream();
+    if (large_received != before + 1) {
+        fprintf(stderr, "FAIL: parser lost sync after a rejected large frame\n");
+        return 0;
+    }
+
+    printf("  corrupted and oversized large frames rejected\n");
+    return 1;
+}
+
+static int ReadTelemetry(uint8_t *response, int16_t expected_size) {
+    int16_t size = TINYPROTOCOL_TelemetryBytesLeft();
+    int16_t i;
+
+    if (size != expected_size) {
+        fprintf(stderr, "FAIL: response is %d bytes, %d expected\n", size, expected_size);
+        return 0;
+    }
+    for (i = 0; i < size; i++)
+        TINYPROTOCOL_ReadNextTelemetryByte(&response[i]);
+    return 1;
+}
+
+static int RunTelemetry(void) {
+    static uint8_t response[LARGE_BENCH_TLM_SIZE + TINYPROTOCOL_MAX_PAYLOAD_SIZE + 3];
+    static uint8_t expected[sizeof(response)];
+    const uint8_t burst[2] = {LARGE_BENCH_TLM_SMALL, LARGE_BENCH_TLM_LARGE};
+    uint32_t rng = 0x5EED;
+    unsigned i;
+
+    for (i = 0; i < sizeof(tlm_small); i++)
+        tlm_small[i] = (uint8_t)bench_rand(&rng);
+    for (i = 0; i < sizeof(tlm_large); i++)
+        tlm_large[i] = (uint8_t)bench_rand(&rng);
+
+    // Alone: length, payload, CRC over both
+    expected[0] = (uint8_t)LARGE_BENCH_TLM_SIZE;
+    expected[1] = (uint8_t)(LARGE_BENCH_TLM_SIZE >> 8);
+    memcpy(&expected[2], tlm_large, LARGE_BENCH_TLM_SIZE);
+
+    stream_len = 0;
+    TINYPROTOCOL_SendTelemetryRequest(&masterConfig, LARGE_BENCH_TLM_LARGE);
+    ParseStream();
+    if (!ReadTelemetry(response, LARGE_BENCH_TLM_SIZE + 3))
+        return 0;
+    if (memcmp(response, expected, LARGE_BENCH_TLM_SIZE + 2) != 0 ||
+        response[LARGE_BENCH_TLM_SIZE + 2] != LongCRC(expected, LARGE_BENCH_TLM_SIZE + 2)) {
+        fprintf(stderr, "FAIL: large channel returned the wrong bytes\n");
+        return 0;
+    }
+
+    // In a burst: the small channel, then the large one with its length
+    memcpy(expected, tlm_small, sizeof(tlm_small));
+    expected[sizeof(tlm_small)] = (uint8_t)LARGE_BENCH_TLM_SIZE;
+    expected[sizeof(tlm_small) + 1] = (uint8_t)(LARGE_BENCH_TLM_SIZE >> 8);
+    memcpy(&expected[sizeof(tlm_small) + 2], tlm_large, LARGE_BENCH_TLM_SIZE);
+
+    stream_len = 0;
+    TINYPROTOCOL_SendTelemetryBurstRequest(&masterConfig, burst, 2);
+    ParseStream();
+    if (!ReadTelemetry(response, sizeof(tlm_small) + LARGE_BENCH_TLM_SIZE + 3))
+        return 0;
+    if (memcmp(response, expected, sizeof(tlm_small) + LARGE_BENCH_TLM_SIZE + 2) != 0 ||
+        response[sizeof(tlm_small) + LARGE_BENCH_TLM_SIZE + 2] != LongCRC(expected, sizeof(tlm_small) + LARGE_BENCH_TLM_SIZE + 2)) {
+        fprintf(stderr, "FAIL: burst with a large channel returned the wrong bytes\n");
+        return 0;
+    }
+
+    printf("  %d byte telemetry channel answered alone and in a burst\n", LARGE_BENCH_TLM_SIZE);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    uint32_t repetitions = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : LARGE_BENCH_REPETITIONS;
+
+    TINYPROTOCOL_Initialize();
+    TINYPROTOCOL_RegisterTelecommand(LARGE_BENCH_TC_SMALL, TINYPROTOCOL_MAX_PAYLOAD_SIZE);
+    TINYPROTOCOL_RegisterLargeTelecommand(LARGE_BENCH_TC_LARGE, large_rx, sizeof(large_rx));
+    TINYPROTOCOL_RegisterTelemetryChannel(LARGE_BENCH_TLM_SMALL, tlm_small, sizeof(tlm_small));
+    TINYPROTOCOL_RegisterLargeTelemetryChannel(LARGE_BENCH_TLM_LARGE, tlm_large, sizeof(tlm_large));
+
+    if (!RunSizes(repetitions))
+        return 1;
+    if (!RunRejects())
+        return 1;
+    if (!RunTelemetry())
+        return 1;
+    return 0;
+}
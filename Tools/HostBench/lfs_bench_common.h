@@ -0,0 +1,107 @@
+/**
+ * @file lfs_bench_common.h
+ * @brief Power-loss workload shared by the littlefs benchmarks.
+ *
+ * The workload appends records to "pl/log" and creates a file in "pl" after
+ * every fourth record, closing each before the next. It counts what it has
+ * closed, so that after the power is cut and the filesystem mounted again
+ * lfs_bench_powerloss_check() can require all of it to be there. Record n is
+ * LFS_BENCH_RECORD bytes of the value n.
+ */
+
+#ifndef _LFS_BENCH_COMMON_
+#define _LFS_BENCH_COMMON_
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "lfs/lfs.h"
+#include "lfs_hostbd.h"
+
+#define LFS_BENCH_RECORD        32u
+#define LFS_BENCH_RECORDS       64u     /**< Records in a workload run without a cut */
+
+typedef struct {
+    uint32_t records;
+    uint32_t files;
+} lfs_bench_closed_t;
+
+/**
+ * @brief Formats, mounts and creates the "pl" directory.
+ * @return 0 on success, a littlefs error otherwise
+ */
+static inline int lfs_bench_powerloss_format(lfs_t *lfs, const struct lfs_config *cfg)
+{
+    int err = lfs_format(lfs, cfg);
+    if (!err)
+        err = lfs_mount(lfs, cfg);
+    if (!err)
+        err = lfs_mkdir(lfs, "pl");
+    return err;
+}
+
+/**
+ * @brief Runs the workload until it is done or bd loses power.
+ */
+static inline void lfs_bench_powerloss_workload(lfs_t *lfs, const lfs_hostbd_t *bd, lfs_bench_closed_t *closed)
+{
+    uint8_t record[LFS_BENCH_RECORD];
+    lfs_file_t file;
+    char name[32];
+
+    closed->records = 0;
+    closed->files = 0;
+    for (uint32_t i = 0; bd->powered && i < LFS_BENCH_RECORDS; i++) {
+        if (lfs_file_open(lfs, &file, "pl/log", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND))
+            return;
+        memset(record, (uint8_t)closed->records, sizeof(record));
+        lfs_file_write(lfs, &file, record, sizeof(record));
+        if (lfs_file_close(lfs, &file) || !bd->powered)
+            return;
+        closed->records++;
+
+        if (i % 4 == 3) {
+            snprintf(name, sizeof(name), "pl/f%u", (unsigned)closed->files);
+            if (lfs_file_open(lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT))
+                return;
+            lfs_file_write(lfs, &file, name, sizeof(name));
+            if (lfs_file_close(lfs, &file) || !bd->powered)
+                return;
+            closed->files++;
+        }
+    }
+}
+
+/**
+ * @brief Checks that every record and file closed before the cut is there.
+ *
+ * FAILs on the first problem found.
+ */
+static inline void lfs_bench_powerloss_check(lfs_t *lfs, const lfs_bench_closed_t *closed, unsigned trial)
+{
+    static uint8_t data[LFS_BENCH_RECORDS * LFS_BENCH_RECORD];
+    struct lfs_info info;
+    lfs_ssize_t size = 0;
+    lfs_file_t file;
+    char name[32];
+
+    if (lfs_file_open(lfs, &file, "pl/log", LFS_O_RDONLY) == 0) {
+        size = lfs_file_read(lfs, &file, data, sizeof(data));
+        lfs_file_close(lfs, &file);
+        for (lfs_ssize_t i = 0; i < size; i++) {
+            if (data[i] != (uint8_t)(i / LFS_BENCH_RECORD))
+                FAIL("power loss %u: log byte %d", trial, (int)i);
+        }
+    }
+    if (size < (lfs_ssize_t)(closed->records * LFS_BENCH_RECORD) || size % LFS_BENCH_RECORD)
+        FAIL("power loss %u: log of %d bytes, %u records were closed", trial, (int)size,
+             (unsigned)closed->records);
+    for (uint32_t i = 0; i < closed->files; i++) {
+        snprintf(name, sizeof(name), "pl/f%u", (unsigned)i);
+        if (lfs_stat(lfs, name, &info))
+            FAIL("power loss %u: %s lost", trial, name);
+    }
+}
+
+#endif // _LFS_BENCH_COMMON_
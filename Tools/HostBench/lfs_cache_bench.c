@@ -0,0 +1,440 @@
+/**
+ * @file lfs_cache_bench.c
+ * @brief Write-back page cache under littlefs: coherence, power loss and
+ *        SPI transactions per filesystem operation.
+ *
+ * Tools/MramLittleFsPicoDemo/lfs_cachebd.c sits between littlefs and the
+ * block device below. The bench checks it three ways:
+ *  - random reads, programs, erases and syncs go through the cache to a
+ *    small lfs_hostbd. Reads must return what was last programmed, and after
+ *    each sync the device must hold it too;
+ *  - littlefs on the cache over lfs_hostbd has the power cut at random
+ *    programs, as in lfs_suite_bench. After the reboot, with the cache lost,
+ *    every record and file closed before the cut must be there;
+ *  - littlefs with the MRAM profile runs on lfs_mrambd over the SPI MRAM
+ *    model, straight and through the cache. Per filesystem operation it
+ *    prints the SPI transactions (CS assertions) and bus time, and fails if
+ *    the cache takes more transactions for any operation. A last table reads
+ *    a file in small pieces with smaller littlefs caches, where read-ahead
+ *    pays.
+ *
+ * Usage: lfs_cache_bench [sck_hz]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "spi_mram_model.h"
+#include "lfs_hostbd.h"
+#include "lfs_mrambd.h"
+#include "lfs_cachebd.h"
+#include "lfs_bench_common.h"
+
+#define LFS_CACHE_SCK_HZ            20000000u
+#define LFS_CACHE_CHECK_BLOCKS      64u
+#define LFS_CACHE_CHECK_OPS         200000u
+#define LFS_CACHE_POWER_LOSSES      100u
+#define LFS_CACHE_RECORD            32u
+#define LFS_CACHE_FILES             100u    /**< Files in the directory before the cases */
+#define LFS_CACHE_FILE_SIZE         24u     /**< Inline */
+#define LFS_CACHE_BIG_SIZE          8192u
+
+static uint32_t seed = 0xCAC4Eu;
+
+static lfs_t lfs;
+
+//***************************Coherence***************************************************
+
+static void Coherence(void) {
+    static uint8_t ref[LFS_CACHE_CHECK_BLOCKS * LFS_MRAMBD_BLOCK_SIZE];
+    static uint8_t known[sizeof(ref)];      // Bytes programmed since their erase
+    static const struct lfs_hostbd_config hostCfg = {.path = NULL, .erase_value = -1};
+    static struct lfs_cachebd_config cacheCfg = {.page_size = 64, .page_count = 8, .read_ahead = 2};
+    uint8_t data[LFS_MRAMBD_BLOCK_SIZE], check[LFS_MRAMBD_BLOCK_SIZE];
+    struct lfs_config hostLfs, cacheLfs;
+    lfs_hostbd_t host;
+    lfs_cachebd_t cache;
+    lfs_mrambd_t unused;
+    uint32_t syncs = 0;
+
+    lfs_mrambd_profile(&hostLfs, &unused);
+    hostLfs.context = &host;
+    hostLfs.read = lfs_hostbd_read;
+    hostLfs.prog = lfs_hostbd_prog;
+    hostLfs.erase = lfs_hostbd_erase;
+    hostLfs.sync = lfs_hostbd_sync;
+    hostLfs.block_count = LFS_CACHE_CHECK_BLOCKS;
+    if (lfs_hostbd_create(&hostLfs, &hostCfg))
+        FAIL("lfs_hostbd_create");
+    cacheCfg.bd = &hostLfs;
+    lfs_cachebd_wrap(&cacheLfs, &cache, &hostLfs);
+    if (lfs_cachebd_create(&cacheLfs, &cacheCfg))
+        FAIL("lfs_cachebd_create");
+
+    for (uint32_t i = 0; i < LFS_CACHE_CHECK_OPS; i++) {
+        uint32_t op = bench_rand(&seed) % 100;
+        // A few blocks at first, so pages are hit and evicted dirty, then more
+        lfs_block_t block = bench_rand(&seed) % (4 + i / (LFS_CACHE_CHECK_OPS / 60));
+        lfs_off_t off = bench_rand(&seed) % LFS_MRAMBD_BLOCK_SIZE;
+        lfs_size_t size = 1 + bench_rand(&seed) % ((op & 1) ? 16 : LFS_MRAMBD_BLOCK_SIZE - off);
+        uint32_t addr = block * LFS_MRAMBD_BLOCK_SIZE + off;
+
+        size = lfs_min(size, LFS_MRAMBD_BLOCK_SIZE - off);
+
+        if (op < 45) {
+            if (lfs_cachebd_read(&cacheLfs, block, off, data, size))
+                FAIL("read");
+            for (lfs_size_t j = 0; j < size; j++)
+                if (known[addr + j] && data[j] != ref[addr + j])
+                    FAIL("op %u: read of block %u at %u: byte %u differs", (unsigned)i, (unsigned)block,
+                         (unsigned)off, (unsigned)j);
+        } else if (op < 88) {
+            for (lfs_size_t j = 0; j < size; j++)
+                data[j] = (uint8_t)bench_rand(&seed);
+            if (lfs_cachebd_prog(&cacheLfs, block, off, data, size))
+                FAIL("prog");
+            memcpy(&ref[addr], data, size);
+            memset(&known[addr], 1, size);
+        } else if (op < 90) {
+            if (lfs_cachebd_erase(&cacheLfs, block))
+                FAIL("erase");
+            memset(&known[block * LFS_MRAMBD_BLOCK_SIZE], 0, LFS_MRAMBD_BLOCK_SIZE);
+        } else {
+            if (lfs_cachebd_sync(&cacheLfs))
+                FAIL("sync");
+            for (lfs_block_t b = 0; b < LFS_CACHE_CHECK_BLOCKS; b++) {
+                lfs_hostbd_read(&hostLfs, b, 0, check, LFS_MRAMBD_BLOCK_SIZE);
+                for (lfs_size_t j = 0; j < LFS_MRAMBD_BLOCK_SIZE; j++)
+                    if (known[b * LFS_MRAMBD_BLOCK_SIZE + j] && check[j] != ref[b * LFS_MRAMBD_BLOCK_SIZE + j])
+                        FAIL("op %u: after sync, block %u byte %u differs on the device", (unsigned)i,
+                             (unsigned)b, (unsigned)j);
+            }
+            syncs++;
+        }
+    }
+
+    printf("%u random reads, programs, erases and syncs through 8 pages of 64 B: reads match,"
+           " the device matches after each of %u syncs\n", LFS_CACHE_CHECK_OPS, (unsigned)syncs);
+    lfs_cachebd_destroy(&cacheLfs);
+    lfs_hostbd_destroy(&hostLfs);
+}
+
+//***************************Power loss**************************************************
+
+static lfs_hostbd_t host;
+static struct lfs_config hostLfs;
+static lfs_cachebd_t cache;
+static struct lfs_config cacheLfs;
+static const struct lfs_cachebd_config defaultCache = {
+    .bd = NULL,
+    .page_size = LFS_CACHEBD_PAGE_SIZE,
+    .page_count = LFS_CACHEBD_PAGE_COUNT,
+    .read_ahead = LFS_CACHEBD_READ_AHEAD,
+};
+
+// Boots with an empty cache, as after a reset
+static void Boot(struct lfs_cachebd_config *cfg) {
+    lfs_cachebd_wrap(&cacheLfs, &cache, &hostLfs);
+    if (lfs_cachebd_create(&cacheLfs, cfg))
+        FAIL("lfs_cachebd_create");
+}
+
+static void PowerLoss(void) {
+    static const struct lfs_hostbd_config hostCfg = {.path = NULL, .erase_value = -1};
+    struct lfs_cachebd_config cacheCfg = defaultCache;
+    uint32_t programs, cuts = 0;
+    lfs_bench_closed_t closed;
+    lfs_mrambd_t unused;
+
+    lfs_mrambd_profile(&hostLfs, &unused);
+    hostLfs.context = &host;
+    hostLfs.read = lfs_hostbd_read;
+    hostLfs.prog = lfs_hostbd_prog;
+    hostLfs.erase = lfs_hostbd_erase;
+    hostLfs.sync = lfs_hostbd_sync;
+    if (lfs_hostbd_create(&hostLfs, &hostCfg))
+        FAIL("lfs_hostbd_create");
+    cacheCfg.bd = &hostLfs;
+
+    // Programs the whole workload takes below the cache, each trial cuts within them
+    Boot(&cacheCfg);
+    if (lfs_bench_powerloss_format(&lfs, &cacheLfs))
+        FAIL("power loss: format");
+    lfs_hostbd_clearstats(&host);
+    lfs_bench_powerloss_workload(&lfs, &host, &closed);
+    programs = lfs_hostbd_stats(&host)->progs;
+    lfs_unmount(&lfs);
+    lfs_cachebd_destroy(&cacheLfs);
+
+    for (uint32_t trial = 0; trial < LFS_CACHE_POWER_LOSSES; trial++) {
+        Boot(&cacheCfg);
+        if (lfs_bench_powerloss_format(&lfs, &cacheLfs))
+            FAIL("power loss: format");
+
+        lfs_hostbd_setpowercycles(&host, 1 + bench_rand(&seed) % programs);
+        lfs_bench_powerloss_workload(&lfs, &host, &closed);
+        cuts += !host.powered;
+
+        // Reboot: the lfs_t and the cache in RAM are lost, only the image is left
+        lfs_cachebd_destroy(&cacheLfs);
+        lfs_hostbd_poweron(&host);
+        Boot(&cacheCfg);
+        if (lfs_mount(&lfs, &cacheLfs))
+            FAIL("power loss %u: mount", (unsigned)trial);
+        if (lfs_fs_mkconsistent(&lfs))
+            FAIL("power loss %u: mkconsistent", (unsigned)trial);
+
+        lfs_bench_powerloss_check(&lfs, &closed, (unsigned)trial);
+        lfs_unmount(&lfs);
+        lfs_cachebd_destroy(&cacheLfs);
+    }
+
+    printf("%u power cuts at random in the %u programs of a workload (%u during it):"
+           " every closed record and file kept\n", LFS_CACHE_POWER_LOSSES, (unsigned)programs, (unsigned)cuts);
+    lfs_hostbd_destroy(&hostLfs);
+}
+
+//***************************SPI transactions********************************************
+
+typedef struct {
+    const char *name;
+    uint32_t ops;
+    uint64_t selects[2];
+    uint64_t ns[2];
+} sCase_t;
+
+enum {
+    CASE_MOUNT,
+    CASE_CREATE,
+    CASE_OPEN_READ,
+    CASE_STAT,
+    CASE_APPEND_SYNC,
+    CASE_WRITE,
+    CASE_READ,
+    CASE_LIST,
+    CASE_COUNT
+};
+
+static sCase_t cases[CASE_COUNT] = {
+    {"mount", 1, {0}, {0}},
+    {"create 24 B file", 100, {0}, {0}},
+    {"open, read 24 B, close", 200, {0}, {0}},
+    {"stat", 200, {0}, {0}},
+    {"append 32 B, sync", 500, {0}, {0}},
+    {"write 4 KiB in 256 B", 10, {0}, {0}},
+    {"read 8 KiB in 64 B", 10, {0}, {0}},
+    {"list 200 files", 10, {0}, {0}},
+};
+
+static void Begin(void) {
+    mramModelClearStats();
+}
+
+static void End(int c, int cached) {
+    cases[c].selects[cached] += mramModelStats()->selects;
+    cases[c].ns[cached] += mramModelStats()->ns;
+}
+
+static void Workload(const struct lfs_config *cfg, int cached) {
+    uint8_t data[256], check[64];
+    struct lfs_info info;
+    lfs_file_t file;
+    lfs_dir_t dir;
+    char name[32];
+
+    if (lfs_format(&lfs, cfg) || lfs_mount(&lfs, cfg) || lfs_mkdir(&lfs, "d"))
+        FAIL("format");
+    for (uint32_t i = 0; i < LFS_CACHE_FILES; i++) {
+        snprintf(name, sizeof(name), "d/old%03u", (unsigned)i);
+        memset(data, (uint8_t)i, LFS_CACHE_FILE_SIZE);
+        if (lfs_file_open(&lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT)
+                || lfs_file_write(&lfs, &file, data, LFS_CACHE_FILE_SIZE) != LFS_CACHE_FILE_SIZE
+                || lfs_file_close(&lfs, &file))
+            FAIL("create %s", name);
+    }
+    lfs_file_open(&lfs, &file, "big", LFS_O_WRONLY | LFS_O_CREAT);
+    for (uint32_t off = 0; off < LFS_CACHE_BIG_SIZE; off += sizeof(data)) {
+        for (uint32_t i = 0; i < sizeof(data); i++)
+            data[i] = (uint8_t)((off + i) * 13);
+        lfs_file_write(&lfs, &file, data, sizeof(data));
+    }
+    lfs_file_close(&lfs, &file);
+    lfs_unmount(&lfs);
+
+    Begin();
+    if (lfs_mount(&lfs, cfg))
+        FAIL("mount");
+    End(CASE_MOUNT, cached);
+
+    Begin();
+    for (uint32_t i = 0; i < cases[CASE_CREATE].ops; i++) {
+        snprintf(name, sizeof(name), "d/new%03u", (unsigned)i);
+        memset(data, (uint8_t)i, LFS_CACHE_FILE_SIZE);
+        if (lfs_file_open(&lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_EXCL)
+                || lfs_file_write(&lfs, &file, data, LFS_CACHE_FILE_SIZE) != LFS_CACHE_FILE_SIZE
+                || lfs_file_close(&lfs, &file))
+            FAIL("create %s", name);
+    }
+    End(CASE_CREATE, cached);
+
+    Begin();
+    for (uint32_t i = 0; i < cases[CASE_OPEN_READ].ops; i++) {
+        uint32_t n = bench_rand(&seed) % LFS_CACHE_FILES;
+        snprintf(name, sizeof(name), "d/old%03u", (unsigned)n);
+        if (lfs_file_open(&lfs, &file, name, LFS_O_RDONLY)
+                || lfs_file_read(&lfs, &file, check, LFS_CACHE_FILE_SIZE) != LFS_CACHE_FILE_SIZE
+                || lfs_file_close(&lfs, &file) || check[0] != (uint8_t)n || check[LFS_CACHE_FILE_SIZE - 1] != (uint8_t)n)
+            FAIL("read %s", name);
+    }
+    End(CASE_OPEN_READ, cached);
+
+    Begin();
+    for (uint32_t i = 0; i < cases[CASE_STAT].ops; i++) {
+        snprintf(name, sizeof(name), "d/new%03u", (unsigned)(bench_rand(&seed) % cases[CASE_CREATE].ops));
+        if (lfs_stat(&lfs, name, &info) || info.size != LFS_CACHE_FILE_SIZE)
+            FAIL("stat %s", name);
+    }
+    End(CASE_STAT, cached);
+
+    Begin();
+    lfs_file_open(&lfs, &file, "log", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+    for (uint32_t i = 0; i < cases[CASE_APPEND_SYNC].ops; i++) {
+        memset(data, (uint8_t)i, LFS_CACHE_RECORD);
+        if (lfs_file_write(&lfs, &file, data, LFS_CACHE_RECORD) != LFS_CACHE_RECORD || lfs_file_sync(&lfs, &file))
+            FAIL("append");
+    }
+    lfs_file_close(&lfs, &file);
+    End(CASE_APPEND_SYNC, cached);
+
+    Begin();
+    for (uint32_t i = 0; i < cases[CASE_WRITE].ops; i++) {
+        snprintf(name, sizeof(name), "w%u", (unsigned)i);
+        lfs_file_open(&lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT);
+        for (uint32_t off = 0; off < 4096; off += sizeof(data)) {
+            memset(data, (uint8_t)(off / sizeof(data)), sizeof(data));
+            if (lfs_file_write(&lfs, &file, data, sizeof(data)) != sizeof(data))
+                FAIL("write %s", name);
+        }
+        if (lfs_file_close(&lfs, &file))
+            FAIL("close %s", name);
+    }
+    End(CASE_WRITE, cached);
+
+    Begin();
+    for (uint32_t i = 0; i < cases[CASE_READ].ops; i++) {
+        if (lfs_file_open(&lfs, &file, "big", LFS_O_RDONLY))
+            FAIL("open big");
+        for (uint32_t off = 0; off < LFS_CACHE_BIG_SIZE; off += sizeof(check)) {
+            if (lfs_file_read(&lfs, &file, check, sizeof(check)) != sizeof(check))
+                FAIL("read big");
+            for (uint32_t j = 0; j < sizeof(check); j++)
+                if (check[j] != (uint8_t)((off + j) * 13))
+                    FAIL("big byte %u", (unsigned)(off + j));
+        }
+        lfs_file_close(&lfs, &file);
+    }
+    End(CASE_READ, cached);
+
+    Begin();
+    for (uint32_t i = 0; i < cases[CASE_LIST].ops; i++) {
+        uint32_t files = 0;
+        if (lfs_dir_open(&lfs, &dir, "d"))
+            FAIL("open d");
+        while (lfs_dir_read(&lfs, &dir, &info) > 0)
+            files += (info.type == LFS_TYPE_REG);
+        lfs_dir_close(&lfs, &dir);
+        if (files != LFS_CACHE_FILES + cases[CASE_CREATE].ops)
+            FAIL("listed %u files", (unsigned)files);
+    }
+    End(CASE_LIST, cached);
+
+    lfs_unmount(&lfs);
+}
+
+// Reads the 8 KiB file in 16 B reads, returns the bus time
+static uint64_t ReadBig(const struct lfs_config *cfg, uint64_t *selects) {
+    uint8_t data[16];
+    lfs_file_t file;
+
+    if (lfs_mount(&lfs, cfg) || lfs_file_open(&lfs, &file, "big", LFS_O_RDONLY))
+        FAIL("open big");
+    Begin();
+    while (lfs_file_read(&lfs, &file, data, sizeof(data)) > 0)
+        ;
+    *selects = mramModelStats()->selects;
+    lfs_file_close(&lfs, &file);
+    lfs_unmount(&lfs);
+    return mramModelStats()->ns;
+}
+
+static void Transactions(uint32_t sckHz) {
+    const struct lfs_mrambd_config *port = mramModelFixture(sckHz);
+    struct lfs_cachebd_config cacheCfg = defaultCache;
+    struct lfs_config mramLfs, cachedLfs;
+    lfs_cachebd_t mramCache;
+    lfs_mrambd_t mram;
+
+    lfs_mrambd_profile(&mramLfs, &mram);
+    if (lfs_mrambd_create(&mramLfs, port))
+        FAIL("lfs_mrambd_create");
+    cacheCfg.bd = &mramLfs;
+    lfs_cachebd_wrap(&cachedLfs, &mramCache, &mramLfs);
+    if (lfs_cachebd_create(&cachedLfs, &cacheCfg))
+        FAIL("lfs_cachebd_create");
+
+    Workload(&mramLfs, 0);
+    Workload(&cachedLfs, 1);
+
+    printf("\nlittlefs with the MRAM profile on the S3A3204 at %.1f MHz SCK, %u pages of %u B, read-ahead %u\n",
+           sckHz / 1e6, LFS_CACHEBD_PAGE_COUNT, LFS_CACHEBD_PAGE_SIZE, LFS_CACHEBD_READ_AHEAD);
+    printf("%-24s %5s %14s %14s %7s %12s %12s\n", "operation", "ops", "SPI/op direct", "SPI/op cached",
+           "ratio", "us direct", "us cached");
+    for (int c = 0; c < CASE_COUNT; c++) {
+        const sCase_t *k = &cases[c];
+        printf("%-24s %5u %14.1f %14.1f %6.1fx %12.1f %12.1f\n", k->name, (unsigned)k->ops,
+               (double)k->selects[0] / k->ops, (double)k->selects[1] / k->ops,
+               (double)k->selects[0] / k->selects[1], k->ns[0] / 1e3 / k->ops, k->ns[1] / 1e3 / k->ops);
+        if (k->selects[1] > k->selects[0])
+            FAIL("%s takes more SPI transactions through the cache", k->name);
+    }
+
+    // Read-ahead only pays once littlefs reads in pieces smaller than a block,
+    // as with a cache_size cut to save RAM per open file
+    printf("\nread 8 KiB in 16 B reads, SPI transactions and us, by littlefs cache_size and read-ahead\n");
+    printf("%-10s %14s", "cache_size", "direct");
+    for (lfs_size_t pages = 0; pages <= 6; pages += 2) {
+        char label[16];
+        snprintf(label, sizeof(label), "read-ahead %u", (unsigned)pages);
+        printf(" %14s", label);
+    }
+    printf("\n");
+    for (lfs_size_t size = LFS_MRAMBD_CACHE_SIZE; size >= 32; size /= 2) {
+        uint64_t selects, ns;
+
+        mramLfs.cache_size = size;
+        ns = ReadBig(&mramLfs, &selects);
+        printf("%8u B %6u %7.0f", (unsigned)size, (unsigned)selects, ns / 1e3);
+        for (lfs_size_t pages = 0; pages <= 6; pages += 2) {
+            lfs_cachebd_destroy(&cachedLfs);
+            cacheCfg.read_ahead = pages;
+            lfs_cachebd_wrap(&cachedLfs, &mramCache, &mramLfs);
+            lfs_cachebd_create(&cachedLfs, &cacheCfg);
+            ns = ReadBig(&cachedLfs, &selects);
+            printf(" %6u %7.0f", (unsigned)selects, ns / 1e3);
+        }
+        printf("\n");
+    }
+    lfs_cachebd_destroy(&cachedLfs);
+}
+
+int main(int argc, char **argv) {
+    uint32_t sckHz = (argc > 1) ? (uint32_t)atoi(argv[1]) : LFS_CACHE_SCK_HZ;
+
+    printf("lfs_cache_bench: write-back page cache under littlefs\n");
+    Coherence();
+    PowerLoss();
+    Transactions(sckHz);
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * Host block device for littlefs, backed by RAM or by an image file
+ */
+#include "lfs_hostbd.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+int lfs_hostbd_create(const struct lfs_config *cfg,
+        const struct lfs_hostbd_config *bdcfg) {
+    LFS_TRACE("lfs_hostbd_create(%p, %p)", (void*)cfg, (void*)bdcfg);
+    lfs_hostbd_t *bd = cfg->context;
+
+    LFS_ASSERT(cfg->block_count != 0);
+
+    bd->cfg = bdcfg;
+    bd->size = (size_t)cfg->block_size * cfg->block_count;
+    bd->fd = -1;
+    bd->power_cycles = 0;
+    bd->powered = true;
+    memset(&bd->stats, 0, sizeof(bd->stats));
+
+    if (bdcfg->path) {
+        bd->fd = open(bdcfg->path, O_RDWR | O_CREAT, 0666);
+        if (bd->fd < 0 || ftruncate(bd->fd, (off_t)bd->size) < 0) {
+            if (bd->fd >= 0) {
+                close(bd->fd);
+            }
+            LFS_TRACE("lfs_hostbd_create -> %d", LFS_ERR_IO);
+            return LFS_ERR_IO;
+        }
+
+        bd->buffer = mmap(NULL, bd->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                bd->fd, 0);
+        if (bd->buffer == MAP_FAILED) {
+            close(bd->fd);
+            LFS_TRACE("lfs_hostbd_create -> %d", LFS_ERR_IO);
+            return LFS_ERR_IO;
+        }
+    } else {
+        bd->buffer = calloc(1, bd->size);
+        if (!bd->buffer) {
+            LFS_TRACE("lfs_hostbd_create -> %d", LFS_ERR_NOMEM);
+            return LFS_ERR_NOMEM;
+        }
+    }
+
+    LFS_TRACE("lfs_hostbd_create -> %d", 0);
+    return 0;
+}
+
+int lfs_hostbd_destroy(const struct lfs_config *cfg) {
+    LFS_TRACE("lfs_hostbd_destroy(%p)", (void*)cfg);
+    lfs_hostbd_t *bd = cfg->context;
+
+    if (bd->fd >= 0) {
+        munmap(bd->buffer, bd->size);
+        close(bd->fd);
+    } else {
+        free(bd->buffer);
+    }
+    bd->buffer = NULL;
+
+    LFS_TRACE("lfs_hostbd_destroy -> %d", 0);
+    return 0;
+}
+
+int lfs_hostbd_read(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, void *buffer, lfs_size_t size) {
+    LFS_TRACE("lfs_hostbd_read(%p, "
+                "0x%"PRIx32", %"PRIu32", %p, %"PRIu32")",
+            (void*)cfg, block, off, buffer, size);
+    lfs_hostbd_t *bd = cfg->context;
+
+    // check if read is valid
+    LFS_ASSERT(block < cfg->block_count);
+    LFS_ASSERT(off  % cfg->read_size == 0);
+    LFS_ASSERT(size % cfg->read_size == 0);
+    LFS_ASSERT(off+size <= cfg->block_size);
+
+    memcpy(buffer, &bd->buffer[(size_t)block*cfg->block_size + off], size);
+
+    bd->stats.reads += 1;
+    bd->stats.read_bytes += size;
+    bd->stats.ns += bd->cfg->latency.read_ns
+            + (uint64_t)size*bd->cfg->latency.read_byte_ns;
+
+    LFS_TRACE("lfs_hostbd_read -> %d", 0);
+    return 0;
+}
+
+int lfs_hostbd_prog(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, const void *buffer, lfs_size_t size) {
+    LFS_TRACE("lfs_hostbd_prog(%p, "
+                "0x%"PRIx32", %"PRIu32", %p, %"PRIu32")",
+            (void*)cfg, block, off, buffer, size);
+    lfs_hostbd_t *bd = cfg->context;
+
+    // check if write is valid
+    LFS_ASSERT(block < cfg->block_count);
+    LFS_ASSERT(off  % cfg->prog_size == 0);
+    LFS_ASSERT(size % cfg->prog_size == 0);
+    LFS_ASSERT(off+size <= cfg->block_size);
+
+    // nothing is written once the power is gone
+    if (!bd->powered) {
+        LFS_TRACE("lfs_hostbd_prog -> %d", LFS_ERR_IO);
+        return LFS_ERR_IO;
+    }
+
+    // the program that meets the power cut is torn half way
+    lfs_size_t written = size;
+    if (bd->power_cycles && --bd->power_cycles == 0) {
+        written = size / 2;
+        bd->powered = false;
+    }
+    memcpy(&bd->buffer[(size_t)block*cfg->block_size + off], buffer, written);
+
+    bd->stats.progs += 1;
+    bd->stats.prog_bytes += size;
+    bd->stats.ns += bd->cfg->latency.prog_ns
+            + (uint64_t)size*bd->cfg->latency.prog_byte_ns;
+
+    int err = bd->powered ? 0 : LFS_ERR_IO;
+    LFS_TRACE("lfs_hostbd_prog -> %d", err);
+    return err;
+}
+
+int lfs_hostbd_erase(const struct lfs_config *cfg, lfs_block_t block) {
+    LFS_TRACE("lfs_hostbd_erase(%p, 0x%"PRIx32")", (void*)cfg, block);
+    lfs_hostbd_t *bd = cfg->context;
+
+    // check if erase is valid
+    LFS_ASSERT(block < cfg->block_count);
+
+    if (!bd->powered) {
+        LFS_TRACE("lfs_hostbd_erase -> %d", LFS_ERR_IO);
+        return LFS_ERR_IO;
+    }
+
+    if (bd->cfg->erase_value >= 0) {
+        memset(&bd->buffer[(size_t)block*cfg->block_size],
+                bd->cfg->erase_value, cfg->block_size);
+    }
+
+    bd->stats.erases += 1;
+    bd->stats.ns += bd->cfg->latency.erase_ns;
+
+    LFS_TRACE("lfs_hostbd_erase -> %d", 0);
+    return 0;
+}
+
+int lfs_hostbd_sync(const struct lfs_config *cfg) {
+    LFS_TRACE("lfs_hostbd_sync(%p)", (void*)cfg);
+    lfs_hostbd_t *bd = cfg->context;
+
+    int err = 0;
+    if (bd->fd >= 0 && msync(bd->buffer, bd->size, MS_ASYNC) < 0) {
+        err = LFS_ERR_IO;
+    }
+
+    bd->stats.syncs += 1;
+    bd->stats.ns += bd->cfg->latency.sync_ns;
+
+    LFS_TRACE("lfs_hostbd_sync -> %d", err);
+    return err;
+}
+
+void lfs_hostbd_setpowercycles(lfs_hostbd_t *bd, uint32_t programs) {
+    bd->power_cycles = programs;
+}
+
+void lfs_hostbd_poweron(lfs_hostbd_t *bd) {
+    bd->power_cycles = 0;
+    bd->powered = true;
+}
+
+const lfs_hostbd_stats_t *lfs_hostbd_stats(const lfs_hostbd_t *bd) {
+    return &bd->stats;
+}
+
+void lfs_hostbd_clearstats(lfs_hostbd_t *bd) {
+    memset(&bd->stats, 0, sizeof(bd->stats));
+}
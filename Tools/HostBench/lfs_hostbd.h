@@ -0,0 +1,122 @@
+/*
+ * Host block device for littlefs, backed by RAM or by an image file
+ *
+ * Lets lfs.c run on the host without a Pico or an MRAM. Each operation adds
+ * its modelled latency to a simulated clock instead of sleeping, so runs are
+ * quick and repeatable, and the time read back is what the target would
+ * spend on the bus. LFS_HOSTBD_S3A3204() gives the latency of the MRAM behind
+ * lfs_mrambd on the Pico's SPI.
+ *
+ * Power loss is modelled by cutting the power after a given number of
+ * programs: the program that hits the cut is torn half way, and it and every
+ * program or erase after it fail with LFS_ERR_IO, so the filesystem call
+ * stops there as the CPU would. Reads still work, to look at the image.
+ * Powering on and remounting the same device is the reboot.
+ */
+#ifndef LFS_HOSTBD_H
+#define LFS_HOSTBD_H
+
+#include "lfs/lfs.h"
+#include "lfs/lfs_util.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+// Latency of each operation in ns, a fixed cost per call plus a cost per byte
+struct lfs_hostbd_latency {
+    uint32_t read_ns;
+    uint32_t read_byte_ns;
+    uint32_t prog_ns;
+    uint32_t prog_byte_ns;
+    uint32_t erase_ns;
+    uint32_t sync_ns;
+};
+
+// The S3A3204 behind lfs_mrambd: a read is one select, the command and 3
+// address bytes and two transfer calls; a program adds the write enable in
+// its own select. 3 us per select and 1 us per transfer call, as measured
+// with the Arduino mbed SPI driver (see hal/spi_mram_model.h).
+#define LFS_HOSTBD_SPI_BYTE_NS(sck_hz)  (8000000000ULL / (sck_hz))
+#define LFS_HOSTBD_S3A3204(sck_hz) {                                        \
+    .read_ns = 3000 + 2*1000 + 4*LFS_HOSTBD_SPI_BYTE_NS(sck_hz),            \
+    .read_byte_ns = LFS_HOSTBD_SPI_BYTE_NS(sck_hz),                         \
+    .prog_ns = 2*3000 + 3*1000 + 5*LFS_HOSTBD_SPI_BYTE_NS(sck_hz),          \
+    .prog_byte_ns = LFS_HOSTBD_SPI_BYTE_NS(sck_hz),                         \
+    .erase_ns = 0,                                                          \
+    .sync_ns = 0,                                                           \
+}
+
+struct lfs_hostbd_config {
+    // Image file, created or resized to block_size*block_count and mapped.
+    // NULL keeps the device in RAM.
+    const char *path;
+
+    // Value an erased byte takes, or -1 to leave erased blocks as they are,
+    // as on MRAM
+    int32_t erase_value;
+
+    // Latency model, all zero for none
+    struct lfs_hostbd_latency latency;
+};
+
+typedef struct lfs_hostbd_stats {
+    uint64_t ns;            // Simulated time
+    uint32_t reads;
+    uint32_t progs;
+    uint32_t erases;
+    uint32_t syncs;
+    uint64_t read_bytes;
+    uint64_t prog_bytes;
+} lfs_hostbd_stats_t;
+
+// Host block device state, set as lfs_config.context
+typedef struct lfs_hostbd {
+    const struct lfs_hostbd_config *cfg;
+    uint8_t *buffer;
+    size_t size;
+    int fd;
+    lfs_hostbd_stats_t stats;
+    uint32_t power_cycles;  // Programs left before the power cut, 0 for never
+    bool powered;
+} lfs_hostbd_t;
+
+
+// Creates the device. cfg->context must point to an lfs_hostbd_t and
+// cfg->block_count must be set.
+int lfs_hostbd_create(const struct lfs_config *cfg,
+        const struct lfs_hostbd_config *bdcfg);
+
+// Unmaps or frees the device, an image file keeps its contents
+int lfs_hostbd_destroy(const struct lfs_config *cfg);
+
+int lfs_hostbd_read(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, void *buffer, lfs_size_t size);
+
+int lfs_hostbd_prog(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, const void *buffer, lfs_size_t size);
+
+int lfs_hostbd_erase(const struct lfs_config *cfg, lfs_block_t block);
+
+// Flushes an image file to disk, without simulated cost beyond sync_ns
+int lfs_hostbd_sync(const struct lfs_config *cfg);
+
+// Cuts the power after that many more programs, 0 to never cut it
+void lfs_hostbd_setpowercycles(lfs_hostbd_t *bd, uint32_t programs);
+
+// Powers the device back on after a cut
+void lfs_hostbd_poweron(lfs_hostbd_t *bd);
+
+// Simulated time and counts since creation or the last clear
+const lfs_hostbd_stats_t *lfs_hostbd_stats(const lfs_hostbd_t *bd);
+
+void lfs_hostbd_clearstats(lfs_hostbd_t *bd);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,295 @@
+/**
+ * @file lfs_suite_bench.c
+ * @brief littlefs benchmark suite on the host block device.
+ *
+ * lfs.c runs on lfs_hostbd, in RAM or on a mapped image file, with the
+ * geometry of lfs_mrambd_profile() and the latency of the S3A3204 behind
+ * lfs_mrambd (LFS_HOSTBD_S3A3204). Times are simulated bus time on the
+ * target. Host time is printed next to them to catch a slow change in the
+ * filesystem layer itself.
+ *
+ * The cases:
+ *  - mount of an empty filesystem, and of one holding each directory below;
+ *  - create: files of 24 bytes, inlined in their directory. 1k of them in
+ *    one directory, then 10k spread over 100 directories: littlefs finds a
+ *    name by walking its directory, so a create costs O(files in the
+ *    directory) and 10k in one directory would take minutes of bus time;
+ *  - directory listing of the 1k directory and of the 10k tree;
+ *  - append: 32 byte records to one file, opened once;
+ *  - random read: 64 bytes at random offsets of that file;
+ *  - power-loss recovery: the power is cut at a random program during
+ *    appends and creates, then the time to mount and make the filesystem
+ *    consistent is measured. Every closed record and file must survive.
+ *
+ * Usage: lfs_suite_bench [image_file] [sck_hz]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "lfs_hostbd.h"
+#include "lfs_mrambd.h"
+#include "lfs_bench_common.h"
+
+#define LFS_SUITE_SCK_HZ        20000000u
+#define LFS_SUITE_FLAT          1000u       /**< Files in one directory */
+#define LFS_SUITE_TREE          10000u      /**< Files spread over directories */
+#define LFS_SUITE_TREE_DIRS     100u
+#define LFS_SUITE_FILE_SIZE     24u         /**< Inline, under the profile's inline_max */
+#define LFS_SUITE_RECORD        32u
+#define LFS_SUITE_APPENDS       4096u
+#define LFS_SUITE_READ_SIZE     64u
+#define LFS_SUITE_READS         2000u
+#define LFS_SUITE_POWER_LOSSES  100u
+
+static uint32_t seed = 0x5A3204u;
+
+static lfs_hostbd_t bd;
+static struct lfs_hostbd_config bdcfg = {
+    .path = NULL,
+    .erase_value = -1,
+};
+static struct lfs_config cfg;
+static lfs_t lfs;
+
+static uint8_t records[LFS_SUITE_APPENDS * LFS_SUITE_RECORD];
+
+//***************************Measurement*************************************************
+
+typedef struct {
+    lfs_hostbd_stats_t start;
+    double host;
+} sMeasure_t;
+
+static void Start(sMeasure_t *m) {
+    m->start = *lfs_hostbd_stats(&bd);
+    m->host = bench_seconds();
+}
+
+static void Stop(sMeasure_t *m, const char *name, uint32_t ops) {
+    const lfs_hostbd_stats_t *now = lfs_hostbd_stats(&bd);
+    double ms = (now->ns - m->start.ns) / 1e6;
+
+    printf("%-30s %7u %12.1f %11.1f %9.1f %9.1f %10.1f\n", name, (unsigned)ops, ms, ms * 1e3 / ops,
+           (double)(now->reads - m->start.reads) / ops, (double)(now->progs - m->start.progs) / ops,
+           (bench_seconds() - m->host) * 1e3);
+}
+
+//***************************Cases*******************************************************
+
+static void Mount(const char *name) {
+    sMeasure_t m;
+
+    Start(&m);
+    if (lfs_mount(&lfs, &cfg))
+        FAIL("mount");
+    Stop(&m, name, 1);
+}
+
+static void Create(const char *dir, uint32_t count, uint32_t dirs) {
+    uint8_t data[LFS_SUITE_FILE_SIZE];
+    char name[64], label[64];
+    lfs_file_t file;
+    sMeasure_t m;
+
+    if (lfs_mkdir(&lfs, dir))
+        FAIL("mkdir %s", dir);
+    for (uint32_t d = 0; dirs > 1 && d < dirs; d++) {
+        snprintf(name, sizeof(name), "%s/d%03u", dir, (unsigned)d);
+        if (lfs_mkdir(&lfs, name))
+            FAIL("mkdir %s", name);
+    }
+
+    if (dirs > 1)
+        snprintf(label, sizeof(label), "create %u in %u dirs", (unsigned)count, (unsigned)dirs);
+    else
+        snprintf(label, sizeof(label), "create %u in one dir", (unsigned)count);
+    Start(&m);
+    for (uint32_t i = 0; i < count; i++) {
+        if (dirs > 1)
+            snprintf(name, sizeof(name), "%s/d%03u/file%05u", dir, (unsigned)(i % dirs), (unsigned)i);
+        else
+            snprintf(name, sizeof(name), "%s/file%05u", dir, (unsigned)i);
+        memset(data, (uint8_t)i, sizeof(data));
+        if (lfs_file_open(&lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_EXCL)
+                || lfs_file_write(&lfs, &file, data, sizeof(data)) != sizeof(data)
+                || lfs_file_close(&lfs, &file))
+            FAIL("create %s", name);
+    }
+    Stop(&m, label, count);
+}
+
+// Regular files of the suite's size under dir, recursing into directories
+static uint32_t Walk(const char *dir) {
+    struct lfs_info info;
+    char path[64 + LFS_NAME_MAX];
+    uint32_t files = 0;
+    lfs_dir_t d;
+    int err;
+
+    if (lfs_dir_open(&lfs, &d, dir))
+        FAIL("open %s", dir);
+    while ((err = lfs_dir_read(&lfs, &d, &info)) > 0) {
+        if (info.type == LFS_TYPE_REG && info.size == LFS_SUITE_FILE_SIZE) {
+            files++;
+        } else if (info.type == LFS_TYPE_DIR && strcmp(info.name, ".") && strcmp(info.name, "..")) {
+            snprintf(path, sizeof(path), "%s/%s", dir, info.name);
+            files += Walk(path);
+        }
+    }
+    lfs_dir_close(&lfs, &d);
+    if (err < 0)
+        FAIL("read %s", dir);
+    return files;
+}
+
+static void List(const char *dir, uint32_t count, uint32_t dirs) {
+    char label[64];
+    uint32_t files;
+    sMeasure_t m;
+
+    if (dirs > 1)
+        snprintf(label, sizeof(label), "list %u files in %u dirs", (unsigned)count, (unsigned)dirs);
+    else
+        snprintf(label, sizeof(label), "list %u files in one dir", (unsigned)count);
+    Start(&m);
+    files = Walk(dir);
+    Stop(&m, label, count);
+
+    if (files != count)
+        FAIL("%s lists %u files of %u", dir, (unsigned)files, (unsigned)count);
+}
+
+static void AppendAndRead(void) {
+    uint8_t data[LFS_SUITE_READ_SIZE];
+    lfs_file_t file;
+    sMeasure_t m;
+
+    for (uint32_t i = 0; i < sizeof(records); i++)
+        records[i] = (uint8_t)bench_rand(&seed);
+
+    if (lfs_file_open(&lfs, &file, "log", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND))
+        FAIL("open log");
+    Start(&m);
+    for (uint32_t i = 0; i < LFS_SUITE_APPENDS; i++) {
+        if (lfs_file_write(&lfs, &file, &records[i * LFS_SUITE_RECORD], LFS_SUITE_RECORD) != LFS_SUITE_RECORD)
+            FAIL("append %u", (unsigned)i);
+    }
+    if (lfs_file_close(&lfs, &file))
+        FAIL("close log");
+    Stop(&m, "append 32 B", LFS_SUITE_APPENDS);
+
+    if (lfs_file_open(&lfs, &file, "log", LFS_O_RDONLY))
+        FAIL("open log");
+    Start(&m);
+    for (uint32_t i = 0; i < LFS_SUITE_READS; i++) {
+        lfs_off_t off = bench_rand(&seed) % (sizeof(records) - sizeof(data));
+        if (lfs_file_seek(&lfs, &file, off, LFS_SEEK_SET) != (lfs_soff_t)off
+                || lfs_file_read(&lfs, &file, data, sizeof(data)) != sizeof(data)
+                || memcmp(data, &records[off], sizeof(data)))
+            FAIL("random read at %u", (unsigned)off);
+    }
+    Stop(&m, "random read 64 B", LFS_SUITE_READS);
+    lfs_file_close(&lfs, &file);
+}
+
+//***************************Power loss**************************************************
+
+static void PowerLoss(void) {
+    uint64_t worst = 0, total = 0;
+    uint32_t programs, cuts = 0;
+    lfs_hostbd_stats_t before;
+    lfs_bench_closed_t closed;
+
+    // Programs the whole workload takes, each trial cuts within them
+    if (lfs_bench_powerloss_format(&lfs, &cfg))
+        FAIL("power loss: format");
+    before = *lfs_hostbd_stats(&bd);
+    lfs_bench_powerloss_workload(&lfs, &bd, &closed);
+    programs = lfs_hostbd_stats(&bd)->progs - before.progs;
+    lfs_unmount(&lfs);
+
+    for (uint32_t trial = 0; trial < LFS_SUITE_POWER_LOSSES; trial++) {
+        uint64_t ns;
+
+        if (lfs_bench_powerloss_format(&lfs, &cfg))
+            FAIL("power loss: format");
+
+        lfs_hostbd_setpowercycles(&bd, 1 + bench_rand(&seed) % programs);
+        lfs_bench_powerloss_workload(&lfs, &bd, &closed);
+        cuts += !bd.powered;
+
+        // Reboot: the lfs_t in RAM is lost, only the image is left
+        lfs_hostbd_poweron(&bd);
+        before = *lfs_hostbd_stats(&bd);
+        if (lfs_mount(&lfs, &cfg))
+            FAIL("power loss %u: mount", (unsigned)trial);
+        if (lfs_fs_mkconsistent(&lfs))
+            FAIL("power loss %u: mkconsistent", (unsigned)trial);
+        ns = lfs_hostbd_stats(&bd)->ns - before.ns;
+        total += ns;
+        if (ns > worst)
+            worst = ns;
+
+        lfs_bench_powerloss_check(&lfs, &closed, (unsigned)trial);
+        lfs_unmount(&lfs);
+    }
+
+    printf("%-30s %7u %12.1f %11.1f %9s %9s %10s\n", "power-loss recovery", LFS_SUITE_POWER_LOSSES,
+           total / 1e6, total / 1e3 / LFS_SUITE_POWER_LOSSES, "", "", "");
+    printf("  cut at random in the %u programs of the workload (%u cuts), worst recovery %.1f us,"
+           " every closed record and file kept\n", (unsigned)programs, (unsigned)cuts, worst / 1e3);
+}
+
+int main(int argc, char **argv) {
+    uint32_t sckHz = (argc > 2) ? (uint32_t)atoi(argv[2]) : LFS_SUITE_SCK_HZ;
+    struct lfs_hostbd_latency latency = LFS_HOSTBD_S3A3204(LFS_SUITE_SCK_HZ);
+    lfs_mrambd_t unused;
+
+    if (argc > 1 && strcmp(argv[1], "-") != 0)
+        bdcfg.path = argv[1];
+    if (sckHz != LFS_SUITE_SCK_HZ) {
+        struct lfs_hostbd_latency scaled = LFS_HOSTBD_S3A3204(sckHz);
+        latency = scaled;
+    }
+    bdcfg.latency = latency;
+
+    // The flight geometry, on the host device
+    lfs_mrambd_profile(&cfg, &unused);
+    cfg.context = &bd;
+    cfg.read = lfs_hostbd_read;
+    cfg.prog = lfs_hostbd_prog;
+    cfg.erase = lfs_hostbd_erase;
+    cfg.sync = lfs_hostbd_sync;
+    if (lfs_hostbd_create(&cfg, &bdcfg))
+        FAIL("cannot create the device on %s", bdcfg.path ? bdcfg.path : "RAM");
+
+    printf("lfs_suite_bench: %s, %u x %u B blocks, S3A3204 at %.1f MHz SCK\n",
+           bdcfg.path ? bdcfg.path : "RAM", (unsigned)cfg.block_count, (unsigned)cfg.block_size, sckHz / 1e6);
+    printf("%-30s %7s %12s %11s %9s %9s %10s\n", "case", "ops", "sim ms", "sim us/op", "reads/op",
+           "progs/op", "host ms");
+
+    if (lfs_format(&lfs, &cfg))
+        FAIL("format");
+    Mount("mount empty");
+
+    Create("flat", LFS_SUITE_FLAT, 1);
+    List("flat", LFS_SUITE_FLAT, 1);
+    lfs_unmount(&lfs);
+    Mount("mount with 1k files");
+
+    Create("tree", LFS_SUITE_TREE, LFS_SUITE_TREE_DIRS);
+    List("tree", LFS_SUITE_TREE, LFS_SUITE_TREE_DIRS);
+    lfs_unmount(&lfs);
+    Mount("mount with 11k files");
+
+    AppendAndRead();
+    lfs_unmount(&lfs);
+
+    PowerLoss();
+
+    lfs_hostbd_destroy(&cfg);
+    return 0;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file mram_bd_bench.c
+ * @brief Throughput of the burst MRAM block device against per-byte SPI access.
+ *
+ * Tools/MramLittleFsPicoDemo/lfs_mrambd.c runs against the SPI MRAM model in
+ * hal/spi_mram_model.c, which decodes the commands as the S3A3204 does and
+ * adds up the bus time: SCK per byte, plus the cost of each select and of
+ * each call into the SPI driver.
+ *
+ * The first part checks the driver: random reads and programs must match a
+ * reference copy, every read must be one select and every program two (its
+ * write enable and the burst), and no write may be rejected by the chip.
+ *
+ * The second part prints KB/s of bus time for sequential and random access,
+ * raw and through littlefs, next to the per-byte code the demo sketch had:
+ * one transaction per byte, and a write enable and delay(50) before each byte
+ * programmed.
+ *
+ * Usage: mram_bd_bench [sck_hz]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "spi_mram_model.h"
+#include "lfs_mrambd.h"
+
+#define MRAM_BD_BENCH_SCK_HZ        1000000u    /**< As the demo sketch */
+#define MRAM_BD_BENCH_FAST_SCK_HZ   20000000u
+#define MRAM_BD_BENCH_CHECKS        20000u
+#define MRAM_BD_BENCH_SEQUENTIAL    (256u * 1024u)
+#define MRAM_BD_BENCH_RANDOM        2000u
+#define MRAM_BD_BENCH_FILE          (64u * 1024u)
+#define MRAM_BD_BENCH_CHUNK         256u
+
+#define OLD_PROG_DELAY_MS           50u         /**< delay(50) before each byte */
+
+#define BLOCK_SIZE                  512u
+#define BLOCK_COUNT                 (LFS_MRAMBD_SIZE / BLOCK_SIZE)
+
+static uint32_t seed = 0x3A3204u;
+
+static const struct lfs_mrambd_config *port;
+static lfs_mrambd_t mram;
+static uint8_t reference[LFS_MRAMBD_SIZE];
+static uint8_t buffer[MRAM_BD_BENCH_FILE];
+static uint8_t readBack[MRAM_BD_BENCH_FILE];
+
+//***************************Per-byte access, as the demo sketch had*********************
+
+static void OldTransaction(uint8_t cmd, uint32_t addr, const uint8_t *tx, uint8_t *rx) {
+    uint8_t bytes[4] = {cmd, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8), (uint8_t)addr};
+
+    mramModelSelect(NULL);
+    for (int i = 0; i < 4; i++)
+        mramModelTransfer(NULL, &bytes[i], NULL, 1);
+    mramModelTransfer(NULL, tx, rx, 1);
+    mramModelDeselect(NULL);
+}
+
+static int OldRead(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *data, lfs_size_t size) {
+    uint32_t addr = c->block_size * block + off;
+    for (lfs_size_t i = 0; i < size; i++)
+        OldTransaction(LFS_MRAMBD_CMD_READ, addr + i, NULL, (uint8_t *)data + i);
+    return 0;
+}
+
+static int OldProg(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *data, lfs_size_t size) {
+    const uint8_t wren = LFS_MRAMBD_CMD_WREN;
+    uint32_t addr = c->block_size * block + off;
+
+    for (lfs_size_t i = 0; i < size; i++) {
+        mramModelSelect(NULL);
+        mramModelTransfer(NULL, &wren, NULL, 1);
+        mramModelDeselect(NULL);
+        mramModelDelayUs(OLD_PROG_DELAY_MS * 1000);
+        OldTransaction(LFS_MRAMBD_CMD_WRITE, addr + i, (const uint8_t *)data + i, NULL);
+    }
+    return 0;
+}
+
+//***************************Configuration***********************************************
+
+static void Configure(struct lfs_config *cfg, int burst) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->context = &mram;
+    cfg->read = burst ? lfs_mrambd_read : OldRead;
+    cfg->prog = burst ? lfs_mrambd_prog : OldProg;
+    cfg->erase = lfs_mrambd_erase;
+    cfg->sync = lfs_mrambd_sync;
+    cfg->read_size = 16;
+    cfg->prog_size = 16;
+    cfg->block_size = BLOCK_SIZE;
+    cfg->block_count = BLOCK_COUNT;
+    cfg->block_cycles = 500;
+    cfg->cache_size = 64;
+    cfg->lookahead_size = 16;
+    if (lfs_mrambd_create(cfg, port))
+        FAIL("lfs_mrambd_create");
+}
+
+static void Fill(uint8_t *data, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++)
+        data[i] = (uint8_t)bench_rand(&seed);
+}
+
+//***************************Checks******************************************************
+
+static void CheckDriver(void) {
+    struct lfs_config cfg;
+    sMramModelStats_t before;
+    uint32_t i;
+
+    port = mramModelFixture(0);
+    memset(reference, 0, sizeof(reference));
+    Configure(&cfg, 1);
+
+    if (lfs_mrambd_deviceid(&mram) != MRAM_MODEL_DEVICE_ID)
+        FAIL("device ID %08lx", (unsigned long)lfs_mrambd_deviceid(&mram));
+
+    for (i = 0; i < MRAM_BD_BENCH_CHECKS; i++) {
+        lfs_block_t block = bench_rand(&seed) % BLOCK_COUNT;
+        lfs_size_t size = 16 * (1 + bench_rand(&seed) % (BLOCK_SIZE / 16));
+        lfs_off_t off = 16 * (bench_rand(&seed) % ((BLOCK_SIZE - size) / 16 + 1));
+        uint32_t addr = block * BLOCK_SIZE + off;
+        int prog = bench_rand(&seed) & 1;
+
+        before = *mramModelStats();
+        if (prog) {
+            Fill(buffer, size);
+            memcpy(&reference[addr], buffer, size);
+            lfs_mrambd_prog(&cfg, block, off, buffer, size);
+            if (memcmp(&mramModelArray()[addr], buffer, size))
+                FAIL("prog of %u bytes at %06lx", (unsigned)size, (unsigned long)addr);
+        } else {
+            lfs_mrambd_read(&cfg, block, off, buffer, size);
+            if (memcmp(&reference[addr], buffer, size))
+                FAIL("read of %u bytes at %06lx", (unsigned)size, (unsigned long)addr);
+        }
+        if (mramModelStats()->selects - before.selects != (prog ? 2u : 1u))
+            FAIL("%s took %lu selects", prog ? "prog" : "read",
+                 (unsigned long)(mramModelStats()->selects - before.selects));
+    }
+
+    if (mramModelStats()->rejected || mramModelStats()->unknown)
+        FAIL("%lu writes rejected, %lu unknown commands",
+             (unsigned long)mramModelStats()->rejected, (unsigned long)mramModelStats()->unknown);
+    if (memcmp(reference, mramModelArray(), sizeof(reference)))
+        FAIL("array differs from the reference");
+
+    // The per-byte code must see the same data, it is only slower
+    Configure(&cfg, 0);
+    OldRead(&cfg, 3, 64, buffer, 256);
+    if (memcmp(&reference[3 * BLOCK_SIZE + 64], buffer, 256))
+        FAIL("per-byte read");
+    Fill(buffer, 64);
+    OldProg(&cfg, 5, 0, buffer, 64);
+    if (memcmp(&mramModelArray()[5 * BLOCK_SIZE], buffer, 64))
+        FAIL("per-byte prog");
+
+    printf("%u random reads and programs match, 1 select per read, 2 per program, no write rejected\n",
+           MRAM_BD_BENCH_CHECKS);
+}
+
+//***************************Throughput**************************************************
+
+static double KBs(uint64_t bytes, uint64_t ns) {
+    return ns ? (double)bytes / 1024.0 / ((double)ns * 1e-9) : 0.0;
+}
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t ns;
+    uint32_t selects;
+} sRun_t;
+
+// Sequential or random accesses of size bytes, bounded by total bytes
+static sRun_t Raw(struct lfs_config *cfg, int prog, int random, lfs_size_t size, uint32_t total) {
+    sRun_t run = {0};
+    uint32_t done;
+
+    mramModelClearStats();
+    for (done = 0; done < total; done += size) {
+        uint32_t addr = random ? 16 * (bench_rand(&seed) % ((LFS_MRAMBD_SIZE - size) / 16))
+                               : done % LFS_MRAMBD_SIZE;
+        lfs_block_t block = addr / BLOCK_SIZE;
+        lfs_off_t off = addr % BLOCK_SIZE;
+
+        // Keep each access inside its block, as littlefs does
+        if (off + size > BLOCK_SIZE)
+            off = BLOCK_SIZE - size;
+        if (prog)
+            cfg->prog(cfg, block, off, buffer, size);
+        else
+            cfg->read(cfg, block, off, buffer, size);
+    }
+    run.bytes = total;
+    run.ns = mramModelStats()->ns;
+    run.selects = mramModelStats()->selects;
+    return run;
+}
+
+// A file written and read back in MRAM_BD_BENCH_CHUNK byte calls
+static void ThroughLittleFs(struct lfs_config *cfg, uint32_t size, sRun_t *write, sRun_t *read) {
+    lfs_t lfs;
+    lfs_file_t file;
+    uint32_t done;
+
+    if (lfs_format(&lfs, cfg) || lfs_mount(&lfs, cfg))
+        FAIL("format and mount");
+
+    Fill(buffer, size);
+    mramModelClearStats();
+    if (lfs_file_open(&lfs, &file, "data", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC))
+        FAIL("open for writing");
+    for (done = 0; done < size; done += MRAM_BD_BENCH_CHUNK)
+        if (lfs_file_write(&lfs, &file, &buffer[done], MRAM_BD_BENCH_CHUNK) != MRAM_BD_BENCH_CHUNK)
+            FAIL("write at %lu", (unsigned long)done);
+    if (lfs_file_close(&lfs, &file))
+        FAIL("close after writing");
+    write->bytes = size;
+    write->ns = mramModelStats()->ns;
+    write->selects = mramModelStats()->selects;
+
+    mramModelClearStats();
+    if (lfs_file_open(&lfs, &file, "data", LFS_O_RDONLY))
+        FAIL("open for reading");
+    for (done = 0; done < size; done += MRAM_BD_BENCH_CHUNK)
+        if (lfs_file_read(&lfs, &file, &readBack[done], MRAM_BD_BENCH_CHUNK) != MRAM_BD_BENCH_CHUNK)
+            FAIL("read at %lu", (unsigned long)done);
+    lfs_file_close(&lfs, &file);
+    read->bytes = size;
+    read->ns = mramModelStats()->ns;
+    read->selects = mramModelStats()->selects;
+
+    if (memcmp(buffer, readBack, size))
+        FAIL("file read back differs");
+    lfs_unmount(&lfs);
+}
+
+static void PrintRow(const char *name, sRun_t old, sRun_t burst) {
+    printf("%-26s %12.3f %12.1f %9.0fx %12.1f %12.2f\n", name,
+           KBs(old.bytes, old.ns), KBs(burst.bytes, burst.ns),
+           KBs(burst.bytes, burst.ns) / KBs(old.bytes, old.ns),
+           old.selects * 1024.0 / old.bytes, burst.selects * 1024.0 / burst.bytes);
+}
+
+static void Throughput(uint32_t sckHz) {
+    struct lfs_config burst, old;
+    sRun_t oldWrite, oldRead, burstWrite, burstRead;
+
+    port = mramModelFixture(sckHz);
+    Configure(&burst, 1);
+    Configure(&old, 0);
+    Fill(buffer, BLOCK_SIZE);
+
+    printf("\nSCK %.1f MHz, %u ns per select, %u ns per transfer call; KB/s of bus time\n",
+           sckHz / 1e6, MRAM_MODEL_SELECT_NS, MRAM_MODEL_CALL_NS);
+    printf("%-26s %12s %12s %10s %12s %12s\n", "access", "per-byte", "burst", "speedup",
+           "CS/KiB old", "CS/KiB burst");
+
+    // The per-byte path is linear in bytes, a small sample gives its rate
+    PrintRow("sequential read 512 B", Raw(&old, 0, 0, BLOCK_SIZE, 8 * BLOCK_SIZE),
+             Raw(&burst, 0, 0, BLOCK_SIZE, MRAM_BD_BENCH_SEQUENTIAL));
+    PrintRow("sequential prog 512 B", Raw(&old, 1, 0, BLOCK_SIZE, BLOCK_SIZE),
+             Raw(&burst, 1, 0, BLOCK_SIZE, MRAM_BD_BENCH_SEQUENTIAL));
+    PrintRow("random read 16 B", Raw(&old, 0, 1, 16, 64 * 16),
+             Raw(&burst, 0, 1, 16, MRAM_BD_BENCH_RANDOM * 16));
+    PrintRow("random read 64 B", Raw(&old, 0, 1, 64, 16 * 64),
+             Raw(&burst, 0, 1, 64, MRAM_BD_BENCH_RANDOM * 64));
+    PrintRow("random prog 16 B", Raw(&old, 1, 1, 16, 4 * 16),
+             Raw(&burst, 1, 1, 16, MRAM_BD_BENCH_RANDOM * 16));
+    PrintRow("random prog 64 B", Raw(&old, 1, 1, 64, 64),
+             Raw(&burst, 1, 1, 64, MRAM_BD_BENCH_RANDOM * 64));
+
+    ThroughLittleFs(&old, 4 * MRAM_BD_BENCH_CHUNK, &oldWrite, &oldRead);
+    ThroughLittleFs(&burst, MRAM_BD_BENCH_FILE, &burstWrite, &burstRead);
+    PrintRow("littlefs file write 256 B", oldWrite, burstWrite);
+    PrintRow("littlefs file read 256 B", oldRead, burstRead);
+
+    lfs_mrambd_destroy(&burst);
+}
+
+int main(int argc, char **argv) {
+    uint32_t sckHz = (argc > 1) ? (uint32_t)atoi(argv[1]) : 0;
+
+    printf("mram_bd_bench: S3A3204 model, %u byte blocks, %u blocks\n", BLOCK_SIZE, (unsigned)BLOCK_COUNT);
+    CheckDriver();
+
+    if (sckHz) {
+        Throughput(sckHz);
+    } else {
+        Throughput(MRAM_BD_BENCH_SCK_HZ);
+        Throughput(MRAM_BD_BENCH_FAST_SCK_HZ);
+    }
+    printf("littlefs rows are bytes of file data over all bus time, metadata included\n");
+    return 0;
+}
@@ -0,0 +1,393 @@
+/**
+ * @file mram_log_bench.c
+ * @brief Telemetry log on the MRAM: queries, recovery and record rate.
+ *
+ * Tools/MramLittleFsPicoDemo/mram_log.c runs on the burst block device over
+ * the SPI MRAM model, so times are bus time on the target.
+ *
+ * The first part appends records of random size with millisecond
+ * timestamps, committing at random, until the log has wrapped many times.
+ * Along the way, each check must hold:
+ *  - reading from the start returns a contiguous run of the records
+ *    committed, ending with the last one;
+ *  - random "records between T1 and T2" queries return exactly the records
+ *    of that run within the window;
+ *  - a remount finds the same end.
+ *
+ * The second part tears commits half way, as a power cut would, and
+ * remounts. The log must come back with every earlier commit and nothing of
+ * the torn one, having read the segment headers and the newest segment
+ * only. Appends must then carry on.
+ *
+ * The third part prints records per second against littlefs appends with
+ * the MRAM profile, and the cost of a seek and of a mount for logs of
+ * growing size.
+ *
+ * Usage: mram_log_bench [records]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "spi_mram_model.h"
+#include "lfs_mrambd.h"
+#include "mram_log.h"
+
+#define MRAM_LOG_BENCH_RECORDS      60000u
+#define MRAM_LOG_BENCH_SEGMENT      4096u
+#define MRAM_LOG_BENCH_REGION       (256u * 1024u)  /**< 64 segments, wraps often */
+#define MRAM_LOG_BENCH_BASE         (1024u * 1024u) /**< Above a littlefs of 1 MiB */
+#define MRAM_LOG_BENCH_CHECK_EVERY  5000u
+#define MRAM_LOG_BENCH_QUERIES      200u
+#define MRAM_LOG_BENCH_TEARS        200u
+#define MRAM_LOG_BENCH_RATE         20000u
+#define MRAM_LOG_BENCH_PAYLOAD      24u
+#define MRAM_LOG_BENCH_SEEKS        500u
+
+static uint32_t seed = 0x106u;
+
+static lfs_mrambd_t mram;
+static struct lfs_config lfsConfig;
+
+// Every record appended: its time and size. The payload and ID follow from
+// the index, so the reference stays small.
+typedef struct {
+    uint32_t time;
+    uint16_t size;
+} sRef_t;
+
+static sRef_t *refs;
+static uint32_t appended = 0;      /**< Records appended */
+static uint32_t committed = 0;     /**< Of them, committed */
+static uint32_t now = 0;           /**< Last timestamp, ms */
+
+static mram_log_t logState;
+static mram_log_cursor_t cursor;
+
+//***************************Helpers*****************************************************
+
+static void Attach(uint32_t sckHz) {
+    const struct lfs_mrambd_config *port = mramModelFixture(sckHz);
+
+    lfs_mrambd_profile(&lfsConfig, &mram);
+    if (lfs_mrambd_create(&lfsConfig, port))
+        FAIL("lfs_mrambd_create");
+}
+
+static void Payload(uint32_t index, uint8_t *data, uint16_t size) {
+    for (uint16_t i = 0; i < size; i++)
+        data[i] = (uint8_t)(index * 7 + i);
+}
+
+static void Append(mram_log_t *log, uint16_t size) {
+    uint8_t data[MRAM_LOG_RECORD_MAX];
+    uint32_t before = log->commits;
+
+    now += bench_rand(&seed) % 3;       // Several records share a millisecond
+    Payload(appended, data, size);
+    if (mram_log_append(log, now, (uint16_t)appended, data, size))
+        FAIL("append %u", (unsigned)appended);
+    refs[appended].time = now;
+    refs[appended].size = size;
+    appended++;
+    if (log->commits != before)
+        committed = appended - 1;       // The batch before this record went out
+}
+
+static void Sync(mram_log_t *log) {
+    if (mram_log_sync(log))
+        FAIL("sync");
+    committed = appended;
+}
+
+// The record must be reference index, returns it
+static uint32_t Match(const mram_log_record_t *record, const uint8_t *data) {
+    uint8_t expected[MRAM_LOG_RECORD_MAX];
+    uint32_t index = (committed & ~0xFFFFu) | record->id;
+
+    // The ID holds the low 16 bits of the index, the time picks the epoch
+    while (index > committed || (index < committed && refs[index].time > record->time))
+        index -= 0x10000;
+    if (index >= committed || refs[index].time != record->time || refs[index].size != record->size)
+        FAIL("record id %u at %u ms is not one committed", (unsigned)record->id, (unsigned)record->time);
+    Payload(index, expected, record->size);
+    if (memcmp(expected, data, record->size))
+        FAIL("payload of record %u", (unsigned)index);
+    return index;
+}
+
+// Reads from the start: a contiguous run ending at the last commit. Returns its first index.
+static uint32_t CheckAll(mram_log_t *log) {
+    mram_log_record_t record;
+    uint8_t data[MRAM_LOG_RECORD_MAX];
+    uint32_t first = 0, next = 0, count = 0;
+
+    mram_log_seek(log, &cursor, 0);
+    while (mram_log_next(log, &cursor, &record, data, sizeof(data)) > 0) {
+        uint32_t index = Match(&record, data);
+        if (count == 0)
+            first = next = index;
+        if (index != next)
+            FAIL("record %u follows %u", (unsigned)index, (unsigned)(next - 1));
+        next++;
+        count++;
+    }
+    if (committed && next != committed)
+        FAIL("the log ends at record %u, %u were committed", (unsigned)next, (unsigned)committed);
+    return first;
+}
+
+static void CheckQueries(mram_log_t *log, uint32_t first) {
+    mram_log_record_t record;
+    uint8_t data[MRAM_LOG_RECORD_MAX];
+
+    for (uint32_t q = 0; q < MRAM_LOG_BENCH_QUERIES; q++) {
+        uint32_t span = refs[committed - 1].time - refs[first].time + 20;
+        uint32_t t1 = refs[first].time - 10 + bench_rand(&seed) % span;
+        uint32_t t2 = t1 + bench_rand(&seed) % 200;
+        uint32_t index = first;
+
+        // First retained record at or after t1, by the reference
+        while (index < committed && refs[index].time < t1)
+            index++;
+
+        mram_log_seek(log, &cursor, t1);
+        while (mram_log_next(log, &cursor, &record, data, sizeof(data)) > 0 && record.time <= t2) {
+            if (Match(&record, data) != index)
+                FAIL("query [%u, %u] returned record %u, expected %u", (unsigned)t1, (unsigned)t2,
+                     (unsigned)Match(&record, data), (unsigned)index);
+            index++;
+        }
+        if (index < committed && refs[index].time <= t2)
+            FAIL("query [%u, %u] stopped before record %u", (unsigned)t1, (unsigned)t2, (unsigned)index);
+    }
+}
+
+//***************************Wrap and queries********************************************
+
+static void Correctness(uint32_t records, const struct mram_log_config *cfg) {
+    uint32_t nextSync = 1 + bench_rand(&seed) % 32;
+    uint32_t checks = 0, first = 0;
+
+    mram_log_format(&logState, cfg);
+    if (mram_log_mount(&logState, cfg) || logState.seq != 0)
+        FAIL("a formatted log is not empty");
+    CheckAll(&logState);
+
+    for (uint32_t i = 0; i < records; i++) {
+        Append(&logState, 4 + bench_rand(&seed) % 37);
+        if (--nextSync == 0) {
+            Sync(&logState);
+            nextSync = 1 + bench_rand(&seed) % 32;
+        }
+        if ((i + 1) % MRAM_LOG_BENCH_CHECK_EVERY == 0) {
+            mram_log_t remounted;
+
+            Sync(&logState);
+            first = CheckAll(&logState);
+            CheckQueries(&logState, first);
+            mram_log_mount(&remounted, cfg);
+            if (remounted.seq != logState.seq || remounted.off != logState.off
+                    || remounted.last_time != logState.last_time)
+                FAIL("remount at segment %u offset %u, the log is at %u offset %u", (unsigned)remounted.seq,
+                     (unsigned)remounted.off, (unsigned)logState.seq, (unsigned)logState.off);
+            checks++;
+        }
+    }
+
+    printf("%u records, %u commits, %u segments written (%u laps of %u): %u checks of %u queries and a remount,"
+           " %u records kept\n", (unsigned)records, (unsigned)logState.commits, (unsigned)logState.seq,
+           (unsigned)(logState.seq / logState.segments), (unsigned)logState.segments, (unsigned)checks,
+           MRAM_LOG_BENCH_QUERIES, (unsigned)(committed - first));
+}
+
+//***************************Torn commits************************************************
+
+static void Tears(const struct mram_log_config *cfg) {
+    static uint8_t snapshot[MRAM_LOG_BENCH_REGION];
+    uint8_t *array = mramModelArray() + cfg->base;
+    uint32_t worstBytes = 0, headers = 0;
+    uint64_t worstNs = 0;
+
+    for (uint32_t t = 0; t < MRAM_LOG_BENCH_TEARS; t++) {
+        uint32_t before = committed, lo, hi, count = 1 + bench_rand(&seed) % 30;
+        const sMramModelStats_t *stats = mramModelStats();
+
+        // A batch, then its commit is torn half way
+        for (uint32_t i = 0; i < count; i++)
+            Append(&logState, 4 + bench_rand(&seed) % 37);
+        if (committed != before) {
+            Sync(&logState);        // Only tear the last batch
+            before = committed;
+        }
+        memcpy(snapshot, array, cfg->size);
+        Sync(&logState);
+        for (lo = 0; lo < cfg->size && array[lo] == snapshot[lo]; lo++)
+            ;
+        for (hi = cfg->size; hi > lo && array[hi - 1] == snapshot[hi - 1]; hi--)
+            ;
+        memcpy(&array[lo + (hi - lo) / 2], &snapshot[lo + (hi - lo) / 2], hi - lo - (hi - lo) / 2);
+        committed = before;
+        appended = before;
+        now = committed ? refs[committed - 1].time : 0;
+
+        // Reset: only the MRAM is left
+        mramModelClearStats();
+        if (mram_log_mount(&logState, cfg))
+            FAIL("mount after tear %u", (unsigned)t);
+        if (stats->ns > worstNs)
+            worstNs = stats->ns;
+        if (stats->bytes > worstBytes)
+            worstBytes = (uint32_t)stats->bytes;
+        if (stats->reads > headers)
+            headers = stats->reads;
+        if (stats->bytes > cfg->segment_size + 64 * MRAM_LOG_SEGMENT_HEADER)
+            FAIL("mount after tear %u read %lu bytes", (unsigned)t, (unsigned long)stats->bytes);
+        if (logState.last_time < now)
+            FAIL("mount after tear %u: last time %u, expected at least %u", (unsigned)t,
+                 (unsigned)logState.last_time, (unsigned)now);
+        now = logState.last_time;
+
+        CheckAll(&logState);
+    }
+
+    // And it carries on
+    for (uint32_t i = 0; i < 2000; i++)
+        Append(&logState, 4 + bench_rand(&seed) % 37);
+    Sync(&logState);
+    CheckQueries(&logState, CheckAll(&logState));
+
+    printf("%u torn commits: every earlier commit kept, nothing of the torn one; mount read at most %u bytes"
+           " in %u reads (%.0f us at 20 MHz)\n", MRAM_LOG_BENCH_TEARS, (unsigned)worstBytes, (unsigned)headers,
+           worstNs / 1e3);
+}
+
+//***************************Rates*******************************************************
+
+static double LogRate(const struct mram_log_config *cfg, uint32_t syncEvery) {
+    mram_log_t log;
+    uint8_t data[MRAM_LOG_BENCH_PAYLOAD] = {0};
+
+    mram_log_format(&log, cfg);
+    mramModelClearStats();
+    for (uint32_t i = 0; i < MRAM_LOG_BENCH_RATE; i++) {
+        mram_log_append(&log, i, (uint16_t)i, data, sizeof(data));
+        if (syncEvery && (i + 1) % syncEvery == 0)
+            mram_log_sync(&log);
+    }
+    mram_log_sync(&log);
+    return MRAM_LOG_BENCH_RATE / (mramModelStats()->ns * 1e-9);
+}
+
+static double LittleFsRate(uint32_t syncEvery, uint32_t records) {
+    uint8_t data[MRAM_LOG_BENCH_PAYLOAD + 8] = {0};
+    lfs_file_t file;
+    lfs_t lfs;
+
+    lfsConfig.block_count = MRAM_LOG_BENCH_BASE / lfsConfig.block_size;
+    if (lfs_format(&lfs, &lfsConfig) || lfs_mount(&lfs, &lfsConfig))
+        FAIL("littlefs format");
+    mramModelClearStats();
+    if (syncEvery) {
+        lfs_file_open(&lfs, &file, "hk", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+        for (uint32_t i = 0; i < records; i++) {
+            lfs_file_write(&lfs, &file, data, sizeof(data));
+            if ((i + 1) % syncEvery == 0)
+                lfs_file_sync(&lfs, &file);
+        }
+        lfs_file_close(&lfs, &file);
+    } else {
+        for (uint32_t i = 0; i < records; i++) {
+            lfs_file_open(&lfs, &file, "hk", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+            lfs_file_write(&lfs, &file, data, sizeof(data));
+            lfs_file_close(&lfs, &file);
+        }
+    }
+    lfs_unmount(&lfs);
+    return records / (mramModelStats()->ns * 1e-9);
+}
+
+static void Rates(void) {
+    static const uint32_t clocks[] = {1000000, 20000000};
+    struct mram_log_config cfg = {&mram, MRAM_LOG_BENCH_BASE, 2 * 1024 * 1024, MRAM_LOG_BENCH_SEGMENT};
+
+    printf("\nrecords/s of bus time, %u B payloads\n", MRAM_LOG_BENCH_PAYLOAD);
+    printf("%-8s %12s %12s %12s %14s %14s\n", "SCK", "log batched", "log sync/8", "log sync/1",
+           "lfs sync/8", "lfs open/close");
+    for (uint32_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++) {
+        Attach(clocks[c]);
+        printf("%4.0f MHz %12.0f %12.0f %12.0f %14.0f %14.0f\n", clocks[c] / 1e6, LogRate(&cfg, 0),
+               LogRate(&cfg, 8), LogRate(&cfg, 1), LittleFsRate(8, 2000), LittleFsRate(0, 500));
+    }
+    printf("lfs: the same records as 32 B appends to one file with the MRAM profile, synced every 8,\n"
+           "or opened, appended and closed one at a time\n");
+}
+
+// Seek and mount cost as the log grows, full logs of 24 B records
+static void Scaling(void) {
+    static const uint32_t regions[] = {64 * 1024, 512 * 1024, 3 * 1024 * 1024};
+    uint8_t data[MRAM_LOG_BENCH_PAYLOAD] = {0};
+
+    Attach(20000000);
+    printf("\nseek to a random time and read 10 records, 20 MHz SCK\n");
+    printf("%10s %9s %9s %12s %12s %12s %12s\n", "region", "segments", "records", "seek reads",
+           "seek us", "mount reads", "mount us");
+    for (uint32_t r = 0; r < sizeof(regions) / sizeof(regions[0]); r++) {
+        struct mram_log_config cfg = {&mram, LFS_MRAMBD_SIZE - regions[r], regions[r], MRAM_LOG_BENCH_SEGMENT};
+        mram_log_record_t record;
+        uint32_t records = 0, first, reads = 0;
+        uint64_t ns = 0;
+        mram_log_t log;
+
+        mram_log_format(&log, &cfg);
+        while (log.seq < log.segments || log.off + 512 < cfg.segment_size) {
+            mram_log_append(&log, records, (uint16_t)records, data, sizeof(data));
+            records++;
+        }
+        mram_log_sync(&log);
+        mram_log_seek(&log, &cursor, 0);
+        mram_log_next(&log, &cursor, &record, data, sizeof(data));
+        first = record.time;            // The first segment may have gone
+
+        for (uint32_t s = 0; s < MRAM_LOG_BENCH_SEEKS; s++) {
+            uint32_t time = first + bench_rand(&seed) % (records - first - 10);
+            mramModelClearStats();
+            mram_log_seek(&log, &cursor, time);
+            for (int i = 0; i < 10; i++)
+                if (mram_log_next(&log, &cursor, &record, data, sizeof(data)) <= 0 || record.time != time + i)
+                    FAIL("seek to %u", (unsigned)time);
+            reads += mramModelStats()->reads;
+            ns += mramModelStats()->ns;
+        }
+
+        mramModelClearStats();
+        mram_log_mount(&log, &cfg);
+        printf("%7u KiB %9u %9u %12.1f %12.1f %12u %12.1f\n", (unsigned)(regions[r] / 1024), (unsigned)log.segments,
+               (unsigned)(records - first), (double)reads / MRAM_LOG_BENCH_SEEKS, ns / 1e3 / MRAM_LOG_BENCH_SEEKS,
+               (unsigned)mramModelStats()->reads, mramModelStats()->ns / 1e3);
+        if (mramModelStats()->reads > 2 * (uint32_t)log2(log.segments) + cfg.segment_size / 512 * 2 + 8)
+            FAIL("mount of %u segments took %u reads", (unsigned)log.segments, (unsigned)mramModelStats()->reads);
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t records = (argc > 1) ? (uint32_t)atoi(argv[1]) : MRAM_LOG_BENCH_RECORDS;
+    struct mram_log_config cfg = {&mram, MRAM_LOG_BENCH_BASE, MRAM_LOG_BENCH_REGION, MRAM_LOG_BENCH_SEGMENT};
+
+    if (records < MRAM_LOG_BENCH_CHECK_EVERY)
+        records = MRAM_LOG_BENCH_CHECK_EVERY;
+    refs = calloc(records + MRAM_LOG_BENCH_TEARS * 32 + 4000, sizeof(*refs));
+
+    printf("mram_log_bench: %u KiB log of %u B segments, batches of %u B\n", MRAM_LOG_BENCH_REGION / 1024,
+           MRAM_LOG_BENCH_SEGMENT, MRAM_LOG_BATCH_SIZE);
+    Attach(20000000);
+    Correctness(records, &cfg);
+    Tears(&cfg);
+    Rates();
+    Scaling();
+    free(refs);
+    return 0;
+}
@@ -0,0 +1,263 @@
+/**
+ * @file mram_profile_bench.c
+ * @brief littlefs on the MRAM: the MRAM profile against NOR flash settings.
+ *
+ * Both configurations run on the burst block device
+ * (Tools/MramLittleFsPicoDemo/lfs_mrambd.c) over the SPI MRAM model, so the
+ * times are bus time. The NOR settings are the ones the demo sketch had:
+ * 16 byte reads and programs, 512 byte blocks, 64 byte caches, wear leveling
+ * every 500 erases. The MRAM profile is lfs_mrambd_profile().
+ *
+ * Each configuration is formatted and filled with directories of small
+ * files, then:
+ *  - it is mounted, and the mount is timed;
+ *  - small status files are rewritten whole (open, truncate, write, close);
+ *  - records are appended to log files (open, append, close).
+ * Every call is timed. A compaction, or the copy of a file's last block,
+ * shows as a call taking several times the median: these are the stalls.
+ * Erase calls count the blocks littlefs allocated for metadata and data.
+ * Files are checked against a reference after a remount.
+ *
+ * Usage: mram_profile_bench [operations] [sck_hz]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "spi_mram_model.h"
+#include "lfs_mrambd.h"
+
+#define MRAM_PROFILE_BENCH_SCK_HZ   20000000u
+#define MRAM_PROFILE_BENCH_OPS      4000u
+#define MRAM_PROFILE_BENCH_DIRS     4u
+#define MRAM_PROFILE_BENCH_FILES    64u         /**< Per directory, up to 200 bytes */
+#define MRAM_PROFILE_BENCH_STATUS   8u          /**< Status files, rewritten whole */
+#define MRAM_PROFILE_BENCH_STATUS_SIZE 48u
+#define MRAM_PROFILE_BENCH_LOGS     16u         /**< Log files, appended to */
+#define MRAM_PROFILE_BENCH_RECORD   32u
+#define MRAM_PROFILE_BENCH_STALL    4u          /**< Stall: more than 4x the median call */
+
+static uint32_t seed = 0x1F5u;
+
+static lfs_mrambd_t mram;
+static uint32_t erases = 0;
+
+// The contents each file must have
+static uint8_t statusData[MRAM_PROFILE_BENCH_STATUS][MRAM_PROFILE_BENCH_STATUS_SIZE];
+static uint8_t statusWritten[MRAM_PROFILE_BENCH_STATUS];
+static uint8_t *logData[MRAM_PROFILE_BENCH_LOGS];
+static uint32_t logSize[MRAM_PROFILE_BENCH_LOGS];
+
+typedef struct {
+    const char *name;
+    double mountUs;
+    uint32_t mountSelects;
+    double meanUs, medianUs, p99Us, maxUs;
+    uint32_t stalls;
+    double stallMs;         /**< Time above the median in stalled calls */
+    double erasesPerOp;
+} sResult_t;
+
+static int CountedErase(const struct lfs_config *cfg, lfs_block_t block) {
+    erases++;
+    return lfs_mrambd_erase(cfg, block);
+}
+
+static void ConfigureNor(struct lfs_config *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->context = &mram;
+    cfg->read = lfs_mrambd_read;
+    cfg->prog = lfs_mrambd_prog;
+    cfg->erase = lfs_mrambd_erase;
+    cfg->sync = lfs_mrambd_sync;
+    cfg->read_size = 16;
+    cfg->prog_size = 16;
+    cfg->block_size = 512;
+    cfg->block_count = LFS_MRAMBD_SIZE / 512;
+    cfg->block_cycles = 500;
+    cfg->cache_size = 64;
+    cfg->lookahead_size = 16;
+}
+
+static int CompareNs(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void Fill(uint8_t *data, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++)
+        data[i] = (uint8_t)bench_rand(&seed);
+}
+
+static void Populate(lfs_t *lfs) {
+    uint8_t data[200];
+    lfs_file_t file;
+    char name[32];
+
+    for (uint32_t d = 0; d < MRAM_PROFILE_BENCH_DIRS; d++) {
+        snprintf(name, sizeof(name), "d%u", (unsigned)d);
+        if (lfs_mkdir(lfs, name))
+            FAIL("mkdir %s", name);
+        for (uint32_t f = 0; f < MRAM_PROFILE_BENCH_FILES; f++) {
+            lfs_size_t size = bench_rand(&seed) % sizeof(data);
+            snprintf(name, sizeof(name), "d%u/f%u", (unsigned)d, (unsigned)f);
+            Fill(data, size);
+            if (lfs_file_open(lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT)
+                    || lfs_file_write(lfs, &file, data, size) != (lfs_ssize_t)size
+                    || lfs_file_close(lfs, &file))
+                FAIL("create %s", name);
+        }
+    }
+}
+
+// One status rewrite or log append, both the small writes of housekeeping
+static void SmallWrite(lfs_t *lfs, uint32_t op) {
+    uint8_t data[MRAM_PROFILE_BENCH_STATUS_SIZE];
+    lfs_file_t file;
+    char name[32];
+
+    if (op % 3 == 0) {
+        uint32_t n = bench_rand(&seed) % MRAM_PROFILE_BENCH_STATUS;
+        snprintf(name, sizeof(name), "status%u", (unsigned)n);
+        Fill(data, sizeof(data));
+        memcpy(statusData[n], data, sizeof(data));
+        statusWritten[n] = 1;
+        if (lfs_file_open(lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC)
+                || lfs_file_write(lfs, &file, data, sizeof(data)) != (lfs_ssize_t)sizeof(data)
+                || lfs_file_close(lfs, &file))
+            FAIL("rewrite %s", name);
+    } else {
+        uint32_t n = bench_rand(&seed) % MRAM_PROFILE_BENCH_LOGS;
+        snprintf(name, sizeof(name), "d0/log%u", (unsigned)n);
+        Fill(data, MRAM_PROFILE_BENCH_RECORD);
+        logData[n] = realloc(logData[n], logSize[n] + MRAM_PROFILE_BENCH_RECORD);
+        memcpy(logData[n] + logSize[n], data, MRAM_PROFILE_BENCH_RECORD);
+        logSize[n] += MRAM_PROFILE_BENCH_RECORD;
+        if (lfs_file_open(lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND)
+                || lfs_file_write(lfs, &file, data, MRAM_PROFILE_BENCH_RECORD) != MRAM_PROFILE_BENCH_RECORD
+                || lfs_file_close(lfs, &file))
+            FAIL("append %s", name);
+    }
+}
+
+static void CheckFile(lfs_t *lfs, const char *name, const uint8_t *expected, uint32_t size) {
+    static uint8_t data[MRAM_PROFILE_BENCH_OPS * MRAM_PROFILE_BENCH_RECORD];
+    lfs_file_t file;
+
+    if (lfs_file_open(lfs, &file, name, LFS_O_RDONLY))
+        FAIL("open %s", name);
+    if (lfs_file_size(lfs, &file) != (lfs_soff_t)size
+            || lfs_file_read(lfs, &file, data, size) != (lfs_ssize_t)size
+            || memcmp(data, expected, size))
+        FAIL("%s differs after remount", name);
+    lfs_file_close(lfs, &file);
+}
+
+static sResult_t Run(const char *name, struct lfs_config *cfg, uint32_t ops, uint32_t sckHz) {
+    uint64_t *ns = malloc(ops * sizeof(*ns));
+    sResult_t result = {0};
+    uint64_t total = 0;
+    char file[32];
+    lfs_t lfs;
+
+    result.name = name;
+    cfg->erase = CountedErase;
+    if (lfs_mrambd_create(cfg, mramModelFixture(sckHz)))
+        FAIL("%s: lfs_mrambd_create", name);
+    if (lfs_format(&lfs, cfg) || lfs_mount(&lfs, cfg))
+        FAIL("%s: format and mount", name);
+    Populate(&lfs);
+    memset(logSize, 0, sizeof(logSize));
+    memset(statusWritten, 0, sizeof(statusWritten));
+    lfs_unmount(&lfs);
+
+    mramModelClearStats();
+    if (lfs_mount(&lfs, cfg))
+        FAIL("%s: mount", name);
+    result.mountUs = mramModelStats()->ns / 1e3;
+    result.mountSelects = mramModelStats()->selects;
+
+    erases = 0;
+    for (uint32_t op = 0; op < ops; op++) {
+        mramModelClearStats();
+        SmallWrite(&lfs, op);
+        ns[op] = mramModelStats()->ns;
+        total += ns[op];
+    }
+    result.erasesPerOp = (double)erases / ops;
+
+    // Every file must read back after a remount
+    lfs_unmount(&lfs);
+    if (lfs_mount(&lfs, cfg))
+        FAIL("%s: remount", name);
+    for (uint32_t n = 0; n < MRAM_PROFILE_BENCH_STATUS; n++) {
+        if (!statusWritten[n])
+            continue;
+        snprintf(file, sizeof(file), "status%u", (unsigned)n);
+        CheckFile(&lfs, file, statusData[n], MRAM_PROFILE_BENCH_STATUS_SIZE);
+    }
+    for (uint32_t n = 0; n < MRAM_PROFILE_BENCH_LOGS; n++) {
+        if (!logSize[n])
+            continue;
+        snprintf(file, sizeof(file), "d0/log%u", (unsigned)n);
+        CheckFile(&lfs, file, logData[n], logSize[n]);
+    }
+    lfs_unmount(&lfs);
+    lfs_mrambd_destroy(cfg);
+
+    qsort(ns, ops, sizeof(*ns), CompareNs);
+    result.meanUs = total / 1e3 / ops;
+    result.medianUs = ns[ops / 2] / 1e3;
+    result.p99Us = ns[ops * 99 / 100] / 1e3;
+    result.maxUs = ns[ops - 1] / 1e3;
+    for (uint32_t op = 0; op < ops; op++) {
+        if (ns[op] > MRAM_PROFILE_BENCH_STALL * ns[ops / 2]) {
+            result.stalls++;
+            result.stallMs += (ns[op] - ns[ops / 2]) / 1e6;
+        }
+    }
+    free(ns);
+    return result;
+}
+
+static void Print(const sResult_t *r) {
+    printf("%-12s %10.0f %8u %9.0f %9.0f %9.0f %10.0f %7u %9.1f %8.2f\n", r->name,
+           r->mountUs, (unsigned)r->mountSelects, r->meanUs, r->medianUs, r->p99Us, r->maxUs,
+           (unsigned)r->stalls, r->stallMs, r->erasesPerOp);
+}
+
+int main(int argc, char **argv) {
+    uint32_t ops = (argc > 1) ? (uint32_t)atoi(argv[1]) : MRAM_PROFILE_BENCH_OPS;
+    uint32_t sckHz = (argc > 2) ? (uint32_t)atoi(argv[2]) : MRAM_PROFILE_BENCH_SCK_HZ;
+    struct lfs_config nor, profile;
+    sResult_t norResult, profileResult;
+
+    if (ops == 0 || ops > MRAM_PROFILE_BENCH_OPS)
+        ops = MRAM_PROFILE_BENCH_OPS;
+
+    ConfigureNor(&nor);
+    lfs_mrambd_profile(&profile, &mram);
+
+    printf("mram_profile_bench: %u dirs of %u files, %u small writes (1/3 %u B rewrites, 2/3 %u B appends), SCK %.1f MHz\n",
+           MRAM_PROFILE_BENCH_DIRS, MRAM_PROFILE_BENCH_FILES, (unsigned)ops, MRAM_PROFILE_BENCH_STATUS_SIZE,
+           MRAM_PROFILE_BENCH_RECORD, sckHz / 1e6);
+    printf("MRAM profile: %u B blocks, read/prog %u B, cache %u B, lookahead %u B, block_cycles %d, inline_max %u B\n",
+           (unsigned)profile.block_size, (unsigned)profile.read_size, (unsigned)profile.cache_size,
+           (unsigned)profile.lookahead_size, (int)profile.block_cycles, (unsigned)profile.inline_max);
+
+    norResult = Run("NOR", &nor, ops, sckHz);
+    profileResult = Run("MRAM profile", &profile, ops, sckHz);
+
+    printf("\n%-12s %10s %8s %9s %9s %9s %10s %7s %9s %8s\n", "settings", "mount us", "mount CS",
+           "mean us", "median", "p99", "max us", "stalls", "stall ms", "erase/op");
+    Print(&norResult);
+    Print(&profileResult);
+    printf("stall: a call over %ux the median, stall ms is their time above it\n", MRAM_PROFILE_BENCH_STALL);
+
+    if (profileResult.mountUs >= norResult.mountUs || profileResult.meanUs >= norResult.meanUs
+            || profileResult.stallMs >= norResult.stallMs)
+        FAIL("the MRAM profile is not faster than the NOR settings");
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file pds_master.h
+ * @brief Minimal I2C master driving the PDS firmware through USCI_B0_ISR.
+ *
+ * Shared by the host tools that run the real AppComm.c / i2c.c. Each helper
+ * raises the interrupts a real eUSCI_B slave would see for one transaction,
+ * then runs the main loop once so queued RX bytes get parsed.
+ */
+
+#ifndef _PDS_MASTER_
+#define _PDS_MASTER_
+
+#include "AppComm.h"
+
+void USCI_B0_ISR(void);
+
+static inline void RaiseI2CInterrupt(uint16_t vector) {
+    UCB0IV = vector;
+    USCI_B0_ISR();
+}
+
+/**
+ * @brief Write transaction: every byte through the RX interrupt, then STOP.
+ */
+static inline void MasterWrite(const uint8_t *data, uint8_t size) {
+    uint8_t i;
+    for (i = 0; i < size; i++) {
+        UCB0RXBUF = data[i];
+        RaiseI2CInterrupt(USCI_I2C_UCRXIFG0);
+    }
+    RaiseI2CInterrupt(USCI_I2C_UCSTPIFG);
+
+    // Main loop: the ISR only queued the bytes
+    ProcessAppComm();
+}
+
+/**
+ * @brief Read transaction: every byte through the TX interrupt, then STOP.
+ */
+static inline void MasterRead(uint8_t *data, uint16_t size) {
+    uint16_t i;
+    for (i = 0; i < size; i++) {
+        RaiseI2CInterrupt(USCI_I2C_UCTXIFG0);
+        data[i] = (uint8_t)UCB0TXBUF;
+    }
+    RaiseI2CInterrupt(USCI_I2C_UCSTPIFG);
+}
+
+static inline void MasterRequestTelemetry(uint8_t channel) {
+    uint8_t frame[3] = {TINYPROTOCOL_MAGIC, channel | 0x80, TINYPROTOCOL_CalculateCRC(&channel, 1)};
+    MasterWrite(frame, sizeof(frame));
+}
+
+#endif // _PDS_MASTER_
@@ -0,0 +1,23 @@
+/**
+ * @file pds_rails_sim.h
+ * @brief Rail table the simulations build APP/PDS_App/bsp.c with.
+ *
+ * The PDS schematic does not fix the rail pins and dividers yet, so the
+ * firmware has no PDS_RAILS of its own (see bsp.h). The pins and windows here
+ * are made up: six rails over two ports, enough to drive the rail sequence,
+ * the window comparator and the RAIL_FAULTS report.
+ */
+
+#ifndef PDS_RAILS_SIM_H
+#define PDS_RAILS_SIM_H
+
+//  X(Rail name,  ADC pin, GPIO port,    GPIO pin,  alarm low, alarm high)
+#define PDS_RAILS(X) \
+    X(RAIL_VBAT,     P1_2, GPIO_PORT_P1, GPIO_PIN2, 2300, 3700) \
+    X(RAIL_3V3,      P1_3, GPIO_PORT_P1, GPIO_PIN3, 1900, 2200) \
+    X(RAIL_5V,       P1_4, GPIO_PORT_P1, GPIO_PIN4, 2700, 3300) \
+    X(RAIL_IBAT,     P1_5, GPIO_PORT_P1, GPIO_PIN5, 0,    3600) \
+    X(RAIL_I3V3,     P3_0, GPIO_PORT_P3, GPIO_PIN0, 0,    3000) \
+    X(RAIL_I5V,      P3_1, GPIO_PORT_P3, GPIO_PIN1, 0,    3000)
+
+#endif // PDS_RAILS_SIM_H
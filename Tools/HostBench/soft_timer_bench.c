@@ -0,0 +1,374 @@
+/**
+ * @file soft_timer_bench.c
+ * @brief Exactness, wake-ups and insert / expire cost of the tickless software timers.
+ *
+ * DRIVERS/MSP430/TIMER/SoftTimer.c runs on the host register file. The
+ * bench plays Timer_A1: the counter jumps from one TA1CCR0 match to the
+ * next and TIMER1_A0_ISR runs on each, so simulated hours take
+ * milliseconds.
+ *
+ * The first part runs thousands of one-shot and periodic timers, some further
+ * out than the wheel reaches. Their callbacks stop, restart and add timers at
+ * random. Every expiry must land on its exact tick, and none may be lost or
+ * repeated. It also checks that there is no tick: an idle service takes no
+ * interrupt at all, and a lone long timer only wakes the CPU once per
+ * SOFT_TIMER_HORIZON.
+ *
+ * A timer set up with SOFT_TIMER_INIT() over stack garbage has to start
+ * and expire like a static one.
+ *
+ * The second part times start, stop and expiry with n timers running,
+ * against a sorted list, the other usual choice. Host cycles include the
+ * register file emulation of the TA1CCR0 update, so the target register
+ * accesses are printed as well.
+ *
+ * Usage: soft_timer_bench [timers] [hours]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <msp430.h>
+
+#include "bench.h"
+#include "SoftTimer.h"
+
+#define SOFT_TIMER_BENCH_TIMERS     4000u
+#define SOFT_TIMER_BENCH_HOURS      3u
+#define SOFT_TIMER_BENCH_OPS        2000u
+
+void TIMER1_A0_ISR(void);
+
+static uint32_t seed = 0x7131E125u;
+
+//***************************Timer_A1*****************************************************
+
+static uint32_t counter = 0;        /**< TA1R, extended to 32 bits */
+static uint32_t isrs = 0;
+
+static void SetCounter(uint32_t tick) {
+    counter = tick;
+    HOST_REG16(SOFT_TIMER_BASE + OFS_TAxR) = (uint16_t)tick;
+}
+
+// Counts up to end, taking TIMER1_A0 on every compare match on the way
+static void RunUntil(uint32_t end) {
+    for (;;) {
+        uint16_t cctl, distance;
+        uint32_t match;
+
+        hostRegSync();
+        cctl = HOST_REG16(SOFT_TIMER_BASE + OFS_TAxCCTL0);
+        if (!(cctl & CCIE))
+            break;
+
+        if (cctl & CCIFG) {
+            match = counter;
+        } else {
+            distance = HOST_REG16(SOFT_TIMER_BASE + OFS_TAxCCR0) - (uint16_t)counter;
+            match = counter + (distance ? distance : 0x10000);
+        }
+        if ((int32_t)(match - end) > 0)
+            break;
+
+        SetCounter(match);
+        HOST_REG16(SOFT_TIMER_BASE + OFS_TAxCCTL0) &= ~CCIFG;
+        isrs++;
+        TIMER1_A0_ISR();
+    }
+    SetCounter(end);
+}
+
+static void Reset(void) {
+    hostRegReset();
+    SetCounter(0);
+    SoftTimer_Init();
+    hostRegSync();
+    if (!(HOST_REG16(SOFT_TIMER_BASE + OFS_TAxCTL) & MC__CONTINUOUS) ||
+        (HOST_REG16(SOFT_TIMER_BASE + OFS_TAxCTL) & TASSEL_3) != TASSEL__ACLK)
+        FAIL("Timer_A1 is not counting ACLK in continuous mode");
+    SetCounter(0);
+    isrs = 0;
+}
+
+//***************************Workload*****************************************************
+
+typedef struct {
+    sSoftTimer_t timer;             /**< First, so the callback can cast back */
+    uint32_t due;                   /**< Reference deadline */
+    uint8_t running;                /**< Reference state */
+    uint32_t fired;
+} sBenchTimer_t;
+
+static sBenchTimer_t *timers;
+static uint32_t timer_count;
+static uint32_t expiries, restarts, stops;
+static uint32_t now_offset;         /**< counter - SoftTimer_Now(), whole wraps the idle service missed */
+
+static uint32_t RandomDelay(void) {
+    switch (bench_rand(&seed) % 8) {
+        case 0:  return bench_rand(&seed) % 16;                             // Next few ticks
+        case 1:  return SOFT_TIMER_SECONDS(60) + bench_rand(&seed) % SOFT_TIMER_SECONDS(7200);  // Up to past the wheel
+        default: return 1 + bench_rand(&seed) % SOFT_TIMER_SECONDS(600);
+    }
+}
+
+static void Start(sBenchTimer_t *t, uint32_t delay, uint32_t period) {
+    if (SoftTimer_Count() == 0)
+        now_offset = counter - SoftTimer_Now();
+    SoftTimer_Start(&t->timer, delay, period);
+    t->due = counter + (delay ? delay : 1);
+    t->running = 1;
+}
+
+static void Expired(sSoftTimer_t *timer) {
+    sBenchTimer_t *t = (sBenchTimer_t *)timer;
+    sBenchTimer_t *other;
+    uint32_t now = SoftTimer_Now() + now_offset;
+
+    if (!t->running)
+        FAIL("a stopped timer expired at tick %u", now);
+    if (now != t->due || now != counter)
+        FAIL("timer %u due at tick %u expired at %u (counter %u)", (unsigned)(t - timers), t->due, now, counter);
+    t->fired++;
+    expiries++;
+
+    if (t->timer.period != 0)
+        t->due += t->timer.period;
+    else
+        t->running = 0;
+
+    // Disturb the wheel from inside the ISR, as a real callback may
+    other = &timers[bench_rand(&seed) % timer_count];
+    switch (bench_rand(&seed) % 16) {
+        case 0:
+            SoftTimer_Stop(&other->timer);
+            other->running = 0;
+            stops++;
+            break;
+        case 1:
+            Start(other, RandomDelay(), (bench_rand(&seed) & 1) ? 1 + bench_rand(&seed) % SOFT_TIMER_SECONDS(300) : 0);
+            restarts++;
+            break;
+        case 2:
+            // Restarting itself from its own callback
+            Start(t, bench_rand(&seed) % 4, 0);
+            restarts++;
+            break;
+        default:
+            break;
+    }
+}
+
+static void Counted(sSoftTimer_t *timer) {
+    (void)timer;
+    expiries++;
+}
+
+static void CheckExact(uint32_t count, uint32_t hours) {
+    uint32_t end = SOFT_TIMER_SECONDS(3600) * hours;
+    uint32_t i, step, ticks;
+
+    timers = calloc(count, sizeof(*timers));
+    timer_count = count;
+    Reset();
+
+    for (i = 0; i < count; i++) {
+        timers[i].timer.Timer_Expired = Expired;
+        // A third periodic, down to one tick
+        Start(&timers[i], RandomDelay(), (i % 3 == 0) ? 1 + bench_rand(&seed) % SOFT_TIMER_SECONDS(300) : 0);
+    }
+    if (SoftTimer_Count() != count)
+        FAIL("%u timers running after starting %u", SoftTimer_Count(), count);
+
+    // Main loop activity in between: stops and starts at random times
+    for (step = 0; counter < end; step++) {
+        sBenchTimer_t *t = &timers[bench_rand(&seed) % count];
+
+        RunUntil(counter + 1 + bench_rand(&seed) % SOFT_TIMER_SECONDS(20));
+        if (step & 1) {
+            SoftTimer_Stop(&t->timer);
+            t->running = 0;
+        } else {
+            Start(t, RandomDelay(), 0);
+        }
+    }
+
+    // Every timer still running is due later, every reference one is running
+    ticks = 0;
+    for (i = 0; i < count; i++) {
+        if (SoftTimer_Running(&timers[i].timer) != timers[i].running)
+            FAIL("timer %u running %u, expected %u", i, SoftTimer_Running(&timers[i].timer), timers[i].running);
+        if (timers[i].running && (int32_t)(timers[i].due - counter) <= 0)
+            FAIL("timer %u due at tick %u missed, now %u", i, timers[i].due, counter);
+        ticks += timers[i].running;
+    }
+    if (SoftTimer_Count() != ticks)
+        FAIL("SoftTimer_Count() %u, %u running", SoftTimer_Count(), ticks);
+
+    printf("%u timers over %u h: %u expiries, %u ISRs (%.2f per expiry), %u restarts and %u stops from callbacks, all on their tick\n",
+           count, hours, expiries, isrs, (double)isrs / expiries, restarts, stops);
+
+    // Idle: no timer, no interrupt
+    for (i = 0; i < count; i++)
+        SoftTimer_Stop(&timers[i].timer);
+    isrs = 0;
+    RunUntil(counter + SOFT_TIMER_SECONDS(3600));
+    if (isrs != 0)
+        FAIL("%u interrupts in an hour with no timer running", isrs);
+
+    // One 10 minute timer: only the horizon compares and its expiry. SoftTimer_Now() missed the wraps of
+    // the idle hour, so only the expiry count is checked.
+    expiries = 0;
+    timers[0].timer.Timer_Expired = Counted;
+    SoftTimer_Start(&timers[0].timer, SOFT_TIMER_SECONDS(600), 0);
+    RunUntil(counter + SOFT_TIMER_SECONDS(600) - 1);
+    if (expiries != 0)
+        FAIL("a 10 minute timer expired early");
+    RunUntil(counter + 1);
+    if (expiries != 1 || isrs > SOFT_TIMER_SECONDS(600) / SOFT_TIMER_HORIZON + 1)
+        FAIL("a lone 10 minute timer expired %u times in %u interrupts", expiries, isrs);
+    printf("idle hour: 0 interrupts; lone 10 min timer: %u interrupts (horizon %lu ticks, %.1f s)\n",
+           isrs, (unsigned long)SOFT_TIMER_HORIZON, (double)SOFT_TIMER_HORIZON / SOFT_TIMER_HZ);
+
+    free(timers);
+}
+
+// A timer that is not static starts with whatever was in its memory
+static void CheckInit(void) {
+    sSoftTimer_t timer;
+
+    Reset();
+    expiries = 0;
+    memset(&timer, 0xA5, sizeof(timer));
+    timer = (sSoftTimer_t)SOFT_TIMER_INIT(Counted);
+    if (SoftTimer_Running(&timer))
+        FAIL("a SOFT_TIMER_INIT() timer is running");
+    SoftTimer_Start(&timer, SOFT_TIMER_MS(100), 0);
+    if (SoftTimer_Count() != 1)
+        FAIL("%u timers running after starting a SOFT_TIMER_INIT() timer", SoftTimer_Count());
+    RunUntil(counter + SOFT_TIMER_MS(100));
+    if (expiries != 1 || SoftTimer_Running(&timer) || SoftTimer_Count() != 0)
+        FAIL("a SOFT_TIMER_INIT() timer expired %u times", expiries);
+    printf("SOFT_TIMER_INIT() timer over stack garbage: started and expired once\n");
+}
+
+//***************************Sorted list reference****************************************
+
+typedef struct sListTimer {
+    struct sListTimer *next, *prev;
+    uint32_t expires;
+} sListTimer_t;
+
+static sListTimer_t list_head = {&list_head, &list_head, 0};
+
+static void ListInsert(sListTimer_t *t, uint32_t now) {
+    sListTimer_t *at = list_head.next;
+
+    while (at != &list_head && (int32_t)(at->expires - now) <= (int32_t)(t->expires - now))
+        at = at->next;
+    t->next = at;
+    t->prev = at->prev;
+    at->prev->next = t;
+    at->prev = t;
+}
+
+static void ListRemove(sListTimer_t *t) {
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+}
+
+//***************************Cost*********************************************************
+
+static void NoOp(sSoftTimer_t *timer) {
+    (void)timer;
+}
+
+static void Cost(uint32_t count, uint64_t overhead) {
+    sSoftTimer_t *wheel = calloc(count + 1, sizeof(*wheel));
+    sListTimer_t *list = calloc(count + 1, sizeof(*list));
+    uint64_t start_cycles = 0, stop_cycles = 0, expire_cycles = 0;
+    uint64_t list_insert = 0, list_remove = 0, list_expire = 0;
+    uint32_t start_accesses = 0, i, ops = SOFT_TIMER_BENCH_OPS, expired;
+    uint64_t t0;
+
+    Reset();
+    list_head.next = list_head.prev = &list_head;
+    for (i = 0; i <= count; i++) {
+        uint32_t delay = 1 + bench_rand(&seed) % SOFT_TIMER_SECONDS(600);
+
+        wheel[i].Timer_Expired = NoOp;
+        if (i < count) {
+            SoftTimer_Start(&wheel[i], delay, 0);
+            list[i].expires = delay;
+            ListInsert(&list[i], 0);
+        }
+    }
+
+    for (i = 0; i < ops; i++) {
+        uint32_t delay = 1 + bench_rand(&seed) % SOFT_TIMER_SECONDS(600);
+        uint32_t accesses = host_reg_accesses;
+
+        t0 = bench_cycles();
+        SoftTimer_Start(&wheel[count], delay, 0);
+        start_cycles += bench_cycles() - t0 - overhead;
+        start_accesses += host_reg_accesses - accesses;
+        t0 = bench_cycles();
+        SoftTimer_Stop(&wheel[count]);
+        stop_cycles += bench_cycles() - t0 - overhead;
+
+        list[count].expires = delay;
+        t0 = bench_cycles();
+        ListInsert(&list[count], 0);
+        list_insert += bench_cycles() - t0 - overhead;
+        t0 = bench_cycles();
+        ListRemove(&list[count]);
+        list_remove += bench_cycles() - t0 - overhead;
+    }
+
+    // Expire them all, in order
+    t0 = bench_cycles();
+    RunUntil(SOFT_TIMER_SECONDS(601));
+    expire_cycles = bench_cycles() - t0;
+    expired = count - SoftTimer_Count();
+    if (expired != count)
+        FAIL("%u of %u timers expired", expired, count);
+
+    t0 = bench_cycles();
+    while (list_head.next != &list_head)
+        ListRemove(list_head.next);
+    list_expire = bench_cycles() - t0;
+
+    printf("%7u %12.0f %8.1f %10.0f %12.0f %12.0f %12.0f %12.0f\n", count,
+           (double)start_cycles / ops, (double)start_accesses / ops, (double)stop_cycles / ops,
+           (double)expire_cycles / count, (double)list_insert / ops, (double)list_remove / ops,
+           (double)list_expire / count);
+
+    free(wheel);
+    free(list);
+}
+
+int main(int argc, char **argv) {
+    uint32_t count = (argc > 1) ? (uint32_t)atoi(argv[1]) : SOFT_TIMER_BENCH_TIMERS;
+    uint32_t hours = (argc > 2) ? (uint32_t)atoi(argv[2]) : SOFT_TIMER_BENCH_HOURS;
+    static const uint32_t sizes[] = {16, 256, 4096, 16384};
+    uint64_t overhead = bench_cycles_overhead();
+    uint8_t i;
+
+    if (count < 2 || hours == 0)
+        FAIL("usage: soft_timer_bench [timers >= 2] [hours >= 1]");
+
+    printf("soft_timer_bench: %u Hz ticks, %u levels of %u slots\n",
+           (unsigned)SOFT_TIMER_HZ, SOFT_TIMER_LEVELS, 1u << SOFT_TIMER_LEVEL_BITS);
+    CheckExact(count, hours);
+    CheckInit();
+
+    printf("\nhost cycles per operation with n timers running, wheel against a sorted list\n");
+    printf("%7s %12s %8s %10s %12s %12s %12s %12s\n", "n", "wheel start", "reg acc", "stop",
+           "expire", "list insert", "remove", "expire");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        Cost(sizes[i], overhead);
+    printf("wheel start includes setting TA1CCR0 through the register file; expire is TIMER1_A0_ISR time per timer\n");
+    return 0;
+}
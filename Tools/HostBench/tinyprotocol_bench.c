@@ -0,0 +1,351 @@
+/**
+ * @file tinyprotocol_bench.c
+ * @brief Byte-stream throughput benchmark for TINYPROTOCOL_ParseByte.
+ *
+ * A randomized stream of valid and corrupted telecommand / telemetry request
+ * frames is encoded with the master functions and fed byte by byte to the
+ * slave parser. The run reports frames/s, average cycles per byte and the
+ * worst-case per-byte latency, and fails if the parser accepted a different
+ * number of frames than were generated valid.
+ *
+ * The stream is then replayed with the same commands served from a
+ * TINYPROTOCOL_Registry table instead of the registered sizes and the
+ * Config callbacks, and the two dispatch paths are compared.
+ *
+ * Usage: tinyprotocol_bench [frames] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "tinyprotocol.h"
+
+#define BENCH_DEFAULT_FRAMES    2000000u
+#define BENCH_TC_FIRST          TINYPROTOCOL_TC_RESERVED
+#define BENCH_TC_COUNT          (TINYPROTOCOL_MAX_PAYLOAD_SIZE + 1)   /**< One TC per payload size 0..max */
+#define BENCH_TLM_FIRST         TINYPROTOCOL_TLM_RESERVED
+#define BENCH_TLM_COUNT         8
+#define BENCH_HIST_BUCKETS      4096
+#define BENCH_CHUNK_FRAMES      256     /**< Frames timed together in the latency pass */
+#define BENCH_CHUNK_REPEAT      3       /**< Best-of-N per byte to filter host preemption */
+
+//***************************Stream generation***************************************************
+
+static uint8_t *stream = NULL;
+static size_t stream_len = 0;
+static size_t stream_cap = 0;
+static uint32_t *frame_start = NULL;    /**< Stream offset of each frame (parser is idle there) */
+
+static int16_t StreamWriteBuffer(const uint8_t* buffer, uint8_t size) {
+    memcpy(&stream[stream_len], buffer, size);
+    stream_len += size;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static const struct TINYPROTOCOL_Config generatorConfig = {
+    .TINYPROTOCOL_ProcessTelecommand = NULL,
+    .TINYPROTOCOL_ProcessTelemetryRequest = NULL,
+    .TINYPROTOCOL_WriteBuffer = StreamWriteBuffer
+};
+
+//***************************Slave side***************************************************
+
+static uint8_t tlm_data[BENCH_TLM_COUNT][TINYPROTOCOL_MAX_PAYLOAD_SIZE];
+static uint32_t tc_received = 0;
+static uint32_t tlm_received = 0;
+static uint32_t tlm_bytes_sent = 0;
+
+static int16_t SinkWriteBuffer(const uint8_t* buffer, uint8_t size) {
+    (void)buffer;
+    tlm_bytes_sent += size;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static int16_t BenchProcessTelecommand(uint8_t command, const uint8_t* buffer, uint16_t size) {
+    (void)command;
+    (void)buffer;
+    (void)size;
+    tc_received++;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static int16_t DrainTelemetry(void) {
+    // Same drain-and-write sequence as the PDS SendTelemetryResponse
+    uint8_t bytes[TINYPROTOCOL_MAX_PACKET_SIZE];
+    uint8_t count = 0;
+
+    while (TINYPROTOCOL_TelemetryBytesLeft() > 0) {
+        int16_t result = TINYPROTOCOL_ReadNextTelemetryByte(&bytes[count]);
+        if (result != ETINYPROTOCOL_SUCCESS)
+            return result;
+        count++;
+    }
+
+    return SinkWriteBuffer(bytes, count);
+}
+
+static int16_t BenchProcessTelemetryRequest(uint8_t command) {
+    (void)command;
+    tlm_received++;
+    return DrainTelemetry();
+}
+
+static const struct TINYPROTOCOL_Config slaveConfig = {
+    .TINYPROTOCOL_ProcessTelecommand = BenchProcessTelecommand,
+    .TINYPROTOCOL_ProcessTelemetryRequest = BenchProcessTelemetryRequest,
+    .TINYPROTOCOL_WriteBuffer = SinkWriteBuffer
+};
+
+//***************************Registry side***************************************************
+
+static int16_t BenchTelecommandHandler(const uint8_t* buffer, uint16_t size) {
+    (void)buffer;
+    (void)size;
+    tc_received++;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static int16_t BenchTelemetryRefresh(void) {
+    tlm_received++;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static struct TINYPROTOCOL_TelecommandEntry tc_table[BENCH_TC_FIRST + BENCH_TC_COUNT];
+static struct TINYPROTOCOL_TelemetryEntry tlm_table[BENCH_TLM_FIRST + BENCH_TLM_COUNT];
+
+static const struct TINYPROTOCOL_Registry benchRegistry = {
+    .telecommands = tc_table,
+    .telecommand_count = BENCH_TC_FIRST + BENCH_TC_COUNT,
+    .telemetry = tlm_table,
+    .telemetry_count = BENCH_TLM_FIRST + BENCH_TLM_COUNT
+};
+
+// No per-command callbacks: everything is dispatched from the registry
+static const struct TINYPROTOCOL_Config registryConfig = {
+    .TINYPROTOCOL_WriteBuffer = SinkWriteBuffer,
+    .TINYPROTOCOL_TelemetryReady = DrainTelemetry
+};
+
+// The firmware keeps these tables const; the bench fills them at startup
+static void SetBenchRegistry(void) {
+    uint8_t i;
+
+    TINYPROTOCOL_Initialize();
+
+    for (i = 0; i < BENCH_TC_COUNT; i++) {
+        tc_table[BENCH_TC_FIRST + i].handler = BenchTelecommandHandler;
+        tc_table[BENCH_TC_FIRST + i].size = i;
+    }
+
+    for (i = 0; i < BENCH_TLM_COUNT; i++) {
+        tlm_table[BENCH_TLM_FIRST + i].ptr = tlm_data[i];
+        tlm_table[BENCH_TLM_FIRST + i].size = i + 1;
+        tlm_table[BENCH_TLM_FIRST + i].refresh = BenchTelemetryRefresh;
+    }
+
+    // A channel with a payload but no buffer must not get in
+    tlm_table[BENCH_TLM_FIRST].ptr = 0;
+    if (TINYPROTOCOL_SetRegistry(&benchRegistry) != -ETINYPROTOCOL_INVALID_PAYLOAD_SIZE) {
+        fprintf(stderr, "FAIL: registry with a NULL channel buffer accepted\n");
+        exit(1);
+    }
+    tlm_table[BENCH_TLM_FIRST].ptr = tlm_data[0];
+
+    if (TINYPROTOCOL_SetRegistry(&benchRegistry) != ETINYPROTOCOL_SUCCESS) {
+        fprintf(stderr, "FAIL: registry rejected\n");
+        exit(1);
+    }
+}
+
+//***************************Benchmark***************************************************
+
+static void RegisterBenchCommands(void) {
+    uint8_t i;
+
+    TINYPROTOCOL_Initialize();
+
+    for (i = 0; i < BENCH_TC_COUNT; i++) {
+        TINYPROTOCOL_RegisterTelecommand(BENCH_TC_FIRST + i, i);
+    }
+
+    for (i = 0; i < BENCH_TLM_COUNT; i++) {
+        memset(tlm_data[i], 0x40 + i, sizeof(tlm_data[i]));
+        TINYPROTOCOL_RegisterTelemetryChannel(BENCH_TLM_FIRST + i, tlm_data[i], i + 1);
+    }
+}
+
+/**
+ * @brief Fills the stream with a random frame mix.
+ *
+ * Corruption only flips a single bit after the command byte, which CRC8 is
+ * guaranteed to catch, so the number of accepted frames is known exactly.
+ */
+static void GenerateStream(uint32_t frames, uint32_t seed, uint32_t *tc_valid, uint32_t *tlm_valid) {
+    uint32_t rng = seed ? seed : 1;
+    uint8_t payload[TINYPROTOCOL_MAX_PAYLOAD_SIZE];
+    uint32_t f;
+
+    stream_cap = (size_t)frames * (TINYPROTOCOL_MAX_PACKET_SIZE + 2);
+    stream = malloc(stream_cap);
+    frame_start = malloc(((size_t)frames + 1) * sizeof(*frame_start));
+    if (stream == NULL || frame_start == NULL) {
+        fprintf(stderr, "out of memory for %u frames\n", frames);
+        exit(2);
+    }
+
+    *tc_valid = 0;
+    *tlm_valid = 0;
+
+    for (f = 0; f < frames; f++) {
+        uint32_t r = bench_rand(&rng);
+        uint32_t kind = r % 100;
+        size_t start;
+        uint8_t corrupt;
+
+        frame_start[f] = (uint32_t)stream_len;
+
+        // Up to two idle bytes between frames, never the magic byte
+        uint8_t gap = (r >> 8) % 3;
+        while (gap--) {
+            uint8_t noise = (uint8_t)bench_rand(&rng);
+            stream[stream_len++] = (noise == TINYPROTOCOL_MAGIC) ? 0x00 : noise;
+        }
+        start = stream_len;
+
+        if (kind < 65) {
+            uint8_t size = (r >> 16) % BENCH_TC_COUNT;
+            uint8_t i;
+            for (i = 0; i < size; i++)
+                payload[i] = (uint8_t)bench_rand(&rng);
+            TINYPROTOCOL_SendTelecommand(&generatorConfig, BENCH_TC_FIRST + size, payload, size);
+            corrupt = (kind >= 45);
+            if (!corrupt)
+                (*tc_valid)++;
+        } else {
+            uint8_t channel = (r >> 16) % BENCH_TLM_COUNT;
+            TINYPROTOCOL_SendTelemetryRequest(&generatorConfig, BENCH_TLM_FIRST + channel);
+            corrupt = (kind >= 90);
+            if (!corrupt)
+                (*tlm_valid)++;
+        }
+
+        if (corrupt) {
+            // Skip MAGIC and the command byte
+            size_t span = stream_len - start - 2;
+            uint32_t pick = bench_rand(&rng);
+            stream[start + 2 + pick % span] ^= (uint8_t)(1u << ((pick >> 8) & 7));
+        }
+    }
+
+    frame_start[frames] = (uint32_t)stream_len;
+}
+
+int main(int argc, char **argv) {
+    uint32_t frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : BENCH_DEFAULT_FRAMES;
+    uint32_t seed = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x5C5D;
+    uint32_t tc_valid, tlm_valid, tlm_bytes;
+    uint64_t registry_cycles;
+    static uint64_t hist[BENCH_HIST_BUCKETS];
+    uint64_t overhead, total_cycles, worst = 0, worst_pos = 0;
+    double t0, t1;
+    uint32_t f;
+    size_t i;
+
+    RegisterBenchCommands();
+    GenerateStream(frames, seed, &tc_valid, &tlm_valid);
+
+    // Bulk pass: throughput
+    t0 = bench_seconds();
+    uint64_t c0 = bench_cycles();
+    for (i = 0; i < stream_len; i++) {
+        TINYPROTOCOL_ParseByte(&slaveConfig, stream[i]);
+    }
+    total_cycles = bench_cycles() - c0;
+    t1 = bench_seconds();
+    tlm_bytes = tlm_bytes_sent;
+
+    if (tc_received != tc_valid || tlm_received != tlm_valid) {
+        fprintf(stderr, "FAIL: accepted %u/%u telecommands, %u/%u telemetry requests\n",
+                tc_received, tc_valid, tlm_received, tlm_valid);
+        return 1;
+    }
+
+    // Timed pass: per-byte latency distribution. Each chunk starts on a frame
+    // boundary, so the parser is idle and the chunk can be replayed; the
+    // fastest of the replays is kept for every byte.
+    overhead = bench_cycles_overhead();
+    for (f = 0; f < frames; f += BENCH_CHUNK_FRAMES) {
+        static uint64_t best[BENCH_CHUNK_FRAMES * (TINYPROTOCOL_MAX_PACKET_SIZE + 2)];
+        uint32_t last = (f + BENCH_CHUNK_FRAMES < frames) ? f + BENCH_CHUNK_FRAMES : frames;
+        size_t begin = frame_start[f], end = frame_start[last];
+        int rep;
+
+        for (i = begin; i < end; i++)
+            best[i - begin] = UINT64_MAX;
+
+        for (rep = 0; rep < BENCH_CHUNK_REPEAT; rep++) {
+            for (i = begin; i < end; i++) {
+                uint64_t b0 = bench_cycles();
+                TINYPROTOCOL_ParseByte(&slaveConfig, stream[i]);
+                uint64_t dt = bench_cycles() - b0;
+                if (dt < best[i - begin])
+                    best[i - begin] = dt;
+            }
+        }
+
+        for (i = begin; i < end; i++) {
+            uint64_t dt = (best[i - begin] > overhead) ? best[i - begin] - overhead : 0;
+            hist[dt < BENCH_HIST_BUCKETS ? dt : BENCH_HIST_BUCKETS - 1]++;
+            if (dt > worst) {
+                worst = dt;
+                worst_pos = i;
+            }
+        }
+    }
+
+    // Registry pass: same stream, dispatched from the command tables
+    SetBenchRegistry();
+    tc_received = 0;
+    tlm_received = 0;
+    tlm_bytes_sent = 0;
+    c0 = bench_cycles();
+    for (i = 0; i < stream_len; i++) {
+        TINYPROTOCOL_ParseByte(&registryConfig, stream[i]);
+    }
+    registry_cycles = bench_cycles() - c0;
+
+    if (tc_received != tc_valid || tlm_received != tlm_valid || tlm_bytes_sent != tlm_bytes) {
+        fprintf(stderr, "FAIL: registry accepted %u/%u telecommands, %u/%u telemetry requests, sent %u/%u bytes\n",
+                tc_received, tc_valid, tlm_received, tlm_valid, tlm_bytes_sent, tlm_bytes);
+        return 1;
+    }
+
+    uint64_t seen = 0, p99 = 0, p999 = 0;
+    for (i = 0; i < BENCH_HIST_BUCKETS; i++) {
+        seen += hist[i];
+        if (!p99 && seen * 1000 >= (uint64_t)stream_len * 990)
+            p99 = i;
+        if (!p999 && seen * 1000 >= (uint64_t)stream_len * 999) {
+            p999 = i;
+            break;
+        }
+    }
+
+    printf("tinyprotocol parser benchmark (seed 0x%X)\n", seed);
+    printf("  frames            %u (%u tc, %u tlm valid)\n", frames, tc_valid, tlm_valid);
+    printf("  stream bytes      %zu\n", stream_len);
+    printf("  telemetry out     %u bytes\n", tlm_bytes);
+    printf("  frames/s          %.0f\n", frames / (t1 - t0));
+    printf("  MB/s              %.1f\n", stream_len / (t1 - t0) / 1e6);
+    printf("  %s/byte       %.2f\n", BENCH_HAS_TSC ? "cycles" : "ns    ", (double)total_cycles / stream_len);
+    printf("  per-byte p99      %llu\n", (unsigned long long)p99);
+    printf("  per-byte p99.9    %llu\n", (unsigned long long)p999);
+    printf("  per-byte worst    %llu (byte %llu)\n", (unsigned long long)worst, (unsigned long long)worst_pos);
+    printf("  %-17s %.2f\n", BENCH_HAS_TSC ? "registry cyc/byte" : "registry ns/byte", (double)registry_cycles / stream_len);
+
+    free(frame_start);
+    free(stream);
+    return 0;
+}
@@ -0,0 +1,492 @@
+/**
+ * @file tinytransfer_loopback.c
+ * @brief Loopback harness for tinytransfer over an impaired link.
+ *
+ * A sender and a receiver run in the same process and exchange frames over
+ * a simulated full duplex link with a fixed byte rate and one-way latency.
+ * Every frame can be dropped, and every byte can get a bit flipped, before it
+ * reaches the other end. Both ends share the process wide tinyprotocol parser,
+ * which is fine because frames are delivered whole and in arrival order.
+ *
+ * Each scenario moves one object, checks that the receiver ends up with an
+ * identical copy and reports the goodput: object bytes per second of
+ * simulated time, also as a share of the raw link rate. Window 1 is
+ * stop-and-wait and serves as the baseline.
+ *
+ * Then the object goes both ways through the real i2c.c slave driver, with
+ * the slave end configured without WriteBuffer: every frame it sends is read
+ * by the master through USCI_B0_ISR, as an I2C slave cannot write on its own.
+ *
+ * Usage: tinytransfer_loopback [object_bytes] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "i2c.h"
+#include "tinytransfer.h"
+
+#define LOOP_DATA_CMD           TINYPROTOCOL_TC_RESERVED
+#define LOOP_ACK_CMD            (TINYPROTOCOL_TC_RESERVED + 1)
+#define LOOP_OBJECT_BYTES       16384u
+#define LOOP_SEGMENT_SIZE       128
+#define LOOP_BYTES_PER_MS       40.0    /**< ~400 kHz I2C or 460800 baud UART */
+#define LOOP_LATENCY_MS         2.0
+#define LOOP_MAX_MS             120000u
+#define LOOP_MAX_FRAME          (5 + TINYTRANSFER_HEADER_SIZE + TINYTRANSFER_MAX_SEGMENT_SIZE)
+#define LOOP_QUEUE_FRAMES       512
+#define LOOP_I2C_POLL_MS        1.0     /**< Master read poll period while the slave has nothing staged */
+#define LOOP_I2C_SLAVE_ADDRESS  0x08
+
+//***************************Link model***************************************************
+
+typedef struct {
+    double arrival_ms;
+    uint16_t size;
+    uint8_t bytes[LOOP_MAX_FRAME];
+} sFrame_t;
+
+typedef struct {
+    sFrame_t queue[LOOP_QUEUE_FRAMES];
+    uint32_t head, tail;
+    double busy_until_ms;       /**< When the wire is free for the next frame */
+    sFrame_t pending;           /**< Frame being assembled from WriteBuffer calls */
+    uint16_t pending_expected;
+    uint32_t frames, dropped, flipped_bytes, wire_bytes;
+} sLink_t;
+
+static sLink_t links[2];        /**< 0: sender to receiver, 1: receiver to sender */
+static double now_ms = 0;
+static double drop_rate = 0;
+static double byte_flip_rate = 0;
+static uint8_t dones_to_drop = 0;   /**< DONE frames still to lose on links[1], on top of drop_rate */
+static int receiver_absent = 0;     /**< Lose every frame on links[0] */
+static uint32_t rng = 1;
+
+static double Uniform(void) {
+    return (bench_rand(&rng) >> 8) * (1.0 / 16777216.0);
+}
+
+static void LinkReset(sLink_t *link) {
+    memset(link, 0, sizeof(*link));
+}
+
+// Impairs a complete frame and puts it on the wire
+static void LinkSubmit(sLink_t *link) {
+    sFrame_t *frame = &link->pending;
+    double start = (now_ms > link->busy_until_ms) ? now_ms : link->busy_until_ms;
+    uint16_t i;
+
+    link->frames++;
+    link->wire_bytes += frame->size;
+    link->busy_until_ms = start + frame->size / LOOP_BYTES_PER_MS;
+
+    if ((link == &links[0] && receiver_absent) ||
+        (link == &links[1] && dones_to_drop != 0 && frame->bytes[4] == TINYTRANSFER_FRAME_DONE)) {
+        if (link == &links[1])
+            dones_to_drop--;
+        link->dropped++;
+        return;
+    }
+    if (Uniform() < drop_rate) {
+        link->dropped++;
+        return;
+    }
+    for (i = 0; i < frame->size; i++) {
+        if (Uniform() < byte_flip_rate) {
+            frame->bytes[i] ^= (uint8_t)(1 << (bench_rand(&rng) & 7));
+            link->flipped_bytes++;
+        }
+    }
+
+    if (link->head - link->tail == LOOP_QUEUE_FRAMES) {
+        fprintf(stderr, "FAIL: link queue overflow\n");
+        exit(1);
+    }
+    frame->arrival_ms = link->busy_until_ms + LOOP_LATENCY_MS;
+    link->queue[link->head++ % LOOP_QUEUE_FRAMES] = *frame;
+}
+
+// tinytransfer only sends large frames: MAGIC, cmd, 16 bit length, payload, CRC
+static void LinkWrite(sLink_t *link, const uint8_t *buffer, uint8_t size) {
+    uint8_t i;
+    for (i = 0; i < size; i++) {
+        sFrame_t *frame = &link->pending;
+        frame->bytes[frame->size++] = buffer[i];
+        if (frame->size == 4)
+            link->pending_expected = 5 + (frame->bytes[2] | (frame->bytes[3] << 8));
+        if (frame->size >= 4 && frame->size == link->pending_expected) {
+            LinkSubmit(link);
+            frame->size = 0;
+        }
+    }
+}
+
+static int16_t SenderWriteBuffer(const uint8_t* buffer, uint8_t size) {
+    LinkWrite(&links[0], buffer, size);
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static int16_t ReceiverWriteBuffer(const uint8_t* buffer, uint8_t size) {
+    LinkWrite(&links[1], buffer, size);
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static const struct TINYPROTOCOL_Config senderConfig = {
+    .TINYPROTOCOL_WriteBuffer = SenderWriteBuffer
+};
+
+static const struct TINYPROTOCOL_Config receiverConfig = {
+    .TINYPROTOCOL_WriteBuffer = ReceiverWriteBuffer
+};
+
+//***************************Both ends***************************************************
+
+static int16_t DispatchTelecommand(uint8_t command, const uint8_t* buffer, uint16_t size) {
+    if (command == LOOP_DATA_CMD)
+        return TINYTRANSFER_ProcessSegment(buffer, size);
+    if (command == LOOP_ACK_CMD)
+        return TINYTRANSFER_ProcessAck(buffer, size);
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static const struct TINYPROTOCOL_Config parserConfig = {
+    .TINYPROTOCOL_ProcessTelecommand = DispatchTelecommand
+};
+
+// Delivers every frame that has arrived by now, oldest first across both directions
+static void DeliverFrames(void) {
+    for (;;) {
+        sLink_t *from = NULL;
+        sFrame_t *frame;
+        uint16_t i;
+        int d;
+
+        for (d = 0; d < 2; d++) {
+            sLink_t *link = &links[d];
+            if (link->head != link->tail && link->queue[link->tail % LOOP_QUEUE_FRAMES].arrival_ms <= now_ms &&
+                (from == NULL || link->queue[link->tail % LOOP_QUEUE_FRAMES].arrival_ms <
+                                 from->queue[from->tail % LOOP_QUEUE_FRAMES].arrival_ms))
+                from = link;
+        }
+        if (from == NULL)
+            return;
+
+        frame = &from->queue[from->tail++ % LOOP_QUEUE_FRAMES];
+        for (i = 0; i < frame->size; i++)
+            TINYPROTOCOL_ParseByte(&parserConfig, frame->bytes[i]);
+    }
+}
+
+//***************************I2C slave***************************************************
+// The slave end runs behind i2c.c and has no WriteBuffer: each frame it sends
+// is staged, and the master reads the header (MAGIC, cmd, length), then the
+// rest of the frame in the same transaction. The master end writes its frames
+// through links[], with no impairments, and the bus time is counted in now_ms.
+
+void USCI_B0_ISR(void);
+
+static void RaiseI2CInterrupt(uint16_t vector) {
+    UCB0IV = vector;
+    USCI_B0_ISR();
+}
+
+static void SlaveRxByte(uint8_t data) {
+    TINYPROTOCOL_ParseByte(&parserConfig, data);
+}
+
+static const struct TINYPROTOCOL_Config slaveConfig = {
+    .TINYPROTOCOL_TelemetryReady = transmitI2CStream
+};
+
+// Write transaction of one frame. A segment is larger than the RX ring, so
+// the slave main loop drains it as the bytes come in, as it does on the
+// target where each byte takes 22 us at 400 kHz.
+static void MasterWriteFrame(const sFrame_t *frame) {
+    uint16_t i;
+
+    for (i = 0; i < frame->size; i++) {
+        UCB0RXBUF = frame->bytes[i];
+        RaiseI2CInterrupt(USCI_I2C_UCRXIFG0);
+        processI2C();
+    }
+    RaiseI2CInterrupt(USCI_I2C_UCSTPIFG);
+    now_ms += (1 + frame->size) / LOOP_BYTES_PER_MS;
+}
+
+// Read transaction: the header, and the rest of the frame if one is staged.
+// Returns 1 if a frame was read and parsed.
+static int MasterReadFrame(void) {
+    uint8_t frame[LOOP_MAX_FRAME];
+    uint16_t size = 4, i;
+
+    for (i = 0; i < size; i++) {
+        RaiseI2CInterrupt(USCI_I2C_UCTXIFG0);
+        frame[i] = (uint8_t)UCB0TXBUF;
+
+        if (i == 3 && frame[0] == TINYPROTOCOL_MAGIC) {
+            size = 4 + (frame[2] | (frame[3] << 8)) + 1;
+            if (size > LOOP_MAX_FRAME) {
+                fprintf(stderr, "FAIL: slave staged a %u byte frame\n", size);
+                exit(1);
+            }
+        }
+    }
+    RaiseI2CInterrupt(USCI_I2C_UCSTPIFG);
+    now_ms += (1 + size) / LOOP_BYTES_PER_MS;
+
+    if (frame[0] != TINYPROTOCOL_MAGIC)
+        return 0;
+    for (i = 0; i < size; i++)
+        TINYPROTOCOL_ParseByte(&parserConfig, frame[i]);
+    return 1;
+}
+
+//***************************Scenarios***************************************************
+
+static uint8_t *object;
+static uint8_t *received;
+static uint32_t object_bytes;
+
+typedef struct {
+    const char *name;
+    double drop_rate;
+    double bit_error_rate;
+    int corrupt_receiver;       /**< Damage the receiver's copy mid-transfer to force an object CRC restart */
+} sScenario_t;
+
+// Moves the object over links[] until the sender is done or gives up, returns the ms it took.
+// The link impairments are set by the caller.
+static uint32_t Transfer(uint8_t window, uint32_t capacity, int corrupt_receiver) {
+    // Long enough for a full window to queue up behind the wire, then some
+    double frame_ms = (5 + TINYTRANSFER_HEADER_SIZE + LOOP_SEGMENT_SIZE) / LOOP_BYTES_PER_MS;
+    uint16_t timeout = (uint16_t)(2 * (window * frame_ms + 2 * LOOP_LATENCY_MS) + 10);
+    uint32_t ms;
+    int corrupted = 0;
+
+    TINYPROTOCOL_Initialize();
+    LinkReset(&links[0]);
+    LinkReset(&links[1]);
+    memset(received, 0, object_bytes);
+    now_ms = 0;
+
+    TINYTRANSFER_InitReceiver(&receiverConfig, LOOP_DATA_CMD, LOOP_ACK_CMD, received, capacity);
+    TINYTRANSFER_InitSender(&senderConfig, LOOP_DATA_CMD, LOOP_ACK_CMD, window, timeout);
+    TINYTRANSFER_Send(object, object_bytes, LOOP_SEGMENT_SIZE);
+
+    for (ms = 0; ms < LOOP_MAX_MS && TINYTRANSFER_SenderStatus() == TINYTRANSFER_BUSY; ms++) {
+        now_ms = ms;
+        DeliverFrames();
+        TINYTRANSFER_SenderTick();
+
+        if (corrupt_receiver && !corrupted && received[object_bytes / 2] != 0) {
+            received[object_bytes / 2] ^= 0x01;
+            corrupted = 1;
+        }
+    }
+    return ms;
+}
+
+static int RunTransfer(const sScenario_t *scenario, uint8_t window, double *goodput) {
+    const TINYTRANSFER_SenderStats *stats;
+    uint32_t size = 0, ms;
+
+    drop_rate = scenario->drop_rate;
+    byte_flip_rate = scenario->bit_error_rate * 8;
+    ms = Transfer(window, object_bytes, scenario->corrupt_receiver);
+
+    stats = TINYTRANSFER_GetSenderStats();
+    if (TINYTRANSFER_SenderStatus() != TINYTRANSFER_DONE ||
+        TINYTRANSFER_ReceiverStatus(&size) != TINYTRANSFER_DONE ||
+        size != object_bytes || memcmp(object, received, object_bytes) != 0) {
+        fprintf(stderr, "FAIL: %s, window %u: transfer did not complete intact after %u ms\n",
+                scenario->name, window, ms);
+        return 0;
+    }
+    if (scenario->corrupt_receiver && stats->restarts == 0) {
+        fprintf(stderr, "FAIL: %s: damaged copy was not caught by the object CRC\n", scenario->name);
+        return 0;
+    }
+
+    *goodput = object_bytes / (double)ms;   // bytes per ms = kB/s
+    printf("  %-22s %6u %8u %9.2f %7.1f%% %9u %8u %7u %6u %3u\n", scenario->name, window, ms,
+           *goodput, 100.0 * *goodput / LOOP_BYTES_PER_MS, stats->segments_sent, stats->retransmits,
+           links[0].dropped + links[1].dropped, links[0].flipped_bytes + links[1].flipped_bytes,
+           stats->restarts);
+    return 1;
+}
+
+// Lost answers: the sender has to settle with the right result instead of
+// resending forever
+typedef struct {
+    const char *name;
+    uint8_t dones_to_drop;
+    int receiver_absent;
+    uint32_t capacity_short;        /**< Receiver buffer this much under the object, to get it rejected */
+    TINYTRANSFER_Status status;
+    uint8_t result;
+} sLostAnswer_t;
+
+static int RunLostAnswer(const sLostAnswer_t *test) {
+    const TINYTRANSFER_SenderStats *stats;
+    uint32_t ms;
+
+    drop_rate = 0;
+    byte_flip_rate = 0;
+    dones_to_drop = test->dones_to_drop;
+    receiver_absent = test->receiver_absent;
+    ms = Transfer(1, object_bytes - test->capacity_short, 0);
+    dones_to_drop = 0;
+    receiver_absent = 0;
+
+    stats = TINYTRANSFER_GetSenderStats();
+    if (ms >= LOOP_MAX_MS || TINYTRANSFER_SenderStatus() != test->status ||
+        TINYTRANSFER_SenderResult() != test->result) {
+        fprintf(stderr, "FAIL: %s: sender status %u result %u after %u ms, expected status %u result %u\n",
+                test->name, TINYTRANSFER_SenderStatus(), TINYTRANSFER_SenderResult(), ms,
+                test->status, test->result);
+        return 0;
+    }
+    if (test->status == TINYTRANSFER_DONE && memcmp(object, received, object_bytes) != 0) {
+        fprintf(stderr, "FAIL: %s: copy differs\n", test->name);
+        return 0;
+    }
+
+    printf("  %-22s %6u %8u %9s %8s %9u %8u %7u %6u %3u\n", test->name, 1, ms, "-", "-",
+           stats->segments_sent, stats->retransmits, links[0].dropped + links[1].dropped, 0u, stats->restarts);
+    return 1;
+}
+
+// Moves the object to or from the I2C slave. A sender on the slave keeps a
+// window of 1, as only its last frame can be read.
+static int RunI2CTransfer(const char *name, int slave_sends, uint8_t window, double *goodput) {
+    double frame_ms = (5 + TINYTRANSFER_HEADER_SIZE + LOOP_SEGMENT_SIZE) / LOOP_BYTES_PER_MS;
+    uint16_t timeout = (uint16_t)(2 * (window * frame_ms + LOOP_I2C_POLL_MS) + 10);
+    sI2cConfigCb_t i2c = {
+        .Rx_Proc_Data = SlaveRxByte,
+        .Tx_Next_Data = TINYPROTOCOL_ReadNextTelemetryByte,
+        .slave_addr = LOOP_I2C_SLAVE_ADDRESS
+    };
+    sLink_t *master_link = &links[slave_sends ? 1 : 0];
+    const TINYTRANSFER_SenderStats *stats;
+    double next_tick_ms = 0;
+    uint32_t size = 0;
+
+    TINYPROTOCOL_Initialize();
+    LinkReset(&links[0]);
+    LinkReset(&links[1]);
+    memset(received, 0, object_bytes);
+    now_ms = 0;
+    drop_rate = 0;
+    byte_flip_rate = 0;
+    initI2C(&i2c);
+
+    if (slave_sends) {
+        TINYTRANSFER_InitReceiver(&receiverConfig, LOOP_DATA_CMD, LOOP_ACK_CMD, received, object_bytes);
+        TINYTRANSFER_InitSender(&slaveConfig, LOOP_DATA_CMD, LOOP_ACK_CMD, window, timeout);
+    } else {
+        TINYTRANSFER_InitReceiver(&slaveConfig, LOOP_DATA_CMD, LOOP_ACK_CMD, received, object_bytes);
+        TINYTRANSFER_InitSender(&senderConfig, LOOP_DATA_CMD, LOOP_ACK_CMD, window, timeout);
+    }
+    TINYTRANSFER_Send(object, object_bytes, LOOP_SEGMENT_SIZE);
+
+    while (now_ms < LOOP_MAX_MS && TINYTRANSFER_SenderStatus() == TINYTRANSFER_BUSY) {
+        while (master_link->head != master_link->tail)
+            MasterWriteFrame(&master_link->queue[master_link->tail++ % LOOP_QUEUE_FRAMES]);
+
+        if (!MasterReadFrame())
+            now_ms += LOOP_I2C_POLL_MS;
+
+        for (; next_tick_ms <= now_ms; next_tick_ms += 1)
+            TINYTRANSFER_SenderTick();
+    }
+
+    stats = TINYTRANSFER_GetSenderStats();
+    if (TINYTRANSFER_SenderStatus() != TINYTRANSFER_DONE ||
+        TINYTRANSFER_ReceiverStatus(&size) != TINYTRANSFER_DONE ||
+        size != object_bytes || memcmp(object, received, object_bytes) != 0) {
+        fprintf(stderr, "FAIL: %s, window %u: transfer did not complete intact after %.0f ms\n",
+                name, window, now_ms);
+        return 0;
+    }
+    // Nothing is impaired: a resend means a staged frame was replaced before the master read it
+    if (stats->retransmits != 0 || stats->restarts != 0) {
+        fprintf(stderr, "FAIL: %s, window %u: %u frames resent on a clean bus\n", name, window, stats->retransmits);
+        return 0;
+    }
+
+    *goodput = object_bytes / now_ms;
+    printf("  %-22s %6u %8.0f %9.2f %7.1f%% %9u %8u %7u %6u %3u\n", name, window, now_ms,
+           *goodput, 100.0 * *goodput / LOOP_BYTES_PER_MS, stats->segments_sent, stats->retransmits,
+           0u, 0u, stats->restarts);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    static const sScenario_t scenarios[] = {
+        {"clean", 0, 0, 0},
+        {"2% drops", 0.02, 0, 0},
+        {"BER 1e-4", 0, 1e-4, 0},
+        {"5% drops + BER 1e-4", 0.05, 1e-4, 0},
+        {"object CRC restart", 0, 0, 1},
+    };
+    static const uint8_t windows[] = {1, 4, 8, 16};
+    static const sLostAnswer_t lost_answers[] = {
+        {"DONE lost once", 1, 0, 0, TINYTRANSFER_DONE, TINYTRANSFER_RESULT_OK},
+        {"rejected, DONE lost", 1, 0, 1, TINYTRANSFER_FAILED, TINYTRANSFER_RESULT_ETOO_LARGE},
+        {"every DONE lost", 255, 0, 0, TINYTRANSFER_FAILED, TINYTRANSFER_RESULT_ETIMEOUT},
+        {"no receiver", 0, 1, 0, TINYTRANSFER_FAILED, TINYTRANSFER_RESULT_ETIMEOUT},
+    };
+    uint32_t seed;
+    unsigned s, w, i;
+
+    object_bytes = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : LOOP_OBJECT_BYTES;
+    seed = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 0x7AB5;
+    rng = seed ? seed : 1;
+
+    object = malloc(object_bytes);
+    received = malloc(object_bytes);
+    for (i = 0; i < object_bytes; i++)
+        object[i] = (uint8_t)bench_rand(&rng);
+
+    printf("tinytransfer loopback, %u byte object, %d byte segments, %.0f kB/s link, %.0f ms latency\n",
+           object_bytes, LOOP_SEGMENT_SIZE, LOOP_BYTES_PER_MS, LOOP_LATENCY_MS);
+    printf("  %-22s %6s %8s %9s %8s %9s %8s %7s %6s %3s\n", "scenario", "window", "ms",
+           "kB/s", "of link", "segments", "resent", "dropped", "flips", "rst");
+
+    for (s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+        double stop_and_wait = 0;
+        for (w = 0; w < sizeof(windows); w++) {
+            double goodput;
+            if (!RunTransfer(&scenarios[s], windows[w], &goodput))
+                return 1;
+            if (windows[w] == 1)
+                stop_and_wait = goodput;
+            else if (scenarios[s].drop_rate == 0 && scenarios[s].bit_error_rate == 0 && goodput <= stop_and_wait) {
+                fprintf(stderr, "FAIL: window %u is not faster than stop-and-wait\n", windows[w]);
+                return 1;
+            }
+        }
+    }
+
+    printf("  lost answers, the sender settles on its own\n");
+    for (i = 0; i < sizeof(lost_answers) / sizeof(lost_answers[0]); i++) {
+        if (!RunLostAnswer(&lost_answers[i]))
+            return 1;
+    }
+
+    printf("  through the I2C slave driver, slave without WriteBuffer\n");
+    {
+        double goodput;
+        if (!RunI2CTransfer("I2C slave receives", 0, 1, &goodput) ||
+            !RunI2CTransfer("I2C slave receives", 0, 4, &goodput) ||
+            !RunI2CTransfer("I2C slave sends", 1, 1, &goodput))
+            return 1;
+    }
+
+    free(object);
+    free(received);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * @file tlm_burst_bench.c
+ * @brief Bus time of a PDS housekeeping cycle: one request per channel vs one burst.
+ *
+ * The real AppComm.c, i2c.c and tinyprotocol.c are driven through
+ * USCI_B0_ISR. Every PDS channel is first read with its own request/response
+ * pair, then all of them at once with TINYPROTOCOL_SendTelemetryBurstRequest.
+ * The burst response must equal the per-channel payloads concatenated in
+ * request order, followed by one valid CRC over all of them.
+ *
+ * The channel list and response lengths come from PDS_COMMANDS (comm.h), and a
+ * telecommand sent with the generated master encoder must reach the slave, so
+ * the two sides cannot drift apart.
+ *
+ * Bus time is derived from the bytes each transaction moved:
+ *  - START + address byte + data bytes + STOP, 9 SCL periods per byte and
+ *    one each for START and STOP
+ *  - a fixed master turnaround before every transaction (SAMV71 driver
+ *    setup, interrupt latency, deciding what to read next)
+ *
+ * Usage: tlm_burst_bench [turnaround_us]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "comm_master.h"
+#include "pds_master.h"
+
+#define BURST_BENCH_TURNAROUND_US   50.0
+#define BURST_BENCH_MAX_RESPONSE    (TINYPROTOCOL_MAX_BURST_CHANNELS * MAX_BUFFER_SIZE)
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;         /**< Data bytes, without the address byte */
+} sBusUsage_t;
+
+static int16_t WriteFrame(const uint8_t* buffer, uint8_t size) {
+    MasterWrite(buffer, size);
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static const struct TINYPROTOCOL_Config masterConfig = {
+    .TINYPROTOCOL_WriteBuffer = WriteFrame
+};
+
+static double BusSeconds(const sBusUsage_t *usage, double scl_hz, double turnaround_us) {
+    double clocks = usage->transactions * (2.0 + 9.0) + usage->bytes * 9.0;
+    return clocks / scl_hz + usage->transactions * turnaround_us * 1e-6;
+}
+
+int main(int argc, char **argv) {
+#define PDS_CHANNEL(ID, Name, cmd_len, resp_len)     {ID##_ID, ID##_RESP_FRAME_LEN},
+    static const struct {
+        uint8_t id;
+        uint16_t frame_len;
+    } pds_channels[] = {
+        PDS_COMMANDS(PDS_CHANNEL)
+    };
+    static const uint8_t status_args[SYSTEM_STATUS_CMD_LEN] = {0xB, 0xC};
+    static const double scl_rates[] = {100e3, 400e3, 1e6};
+    double turnaround_us = (argc > 1) ? strtod(argv[1], NULL) : BURST_BENCH_TURNAROUND_US;
+    uint8_t channels[TINYPROTOCOL_MAX_BURST_CHANNELS];
+    uint8_t expected[BURST_BENCH_MAX_RESPONSE], response[BURST_BENCH_MAX_RESPONSE];
+    sBusUsage_t single = {0, 0}, burst = {0, 0};
+    uint16_t payload = 0;
+    uint8_t count = 0;
+    int16_t size;
+    unsigned c;
+
+    InitAppComm();
+
+    // Arguments sent with the generated encoder come back in the system status response
+    PDS_SendSystemStatus(&masterConfig, status_args);
+    PDS_RequestSystemStatus(&masterConfig);
+    MasterRead(response, SYSTEM_STATUS_RESP_FRAME_LEN);
+    if (response[3] != status_args[0] || response[4] != status_args[1]) {
+        fprintf(stderr, "FAIL: system status telecommand did not reach the slave\n");
+        return 1;
+    }
+
+    // One request/response per channel, as the master does today
+    for (c = 0; c < sizeof(pds_channels) / sizeof(pds_channels[0]); c++) {
+        uint8_t frame[BURST_BENCH_MAX_RESPONSE];
+
+        TINYPROTOCOL_SendTelemetryRequest(&masterConfig, pds_channels[c].id);
+        size = TINYPROTOCOL_TelemetryBytesLeft();
+        if (size != pds_channels[c].frame_len) {
+            fprintf(stderr, "FAIL: channel %u answers %d bytes, the master expects %u\n",
+                    pds_channels[c].id, size, pds_channels[c].frame_len);
+            return 1;
+        }
+        MasterRead(frame, (uint16_t)size);
+
+        if (TINYPROTOCOL_CalculateCRC(frame, (uint8_t)(size - 1)) != frame[size - 1]) {
+            fprintf(stderr, "FAIL: channel %u response has a bad CRC\n", pds_channels[c].id);
+            return 1;
+        }
+
+        memcpy(&expected[payload], frame, (size_t)(size - 1));
+        payload += (uint16_t)(size - 1);
+        channels[count++] = pds_channels[c].id;
+
+        single.transactions += 2;
+        single.bytes += 3 + (uint32_t)size;
+    }
+
+    // The same channels in a single burst
+    TINYPROTOCOL_SendTelemetryBurstRequest(&masterConfig, channels, count);
+    size = TINYPROTOCOL_TelemetryBytesLeft();
+    if (size != payload + 1) {
+        fprintf(stderr, "FAIL: burst response is %d bytes, %u expected\n", size, payload + 1);
+        return 1;
+    }
+    MasterRead(response, (uint16_t)size);
+    expected[payload] = TINYPROTOCOL_CalculateCRC(expected, (uint8_t)payload);
+
+    if (memcmp(expected, response, (size_t)size) != 0) {
+        fprintf(stderr, "FAIL: burst response differs from the per-channel responses\n");
+        return 1;
+    }
+
+    burst.transactions = 2;
+    burst.bytes = (count + 4) + (uint32_t)size;
+
+    printf("PDS housekeeping cycle, %u channels, %u payload bytes, %.0f us master turnaround\n",
+           count, payload, turnaround_us);
+    printf("  %-10s %12s %10s  %10s %10s %10s\n", "request", "transactions", "bus bytes",
+           "100 kHz us", "400 kHz us", "1 MHz us");
+    printf("  %-10s %12u %10u ", "single", single.transactions, single.bytes);
+    for (c = 0; c < sizeof(scl_rates) / sizeof(scl_rates[0]); c++)
+        printf(" %10.1f", BusSeconds(&single, scl_rates[c], turnaround_us) * 1e6);
+    printf("\n  %-10s %12u %10u ", "burst", burst.transactions, burst.bytes);
+    for (c = 0; c < sizeof(scl_rates) / sizeof(scl_rates[0]); c++)
+        printf(" %10.1f", BusSeconds(&burst, scl_rates[c], turnaround_us) * 1e6);
+    printf("\n");
+
+    if (BusSeconds(&burst, scl_rates[0], turnaround_us) >= BusSeconds(&single, scl_rates[0], turnaround_us)) {
+        fprintf(stderr, "FAIL: burst is not faster than per-channel requests\n");
+        return 1;
+    }
+
+    return 0;
+}
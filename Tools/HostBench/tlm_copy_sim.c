@@ -0,0 +1,117 @@
+/**
+ * @file tlm_copy_sim.c
+ * @brief Host simulation of PDS telemetry responses counting memory traffic.
+ *
+ * The real AppComm.c, i2c.c and tinyprotocol.c are driven through
+ * USCI_B0_ISR: the master writes a telemetry request, then clocks the
+ * response out of UCB0TXBUF. Every PDS channel is read twice:
+ *  - staged:    the old SendTelemetryResponse sequence (drain into a stack
+ *               array, then transmitI2C copies it into TransmitBuffer)
+ *  - zero-copy: the TX ISR pulls each byte from the registered channel
+ * Both must produce the same bytes with a valid CRC; responses larger than
+ * TransmitBuffer only go through zero-copy. The simulation fails if the
+ * zero-copy path copies anything.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pds_master.h"
+
+static uint32_t staged_bytes = 0;   /**< Bytes written into the staging array */
+static uint32_t copied_bytes = 0;   /**< Bytes moved by CopyArray into TransmitBuffer */
+
+// Counting stand-in for utils.c
+void CopyArray(uint8_t *source, uint8_t *dest, uint8_t count)
+{
+    uint8_t copyIndex = 0;
+    for (copyIndex = 0; copyIndex < count; copyIndex++)
+    {
+        dest[copyIndex] = source[copyIndex];
+    }
+    copied_bytes += count;
+}
+
+// The pre zero-copy SendTelemetryResponse, kept here as the comparison point
+static int16_t StagedTelemetryResponse(void) {
+    uint8_t bytes[MAX_BUFFER_SIZE];   // transmitI2C cannot take more
+    uint8_t count = 0;
+
+    while (TINYPROTOCOL_TelemetryBytesLeft() > 0) {
+        int16_t result = TINYPROTOCOL_ReadNextTelemetryByte(&bytes[count]);
+        if (result != ETINYPROTOCOL_SUCCESS)
+            return result;
+        count++;
+        staged_bytes++;
+    }
+
+    return transmitI2C(bytes, count);
+}
+
+int main(void) {
+#define PDS_CHANNEL(ID, Name, cmd_len, resp_len)     {ID##_ID, #ID},
+    static const struct {
+        uint8_t id;
+        const char *name;
+    } channels[] = {
+        PDS_COMMANDS(PDS_CHANNEL)
+    };
+    unsigned c;
+    int failed = 0;
+
+    InitAppComm();
+
+    printf("PDS telemetry response memory traffic (bytes per response)\n");
+    printf("  %-18s %5s  %14s %14s  %14s %14s\n", "channel", "size",
+           "staged copies", "staged access", "0-copy copies", "0-copy access");
+
+    for (c = 0; c < sizeof(channels) / sizeof(channels[0]); c++) {
+        uint8_t staged[MAX_BUFFER_SIZE], streamed[TINYPROTOCOL_MAX_LARGE_PAYLOAD_SIZE + 8];
+        uint32_t staged_copies, stream_copies;
+        int16_t size;
+
+        // Staged: the request arms the stream, then the old sequence overrides it.
+        // It cannot send more than TransmitBuffer holds, only zero-copy can.
+        MasterRequestTelemetry(channels[c].id);
+        size = TINYPROTOCOL_TelemetryBytesLeft();
+        if (size <= 0) {
+            printf("  %-18s %5s  (channel not registered)\n", channels[c].name, "-");
+            continue;
+        }
+        staged_copies = 0;
+        if (size <= MAX_BUFFER_SIZE) {
+            staged_bytes = copied_bytes = 0;
+            StagedTelemetryResponse();
+            MasterRead(staged, (uint8_t)size);
+            staged_copies = staged_bytes + copied_bytes;
+        }
+
+        // Zero-copy: the ISR reads straight from the channel
+        staged_bytes = copied_bytes = 0;
+        MasterRequestTelemetry(channels[c].id);
+        MasterRead(streamed, (uint8_t)size);
+        stream_copies = staged_bytes + copied_bytes;
+
+        // Each copied byte is one read and one write on top of the source read.
+        // The staged path also reads TransmitBuffer again in the ISR.
+        if (size <= MAX_BUFFER_SIZE)
+            printf("  %-18s %5d  %14u %14u  %14u %14u\n", channels[c].name, size,
+                   staged_copies, (unsigned)size * 2 + staged_copies * 2,
+                   stream_copies, (unsigned)size + stream_copies * 2);
+        else
+            printf("  %-18s %5d  %14s %14s  %14u %14u\n", channels[c].name, size, "too large", "-",
+                   stream_copies, (unsigned)size + stream_copies * 2);
+
+        if ((size <= MAX_BUFFER_SIZE && memcmp(staged, streamed, (size_t)size) != 0) ||
+            TINYPROTOCOL_CalculateCRC(streamed, (uint8_t)(size - 1)) != streamed[size - 1]) {
+            fprintf(stderr, "FAIL: %s response differs or has a bad CRC\n", channels[c].name);
+            failed = 1;
+        }
+        if (stream_copies != 0) {
+            fprintf(stderr, "FAIL: %s zero-copy response copied %u bytes\n", channels[c].name, stream_copies);
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
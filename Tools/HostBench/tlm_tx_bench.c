@@ -0,0 +1,109 @@
+/**
+ * @file tlm_tx_bench.c
+ * @brief Per-byte cost of TINYPROTOCOL_ReadNextTelemetryByte across a response.
+ *
+ * A maximum size telemetry channel is requested over and over and every byte
+ * of the response is timed individually (best of all repetitions). The CRC
+ * byte must come out correct and must not cost more than the payload bytes,
+ * since the TX interrupt has to keep up with the bus for every byte.
+ *
+ * Usage: tlm_tx_bench [repetitions]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "tinyprotocol.h"
+
+#define TX_BENCH_REPETITIONS    200000u
+#define TX_BENCH_CHANNEL        TINYPROTOCOL_TLM_RESERVED
+#define TX_BENCH_PAYLOAD        TINYPROTOCOL_MAX_PAYLOAD_SIZE
+#define TX_BENCH_TOLERANCE      4       /**< Cycles of timer jitter allowed on the CRC byte */
+
+static uint8_t channel_data[TX_BENCH_PAYLOAD];
+
+static int16_t NoProcessTelecommand(uint8_t command, const uint8_t* buffer, uint16_t size) {
+    (void)command;
+    (void)buffer;
+    (void)size;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+// Leave the response in the protocol so the bench can drain it byte by byte
+static int16_t NoProcessTelemetryRequest(uint8_t command) {
+    (void)command;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static int16_t NoWriteBuffer(const uint8_t* buffer, uint8_t size) {
+    (void)buffer;
+    (void)size;
+    return ETINYPROTOCOL_SUCCESS;
+}
+
+static const struct TINYPROTOCOL_Config slaveConfig = {
+    .TINYPROTOCOL_ProcessTelecommand = NoProcessTelecommand,
+    .TINYPROTOCOL_ProcessTelemetryRequest = NoProcessTelemetryRequest,
+    .TINYPROTOCOL_WriteBuffer = NoWriteBuffer
+};
+
+static void RequestTelemetry(uint8_t channel) {
+    uint8_t crc = TINYPROTOCOL_CalculateCRC(&channel, 1);
+    TINYPROTOCOL_ParseByte(&slaveConfig, TINYPROTOCOL_MAGIC);
+    TINYPROTOCOL_ParseByte(&slaveConfig, channel | 0x80);
+    TINYPROTOCOL_ParseByte(&slaveConfig, crc);
+}
+
+int main(int argc, char **argv) {
+    uint32_t repetitions = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : TX_BENCH_REPETITIONS;
+    uint64_t best[TX_BENCH_PAYLOAD + 1];
+    uint64_t overhead, payload_worst = 0;
+    uint32_t rng = 0x7E1E, r;
+    uint8_t response[TX_BENCH_PAYLOAD + 1];
+    int i;
+
+    TINYPROTOCOL_Initialize();
+    TINYPROTOCOL_RegisterTelemetryChannel(TX_BENCH_CHANNEL, channel_data, TX_BENCH_PAYLOAD);
+
+    for (i = 0; i <= TX_BENCH_PAYLOAD; i++)
+        best[i] = UINT64_MAX;
+
+    overhead = bench_cycles_overhead();
+    for (r = 0; r < repetitions; r++) {
+        for (i = 0; i < TX_BENCH_PAYLOAD; i++)
+            channel_data[i] = (uint8_t)bench_rand(&rng);
+
+        RequestTelemetry(TX_BENCH_CHANNEL);
+
+        for (i = 0; i <= TX_BENCH_PAYLOAD; i++) {
+            uint64_t c0 = bench_cycles();
+            TINYPROTOCOL_ReadNextTelemetryByte(&response[i]);
+            uint64_t dt = bench_cycles() - c0;
+            if (dt < best[i])
+                best[i] = dt;
+        }
+
+        if (response[TX_BENCH_PAYLOAD] != TINYPROTOCOL_CalculateCRC(channel_data, TX_BENCH_PAYLOAD)) {
+            fprintf(stderr, "FAIL: wrong CRC byte on repetition %u\n", r);
+            return 1;
+        }
+    }
+
+    printf("telemetry TX per-byte cost, %d byte payload + CRC (best of %u)\n", TX_BENCH_PAYLOAD, repetitions);
+    for (i = 0; i <= TX_BENCH_PAYLOAD; i++) {
+        uint64_t dt = (best[i] > overhead) ? best[i] - overhead : 0;
+        if (i < TX_BENCH_PAYLOAD && dt > payload_worst)
+            payload_worst = dt;
+        printf("  byte %2d %-7s %llu\n", i, (i == TX_BENCH_PAYLOAD) ? "(CRC)" : "", (unsigned long long)dt);
+    }
+
+    uint64_t crc_cost = (best[TX_BENCH_PAYLOAD] > overhead) ? best[TX_BENCH_PAYLOAD] - overhead : 0;
+    if (crc_cost > payload_worst + TX_BENCH_TOLERANCE) {
+        fprintf(stderr, "FAIL: CRC byte costs %llu, payload bytes at most %llu\n",
+                (unsigned long long)crc_cost, (unsigned long long)payload_worst);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,469 @@
+/*
+ * Write-back page cache for a littlefs block device
+ */
+#include "lfs_cachebd.h"
+
+// Slot holding a page, -1 if it is not cached
+static int lfs_cachebd_find(const lfs_cachebd_t *bd, lfs_block_t block,
+        lfs_off_t off) {
+    for (lfs_size_t i = 0; i < bd->cfg->page_count; i++) {
+        if (bd->pages[i].block == block && bd->pages[i].off == off) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Whether the dirty bytes of slot a run on into slot b
+static bool lfs_cachebd_joins(const lfs_cachebd_t *bd, lfs_size_t a,
+        lfs_size_t b) {
+    const lfs_cachebd_page_t *pa = &bd->pages[a];
+    const lfs_cachebd_page_t *pb = &bd->pages[b];
+    return pb->block == pa->block
+            && pb->off == pa->off + bd->cfg->page_size
+            && pa->dirty_off + pa->dirty_size == bd->cfg->page_size
+            && pb->dirty_size != 0 && pb->dirty_off == 0;
+}
+
+// Programs every dirty run, one call below per run of adjacent slots
+static int lfs_cachebd_flush(const struct lfs_config *cfg) {
+    lfs_cachebd_t *bd = cfg->context;
+    const struct lfs_config *lower = bd->cfg->bd;
+    lfs_size_t ps = bd->cfg->page_size;
+
+    for (lfs_size_t s = 0; s < bd->cfg->page_count; s++) {
+        if (bd->pages[s].dirty_size == 0) {
+            continue;
+        }
+
+        lfs_size_t e = s;
+        while (e+1 < bd->cfg->page_count && lfs_cachebd_joins(bd, e, e+1)) {
+            e += 1;
+        }
+
+        lfs_cachebd_page_t *first = &bd->pages[s];
+        lfs_cachebd_page_t *last = &bd->pages[e];
+        int err = lower->prog(lower, first->block,
+                first->off + first->dirty_off,
+                &bd->buffer[s*ps + first->dirty_off],
+                (e-s)*ps + last->dirty_off + last->dirty_size
+                    - first->dirty_off);
+        if (err) {
+            return err;
+        }
+
+        for (lfs_size_t i = s; i <= e; i++) {
+            bd->pages[i].dirty_size = 0;
+        }
+        s = e;
+    }
+
+    return 0;
+}
+
+// Whether the count slots from s are free or clean
+static bool lfs_cachebd_isclean(const lfs_cachebd_t *bd, lfs_size_t s,
+        lfs_size_t count) {
+    for (lfs_size_t i = 0; i < count; i++) {
+        if (bd->pages[s+i].dirty_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Takes adjacent slots for up to *count pages from off, none of them cached.
+// They go after the slot of the page before off if they can, else in the
+// clean slots least recently used. Stores how many were taken in *count,
+// and returns the first slot.
+static int lfs_cachebd_alloc(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, lfs_size_t *count) {
+    lfs_cachebd_t *bd = cfg->context;
+    lfs_size_t ps = bd->cfg->page_size;
+    lfs_size_t n = bd->cfg->page_count;
+    int prev = (off >= ps) ? lfs_cachebd_find(bd, block, off - ps) : -1;
+    int start = -1;
+    lfs_size_t k;
+
+    for (k = *count; k > 0; k--) {
+        if (prev >= 0 && (lfs_size_t)prev+1+k <= n
+                && lfs_cachebd_isclean(bd, prev+1, k)) {
+            start = prev+1;
+            break;
+        }
+
+        // the window whose newest page is the oldest
+        uint32_t best = 0xffffffff;
+        for (lfs_size_t s = 0; s+k <= n; s++) {
+            if (!lfs_cachebd_isclean(bd, s, k)) {
+                continue;
+            }
+
+            uint32_t newest = 0;
+            for (lfs_size_t i = s; i < s+k; i++) {
+                newest = lfs_max(newest, bd->pages[i].used);
+            }
+            if (start < 0 || newest < best) {
+                best = newest;
+                start = (int)s;
+            }
+        }
+        if (start >= 0) {
+            break;
+        }
+    }
+
+    if (start < 0) {
+        // every slot is dirty
+        int err = lfs_cachebd_flush(cfg);
+        if (err) {
+            return err;
+        }
+        return lfs_cachebd_alloc(cfg, block, off, count);
+    }
+
+    *count = k;
+    for (lfs_size_t i = 0; i < k; i++) {
+        lfs_cachebd_page_t *page = &bd->pages[start+i];
+        page->block = block;
+        page->off = off + i*ps;
+        page->used = ++bd->stamp;
+        page->valid_off = 0;
+        page->valid_size = 0;
+        page->dirty_off = 0;
+        page->dirty_size = 0;
+    }
+    return start;
+}
+
+// Reads [lo, hi) of the page in a slot from the device below
+static int lfs_cachebd_load(const struct lfs_config *cfg, lfs_size_t s,
+        lfs_off_t lo, lfs_off_t hi) {
+    lfs_cachebd_t *bd = cfg->context;
+    const struct lfs_config *lower = bd->cfg->bd;
+    lfs_cachebd_page_t *page = &bd->pages[s];
+
+    return lower->read(lower, page->block, page->off + lo,
+            &bd->buffer[s*bd->cfg->page_size + lo], hi - lo);
+}
+
+// Reads [off, end) of a block into adjacent slots in one read below, the
+// whole page for a small read, and up to read_ahead more pages if it
+// continues a run of fetches. Cached pages in the way are read again if they
+// are clean, the run stops at a dirty one.
+static int lfs_cachebd_fetch(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, lfs_off_t end) {
+    lfs_cachebd_t *bd = cfg->context;
+    const struct lfs_config *lower = bd->cfg->bd;
+    lfs_size_t ps = bd->cfg->page_size;
+    lfs_off_t poff = off - off % ps;
+
+    // littlefs often reads a few bytes, then on from there, and stops: only
+    // the third fetch of a run reads ahead
+    bd->streak = (block == bd->next_block && off == bd->next_off)
+            ? lfs_min(bd->streak + 1, 2) : 0;
+    // a read of a few bytes is a tag, littlefs reads the tags around it next
+    if (end - off < ps/4) {
+        off = poff;
+        end = poff + ps;
+    }
+    lfs_size_t count = (end - poff + ps-1) / ps;
+    if (bd->streak == 2 && bd->cfg->read_ahead) {
+        count += bd->cfg->read_ahead;
+        end = poff + count*ps;
+    }
+    count = lfs_min(count, (cfg->block_size - poff) / ps);
+    count = lfs_min(count, bd->cfg->page_count);
+    for (lfs_size_t i = 0; i < count; i++) {
+        int s = lfs_cachebd_find(bd, block, poff + i*ps);
+        if (s >= 0 && bd->pages[s].dirty_size) {
+            count = i;
+            break;
+        } else if (s >= 0) {
+            bd->pages[s].block = LFS_CACHEBD_FREE;
+            bd->pages[s].used = 0;
+        }
+    }
+    LFS_ASSERT(count > 0);
+
+    int s = lfs_cachebd_alloc(cfg, block, poff, &count);
+    if (s < 0) {
+        return s;
+    }
+    end = lfs_min(end, poff + count*ps);
+
+    int err = lower->read(lower, block, off, &bd->buffer[s*ps + off - poff],
+            end - off);
+    for (lfs_size_t i = 0; i < count; i++) {
+        lfs_cachebd_page_t *page = &bd->pages[s+i];
+        if (err) {
+            page->block = LFS_CACHEBD_FREE;
+            page->used = 0;
+            continue;
+        }
+        page->valid_off = lfs_max(off, page->off) - page->off;
+        page->valid_size = lfs_min(end, page->off + ps) - page->off
+                - page->valid_off;
+    }
+    if (err) {
+        return err;
+    }
+
+    bd->next_block = block;
+    bd->next_off = end;
+    return s;
+}
+
+void lfs_cachebd_wrap(struct lfs_config *cfg, lfs_cachebd_t *bd,
+        const struct lfs_config *bdcfg) {
+    *cfg = *bdcfg;
+    cfg->context = bd;
+    cfg->read = lfs_cachebd_read;
+    cfg->prog = lfs_cachebd_prog;
+    cfg->erase = lfs_cachebd_erase;
+    cfg->sync = lfs_cachebd_sync;
+}
+
+int lfs_cachebd_create(const struct lfs_config *cfg,
+        const struct lfs_cachebd_config *bdcfg) {
+    LFS_TRACE("lfs_cachebd_create(%p, %p)", (void*)cfg, (void*)bdcfg);
+    lfs_cachebd_t *bd = cfg->context;
+
+    LFS_ASSERT(bdcfg->page_count >= 2);
+    LFS_ASSERT(bdcfg->read_ahead < bdcfg->page_count);
+    LFS_ASSERT(cfg->block_size % bdcfg->page_size == 0);
+    LFS_ASSERT(bdcfg->page_size % bdcfg->bd->prog_size == 0);
+    // the bytes around a dirty range may be read
+    LFS_ASSERT(bdcfg->bd->prog_size % bdcfg->bd->read_size == 0);
+
+    bd->cfg = bdcfg;
+
+    if (bdcfg->buffer) {
+        bd->buffer = bdcfg->buffer;
+    } else {
+        bd->buffer = lfs_malloc(bdcfg->page_count * bdcfg->page_size);
+        if (!bd->buffer) {
+            LFS_TRACE("lfs_cachebd_create -> %d", LFS_ERR_NOMEM);
+            return LFS_ERR_NOMEM;
+        }
+    }
+
+    if (bdcfg->pages) {
+        bd->pages = bdcfg->pages;
+    } else {
+        bd->pages = lfs_malloc(bdcfg->page_count * sizeof(*bd->pages));
+        if (!bd->pages) {
+            if (!bdcfg->buffer) {
+                lfs_free(bd->buffer);
+            }
+            LFS_TRACE("lfs_cachebd_create -> %d", LFS_ERR_NOMEM);
+            return LFS_ERR_NOMEM;
+        }
+    }
+
+    for (lfs_size_t i = 0; i < bdcfg->page_count; i++) {
+        bd->pages[i].block = LFS_CACHEBD_FREE;
+        bd->pages[i].off = 0;
+        bd->pages[i].used = 0;
+        bd->pages[i].valid_off = 0;
+        bd->pages[i].valid_size = 0;
+        bd->pages[i].dirty_off = 0;
+        bd->pages[i].dirty_size = 0;
+    }
+    bd->stamp = 0;
+    bd->next_block = LFS_CACHEBD_FREE;
+    bd->next_off = 0;
+    bd->streak = 0;
+
+    LFS_TRACE("lfs_cachebd_create -> %d", 0);
+    return 0;
+}
+
+int lfs_cachebd_destroy(const struct lfs_config *cfg) {
+    LFS_TRACE("lfs_cachebd_destroy(%p)", (void*)cfg);
+    lfs_cachebd_t *bd = cfg->context;
+
+    if (!bd->cfg->buffer) {
+        lfs_free(bd->buffer);
+    }
+    if (!bd->cfg->pages) {
+        lfs_free(bd->pages);
+    }
+    bd->buffer = NULL;
+    bd->pages = NULL;
+
+    LFS_TRACE("lfs_cachebd_destroy -> %d", 0);
+    return 0;
+}
+
+int lfs_cachebd_read(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, void *buffer, lfs_size_t size) {
+    LFS_TRACE("lfs_cachebd_read(%p, "
+                "0x%"PRIx32", %"PRIu32", %p, %"PRIu32")",
+            (void*)cfg, block, off, buffer, size);
+    lfs_cachebd_t *bd = cfg->context;
+    lfs_size_t ps = bd->cfg->page_size;
+    uint8_t *data = buffer;
+    lfs_off_t end = off + size;
+
+    // check if read is valid
+    LFS_ASSERT(block < cfg->block_count);
+    LFS_ASSERT(off  % cfg->read_size == 0);
+    LFS_ASSERT(size % cfg->read_size == 0);
+    LFS_ASSERT(off+size <= cfg->block_size);
+
+    while (off < end) {
+        lfs_off_t poff = off - off % ps;
+        lfs_size_t diff = lfs_min(end - off, poff + ps - off);
+        lfs_off_t lo = off - poff;
+        lfs_off_t hi = lo + diff;
+
+        int s = lfs_cachebd_find(bd, block, poff);
+        lfs_cachebd_page_t *page = (s >= 0) ? &bd->pages[s] : NULL;
+        if (page && (lo < page->valid_off
+                || hi > page->valid_off + page->valid_size)) {
+            if (page->dirty_size) {
+                // grow the bytes held around the dirty ones
+                lfs_off_t vlo = page->valid_off;
+                lfs_off_t vhi = page->valid_off + page->valid_size;
+                int err = 0;
+                if (lo < vlo) {
+                    err = lfs_cachebd_load(cfg, (lfs_size_t)s, lo, vlo);
+                }
+                if (!err && hi > vhi) {
+                    err = lfs_cachebd_load(cfg, (lfs_size_t)s, vhi, hi);
+                }
+                if (err) {
+                    LFS_TRACE("lfs_cachebd_read -> %d", err);
+                    return err;
+                }
+                page->valid_off = lfs_min(lo, vlo);
+                page->valid_size = lfs_max(hi, vhi) - page->valid_off;
+            } else {
+                page = NULL;
+            }
+        }
+
+        if (!page) {
+            s = lfs_cachebd_fetch(cfg, block, off, end);
+            if (s < 0) {
+                LFS_TRACE("lfs_cachebd_read -> %d", s);
+                return s;
+            }
+            page = &bd->pages[s];
+        }
+
+        memcpy(data, &bd->buffer[(lfs_size_t)s*ps + lo], diff);
+        page->used = ++bd->stamp;
+        off += diff;
+        data += diff;
+    }
+
+    LFS_TRACE("lfs_cachebd_read -> %d", 0);
+    return 0;
+}
+
+int lfs_cachebd_prog(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, const void *buffer, lfs_size_t size) {
+    LFS_TRACE("lfs_cachebd_prog(%p, "
+                "0x%"PRIx32", %"PRIu32", %p, %"PRIu32")",
+            (void*)cfg, block, off, buffer, size);
+    lfs_cachebd_t *bd = cfg->context;
+    lfs_size_t ps = bd->cfg->page_size;
+    const uint8_t *data = buffer;
+    lfs_off_t end = off + size;
+
+    // check if write is valid
+    LFS_ASSERT(block < cfg->block_count);
+    LFS_ASSERT(off  % cfg->prog_size == 0);
+    LFS_ASSERT(size % cfg->prog_size == 0);
+    LFS_ASSERT(off+size <= cfg->block_size);
+
+    while (off < end) {
+        lfs_off_t poff = off - off % ps;
+        lfs_size_t diff = lfs_min(end - off, poff + ps - off);
+
+        // a page not cached is not read, it holds the bytes written
+        int s = lfs_cachebd_find(bd, block, poff);
+        if (s < 0) {
+            lfs_size_t count = 1;
+            s = lfs_cachebd_alloc(cfg, block, poff, &count);
+            if (s < 0) {
+                LFS_TRACE("lfs_cachebd_prog -> %d", s);
+                return s;
+            }
+        }
+
+        lfs_cachebd_page_t *page = &bd->pages[s];
+        lfs_off_t lo = off - poff;
+        lfs_off_t hi = lo + diff;
+        lfs_off_t vlo = page->valid_off;
+        lfs_off_t vhi = page->valid_off + page->valid_size;
+        if (page->valid_size == 0 || (!page->dirty_size
+                && (hi < vlo || lo > vhi))) {
+            // nothing held next to it that must be kept
+            vlo = lo;
+            vhi = hi;
+        } else if (hi < vlo || lo > vhi) {
+            // the dirty bytes will run over the gap, it must be held
+            int err = (hi < vlo)
+                    ? lfs_cachebd_load(cfg, (lfs_size_t)s, hi, vlo)
+                    : lfs_cachebd_load(cfg, (lfs_size_t)s, vhi, lo);
+            if (err) {
+                LFS_TRACE("lfs_cachebd_prog -> %d", err);
+                return err;
+            }
+        }
+        page->valid_off = lfs_min(lo, vlo);
+        page->valid_size = lfs_max(hi, vhi) - page->valid_off;
+
+        if (page->dirty_size) {
+            lo = lfs_min(lo, page->dirty_off);
+            hi = lfs_max(hi, page->dirty_off + page->dirty_size);
+        }
+        memcpy(&bd->buffer[(lfs_size_t)s*ps + off - poff], data, diff);
+        page->dirty_off = lo;
+        page->dirty_size = hi - lo;
+        page->used = ++bd->stamp;
+        off += diff;
+        data += diff;
+    }
+
+    LFS_TRACE("lfs_cachebd_prog -> %d", 0);
+    return 0;
+}
+
+int lfs_cachebd_erase(const struct lfs_config *cfg, lfs_block_t block) {
+    LFS_TRACE("lfs_cachebd_erase(%p, 0x%"PRIx32")", (void*)cfg, block);
+    lfs_cachebd_t *bd = cfg->context;
+    const struct lfs_config *lower = bd->cfg->bd;
+
+    // check if erase is valid
+    LFS_ASSERT(block < cfg->block_count);
+
+    for (lfs_size_t i = 0; i < bd->cfg->page_count; i++) {
+        if (bd->pages[i].block == block) {
+            bd->pages[i].block = LFS_CACHEBD_FREE;
+            bd->pages[i].dirty_size = 0;
+            bd->pages[i].used = 0;
+        }
+    }
+
+    int err = lower->erase(lower, block);
+    LFS_TRACE("lfs_cachebd_erase -> %d", err);
+    return err;
+}
+
+int lfs_cachebd_sync(const struct lfs_config *cfg) {
+    LFS_TRACE("lfs_cachebd_sync(%p)", (void*)cfg);
+    lfs_cachebd_t *bd = cfg->context;
+    const struct lfs_config *lower = bd->cfg->bd;
+
+    int err = lfs_cachebd_flush(cfg);
+    if (!err) {
+        err = lower->sync(lower);
+    }
+
+    LFS_TRACE("lfs_cachebd_sync -> %d", err);
+    return err;
+}
@@ -0,0 +1,124 @@
+/*
+ * Write-back page cache for a littlefs block device
+ *
+ * Sits between littlefs and another block device, lfs_mrambd on the Pico.
+ * littlefs reads and programs in pieces of at most its cache_size, and
+ * fetches the same metadata again on every open and commit. Below it each
+ * call costs the MRAM a select, the command and the address, and a program
+ * a write enable in its own select, whatever its size. The cache keeps
+ * page_count pages of page_size bytes in RAM:
+ * - reads are served from the pages. A miss reads the bytes asked for into
+ *   adjacent slots least recently used, in one burst. A read of under a
+ *   quarter page, a tag, fetches its whole page;
+ * - a miss where the last one ended is a sequential read. From the second
+ *   in a row it fetches up to read_ahead more pages in the same burst;
+ * - programs only write the pages and mark the bytes dirty. A page that
+ *   follows a cached one goes in the slot after it, so a sequential write
+ *   fills adjacent slots, and sync programs each run of adjacent dirty
+ *   bytes in one burst.
+ *
+ * Dirty data reaches the device on sync, or when every slot is dirty and
+ * one is needed. littlefs syncs at the end of each operation that writes
+ * and wherever the order of its writes matters, so dirty runs may go out in
+ * any order between two syncs, as the block device API allows.
+ */
+#ifndef LFS_CACHEBD_H
+#define LFS_CACHEBD_H
+
+#include "lfs/lfs.h"
+#include "lfs/lfs_util.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+// Default geometry, 2 KiB of pages
+#ifndef LFS_CACHEBD_PAGE_SIZE
+#define LFS_CACHEBD_PAGE_SIZE   32
+#endif
+#ifndef LFS_CACHEBD_PAGE_COUNT
+#define LFS_CACHEBD_PAGE_COUNT  64
+#endif
+#ifndef LFS_CACHEBD_READ_AHEAD
+#define LFS_CACHEBD_READ_AHEAD  2
+#endif
+
+// Block of a free slot
+#define LFS_CACHEBD_FREE        ((lfs_block_t)-1)
+
+// Slot of the page table
+typedef struct lfs_cachebd_page {
+    lfs_block_t block;      // LFS_CACHEBD_FREE while the slot is free
+    lfs_off_t off;          // Of the page in its block
+    uint32_t used;          // Access stamp, for the LRU
+    lfs_off_t valid_off;    // Bytes held, read or written, in the page
+    lfs_size_t valid_size;
+    lfs_off_t dirty_off;    // Of them, bytes not yet programmed, none if
+    lfs_size_t dirty_size;  // dirty_size is 0
+} lfs_cachebd_page_t;
+
+struct lfs_cachebd_config {
+    // Block device below, with the same geometry
+    const struct lfs_config *bd;
+
+    // Bytes per page, divides the block size
+    lfs_size_t page_size;
+
+    // Pages held, at least 2
+    lfs_size_t page_count;
+
+    // Pages fetched beyond a sequential miss, 0 for none
+    lfs_size_t read_ahead;
+
+    // Optional page buffer of page_count*page_size bytes, and page table of
+    // page_count entries. NULL uses lfs_malloc.
+    void *buffer;
+    lfs_cachebd_page_t *pages;
+};
+
+// Cache state, set as lfs_config.context
+typedef struct lfs_cachebd {
+    const struct lfs_cachebd_config *cfg;
+    uint8_t *buffer;
+    lfs_cachebd_page_t *pages;
+    uint32_t stamp;
+    lfs_block_t next_block; // Where the last fetch ended, for read-ahead
+    lfs_off_t next_off;
+    uint8_t streak;         // Fetches in a row that continued the one before
+} lfs_cachebd_t;
+
+
+// Fills cfg with the geometry of bdcfg, the device below, and the cache's
+// callbacks, with bd as its context. Call lfs_cachebd_create() next.
+void lfs_cachebd_wrap(struct lfs_config *cfg, lfs_cachebd_t *bd,
+        const struct lfs_config *bdcfg);
+
+// Creates an empty cache. cfg->context must point to an lfs_cachebd_t.
+int lfs_cachebd_create(const struct lfs_config *cfg,
+        const struct lfs_cachebd_config *bdcfg);
+
+// Frees the buffers lfs_cachebd_create allocated. Dirty pages are lost, sync
+// first.
+int lfs_cachebd_destroy(const struct lfs_config *cfg);
+
+int lfs_cachebd_read(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, void *buffer, lfs_size_t size);
+
+// Writes the pages, the device is programmed on sync
+int lfs_cachebd_prog(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, const void *buffer, lfs_size_t size);
+
+// Drops the pages of the block, then erases it below
+int lfs_cachebd_erase(const struct lfs_config *cfg, lfs_block_t block);
+
+// Programs the dirty runs, then syncs the device below
+int lfs_cachebd_sync(const struct lfs_config *cfg);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
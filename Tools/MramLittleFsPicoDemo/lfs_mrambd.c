@@ -0,0 +1,167 @@
+/*
+ * Block device for littlefs on an SPI MRAM (S3A3204V0M)
+ */
+#include "lfs_mrambd.h"
+
+// Command and address, sent as one transfer ahead of the burst
+static lfs_size_t lfs_mrambd_header(const lfs_mrambd_t *bd, uint8_t cmd,
+        uint32_t addr, uint8_t *header) {
+    header[0] = cmd;
+    for (uint8_t i = 0; i < bd->addr_size; i++) {
+        header[1 + i] = (uint8_t)(addr >> (8 * (bd->addr_size - 1 - i)));
+    }
+    return 1 + bd->addr_size;
+}
+
+void lfs_mrambd_profile(struct lfs_config *cfg, lfs_mrambd_t *bd) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->context = bd;
+    cfg->read = lfs_mrambd_read;
+    cfg->prog = lfs_mrambd_prog;
+    cfg->erase = lfs_mrambd_erase;
+    cfg->sync = lfs_mrambd_sync;
+
+    cfg->read_size = 1;
+    cfg->prog_size = 1;
+    cfg->block_size = LFS_MRAMBD_BLOCK_SIZE;
+    cfg->block_count = LFS_MRAMBD_SIZE / LFS_MRAMBD_BLOCK_SIZE;
+    cfg->block_cycles = -1;
+    cfg->cache_size = LFS_MRAMBD_CACHE_SIZE;
+    cfg->lookahead_size = LFS_MRAMBD_LOOKAHEAD_SIZE;
+    cfg->metadata_max = LFS_MRAMBD_BLOCK_SIZE;
+    cfg->inline_max = LFS_MRAMBD_INLINE_MAX;
+}
+
+int lfs_mrambd_create(const struct lfs_config *cfg,
+        const struct lfs_mrambd_config *bdcfg) {
+    LFS_TRACE("lfs_mrambd_create(%p, %p)", (void*)cfg, (void*)bdcfg);
+    lfs_mrambd_t *bd = cfg->context;
+
+    LFS_ASSERT(bdcfg->select && bdcfg->deselect && bdcfg->transfer);
+    LFS_ASSERT(bdcfg->addr_size <= 4);
+
+    bd->cfg = bdcfg;
+    bd->addr_size = bdcfg->addr_size ? bdcfg->addr_size : 3;
+
+    // Every block must be reachable with the address bytes
+    LFS_ASSERT(bd->addr_size == 4 || (uint64_t)cfg->block_size
+            * cfg->block_count <= ((uint64_t)1 << (8 * bd->addr_size)));
+
+    LFS_TRACE("lfs_mrambd_create -> %d", 0);
+    return 0;
+}
+
+int lfs_mrambd_destroy(const struct lfs_config *cfg) {
+    LFS_TRACE("lfs_mrambd_destroy(%p)", (void*)cfg);
+    lfs_mrambd_t *bd = cfg->context;
+    bd->cfg = NULL;
+    LFS_TRACE("lfs_mrambd_destroy -> %d", 0);
+    return 0;
+}
+
+int lfs_mrambd_readaddr(lfs_mrambd_t *bd, uint32_t addr,
+        void *buffer, lfs_size_t size) {
+    const struct lfs_mrambd_config *port = bd->cfg;
+    uint8_t header[5];
+    lfs_size_t length = lfs_mrambd_header(bd, LFS_MRAMBD_CMD_READ, addr,
+            header);
+
+    port->select(port->port);
+    port->transfer(port->port, header, NULL, length);
+    port->transfer(port->port, NULL, buffer, size);
+    port->deselect(port->port);
+    return 0;
+}
+
+int lfs_mrambd_progaddr(lfs_mrambd_t *bd, uint32_t addr,
+        const void *buffer, lfs_size_t size) {
+    const struct lfs_mrambd_config *port = bd->cfg;
+    const uint8_t wren = LFS_MRAMBD_CMD_WREN;
+    uint8_t header[5];
+    lfs_size_t length = lfs_mrambd_header(bd, LFS_MRAMBD_CMD_WRITE, addr,
+            header);
+
+    // The write enable latch only lasts for one write
+    port->select(port->port);
+    port->transfer(port->port, &wren, NULL, 1);
+    port->deselect(port->port);
+
+    port->select(port->port);
+    port->transfer(port->port, header, NULL, length);
+    port->transfer(port->port, buffer, NULL, size);
+    port->deselect(port->port);
+    return 0;
+}
+
+int lfs_mrambd_read(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, void *buffer, lfs_size_t size) {
+    LFS_TRACE("lfs_mrambd_read(%p, "
+                "0x%"PRIx32", %"PRIu32", %p, %"PRIu32")",
+            (void*)cfg, block, off, buffer, size);
+    lfs_mrambd_t *bd = cfg->context;
+
+    // check if read is valid
+    LFS_ASSERT(block < cfg->block_count);
+    LFS_ASSERT(off  % cfg->read_size == 0);
+    LFS_ASSERT(size % cfg->read_size == 0);
+    LFS_ASSERT(off+size <= cfg->block_size);
+
+    int err = lfs_mrambd_readaddr(bd, block*cfg->block_size + off,
+            buffer, size);
+
+    LFS_TRACE("lfs_mrambd_read -> %d", err);
+    return err;
+}
+
+int lfs_mrambd_prog(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, const void *buffer, lfs_size_t size) {
+    LFS_TRACE("lfs_mrambd_prog(%p, "
+                "0x%"PRIx32", %"PRIu32", %p, %"PRIu32")",
+            (void*)cfg, block, off, buffer, size);
+    lfs_mrambd_t *bd = cfg->context;
+
+    // check if write is valid
+    LFS_ASSERT(block < cfg->block_count);
+    LFS_ASSERT(off  % cfg->prog_size == 0);
+    LFS_ASSERT(size % cfg->prog_size == 0);
+    LFS_ASSERT(off+size <= cfg->block_size);
+
+    int err = lfs_mrambd_progaddr(bd, block*cfg->block_size + off,
+            buffer, size);
+
+    LFS_TRACE("lfs_mrambd_prog -> %d", err);
+    return err;
+}
+
+int lfs_mrambd_erase(const struct lfs_config *cfg, lfs_block_t block) {
+    LFS_TRACE("lfs_mrambd_erase(%p, 0x%"PRIx32")", (void*)cfg, block);
+
+    // check if erase is valid
+    LFS_ASSERT(block < cfg->block_count);
+    (void)cfg;
+    (void)block;
+
+    LFS_TRACE("lfs_mrambd_erase -> %d", 0);
+    return 0;
+}
+
+int lfs_mrambd_sync(const struct lfs_config *cfg) {
+    LFS_TRACE("lfs_mrambd_sync(%p)", (void*)cfg);
+    (void)cfg;
+    LFS_TRACE("lfs_mrambd_sync -> %d", 0);
+    return 0;
+}
+
+uint32_t lfs_mrambd_deviceid(lfs_mrambd_t *bd) {
+    const struct lfs_mrambd_config *port = bd->cfg;
+    const uint8_t cmd = LFS_MRAMBD_CMD_RDID;
+    uint8_t id[4];
+
+    port->select(port->port);
+    port->transfer(port->port, &cmd, NULL, 1);
+    port->transfer(port->port, NULL, id, sizeof(id));
+    port->deselect(port->port);
+
+    return ((uint32_t)id[0] << 24) | ((uint32_t)id[1] << 16)
+            | ((uint32_t)id[2] << 8) | id[3];
+}
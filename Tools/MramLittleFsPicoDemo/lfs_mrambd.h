@@ -0,0 +1,133 @@
+/*
+ * Block device for littlefs on an SPI MRAM (S3A3204V0M)
+ *
+ * Every access is one SPI transaction: the command and the address, then the
+ * whole buffer as a single burst, with CS held low throughout. The MRAM
+ * writes at bus speed, so there is no busy polling and no delay, and it has
+ * no erase cycle.
+ *
+ * The SPI port is supplied by the caller, so the same driver runs on the Pico
+ * and against the host model in Tools/HostBench.
+ */
+#ifndef LFS_MRAMBD_H
+#define LFS_MRAMBD_H
+
+#include "lfs/lfs.h"
+#include "lfs/lfs_util.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+// S3A3204V0M commands
+#define LFS_MRAMBD_CMD_WREN     0x06    // Write enable, cleared again by each write
+#define LFS_MRAMBD_CMD_WRDI     0x04    // Write disable
+#define LFS_MRAMBD_CMD_RDSR     0x05    // Read status register
+#define LFS_MRAMBD_CMD_READ     0x03    // Read memory array
+#define LFS_MRAMBD_CMD_WRITE    0x02    // Write memory array
+#define LFS_MRAMBD_CMD_RDID     0x9F    // Read device ID, 4 bytes
+#define LFS_MRAMBD_CMD_RDUID    0x4C    // Read unique ID
+
+#define LFS_MRAMBD_SIZE         0x400000    // 32 Mbit
+
+// MRAM profile, see lfs_mrambd_profile()
+#ifndef LFS_MRAMBD_BLOCK_SIZE
+#define LFS_MRAMBD_BLOCK_SIZE   256     // Least a file takes outside its metadata
+#endif
+#ifndef LFS_MRAMBD_CACHE_SIZE
+#define LFS_MRAMBD_CACHE_SIZE   128     // Read and program cache, and one per open file
+#endif
+#ifndef LFS_MRAMBD_LOOKAHEAD_SIZE
+#define LFS_MRAMBD_LOOKAHEAD_SIZE 256   // 2048 blocks per allocator scan
+#endif
+#ifndef LFS_MRAMBD_INLINE_MAX
+#define LFS_MRAMBD_INLINE_MAX   (LFS_MRAMBD_BLOCK_SIZE / 8)
+#endif
+
+
+// SPI port of the MRAM
+struct lfs_mrambd_config {
+    // Asserts CS. Also the place to claim the bus (SPI.beginTransaction).
+    void (*select)(void *port);
+
+    // Releases CS, and the bus.
+    void (*deselect)(void *port);
+
+    // Clocks size bytes. Sends tx, or zeros when tx is NULL, and stores what
+    // comes back in rx unless rx is NULL. Must not touch CS.
+    void (*transfer)(void *port, const uint8_t *tx, uint8_t *rx,
+            lfs_size_t size);
+
+    // Passed to the functions above.
+    void *port;
+
+    // Address bytes after each command, 3 for the S3A3204 (4 MiB). Defaults
+    // to 3 when zero.
+    uint8_t addr_size;
+};
+
+// MRAM block device state, set as lfs_config.context
+typedef struct lfs_mrambd {
+    const struct lfs_mrambd_config *cfg;
+    uint8_t addr_size;
+} lfs_mrambd_t;
+
+
+// Fills cfg for littlefs on the whole MRAM, with bd as its context.
+//
+// MRAM is not flash, so the NOR settings waste time:
+// - read_size and prog_size are 1. A commit is not padded and a read fetches
+//   what littlefs asks for, the caches still group the small accesses.
+// - erase is the no-op lfs_mrambd_erase().
+// - block_cycles is -1, MRAM does not wear out, so metadata is never moved
+//   for wear leveling.
+// - blocks are small. Appending to a file copies its last block, and a
+//   directory is fetched by reading its metadata log, both scale with the
+//   block size. metadata_max is the whole block so a log compacts as
+//   seldom as it can, and inline_max is the most littlefs allows for it.
+//
+// Buffers are left NULL (lfs_malloc), set them afterwards to make them
+// static. Call lfs_mrambd_create() next.
+void lfs_mrambd_profile(struct lfs_config *cfg, lfs_mrambd_t *bd);
+
+// Attaches the block device to its SPI port. cfg->context must point to an
+// lfs_mrambd_t, bdcfg must stay in memory while the device is used.
+int lfs_mrambd_create(const struct lfs_config *cfg,
+        const struct lfs_mrambd_config *bdcfg);
+
+// Releases the block device
+int lfs_mrambd_destroy(const struct lfs_config *cfg);
+
+// Reads a region of a block in a single burst
+int lfs_mrambd_read(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, void *buffer, lfs_size_t size);
+
+// Programs a region of a block in a single burst, after its write enable
+int lfs_mrambd_prog(const struct lfs_config *cfg, lfs_block_t block,
+        lfs_off_t off, const void *buffer, lfs_size_t size);
+
+// Nothing to do, MRAM cells are overwritten in place
+int lfs_mrambd_erase(const struct lfs_config *cfg, lfs_block_t block);
+
+// Nothing to do, a write is complete when CS goes high
+int lfs_mrambd_sync(const struct lfs_config *cfg);
+
+// Reads size bytes from a byte address, for data kept outside the filesystem
+int lfs_mrambd_readaddr(lfs_mrambd_t *bd, uint32_t addr,
+        void *buffer, lfs_size_t size);
+
+// Programs size bytes at a byte address, for data kept outside the filesystem
+int lfs_mrambd_progaddr(lfs_mrambd_t *bd, uint32_t addr,
+        const void *buffer, lfs_size_t size);
+
+// Reads the 4 byte device ID, first byte in the top bits
+uint32_t lfs_mrambd_deviceid(lfs_mrambd_t *bd);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,333 @@
+/*
+ * Append-only telemetry log on the MRAM, beside littlefs
+ */
+#include "mram_log.h"
+
+#include <stddef.h>
+
+#define MRAM_LOG_MAGIC  0x474f4c4d  // "MLOG"
+
+struct mram_log_segment {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t time;      // First record
+    uint32_t crc;       // Of the fields above
+};
+
+struct mram_log_commit {
+    uint32_t seq;       // Segment it belongs to, tells it from an older lap
+    uint32_t time;      // First record
+    uint16_t size;      // Record bytes
+    uint16_t count;
+    uint32_t crc;       // Of the fields above and the records
+};
+
+typedef char mram_log_segment_size_check[
+        (sizeof(struct mram_log_segment) == MRAM_LOG_SEGMENT_HEADER) ? 1 : -1];
+typedef char mram_log_commit_size_check[
+        (sizeof(struct mram_log_commit) == MRAM_LOG_COMMIT_HEADER) ? 1 : -1];
+typedef char mram_log_record_size_check[
+        (sizeof(mram_log_record_t) == MRAM_LOG_RECORD_HEADER) ? 1 : -1];
+
+static uint32_t mram_log_addr(const mram_log_t *log, uint32_t seq,
+        uint32_t off) {
+    return log->cfg->base
+            + ((seq - 1) % log->segments) * log->cfg->segment_size + off;
+}
+
+// Header of the segment at a physical index, 1 if it is intact
+static int mram_log_readsegment(mram_log_t *log, uint32_t index,
+        struct mram_log_segment *segment) {
+    lfs_mrambd_readaddr(log->cfg->bd,
+            log->cfg->base + index*log->cfg->segment_size,
+            segment, sizeof(*segment));
+    return segment->magic == MRAM_LOG_MAGIC
+            && segment->crc == lfs_crc(0xffffffff, segment,
+                offsetof(struct mram_log_segment, crc));
+}
+
+// Header of the segment holding seq, 1 if it is intact and still holds seq
+static int mram_log_segmentof(mram_log_t *log, uint32_t seq,
+        struct mram_log_segment *segment) {
+    return mram_log_readsegment(log, (seq - 1) % log->segments, segment)
+            && segment->seq == seq;
+}
+
+// Commit at off in segment seq, 1 if it belongs there. With a body buffer
+// its records are read as well and must match the CRC.
+static int mram_log_readcommit(mram_log_t *log, uint32_t seq, uint32_t off,
+        struct mram_log_commit *commit, uint8_t *body) {
+    if (off + MRAM_LOG_COMMIT_HEADER > log->cfg->segment_size) {
+        return 0;
+    }
+
+    lfs_mrambd_readaddr(log->cfg->bd, mram_log_addr(log, seq, off),
+            commit, sizeof(*commit));
+    if (commit->seq != seq || commit->count == 0
+            || commit->size > MRAM_LOG_BATCH_SIZE - MRAM_LOG_COMMIT_HEADER
+            || off + MRAM_LOG_COMMIT_HEADER + commit->size
+                > log->cfg->segment_size) {
+        return 0;
+    }
+    if (!body) {
+        return 1;
+    }
+
+    lfs_mrambd_readaddr(log->cfg->bd,
+            mram_log_addr(log, seq, off + MRAM_LOG_COMMIT_HEADER),
+            body, commit->size);
+    uint32_t crc = lfs_crc(0xffffffff, commit,
+            offsetof(struct mram_log_commit, crc));
+    return commit->crc == lfs_crc(crc, body, commit->size);
+}
+
+static int mram_log_init(mram_log_t *log, const struct mram_log_config *cfg) {
+    LFS_ASSERT(cfg->segment_size >= MRAM_LOG_SEGMENT_HEADER
+            + MRAM_LOG_BATCH_SIZE);
+    LFS_ASSERT(cfg->size % cfg->segment_size == 0);
+    LFS_ASSERT(cfg->size / cfg->segment_size >= 2);
+
+    log->cfg = cfg;
+    log->segments = cfg->size / cfg->segment_size;
+    log->seq = 0;
+    log->off = 0;
+    log->last_time = 0;
+    log->batch_size = 0;
+    log->batch_count = 0;
+    log->commits = 0;
+    return 0;
+}
+
+int mram_log_format(mram_log_t *log, const struct mram_log_config *cfg) {
+    struct mram_log_segment blank;
+
+    mram_log_init(log, cfg);
+    memset(&blank, 0, sizeof(blank));
+    for (uint32_t i = 0; i < log->segments; i++) {
+        lfs_mrambd_progaddr(cfg->bd, cfg->base + i*cfg->segment_size,
+                &blank, sizeof(blank));
+    }
+    return 0;
+}
+
+int mram_log_mount(mram_log_t *log, const struct mram_log_config *cfg) {
+    struct mram_log_segment segment;
+    struct mram_log_commit commit;
+    uint8_t *body = &log->batch[MRAM_LOG_SEGMENT_HEADER];
+
+    mram_log_init(log, cfg);
+
+    // Segment seq sits at index (seq - 1) % segments, so from index 0 the
+    // sequence numbers run on by one up to the newest segment
+    if (mram_log_readsegment(log, 0, &segment)) {
+        uint32_t first = segment.seq;
+        uint32_t lo = 0;
+        uint32_t hi = log->segments;
+        while (hi - lo > 1) {
+            uint32_t mid = lo + (hi - lo)/2;
+            if (mram_log_readsegment(log, mid, &segment)
+                    && segment.seq == first + mid) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        log->seq = first + lo;
+    } else if (mram_log_readsegment(log, log->segments - 1, &segment)
+            && (segment.seq - 1) % log->segments == log->segments - 1) {
+        // Torn while wrapping back to index 0
+        log->seq = segment.seq;
+    } else {
+        return 0;
+    }
+
+    mram_log_segmentof(log, log->seq, &segment);
+    log->last_time = segment.time;
+
+    // Only the newest segment is scanned, up to its last intact commit
+    log->off = MRAM_LOG_SEGMENT_HEADER;
+    while (mram_log_readcommit(log, log->seq, log->off, &commit, body)) {
+        uint32_t pos = 0;
+        while (pos < commit.size) {
+            mram_log_record_t record;
+            memcpy(&record, &body[pos], sizeof(record));
+            log->last_time = record.time;
+            pos += MRAM_LOG_RECORD_HEADER + record.size;
+        }
+        log->off += MRAM_LOG_COMMIT_HEADER + commit.size;
+    }
+    return 0;
+}
+
+int mram_log_append(mram_log_t *log, uint32_t time, uint16_t id,
+        const void *data, uint16_t size) {
+    if (size > MRAM_LOG_RECORD_MAX || time < log->last_time) {
+        return LFS_ERR_INVAL;
+    }
+
+    if (log->batch_size + MRAM_LOG_RECORD_HEADER + size
+            > MRAM_LOG_BATCH_SIZE - MRAM_LOG_COMMIT_HEADER) {
+        int err = mram_log_sync(log);
+        if (err) {
+            return err;
+        }
+    }
+
+    mram_log_record_t record = {.time = time, .id = id, .size = size};
+    uint8_t *p = &log->batch[MRAM_LOG_SEGMENT_HEADER + MRAM_LOG_COMMIT_HEADER
+            + log->batch_size];
+    memcpy(p, &record, sizeof(record));
+    memcpy(p + sizeof(record), data, size);
+
+    log->batch_size += MRAM_LOG_RECORD_HEADER + size;
+    log->batch_count += 1;
+    log->last_time = time;
+    return 0;
+}
+
+int mram_log_sync(mram_log_t *log) {
+    uint8_t *records = &log->batch[MRAM_LOG_SEGMENT_HEADER
+            + MRAM_LOG_COMMIT_HEADER];
+    uint32_t length = MRAM_LOG_COMMIT_HEADER + log->batch_size;
+    struct mram_log_commit commit;
+    mram_log_record_t first;
+
+    if (log->batch_count == 0) {
+        return 0;
+    }
+
+    // A batch that does not fit opens the next segment, dropping the oldest
+    if (log->seq == 0 || log->off + length > log->cfg->segment_size) {
+        log->seq += 1;
+        log->off = 0;
+    }
+
+    memcpy(&first, records, sizeof(first));
+    commit.seq = log->seq;
+    commit.time = first.time;
+    commit.size = (uint16_t)log->batch_size;
+    commit.count = log->batch_count;
+    commit.crc = lfs_crc(lfs_crc(0xffffffff, &commit,
+            offsetof(struct mram_log_commit, crc)), records, log->batch_size);
+    memcpy(&log->batch[MRAM_LOG_SEGMENT_HEADER], &commit, sizeof(commit));
+
+    // The segment header goes out in the same burst as its first commit
+    uint8_t *start = &log->batch[MRAM_LOG_SEGMENT_HEADER];
+    if (log->off == 0) {
+        struct mram_log_segment segment = {
+            .magic = MRAM_LOG_MAGIC,
+            .seq = log->seq,
+            .time = first.time,
+        };
+        segment.crc = lfs_crc(0xffffffff, &segment,
+                offsetof(struct mram_log_segment, crc));
+        memcpy(log->batch, &segment, sizeof(segment));
+        start = log->batch;
+        length += MRAM_LOG_SEGMENT_HEADER;
+    }
+
+    int err = lfs_mrambd_progaddr(log->cfg->bd,
+            mram_log_addr(log, log->seq, log->off), start, length);
+    if (err) {
+        return err;
+    }
+
+    log->off += length;
+    log->batch_size = 0;
+    log->batch_count = 0;
+    log->commits += 1;
+    return 0;
+}
+
+// Buffers the next commit if the one buffered is used up, 0 at the end
+static int mram_log_load(mram_log_t *log, mram_log_cursor_t *cursor) {
+    struct mram_log_commit commit;
+
+    while (cursor->pos >= cursor->size) {
+        if (cursor->seq == 0 || cursor->seq > log->seq
+                || log->seq - cursor->seq >= log->segments) {
+            return 0;   // Empty, past the newest, or wrapped over
+        }
+        if (cursor->seq == log->seq && cursor->off >= log->off) {
+            return 0;
+        }
+
+        if (mram_log_readcommit(log, cursor->seq, cursor->off, &commit,
+                cursor->buffer)) {
+            cursor->off += MRAM_LOG_COMMIT_HEADER + commit.size;
+            cursor->pos = 0;
+            cursor->size = commit.size;
+        } else if (cursor->seq == log->seq) {
+            return 0;
+        } else {
+            cursor->seq += 1;
+            cursor->off = MRAM_LOG_SEGMENT_HEADER;
+        }
+    }
+    return 1;
+}
+
+int mram_log_seek(mram_log_t *log, mram_log_cursor_t *cursor, uint32_t time) {
+    struct mram_log_segment segment;
+    struct mram_log_commit commit;
+
+    cursor->seq = 0;
+    cursor->off = MRAM_LOG_SEGMENT_HEADER;
+    cursor->pos = 0;
+    cursor->size = 0;
+    if (log->seq == 0) {
+        return 0;
+    }
+
+    // Last segment starting before time, or the oldest. The oldest may be
+    // the one a torn wrap left without a header.
+    uint32_t lo = (log->seq > log->segments)
+            ? log->seq - log->segments + 1 : 1;
+    if (lo < log->seq && !mram_log_segmentof(log, lo, &segment)) {
+        lo += 1;
+    }
+    uint32_t hi = log->seq + 1;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo)/2;
+        if (mram_log_segmentof(log, mid, &segment) && segment.time < time) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    cursor->seq = lo;
+
+    // Last commit in it starting before time, from the commit headers alone
+    uint32_t off = MRAM_LOG_SEGMENT_HEADER;
+    while (!(lo == log->seq && off >= log->off)
+            && mram_log_readcommit(log, lo, off, &commit, NULL)
+            && commit.time < time) {
+        cursor->off = off;
+        off += MRAM_LOG_COMMIT_HEADER + commit.size;
+    }
+
+    // Then record by record
+    while (mram_log_load(log, cursor) > 0) {
+        mram_log_record_t record;
+        memcpy(&record, &cursor->buffer[cursor->pos], sizeof(record));
+        if (record.time >= time) {
+            break;
+        }
+        cursor->pos += MRAM_LOG_RECORD_HEADER + record.size;
+    }
+    return 0;
+}
+
+int mram_log_next(mram_log_t *log, mram_log_cursor_t *cursor,
+        mram_log_record_t *record, void *data, uint16_t size) {
+    int ok = mram_log_load(log, cursor);
+    if (ok <= 0) {
+        return ok;
+    }
+
+    memcpy(record, &cursor->buffer[cursor->pos], sizeof(*record));
+    memcpy(data, &cursor->buffer[cursor->pos + MRAM_LOG_RECORD_HEADER],
+            (size < record->size) ? size : record->size);
+    cursor->pos += MRAM_LOG_RECORD_HEADER + record->size;
+    return 1;
+}
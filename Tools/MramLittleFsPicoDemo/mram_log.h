@@ -0,0 +1,125 @@
+/*
+ * Append-only telemetry log on the MRAM, beside littlefs
+ *
+ * A circular log of records in a region of the MRAM that littlefs does not
+ * use (shrink its block_count to make room). A record is a fixed 8 byte
+ * header, the RTC timestamp, an ID and the payload size, then the payload.
+ *
+ * Appends only copy the record into RAM. mram_log_sync(), or a full batch,
+ * commits the batch: one SPI burst with a header and CRC over the records,
+ * so a power cut loses at most the batch in RAM and a torn commit is
+ * dropped whole.
+ *
+ * The region is cut into segments, written in turn. Each starts with a
+ * header holding its sequence number and the timestamp of its first record:
+ * that is the time index, one entry per segment, kept in the log itself.
+ * Segment seq lives in segment (seq - 1) % segments, so:
+ * - mounting finds the newest segment with a binary search over the segment
+ *   headers, then scans that one segment for its last commit;
+ * - a time is found with a binary search over the segment headers, then a
+ *   walk over the commit headers of one segment;
+ * - when the log wraps, the oldest segment is dropped whole.
+ *
+ * Timestamps must not go backwards. Headers are stored little-endian, as on
+ * the Pico.
+ */
+#ifndef MRAM_LOG_H
+#define MRAM_LOG_H
+
+#include "lfs_mrambd.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#ifndef MRAM_LOG_BATCH_SIZE
+#define MRAM_LOG_BATCH_SIZE     512     // Commit header and records, one SPI burst
+#endif
+
+#define MRAM_LOG_SEGMENT_HEADER 16
+#define MRAM_LOG_COMMIT_HEADER  16
+#define MRAM_LOG_RECORD_HEADER  8
+
+// Largest payload of a record
+#define MRAM_LOG_RECORD_MAX \
+    (MRAM_LOG_BATCH_SIZE - MRAM_LOG_COMMIT_HEADER - MRAM_LOG_RECORD_HEADER)
+
+struct mram_log_config {
+    // MRAM holding the log, attached with lfs_mrambd_create()
+    lfs_mrambd_t *bd;
+
+    // First byte of the region
+    uint32_t base;
+
+    // Bytes in the region, a multiple of segment_size, at least 2 segments
+    uint32_t size;
+
+    // Bytes per segment: a wrap drops this much, and the time index has an
+    // entry per segment. Larger than MRAM_LOG_BATCH_SIZE.
+    uint32_t segment_size;
+};
+
+typedef struct mram_log_record {
+    uint32_t time;      // RTC timestamp
+    uint16_t id;        // Telemetry channel
+    uint16_t size;      // Payload bytes
+} mram_log_record_t;
+
+typedef struct mram_log {
+    const struct mram_log_config *cfg;
+    uint32_t segments;
+    uint32_t seq;       // Segment being written, 0 while the log is empty
+    uint32_t off;       // Where its next commit goes, 0 if it has no header yet
+    uint32_t last_time; // Of the last record appended
+
+    // Segment header, commit header and records, written in one burst
+    uint8_t batch[MRAM_LOG_SEGMENT_HEADER + MRAM_LOG_BATCH_SIZE];
+    uint32_t batch_size;    // Record bytes buffered
+    uint16_t batch_count;
+
+    uint32_t commits;   // Since mount
+} mram_log_t;
+
+// Where a reader is, commits are read one at a time
+typedef struct mram_log_cursor {
+    uint32_t seq;       // Segment being read
+    uint32_t off;       // Next commit in it
+    uint32_t pos;       // Next record in the commit buffered
+    uint32_t size;      // Record bytes buffered
+    uint8_t buffer[MRAM_LOG_BATCH_SIZE];
+} mram_log_cursor_t;
+
+
+// Empties the log. Invalidates every segment header of the region.
+int mram_log_format(mram_log_t *log, const struct mram_log_config *cfg);
+
+// Opens the log after a reset: reads O(log segments) segment headers and
+// the commits of the newest segment
+int mram_log_mount(mram_log_t *log, const struct mram_log_config *cfg);
+
+// Buffers a record, committing the batch first if the record does not fit.
+// Returns LFS_ERR_INVAL if time is before the last record, or the payload
+// is over MRAM_LOG_RECORD_MAX.
+int mram_log_append(mram_log_t *log, uint32_t time, uint16_t id,
+        const void *data, uint16_t size);
+
+// Commits the records buffered, if any
+int mram_log_sync(mram_log_t *log);
+
+// Places the cursor on the first committed record at or after time
+int mram_log_seek(mram_log_t *log, mram_log_cursor_t *cursor, uint32_t time);
+
+// Reads the next committed record, and up to size bytes of its payload into
+// data. Returns 1 with a record, 0 at the end of the log. A cursor the
+// writer has wrapped over ends.
+int mram_log_next(mram_log_t *log, mram_log_cursor_t *cursor,
+        mram_log_record_t *record, void *data, uint16_t size);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif
@@ -1,7 +1,7 @@
 #include "tinyprotocol.h"
 
 // Configuration
-int16_t CustomProcessTelecommand(uint8_t command, const uint8_t* buffer, uint8_t size);
+int16_t CustomProcessTelecommand(uint8_t command, const uint8_t* buffer, uint16_t size);
 int16_t CustomWriteBuffer(const uint8_t* buffer, uint8_t size);
 int16_t CustomProcessTelemetryRequest();
 
@@ -67,7 +67,7 @@ void loop() {
   }
 }
 
-int16_t CustomProcessTelecommand(uint8_t command, const uint8_t* buffer, uint8_t size) {
+int16_t CustomProcessTelecommand(uint8_t command, const uint8_t* buffer, uint16_t size) {
   switch (command) {
     case TC_TOGGLE_LED:
       led_status = !led_status;